@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+class Tracer;
+class PipelineStats;
+
+// obNGh̎
+enum BackendType {
+	BACKEND_D3D11,
+	BACKEND_CPU,
+};
+
+// CPȔfoCXԂ̓]ɎgtH[}bg
+// P010/P016NV12Ɠт16bitiLrbg͏ʂɋl߂j
+// AYUV1f4oCgiV,U,Y,Ȁj
+enum SurfaceFormat {
+	SURFACE_NV12,
+	SURFACE_YUY2,
+	SURFACE_P010,
+	SURFACE_P016,
+	SURFACE_AYUV,
+};
+
+// CPUANZXł悤Ƀ}bvT[tFX
+// NV12(P010/P016)̏ꍇAUVv[Yv[̒ipData + height * RowPitchjɂ
+struct MappedSurface {
+	void* pData;
+	int RowPitch;
+};
+
+// CPȔfoCXԂ̓]pT[tFXiD3D11ȂXe[WOeNX`j
+class BackendSurface
+{
+public:
+	virtual ~BackendSurface() { }
+};
+
+struct BackendParam {
+	SurfaceFormat format;
+	int srcWidth, srcHeight; // ̓TCY
+	int fpsNum, fpsDen;      // FPS
+	int width, height;       // o̓TCY
+	int tff;
+	int numFields;           // 1̓t[̏o̓t[
+	int quality;
+	std::string deviceName;
+	int deviceIndex;
+	int deviceGroup;         // l̃CX^XŃfoCXLi񏈗̃CX^X͕ʂ̒lɂj
+	int numInputStaging;     // ͓]pT[tFX̐
+	int numOutputStaging;    // o͓]pT[tFX̐
+	int numOutput;           // o̓Xbg̐
+	int debug;
+	Tracer* tracer;          // nullptrłȂ΃bN҂L^
+	PipelineStats* stats;    // nullptrłȂ΃foCXbN̉񐔂ƎԂL^
+};
+
+// obNGh̃C^[tFCX
+// ̓Xbg PastFrames() + 1 + FutureFrames() A
+// Process()ɂ̓Xbgԍߋ݁̏œn
+template <typename ErrorHandler>
+class VPBackend
+{
+public:
+	virtual ~VPBackend() { }
+
+	// foCXƃ\[X쐬
+	virtual void Create(const BackendParam& param, ErrorHandler* env) = 0;
+	virtual void SetFilter(bool autop, int nr, int edge, ErrorHandler* env) = 0;
+
+	virtual int PastFrames() = 0;
+	virtual int FutureFrames() = 0;
+
+	// ]pT[tFXiBackendParamŎw肵́j
+	virtual BackendSurface* GetInputStaging(int i) = 0;
+	virtual BackendSurface* GetOutputStaging(int i) = 0;
+
+	// o͓]pT[tFX̃}bv
+	// o͓]pT[tFXUnmapɍėpĂ悢iDownloadŃA}bvj
+	virtual MappedSurface Map(BackendSurface* surf, bool write, ErrorHandler* env) = 0;
+	virtual void Unmap(BackendSurface* surf) = 0;
+
+	// ͓]pT[tFX̏ݐ擾
+	// ͓]pT[tFX̓}bv܂܂ɂĂ̂ŁAUnmap͕sv
+	virtual MappedSurface GetInputMapping(BackendSurface* surf, ErrorHandler* env) = 0;
+	// ͓]pT[tFX̓XbgɃRs[
+	// ͓]pT[tFX͌Âɍėp邱ƁiRs[Îă}bv邽߁j
+	virtual void Upload(int slot, BackendSurface* src, ErrorHandler* env) = 0;
+	// C^ďo̓Xbgɏ
+	// field: JñtB[hԍ, parity: 0=1ڂ̃tB[h 1=2ڂ̃tB[h
+	// progressive: Ȃ̂Ȃt[Ȃ̂ŃC^Ɍ݂̃t[̂܂܁iTCYājo͂
+	virtual void Process(const int* slots, int field, int parity, int outSlot, bool progressive, ErrorHandler* env) = 0;
+	// tB[hI[_[ύXiProcess甽fBProcessƓXbhĂԂƁj
+	virtual void SetFieldOrder(bool tff) = 0;
+	// o̓Xbg]pT[tFXɃRs[
+	virtual void Download(BackendSurface* dst, int outSlot, ErrorHandler* env) = 0;
+
+	// EndBatch܂łUpload/Process/Download1̃foCXbNł܂Ƃ߂Ĕs
+	// ProcessƓXbhĂԂƁBob`͑̃XbhMapȂǂ҂̂ŁA
+	// ob`ɑ̃Xbh҂Ȃ
+	virtual void BeginBatch() { }
+	virtual void EndBatch() { }
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+#include <memory>
+
+#include "Thread.hpp"
+#include "Backend.hpp"
+#include "deint.h"
+
+// CPUŏobNGh
+// GPUȂhCoVideoProcessorgȂp
+// VideoProcessorBltƓO1t[󂯎ătB[hPʂŏo͂
+// C^͓KiyadifjŁAt[sohɕă[J[Xbhŕ񏈗
+template <typename ErrorHandler>
+class CPUBackend : public VPBackend<ErrorHandler>
+{
+	enum {
+		PAST_FRAMES = 1,
+		FUTURE_FRAMES = 1,
+		ALIGN = 64,
+	};
+
+	struct CPUSurface : public BackendSurface {
+		std::unique_ptr<uint8_t[]> mem;
+		uint8_t* data;
+		int pitch;
+
+		CPUSurface(int rowBytes, int rows)
+			: pitch((rowBytes + ALIGN - 1) & ~(ALIGN - 1))
+		{
+			mem = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * rows + ALIGN - 1]);
+			data = reinterpret_cast<uint8_t*>(
+				(reinterpret_cast<uintptr_t>(mem.get()) + ALIGN - 1) & ~(uintptr_t)(ALIGN - 1));
+		}
+
+		// TCỸT[tFXƃobt@iRs[̑j
+		void Swap(CPUSurface& o) {
+			std::swap(mem, o.mem);
+			std::swap(data, o.data);
+			std::swap(pitch, o.pitch);
+		}
+	};
+
+	// 1oh̍ŏsiƃXbh؂ւ̃I[o[wbh傫j
+	enum { MIN_BAND_ROWS = 32 };
+
+	typedef void(*DeintFunc)(uint8_t* dst, int dstPitch,
+		const uint8_t* prev, const uint8_t* cur, const uint8_t* next, int srcPitch,
+		int rowBytes, int height, int keepParity, int secondField, int yStart, int yEnd);
+
+	BackendParam param;
+	WorkerPool<ErrorHandler>* pool;
+	bool avx2;
+	DeintFunc deint;
+
+	std::vector<std::unique_ptr<CPUSurface>> inputStaging;
+	std::vector<std::unique_ptr<CPUSurface>> outputStaging;
+	std::vector<std::unique_ptr<CPUSurface>> inputSlots;
+	std::vector<std::unique_ptr<CPUSurface>> outputSlots;
+
+	bool Is16bit() const {
+		return param.format == SURFACE_P010 || param.format == SURFACE_P016;
+	}
+
+	int RowBytes(int w) {
+		switch (param.format) {
+		case SURFACE_NV12: return w;
+		case SURFACE_AYUV: return w * 4;
+		default: return w * 2;
+		}
+	}
+
+	// Fv[iYv[̌ɑjtH[}bg
+	bool HasChromaPlane() const {
+		return param.format == SURFACE_NV12 || Is16bit();
+	}
+
+	int NumRows(int h) {
+		return HasChromaPlane() ? h + (h >> 1) : h;
+	}
+
+	static CPUSurface* Get(BackendSurface* surf) {
+		return static_cast<CPUSurface*>(surf);
+	}
+
+public:
+	CPUBackend(WorkerPool<ErrorHandler>* pool, bool avx2)
+		: pool(pool)
+		, avx2(avx2)
+		, deint(nullptr)
+	{ }
+
+	void Create(const BackendParam& param, ErrorHandler* env)
+	{
+		this->param = param;
+
+		if (Is16bit()) {
+			deint = avx2 ? yadif_field16_avx2 : yadif_field16_c;
+		}
+		else {
+			deint = avx2 ? yadif_field_avx2 : yadif_field_c;
+		}
+
+		if (param.width != param.srcWidth || param.height != param.srcHeight) {
+			env->ThrowError("[D3DVP Error] cpu backend does not support resize");
+		}
+
+		int srcRowBytes = RowBytes(param.srcWidth);
+		int srcRows = NumRows(param.srcHeight);
+		int dstRowBytes = RowBytes(param.width);
+		int dstRows = NumRows(param.height);
+
+		for (int i = 0; i < param.numInputStaging; ++i) {
+			inputStaging.emplace_back(new CPUSurface(srcRowBytes, srcRows));
+		}
+		for (int i = 0; i < PAST_FRAMES + FUTURE_FRAMES + 1; ++i) {
+			inputSlots.emplace_back(new CPUSurface(srcRowBytes, srcRows));
+		}
+		for (int i = 0; i < param.numOutputStaging; ++i) {
+			outputStaging.emplace_back(new CPUSurface(dstRowBytes, dstRows));
+		}
+		for (int i = 0; i < param.numOutput; ++i) {
+			outputSlots.emplace_back(new CPUSurface(dstRowBytes, dstRows));
+		}
+	}
+
+	void SetFilter(bool autop, int nr, int edge, ErrorHandler* env)
+	{
+		// NRAGbWA␳CPUłł͔Ήij
+	}
+
+	int PastFrames() { return PAST_FRAMES; }
+	int FutureFrames() { return FUTURE_FRAMES; }
+
+	BackendSurface* GetInputStaging(int i) { return inputStaging[i].get(); }
+	BackendSurface* GetOutputStaging(int i) { return outputStaging[i].get(); }
+
+	MappedSurface Map(BackendSurface* surf, bool write, ErrorHandler* env)
+	{
+		MappedSurface ret = { Get(surf)->data, Get(surf)->pitch };
+		return ret;
+	}
+
+	void Unmap(BackendSurface* surf) { }
+
+	MappedSurface GetInputMapping(BackendSurface* surf, ErrorHandler* env)
+	{
+		return Map(surf, true, env);
+	}
+
+	void Upload(int slot, BackendSurface* src, ErrorHandler* env)
+	{
+		// ]pT[tFX͏㗬őSʏ̂Ńobt@邾ł悢
+		inputSlots[slot]->Swap(*Get(src));
+	}
+
+	void Process(const int* slots, int field, int parity, int outSlot, bool progressive, ErrorHandler* env)
+	{
+		const CPUSurface& prev = *inputSlots[slots[PAST_FRAMES - 1]];
+		const CPUSurface& cur = *inputSlots[slots[PAST_FRAMES]];
+		const CPUSurface& next = *inputSlots[slots[PAST_FRAMES + 1]];
+		CPUSurface& dst = *outputSlots[outSlot];
+
+		int rowBytes = RowBytes(param.srcWidth);
+		int rows = NumRows(param.srcHeight);
+
+		if (param.debug || progressive) {
+			// \]pA܂̓C^Ȃt[
+			for (int y = 0; y < rows; ++y) {
+				memcpy(dst.data + y * dst.pitch, cur.data + y * cur.pitch, rowBytes);
+			}
+			return;
+		}
+
+		// 1ڂ̃tB[hTFFȂgbvisj
+		int keepParity = param.tff ? parity : (1 - parity);
+
+		int lumaHeight = param.srcHeight;
+		int chromaHeight = HasChromaPlane() ? (param.srcHeight >> 1) : 0;
+		int numBands = std::max(1, std::min(pool->NumThreads() * 2, lumaHeight / MIN_BAND_ROWS));
+
+		pool->Run(numBands, [&](int band) {
+			deint(dst.data, dst.pitch, prev.data, cur.data, next.data, cur.pitch,
+				rowBytes, lumaHeight, keepParity, parity,
+				lumaHeight * band / numBands, lumaHeight * (band + 1) / numBands);
+			if (chromaHeight > 0) {
+				// UVv[sƂɃtB[h݂ɕł
+				int offset = lumaHeight;
+				deint(dst.data + offset * dst.pitch, dst.pitch,
+					prev.data + offset * cur.pitch, cur.data + offset * cur.pitch, next.data + offset * cur.pitch, cur.pitch,
+					rowBytes, chromaHeight, keepParity, parity,
+					chromaHeight * band / numBands, chromaHeight * (band + 1) / numBands);
+			}
+		});
+	}
+
+	void SetFieldOrder(bool tff)
+	{
+		param.tff = tff;
+	}
+
+	void Download(BackendSurface* dst, int outSlot, ErrorHandler* env)
+	{
+		// o̓Xbg͎ProcessőSʏ̂Ńobt@邾ł悢
+		outputSlots[outSlot]->Swap(*Get(dst));
+	}
+};
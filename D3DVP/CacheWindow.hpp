@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+
+// vꂽt[̕ѕ
+enum AccessPattern {
+	ACCESS_RANDOM,   // V[Ni܂͗Ȃj
+	ACCESS_FORWARD,  // ̍ĐGR[h
+	ACCESS_BACKWARD, // t̃R}
+};
+
+// ߂̗vp^[Avt[OɕێĂt[Ɛǂݖ߂
+// ŒcacheƋt̃R}ł̓Zbg΂ɂȂA
+// GR[ĥ悤ȏANZXł͉ߋt[̃LbV̖ʂɂȂ邽
+// t[ԍׂ͂ē̓t[P
+class CacheWindow
+{
+public:
+	enum {
+		HISTORY = 8,               // p^[Ɏg߂̈ړʂ̐
+		STEP_FRAMES = 8,           // ȉ̈ړ͘AANZXƂ݂Ȃ
+		MIN_BACK_FRAMES = 2,       // ANZXłcĂߋt[
+		MIN_BACKWARD_FRAMES = 30,  // tANZXŕێŏt[
+	};
+
+	// cacheFrames: ̃LbVt[i_ANZXɎgj
+	CacheWindow(int cacheFrames)
+		: cacheFrames(cacheFrames)
+	{
+		Clear();
+	}
+
+	void Clear() {
+		last = -1;
+		numDeltas = 0;
+		pos = 0;
+		pattern = ACCESS_RANDOM;
+		jitter = 0;
+	}
+
+	void Request(int n) {
+		if (last != -1) {
+			deltas[pos] = n - last;
+			pos = (pos + 1) % HISTORY;
+			numDeltas = std::min(numDeltas + 1, (int)HISTORY);
+			Update();
+		}
+		last = n;
+	}
+
+	AccessPattern Pattern() const { return pattern; }
+
+	// vt[OɕێĂt[
+	int BackFrames() const {
+		switch (pattern) {
+		case ACCESS_FORWARD:
+			// MTŏԂOシ镪c
+			return std::min(cacheFrames, std::max((int)MIN_BACK_FRAMES, jitter));
+		case ACCESS_BACKWARD:
+			return std::max(cacheFrames, (int)MIN_BACKWARD_FRAMES);
+		default:
+			return cacheFrames;
+		}
+	}
+
+	// vt[ɏĂt[
+	// procAhead: pCvC𖄂߂̂ɕKvȖ, minAhead: vt[̏o͂ɕKvȖ
+	int AheadFrames(int procAhead, int minAhead) const {
+		// ȊOł͐̃t[͎gȂ̂ŁAvt[̏o͂ɕKvȕɂ
+		return (pattern == ACCESS_FORWARD) ? procAhead : minAhead;
+	}
+
+private:
+	int cacheFrames;
+	int last;
+	int deltas[HISTORY];
+	int numDeltas;
+	int pos;
+	AccessPattern pattern;
+	int jitter; // AANZX̍ő̌߂
+
+	void Update() {
+		int numRandom = 0;
+		int sum = 0;
+		jitter = 0;
+		for (int i = 0; i < numDeltas; ++i) {
+			int d = deltas[i];
+			if (d > STEP_FRAMES || d < -STEP_FRAMES) {
+				++numRandom;
+			}
+			else {
+				sum += d;
+				jitter = std::max(jitter, -d);
+			}
+		}
+		if (numDeltas < HISTORY / 2 || numRandom * 2 >= numDeltas) {
+			pattern = ACCESS_RANDOM;
+		}
+		else {
+			// 2{FPSł͓̓t[2񑱂̂ňړʂ̍vŌ𔻒肷
+			pattern = (sum < 0) ? ACCESS_BACKWARD : ACCESS_FORWARD;
+		}
+	}
+};
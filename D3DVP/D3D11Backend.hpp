@@ -0,0 +1,718 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <DXGI.h>
+#include <D3D11.h>
+#include <comdef.h>
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+
+#include "Thread.hpp"
+#include "Backend.hpp"
+#include "Tracer.hpp"
+#include "PipelineStats.hpp"
+#include "D3D11DeviceCache.hpp"
+
+#define COM_CHECK(call) \
+	do { \
+		HRESULT hr_ = call; \
+		if (FAILED(hr_)) { \
+			OnComError(hr_); \
+			env->ThrowError("[COM Error] %d: %s at %s:%d", hr_, \
+					_com_error(hr_).ErrorMessage(), __FILE__, __LINE__); \
+				} \
+		} while (0)
+
+inline void OnComError(HRESULT hr) {
+	PRINTF("[COM Error] %s (code: %d)\n", _com_error(hr).ErrorMessage(), hr);
+}
+
+static std::vector<wchar_t> to_wstring(std::string str) {
+	if (str.size() == 0) {
+		return std::vector<wchar_t>(1);
+	}
+	int dstlen = MultiByteToWideChar(
+		CP_ACP, 0, str.c_str(), (int)str.size(), NULL, 0);
+	std::vector<wchar_t> ret(dstlen + 1);
+	MultiByteToWideChar(CP_ACP, 0,
+		str.c_str(), (int)str.size(), ret.data(), (int)ret.size());
+	ret.back() = 0; // null terminate
+	return ret;
+}
+
+// Direct3D 11 Video APIŏobNGh
+template <typename ErrorHandler>
+class D3D11Backend : public VPBackend<ErrorHandler>
+{
+	typedef D3D11StagingTexture StagingTexture;
+
+	BackendParam param;
+
+	// foCXVideoProcessorEnumeratorD3D11DeviceCacheœA_v^Aݒ̃CX^XƋL
+	// VideoProcessorƃeNX`iresj͂̃CX^XLāAjƂprocessorɕԂ
+	std::shared_ptr<D3D11Processor> processor;
+	std::unique_ptr<D3D11Resources> res;
+	std::shared_ptr<D3D11Device> device; // gĂfoCXi쐬processorɌ܂j
+
+	// processorĂ
+	ID3D11Device* dev;
+	ID3D11DeviceContext* devCtx;
+	ID3D11VideoDevice* videoDev;
+	ID3D11VideoContext* videoCtx;
+	ID3D11VideoProcessorEnumerator* videoProcEnum;
+	ID3D11VideoProcessor* videoProc;
+
+	D3D11_VIDEO_PROCESSOR_CAPS caps;
+	D3D11_VIDEO_PROCESSOR_RATE_CONVERSION_CAPS rccaps;
+	D3D11_VIDEO_FRAME_FORMAT frameFormat; // videoProcɐݒ肵Ă͂̃t[tH[}bg
+
+	std::vector<ID3D11VideoProcessorInputView*> pInputViews; // p|C^z
+
+	// Rs[ς݂ōă}bv҂̓͗pCPUeNX`iÂj
+	std::deque<StagingTexture*> pendingRemap;
+
+	// devCtx(+videoCtx?)ĂяoƂɃbN擾
+	// foCXgSCX^XŋLĂ
+	CriticalSection* deviceLock;
+
+	// deviceLockXR[vig[X̓bN҂̎ԂAvLȂ҂ԂƕێԂL^j
+	class DeviceLock : NonCopyable
+	{
+	public:
+		// batch: Upload/Process/DownloadĂԂƂBob`Ȃ烍bNĂ̂ŉȂ
+		DeviceLock(D3D11Backend* backend, bool batch = false)
+			: backend_((batch && backend->batchLock) ? nullptr : backend)
+			, start_(0)
+			, wait_(0)
+		{
+			if (backend_) {
+				TraceScope scope(backend_->param.tracer, "deviceLock wait");
+				int64_t t = GetPerfCounter();
+				backend_->deviceLock->enter();
+				start_ = GetPerfCounter();
+				wait_ = start_ - t;
+			}
+		}
+		~DeviceLock() {
+			if (backend_) {
+				int64_t end = GetPerfCounter();
+				backend_->deviceLock->exit();
+				if (backend_->param.stats) {
+					backend_->param.stats->RecordLock(wait_, end - start_);
+				}
+			}
+		}
+	private:
+		D3D11Backend* backend_;
+		int64_t start_;
+		int64_t wait_;
+	};
+
+	// BeginBatch()EndBatch()܂ŎĂ郍bN
+	std::unique_ptr<DeviceLock> batchLock;
+
+	D3D11_VIDEO_FRAME_FORMAT InterlacedFrameFormat() const {
+		return param.tff
+			? D3D11_VIDEO_FRAME_FORMAT_INTERLACED_TOP_FIELD_FIRST
+			: D3D11_VIDEO_FRAME_FORMAT_INTERLACED_BOTTOM_FIELD_FIRST;
+	}
+
+	// deviceLockԂŌĂԂ
+	void SetFrameFormat(D3D11_VIDEO_FRAME_FORMAT format) {
+		if (frameFormat != format) {
+			videoCtx->VideoProcessorSetStreamFrameFormat(videoProc, 0, format);
+			frameFormat = format;
+		}
+	}
+
+	// deviceLockԂŌĂԂ
+	// noWait: GPU܂gpȂ}bvfalseԂ
+	bool MapInputStaging(StagingTexture* surf, bool noWait, ErrorHandler* env)
+	{
+		D3D11_MAPPED_SUBRESOURCE res;
+		HRESULT hr = devCtx->Map(surf->tex.get(), 0, D3D11_MAP_WRITE, noWait ? D3D11_MAP_FLAG_DO_NOT_WAIT : 0, &res);
+		if (noWait && hr == DXGI_ERROR_WAS_STILL_DRAWING) {
+			return false;
+		}
+		COM_CHECK(hr);
+		MappedSurface mapped = { res.pData, (int)res.RowPitch };
+		surf->mapped = mapped;
+		surf->isMapped.store(true, std::memory_order_release);
+		return true;
+	}
+
+	DXGI_FORMAT GetDXGIFormat() {
+		switch (param.format) {
+		case SURFACE_YUY2: return DXGI_FORMAT_YUY2;
+		case SURFACE_P010: return DXGI_FORMAT_P010;
+		case SURFACE_P016: return DXGI_FORMAT_P016;
+		case SURFACE_AYUV: return DXGI_FORMAT_AYUV;
+		default: return DXGI_FORMAT_NV12;
+		}
+	}
+
+	// COM̌ĂяosifoCX̍폜ȂǁjAgĂfoCXLbVO
+	// G[ɍ蒼CX^XfoCXgȂ悤ɂ邽
+	// COM_CHECK̓o֐̒ł͂炪Ă΂
+	void OnComError(HRESULT hr) {
+		::OnComError(hr);
+		if (device) {
+			D3D11DeviceCache::Get().EvictDevice(device);
+		}
+	}
+
+	// processorݒ肵ăLbṼfoCXȂǂQƂ
+	void SetProcessor(const std::shared_ptr<D3D11Processor>& processor)
+	{
+		this->processor = processor;
+		device = processor->device;
+		dev = processor->device->dev.get();
+		devCtx = processor->device->devCtx.get();
+		videoDev = processor->device->videoDev.get();
+		videoCtx = processor->device->videoCtx.get();
+		videoProcEnum = processor->videoProcEnum.get();
+		deviceLock = &processor->device->lock;
+		caps = processor->caps;
+		rccaps = processor->rccaps;
+	}
+
+	// VideoDeviceT|[gȂnullptrԂ
+	std::shared_ptr<D3D11Device> CreateDevice(IDXGIAdapter* pAdapter, ErrorHandler* env)
+	{
+		// D3D11foCX쐬
+		ID3D11Device* pDevice_;
+		ID3D11DeviceContext* pContext_;
+		const D3D_FEATURE_LEVEL featureLevels[] = {
+			D3D_FEATURE_LEVEL_11_1,
+			D3D_FEATURE_LEVEL_11_0,
+			D3D_FEATURE_LEVEL_10_1,
+			D3D_FEATURE_LEVEL_10_0,
+			D3D_FEATURE_LEVEL_9_3,
+		};
+#ifndef _DEBUG
+		int flags = 0;
+#else
+		int flags = D3D11_CREATE_DEVICE_DEBUG;
+#endif
+		COM_CHECK(D3D11CreateDevice(pAdapter,
+			D3D_DRIVER_TYPE_UNKNOWN, // A_v^w̏ꍇUNKNOWN
+			NULL,
+			flags,
+			featureLevels,
+			sizeof(featureLevels) / sizeof(featureLevels[0]),
+			D3D11_SDK_VERSION,
+			&pDevice_,
+			NULL,
+			&pContext_));
+		auto device = std::make_shared<D3D11Device>();
+		device->dev = make_com_ptr(pDevice_);
+		device->devCtx = make_com_ptr(pContext_);
+
+		// rfIfoCX쐬
+		ID3D11VideoDevice* pVideoDevice_;
+		if (FAILED(device->dev->QueryInterface(&pVideoDevice_))) {
+			return nullptr;
+		}
+		device->videoDev = make_com_ptr(pVideoDevice_);
+
+		ID3D11VideoContext* pVideoCtx_;
+		COM_CHECK(device->devCtx->QueryInterface(&pVideoCtx_));
+		device->videoCtx = make_com_ptr(pVideoCtx_);
+
+		return device;
+	}
+
+	void CreateProcessor(ErrorHandler* env)
+	{
+		// A_v^̗񋓂ƃfoCX̍쐬͏d̂ŁAݒō̂Ύg
+		auto& cache = D3D11DeviceCache::Get();
+		auto& cacheLock = with(cache.Lock());
+
+		D3D11ProcessorKey key(param);
+		auto cached = cache.FindProcessor(key);
+		if (cached) {
+			cache.Stats().processorHit++;
+			SetProcessor(cached);
+			return;
+		}
+
+		auto wname = to_wstring(param.deviceName);
+
+		// DXGIt@Ng쐬
+		IDXGIFactory1 * pFactory_;
+		COM_CHECK(CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void**)&pFactory_));
+		auto pFactory = make_com_ptr(pFactory_);
+
+		// A_v^
+		IDXGIAdapter * pAdapter_;
+		int dIndex = 0;
+		for (int i = 0; pFactory->EnumAdapters(i, &pAdapter_) != DXGI_ERROR_NOT_FOUND; ++i) {
+			auto pAdapter = make_com_ptr(pAdapter_);
+
+			DXGI_ADAPTER_DESC desc;
+			COM_CHECK(pAdapter->GetDesc(&desc));
+
+			PRINTF("%ls\n", desc.Description);
+			if (param.deviceName.size() > 0) { // w肪
+				if (memcmp(wname.data(), desc.Description, std::min(wname.size(), sizeof(desc.Description) / sizeof(desc.Description[0])))) {
+					continue;
+				}
+			}
+			if (dIndex != param.deviceIndex) {
+				dIndex++;
+				continue;
+			}
+
+			// A_v^AO[ṽfoCX΂g
+			device = cache.FindDevice(desc.AdapterLuid, param.deviceGroup);
+			bool newDevice = !device;
+			if (newDevice) {
+				device = CreateDevice(pAdapter.get(), env);
+				if (!device) {
+					// VideoDeviceT|[g
+					continue;
+				}
+				device->luid = desc.AdapterLuid;
+				device->group = param.deviceGroup;
+			}
+
+			D3D11_VIDEO_PROCESSOR_CONTENT_DESC vdesc = {};
+			vdesc.InputFrameFormat = InterlacedFrameFormat();
+			vdesc.InputFrameRate.Numerator = param.fpsNum;
+			vdesc.InputFrameRate.Denominator = param.fpsDen;
+			vdesc.InputHeight = param.srcHeight;
+			vdesc.InputWidth = param.srcWidth;
+			vdesc.OutputFrameRate.Numerator = param.fpsNum * param.numFields;
+			vdesc.OutputFrameRate.Denominator = param.fpsDen;
+			vdesc.OutputHeight = param.height;
+			vdesc.OutputWidth = param.width;
+
+			if (param.quality == 0) {
+				PRINTF("[D3DVP] Quality: Speed\n");
+				vdesc.Usage = D3D11_VIDEO_USAGE_OPTIMAL_SPEED;
+			}
+			else if (param.quality == 1) {
+				PRINTF("[D3DVP] Quality: Normal\n");
+				vdesc.Usage = D3D11_VIDEO_USAGE_PLAYBACK_NORMAL;
+			}
+			else { // quality == 2
+				PRINTF("[D3DVP] Quality: Quality\n");
+				vdesc.Usage = D3D11_VIDEO_USAGE_OPTIMAL_QUALITY;
+			}
+
+			// VideoProcessorEnumerator쐬
+			ID3D11VideoProcessorEnumerator* pEnum_;
+			COM_CHECK(device->videoDev->CreateVideoProcessorEnumerator(&vdesc, &pEnum_));
+			auto pEnum = make_com_ptr(pEnum_);
+
+			// P010/P016/AYUV͓o͂ɑΉĂȂfoCX
+			UINT formatSupport = 0;
+			if (FAILED(pEnum->CheckVideoProcessorFormat(GetDXGIFormat(), &formatSupport)) ||
+				!(formatSupport & D3D11_VIDEO_PROCESSOR_FORMAT_SUPPORT_INPUT) ||
+				!(formatSupport & D3D11_VIDEO_PROCESSOR_FORMAT_SUPPORT_OUTPUT))
+			{
+				PRINTF("[D3DVP] format %d is not supported\n", (int)param.format);
+				continue;
+			}
+
+			D3D11_VIDEO_PROCESSOR_CAPS caps;
+			COM_CHECK(pEnum->GetVideoProcessorCaps(&caps));
+			if (caps.RateConversionCapsCount > 0) {
+				// VideoProcessor̓CX^XƂCreateResourcesō
+				const int rci = 0;
+				auto processor = std::make_shared<D3D11Processor>();
+				processor->device = device;
+				processor->caps = caps;
+				COM_CHECK(pEnum->GetVideoProcessorRateConversionCaps(rci, &processor->rccaps));
+				processor->rateConversionIndex = rci;
+				processor->videoProcEnum = std::move(pEnum);
+
+				if (newDevice) {
+					cache.AddDevice(device);
+					cache.Stats().deviceCreated++;
+				}
+				cache.AddProcessor(key, processor);
+				cache.Stats().processorCreated++;
+				SetProcessor(processor);
+				return;
+				/*
+				for (int k = 0; k < rccaps.CustomRateCount; ++k) {
+				D3D11_VIDEO_PROCESSOR_CUSTOM_RATE customRate;
+				COM_CHECK(pEnum->GetVideoProcessorCustomRate(rci, k, &customRate));
+				PRINTF("%d-%d rate: %d/%d %d -> %d (interladed: %d)\n", rci, k,
+				customRate.CustomRate.Numerator, customRate.CustomRate.Denominator,
+				customRate.InputFramesOrFields, customRate.OutputFrames, customRate.InputInterlaced);
+				}
+				*/
+			}
+		}
+
+		device = nullptr;
+		env->ThrowError("No such device ...");
+	}
+
+	void CreateResources(ErrorHandler* env)
+	{
+		// ÕCX^XgĂ̂΂g
+		res = processor->TakeIdle();
+		if (res) {
+			D3D11DeviceCache::Get().Stats().resourcesReused++;
+			videoProc = res->videoProc.get();
+			// ă}bv҂̂܂ܕԂꂽ̂͂Ń}bv
+			DeviceLock lock(this);
+			for (auto& tex : res->texInputCPU) {
+				if (!tex->isMapped) {
+					MapInputStaging(tex.get(), false, env);
+				}
+			}
+			return;
+		}
+
+		std::unique_ptr<D3D11Resources> newRes(new D3D11Resources());
+
+		ID3D11VideoProcessor* pVideoProcessor_;
+		COM_CHECK(videoDev->CreateVideoProcessor(videoProcEnum, processor->rateConversionIndex, &pVideoProcessor_));
+		newRes->videoProc = make_com_ptr(pVideoProcessor_);
+
+		// KvȃeNX`
+		int numInputTex = rccaps.FutureFrames + rccaps.PastFrames + 1;
+		PRINTF("[D3DVP] PastFrames: %d, FutureFrames: %d\n", rccaps.PastFrames, rccaps.FutureFrames);
+
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = param.srcWidth;
+		desc.Height = param.srcHeight;
+		desc.MipLevels = 1;
+		desc.ArraySize = 1;
+		desc.Format = GetDXGIFormat();
+		// restriction: no anti-aliasing
+		desc.SampleDesc.Count = 1;
+		desc.SampleDesc.Quality = 0;
+		// restriction: D3D11_USAGE_DEFAULT
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		// no bind flag is OK for video processing input
+		desc.BindFlags = 0;
+		desc.CPUAccessFlags = 0;
+		desc.MiscFlags = 0;
+
+		// ͗peNX`
+		newRes->texInput.resize(numInputTex);
+		for (int i = 0; i < numInputTex; ++i) {
+			ID3D11Texture2D* pTexInput_;
+			COM_CHECK(dev->CreateTexture2D(&desc, NULL, &pTexInput_));
+			newRes->texInput[i] = make_com_ptr(pTexInput_);
+		}
+
+		// o͗peNX`
+		desc.Width = param.width;
+		desc.Height = param.height;
+		// output must be D3D11_BIND_RENDER_TARGET
+		desc.BindFlags = D3D11_BIND_RENDER_TARGET;
+
+		newRes->texOutput.resize(param.numOutput);
+		for (int i = 0; i < param.numOutput; ++i) {
+			ID3D11Texture2D* pTexOutput_;
+			COM_CHECK(dev->CreateTexture2D(&desc, NULL, &pTexOutput_));
+			newRes->texOutput[i] = make_com_ptr(pTexOutput_);
+		}
+
+		// ͗pCPUeNX`
+		desc.Width = param.srcWidth;
+		desc.Height = param.srcHeight;
+		desc.Usage = D3D11_USAGE_STAGING;
+		desc.BindFlags = 0;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		newRes->texInputCPU.resize(param.numInputStaging);
+		for (int i = 0; i < param.numInputStaging; ++i) {
+			ID3D11Texture2D* pTexInputCPU_;
+			COM_CHECK(dev->CreateTexture2D(&desc, NULL, &pTexInputCPU_));
+			newRes->texInputCPU[i] = std::unique_ptr<StagingTexture>(new StagingTexture());
+			newRes->texInputCPU[i]->tex = make_com_ptr(pTexInputCPU_);
+		}
+
+		// o͗pCPUeNX`
+		desc.Width = param.width;
+		desc.Height = param.height;
+		desc.Usage = D3D11_USAGE_STAGING;
+		desc.BindFlags = 0;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+		newRes->texOutputCPU.resize(param.numOutputStaging);
+		for (int i = 0; i < param.numOutputStaging; ++i) {
+			ID3D11Texture2D* pTexOutputCPU_;
+			COM_CHECK(dev->CreateTexture2D(&desc, NULL, &pTexOutputCPU_));
+			newRes->texOutputCPU[i] = std::unique_ptr<StagingTexture>(new StagingTexture());
+			newRes->texOutputCPU[i]->tex = make_com_ptr(pTexOutputCPU_);
+		}
+
+		// InputView쐬
+		for (int i = 0; i < numInputTex; ++i) {
+			ID3D11VideoProcessorInputView* pInputView_;
+			D3D11_VIDEO_PROCESSOR_INPUT_VIEW_DESC inputViewDesc = { 0 };
+			inputViewDesc.ViewDimension = D3D11_VPIV_DIMENSION_TEXTURE2D;
+			COM_CHECK(videoDev->CreateVideoProcessorInputView(
+				newRes->texInput[i].get(), videoProcEnum, &inputViewDesc, &pInputView_));
+			newRes->inputViews.emplace_back(pInputView_);
+		}
+
+		// OutputView쐬
+		for (int i = 0; i < param.numOutput; ++i) {
+			ID3D11VideoProcessorOutputView* pOutputView_;
+			D3D11_VIDEO_PROCESSOR_OUTPUT_VIEW_DESC outputViewDesc = { D3D11_VPOV_DIMENSION_TEXTURE2D };
+			outputViewDesc.Texture2D.MipSlice = 0;
+			COM_CHECK(videoDev->CreateVideoProcessorOutputView(
+				newRes->texOutput[i].get(), videoProcEnum, &outputViewDesc, &pOutputView_));
+			newRes->outputViews.emplace_back(pOutputView_);
+		}
+
+		res = std::move(newRes);
+		videoProc = res->videoProc.get();
+
+		// ŏGPUgĂȂ̂łŃ}bvĂ
+		// ReLXg͑̃CX^XƋLĂ̂ŃbN
+		DeviceLock lock(this);
+		for (auto& tex : res->texInputCPU) {
+			MapInputStaging(tex.get(), false, env);
+		}
+	}
+
+public:
+	D3D11Backend()
+		: dev(nullptr)
+		, devCtx(nullptr)
+		, videoDev(nullptr)
+		, videoCtx(nullptr)
+		, videoProcEnum(nullptr)
+		, videoProc(nullptr)
+		, frameFormat(D3D11_VIDEO_FRAME_FORMAT_PROGRESSIVE)
+		, deviceLock(nullptr)
+	{ }
+
+	~D3D11Backend() {
+		// eNX`͔jɓݒ̎̃CX^X̂߂ɎĂ
+		// iݒ̃CX^XcĂȂprocessorƈꏏɉj
+		if (res) {
+			processor->ReturnIdle(std::move(res));
+		}
+	}
+
+	void Create(const BackendParam& param, ErrorHandler* env)
+	{
+		this->param = param;
+		CreateProcessor(env);
+		CreateResources(env);
+		{
+			// g񂵂VideoProcessor͑ÕCX^X̐ݒ肪cĂ̂ŁASetFilteȓOł킹Ă
+			DeviceLock lock(this);
+			frameFormat = InterlacedFrameFormat();
+			videoCtx->VideoProcessorSetStreamFrameFormat(videoProc, 0, frameFormat);
+		}
+		auto& stats = D3D11DeviceCache::Get().Stats();
+		PRINTF("[D3DVP] device: %d, processor: %d (hit %d), resources reused: %d\n",
+			stats.deviceCreated.load(), stats.processorCreated.load(), stats.processorHit.load(), stats.resourcesReused.load());
+	}
+
+	// foCXƃ\[X̃LbVĩCX^XjĂĂ΁A
+	// ݒ̎̃CX^XfoCXƃ\[Xg񂹂j
+	std::shared_ptr<D3D11Processor> GetProcessor() const { return processor; }
+
+	void SetFilter(bool autop, int nr, int edge, ErrorHandler* env)
+	{
+		bool bob = (param.numFields >= 2);
+
+		// ReLXg͓foCXg̃CX^XƋLĂ
+		DeviceLock lock(this);
+
+		// D3D11_VIDEO_PROCESSOR_CONTENT_DESC̎w͔fĂȂۂ̂
+		// VideoProcessorݒ
+		videoCtx->VideoProcessorSetStreamOutputRate(
+			videoProc, 0, bob
+			? D3D11_VIDEO_PROCESSOR_OUTPUT_RATE_NORMAL
+			: D3D11_VIDEO_PROCESSOR_OUTPUT_RATE_HALF, FALSE, NULL);
+		frameFormat = InterlacedFrameFormat();
+		videoCtx->VideoProcessorSetStreamFrameFormat(videoProc, 0, frameFormat);
+
+		BOOL enableNR = (nr >= 0) && (caps.FilterCaps & D3D11_VIDEO_PROCESSOR_FILTER_CAPS_NOISE_REDUCTION);
+		BOOL enableEE = (edge >= 0) && (caps.FilterCaps & D3D11_VIDEO_PROCESSOR_FILTER_CAPS_EDGE_ENHANCEMENT);
+
+		D3D11_VIDEO_PROCESSOR_FILTER_RANGE nrRange = { 0 }, edgeRange = { 0 };
+
+		if (enableNR) {
+			COM_CHECK(videoProcEnum->GetVideoProcessorFilterRange(
+				D3D11_VIDEO_PROCESSOR_FILTER_NOISE_REDUCTION, &nrRange));
+			PRINTF("NR: [%d,%d,%d,%f]\n", nrRange.Minimum, nrRange.Maximum, nrRange.Default, nrRange.Multiplier);
+			nr = (int)std::round((double)nr * 0.01 *
+				(nrRange.Maximum - nrRange.Minimum) + nrRange.Minimum);
+			PRINTF("NR: %d %d\n", enableNR, nr);
+		}
+		if (caps.FilterCaps & D3D11_VIDEO_PROCESSOR_FILTER_CAPS_NOISE_REDUCTION) {
+			// g񂵂VideoProcessor͑O̐ݒ肪cĂ̂ŁȀꍇݒ肷
+			videoCtx->VideoProcessorSetStreamFilter(
+				videoProc, 0, D3D11_VIDEO_PROCESSOR_FILTER_NOISE_REDUCTION, enableNR, nr);
+		}
+
+		if (enableEE) {
+			COM_CHECK(videoProcEnum->GetVideoProcessorFilterRange(
+				D3D11_VIDEO_PROCESSOR_FILTER_EDGE_ENHANCEMENT, &edgeRange));
+			PRINTF("EE: [%d,%d,%d,%f]\n", edgeRange.Minimum, edgeRange.Maximum, edgeRange.Default, edgeRange.Multiplier);
+			edge = (int)std::round((double)edge * 0.01 *
+				(edgeRange.Maximum - edgeRange.Minimum) + edgeRange.Minimum);
+			PRINTF("EE: %d %d\n", enableEE, edge);
+		}
+		if (caps.FilterCaps & D3D11_VIDEO_PROCESSOR_FILTER_CAPS_EDGE_ENHANCEMENT) {
+			videoCtx->VideoProcessorSetStreamFilter(
+				videoProc, 0, D3D11_VIDEO_PROCESSOR_FILTER_EDGE_ENHANCEMENT, enableEE, edge);
+		}
+
+		// auto processing mode
+		videoCtx->VideoProcessorSetStreamAutoProcessingMode(videoProc, 0, (BOOL)autop);
+	}
+
+	int PastFrames() { return rccaps.PastFrames; }
+	int FutureFrames() { return rccaps.FutureFrames; }
+
+	BackendSurface* GetInputStaging(int i) { return res->texInputCPU[i].get(); }
+	BackendSurface* GetOutputStaging(int i) { return res->texOutputCPU[i].get(); }
+
+	MappedSurface Map(BackendSurface* surf, bool write, ErrorHandler* env)
+	{
+		auto tex = static_cast<StagingTexture*>(surf);
+		D3D11_MAPPED_SUBRESOURCE res;
+		{
+			DeviceLock lock(this);
+			COM_CHECK(devCtx->Map(tex->tex.get(), 0, write ? D3D11_MAP_WRITE : D3D11_MAP_READ, 0, &res));
+			tex->isMapped = true;
+		}
+		MappedSurface ret = { res.pData, (int)res.RowPitch };
+		return ret;
+	}
+
+	void Unmap(BackendSurface* surf)
+	{
+		auto tex = static_cast<StagingTexture*>(surf);
+		DeviceLock lock(this);
+		devCtx->Unmap(tex->tex.get(), 0);
+		tex->isMapped = false;
+	}
+
+	MappedSurface GetInputMapping(BackendSurface* surf, ErrorHandler* env)
+	{
+		auto tex = static_cast<StagingTexture*>(surf);
+		if (!tex->isMapped.load(std::memory_order_acquire)) {
+			// ă}bvԂɍȂꍇ݂̂Ń}bviGPŨRs[҂j
+			DeviceLock lock(this);
+			if (!tex->isMapped) {
+				auto it = std::find(pendingRemap.begin(), pendingRemap.end(), tex);
+				if (it != pendingRemap.end()) {
+					pendingRemap.erase(it);
+				}
+				MapInputStaging(tex, false, env);
+			}
+		}
+		return tex->mapped;
+	}
+
+	void Upload(int slot, BackendSurface* src, ErrorHandler* env)
+	{
+		auto tex = static_cast<StagingTexture*>(src);
+		// A}bvARs[AÂeNX`̍ă}bv1̃bNōs
+		DeviceLock lock(this, true);
+		devCtx->Unmap(tex->tex.get(), 0);
+		tex->isMapped = false;
+		devCtx->CopySubresourceRegion(res->texInput[slot].get(), 0, 0, 0, 0, tex->tex.get(), 0, NULL);
+		// ă}bvŗOoĂA}bveNX`Ȃ悤ɐɒǉĂ
+		pendingRemap.push_back(tex);
+		// ȑOɃRs[̂͂GPȔIĂ͂Ȃ̂ŁA҂Ƀ}bvł̂̓}bv
+		while (pendingRemap.front() != tex) {
+			if (!MapInputStaging(pendingRemap.front(), true, env)) {
+				break;
+			}
+			pendingRemap.pop_front();
+		}
+	}
+
+	void Process(const int* slots, int field, int parity, int outSlot, bool progressive, ErrorHandler* env)
+	{
+		int numInputTex = rccaps.PastFrames + rccaps.FutureFrames + 1;
+
+		// pInputViews쐬
+		pInputViews.resize(numInputTex);
+		for (int i = 0; i < numInputTex; ++i) {
+			pInputViews[i] = res->inputViews[slots[i]].get();
+		}
+
+		// stream쐬
+		D3D11_VIDEO_PROCESSOR_STREAM stream = { 0 };
+		stream.Enable = TRUE;
+		stream.PastFrames = rccaps.PastFrames;
+		stream.FutureFrames = rccaps.FutureFrames;
+
+		int findex = 0;
+		stream.ppPastSurfaces = pInputViews.data() + findex;
+		findex += rccaps.PastFrames;
+		stream.pInputSurface = pInputViews[findex++];
+		stream.ppFutureSurfaces = pInputViews.data() + findex;
+		findex += rccaps.FutureFrames;
+
+		stream.OutputIndex = parity;
+		stream.InputFrameOrField = field;
+
+		bool resize = (param.width != param.srcWidth || param.height != param.srcHeight);
+
+		DeviceLock lock(this, true);
+		if (param.debug || (progressive && !resize)) {
+			// \]pA܂̓C^Ȃt[
+			devCtx->CopyResource(res->texOutput[outSlot].get(), res->texInput[slots[rccaps.PastFrames]].get());
+		}
+		else if (progressive) {
+			// TCY
+			stream.PastFrames = 0;
+			stream.FutureFrames = 0;
+			stream.OutputIndex = 0;
+			SetFrameFormat(D3D11_VIDEO_FRAME_FORMAT_PROGRESSIVE);
+			COM_CHECK(videoCtx->VideoProcessorBlt(
+				videoProc, res->outputViews[outSlot].get(), field, 1, &stream));
+		}
+		else {
+			// s
+			SetFrameFormat(InterlacedFrameFormat());
+			COM_CHECK(videoCtx->VideoProcessorBlt(
+				videoProc, res->outputViews[outSlot].get(), parity, 1, &stream));
+		}
+	}
+
+	void SetFieldOrder(bool tff)
+	{
+		// VideoProcessorSetStreamFrameFormatProcessŕςƂĂ
+		param.tff = tff;
+	}
+
+	void Download(BackendSurface* dst, int outSlot, ErrorHandler* env)
+	{
+		auto tex = static_cast<StagingTexture*>(dst);
+		DeviceLock lock(this, true);
+		// o͂ϊXbh̓A}bvɕԂ̂ŁAŃA}bv
+		if (tex->isMapped) {
+			devCtx->Unmap(tex->tex.get(), 0);
+			tex->isMapped = false;
+		}
+		// CPUɃRs[
+		devCtx->CopyResource(tex->tex.get(), res->texOutput[outSlot].get());
+	}
+
+	void BeginBatch()
+	{
+		batchLock.reset(new DeviceLock(this));
+	}
+
+	void EndBatch()
+	{
+		batchLock = nullptr;
+	}
+};
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <DXGI.h>
+#include <D3D11.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <tuple>
+#include <algorithm>
+
+#include "Thread.hpp"
+#include "Backend.hpp"
+
+struct ComDeleter {
+	void operator()(IUnknown* c) {
+		c->Release();
+	}
+};
+template <typename T> using PCom = std::unique_ptr<T, ComDeleter>;
+template <typename T> PCom<T> make_com_ptr(T* p) { return PCom<T>(p); }
+
+// ]peNX`
+struct D3D11StagingTexture : public BackendSurface {
+	PCom<ID3D11Texture2D> tex;
+	// ͗p̓}bv܂܂ɂĂio͗p̃Rs[܂Ń}bv܂܂̂Ƃj
+	// Ԃ̕ύX̓foCX̃bNčs
+	MappedSurface mapped;
+	std::atomic<bool> isMapped;
+
+	D3D11StagingTexture() : isMapped(false) { }
+};
+
+// A_v^iƃfoCXO[vjƂ̃foCX
+// C~fBGCgReLXg̓XbhZ[tłȂ̂ŁÃfoCXgSCX^XlockL
+struct D3D11Device : NonCopyable {
+	LUID luid;
+	int group;
+	PCom<ID3D11Device> dev;
+	PCom<ID3D11DeviceContext> devCtx;
+	PCom<ID3D11VideoDevice> videoDev;
+	PCom<ID3D11VideoContext> videoCtx;
+	CriticalSection lock;
+	std::atomic<bool> removed; // COM̌ĂяosăLbVO
+
+	D3D11Device() : group(0), removed(false) { }
+};
+
+// 1CX^XLVideoProcessorƃeNX`
+// planar formattexture array̓T|[gĂȂƂɒ
+struct D3D11Resources : NonCopyable {
+	PCom<ID3D11VideoProcessor> videoProc;
+
+	std::vector<std::unique_ptr<D3D11StagingTexture>> texInputCPU;
+	std::vector<std::unique_ptr<D3D11StagingTexture>> texOutputCPU;
+
+	std::vector<PCom<ID3D11Texture2D>> texInput;
+	std::vector<PCom<ID3D11VideoProcessorInputView>> inputViews;
+
+	// ꉞ񏈗ł悤ɏo͂pӂĂ
+	std::vector<PCom<ID3D11Texture2D>> texOutput;
+	std::vector<PCom<ID3D11VideoProcessorOutputView>> outputViews;
+
+	// }bv܂܂CPUeNX`A}bv
+	// foCX̃bNԂŌĂԂ
+	void UnmapAll(ID3D11DeviceContext* devCtx) {
+		for (auto* texs : { &texInputCPU, &texOutputCPU }) {
+			for (auto& tex : *texs) {
+				if (tex->isMapped) {
+					devCtx->Unmap(tex->tex.get(), 0);
+					tex->isMapped = false;
+				}
+			}
+		}
+	}
+};
+
+// VideoProcessorEnumeratorƁAݒ̃CX^Xg񂷃\[X
+// gĂCX^XiD3D11BackendjĂāAŌ̃CX^XjƂɉ
+struct D3D11Processor : NonCopyable {
+	enum {
+		MAX_IDLE = 2, // ێĂgĂȂ\[X̐
+	};
+
+	std::shared_ptr<D3D11Device> device;
+	PCom<ID3D11VideoProcessorEnumerator> videoProcEnum;
+	D3D11_VIDEO_PROCESSOR_CAPS caps;
+	D3D11_VIDEO_PROCESSOR_RATE_CONVERSION_CAPS rccaps;
+	int rateConversionIndex;
+
+	~D3D11Processor() {
+		auto& lock = with(device->lock);
+		for (auto& res : idle) {
+			res->UnmapAll(device->devCtx.get());
+		}
+	}
+
+	// gĂȂ\[XoiȂnullptrj
+	std::unique_ptr<D3D11Resources> TakeIdle() {
+		auto& lock = with(idleLock);
+		if (idle.size() == 0) {
+			return nullptr;
+		}
+		auto res = std::move(idle.back());
+		idle.pop_back();
+		return res;
+	}
+
+	// CX^XjƂɃ\[XԂiMAX_IDLE𒴂镪ƁAfoCXꂽꍇ͉j
+	// CPUeNX`̓}bv܂ܕԂĂ悢
+	void ReturnIdle(std::unique_ptr<D3D11Resources>&& res) {
+		if (!device->removed) {
+			auto& lock = with(idleLock);
+			if (idle.size() < MAX_IDLE) {
+				idle.push_back(std::move(res));
+				return;
+			}
+		}
+		auto& lock = with(device->lock);
+		res->UnmapAll(device->devCtx.get());
+		res = nullptr;
+	}
+
+private:
+	CriticalSection idleLock;
+	std::vector<std::unique_ptr<D3D11Resources>> idle;
+};
+
+// D3D11Processor̃L[iVideoProcessorEnumeratorƃ\[X̍쐬Ɏgݒj
+struct D3D11ProcessorKey {
+	std::string deviceName;
+	int deviceIndex;
+	int format;
+	int srcWidth, srcHeight;
+	int width, height;
+	int fpsNum, fpsDen;
+	int numFields;
+	int quality;
+	int tff;
+	int numInputStaging, numOutputStaging, numOutput;
+	int deviceGroup;
+
+	D3D11ProcessorKey(const BackendParam& p)
+		: deviceName(p.deviceName)
+		, deviceIndex(p.deviceIndex)
+		, format(p.format)
+		, srcWidth(p.srcWidth), srcHeight(p.srcHeight)
+		, width(p.width), height(p.height)
+		, fpsNum(p.fpsNum), fpsDen(p.fpsDen)
+		, numFields(p.numFields)
+		, quality(p.quality)
+		, tff(p.tff)
+		, numInputStaging(p.numInputStaging), numOutputStaging(p.numOutputStaging), numOutput(p.numOutput)
+		, deviceGroup(p.deviceGroup)
+	{ }
+
+	bool operator<(const D3D11ProcessorKey& o) const {
+		return Tie() < o.Tie();
+	}
+
+private:
+	std::tuple<const std::string&, int, int, int, int, int, int, int, int, int, int, int, int, int, int, int> Tie() const {
+		return std::tie(deviceName, deviceIndex, format, srcWidth, srcHeight, width, height,
+			fpsNum, fpsDen, numFields, quality, tff, numInputStaging, numOutputStaging, numOutput, deviceGroup);
+	}
+};
+
+// LbṼbN炸ɐǂ񂾂肷̂atomicɂ
+struct D3D11CacheStats {
+	std::atomic<int> deviceCreated;     // foCX쐬
+	std::atomic<int> processorCreated;  // A_v^񋓂VideoProcessorEnumerator쐬
+	std::atomic<int> processorHit;      // ݒVideoProcessorEnumerator
+	std::atomic<int> resourcesReused;   // gĂȂ\[Xg񂵂
+
+	D3D11CacheStats()
+		: deviceCreated(0)
+		, processorCreated(0)
+		, processorHit(0)
+		, resourcesReused(0)
+	{ }
+};
+
+// D3D11̃foCXVideoProcessorEnumerator̃vZXŜ̃LbV
+// XNvgŉxD3DVPĂłAA_v^̗񋓂ƃfoCX̍쐬͍ŏ1񂾂ōς
+// LbV͎QƂȂiweak_ptrĵŁAgĂCX^XSjꂽ
+// iDLL̃A[h̐ÓIIuWFNg̔jCOMIuWFNgȂ悤ɂ邽߁j
+// COM̌ĂяosfoCXEvictDeviceŃLbVOāA蒼CX^XgȂ悤ɂ
+class D3D11DeviceCache : NonCopyable
+{
+public:
+	static D3D11DeviceCache& Get() {
+		static D3D11DeviceCache cache;
+		return cache;
+	}
+
+	// ƒǉ͂̃bNčs
+	// ̂2Ȃ悤ɁA쐬bNĂ
+	CriticalSection& Lock() { return lock_; }
+
+	std::shared_ptr<D3D11Processor> FindProcessor(const D3D11ProcessorKey& key) {
+		auto it = processors_.find(key);
+		if (it == processors_.end()) {
+			return nullptr;
+		}
+		auto processor = it->second.lock();
+		if (!processor) {
+			processors_.erase(it);
+		}
+		return processor;
+	}
+
+	void AddProcessor(const D3D11ProcessorKey& key, const std::shared_ptr<D3D11Processor>& processor) {
+		processors_[key] = processor;
+	}
+
+	std::shared_ptr<D3D11Device> FindDevice(LUID luid, int group) {
+		RemoveExpiredDevices();
+		for (auto& weak : devices_) {
+			auto device = weak.lock();
+			if (device && device->group == group &&
+				device->luid.LowPart == luid.LowPart && device->luid.HighPart == luid.HighPart) {
+				return device;
+			}
+		}
+		return nullptr;
+	}
+
+	void AddDevice(const std::shared_ptr<D3D11Device>& device) {
+		devices_.push_back(device);
+	}
+
+	// foCXƁÃfoCXgVideoProcessorEnumeratorLbVO
+	// gĂCX^X͂̂܂܎Ă邪AVCX^Xɂ͎g킹Ȃ
+	void EvictDevice(const std::shared_ptr<D3D11Device>& device) {
+		auto& lock = with(lock_);
+		device->removed = true;
+		for (auto it = processors_.begin(); it != processors_.end();) {
+			auto processor = it->second.lock();
+			if (!processor || processor->device == device) {
+				it = processors_.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+		devices_.erase(std::remove_if(devices_.begin(), devices_.end(),
+			[&](const std::weak_ptr<D3D11Device>& weak) {
+				auto d = weak.lock();
+				return !d || d == device;
+			}), devices_.end());
+	}
+
+	D3D11CacheStats& Stats() { return stats_; }
+
+private:
+	CriticalSection lock_;
+	std::vector<std::weak_ptr<D3D11Device>> devices_;
+	std::map<D3D11ProcessorKey, std::weak_ptr<D3D11Processor>> processors_;
+	D3D11CacheStats stats_;
+
+	D3D11DeviceCache() { }
+
+	void RemoveExpiredDevices() {
+		devices_.erase(std::remove_if(devices_.begin(), devices_.end(),
+			[](const std::weak_ptr<D3D11Device>& weak) { return weak.expired(); }), devices_.end());
+	}
+};
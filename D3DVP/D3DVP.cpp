@@ -7,11 +7,8 @@
 #include <avisynth.h>
 
 #include <stdio.h>
-
-#include <initguid.h>
-#include <DXGI.h>
-#include <D3D11.h>
-#include <comdef.h>
+#include <limits.h>
+#include <float.h>
 
 #include <intrin.h>
 
@@ -34,41 +31,22 @@
 #define PRINTF(...)
 #endif
 
-#define COM_CHECK(call) \
-	do { \
-		HRESULT hr_ = call; \
-		if (FAILED(hr_)) { \
-			OnComError(hr_); \
-			env->ThrowError("[COM Error] %d: %s at %s:%d", hr_, \
-					_com_error(hr_).ErrorMessage(), __FILE__, __LINE__); \
-				} \
-		} while (0)
-
-void OnComError(HRESULT hr) {
-	PRINTF("[COM Error] %s (code: %d)\n", _com_error(hr).ErrorMessage(), hr);
-}
-
-struct ComDeleter {
-	void operator()(IUnknown* c) {
-		c->Release();
-	}
-};
-template <typename T> using PCom = std::unique_ptr<T, ComDeleter>;
-template <typename T> PCom<T> make_com_ptr(T* p) { return PCom<T>(p); }
-
-static std::vector<wchar_t> to_wstring(std::string str) {
-	if (str.size() == 0) {
-		return std::vector<wchar_t>(1);
-	}
-	int dstlen = MultiByteToWideChar(
-		CP_ACP, 0, str.c_str(), (int)str.size(), NULL, 0);
-	std::vector<wchar_t> ret(dstlen + 1);
-	MultiByteToWideChar(CP_ACP, 0,
-		str.c_str(), (int)str.size(), ret.data(), (int)ret.size());
-	ret.back() = 0; // null terminate
-	return ret;
-}
-
+// D3DVP_NO_D3D11`D3D11obNGhȂiCPUobNGĥ݁jŃrh
+// D3D11̃wb_D3D11Backend.hppCN[h
+#ifndef D3DVP_NO_D3D11
+#include <initguid.h> // D3D11GUID̖͂|PʂŒ`
+#include "D3D11Backend.hpp"
+#endif
+#include "CPUBackend.hpp"
+#include "ParallelConvert.hpp"
+#include "CacheWindow.hpp"
+#include "FramePool.hpp"
+#include "PipelineStats.hpp"
+#include "Tracer.hpp"
+#include "FrameAnalyzer.hpp"
+#include "SegmentParallel.hpp"
+
+#ifndef D3DVP_NO_D3D11
 static std::string to_string(std::wstring str) {
 	if (str.size() == 0) {
 		return std::string();
@@ -80,82 +58,87 @@ static std::string to_string(std::wstring str) {
 		str.c_str(), (int)str.size(), ret.data(), (int)ret.size(), NULL, NULL);
 	return std::string(ret.begin(), ret.end());
 }
-
-class CPUID {
-	bool avx2Enabled;
-public:
-	CPUID() : avx2Enabled(false) {
-		std::array<int, 4> cpui;
-		__cpuid(cpui.data(), 0);
-		int nIds_ = cpui[0];
-		if (7 <= nIds_) {
-			__cpuidex(cpui.data(), 7, 0);
-			std::bitset<32> f_7_EBX_ = cpui[1];
-			avx2Enabled = f_7_EBX_[5];
-		}
-	}
-	bool AVX2(void) { return avx2Enabled; }
-};
+#endif
 
 enum BorderFrame {
 	BORDER_COPY,
 	BORDER_BLANK,
 };
 
+// LbV̓v
+struct CacheStats {
+	int hit;   // vɏς݂
+	int miss;  // ҂
+	int reset; // pCvCZbg
+};
+
+// EH[AbṽXbhp
+// zXgIScriptEnvironment͕ʃXbhgȂ̂ŁAbZ[Wē
+struct WarmUpErrorHandler {
+	template <typename... Args>
+	void ThrowError(const char* fmt, Args... args) {
+		char buf[1024];
+		snprintf(buf, sizeof(buf), fmt, args...);
+		throw std::string(buf);
+	}
+};
+
+// tB[hI[_[̐؂ւ
+struct FieldOrderChange {
+	int frame; // ؂ւ̓t[
+	bool tff;
+
+	FieldOrderChange(int frame, bool tff) : frame(frame), tff(tff) { }
+};
+
+// N̓vi~bj
+struct StartupStats {
+	double initMs;       // obNGh̍쐬ƃXbh̊JnɂԁiȂ疢j
+	double firstFrameMs; // CX^X̍쐬ŏ̃t[Ԃ܂ŁiȂ疢ój
+	double firstWaitMs;  // ŏ̃t[̗vԂ܂
+	bool warmUp;         // EH[Abv
+};
+
 // ̋ʕNX
 template <typename FrameType, typename ErrorHandler>
 class D3DVP
 {
 protected:
 	enum {
+		PROCESS_BATCH = 4, // process1̃foCXbNł܂Ƃ߂ďő̓t[
 		NBUF_IN_FRAME = 4,
-		NBUF_IN_TEX = 4,
+		NBUF_IN_TEX = PROCESS_BATCH + 2, // toGPUprocess1āAcprocess̃L[ɓ
 		NBUF_OUT_TEX = 4,
 
+		IVTC_COMB_THRESH = 80, // IVTCcombw肵ȂƂ̌ǗtB[ĥl
+		FIELD_ORDER_HISTORY = 256, // ̓t[Ƃ̃tB[hI[_[oĂt[
+
 		INVALID_FRAME = -0xFFFF
 	};
 
-	DXGI_FORMAT format;
+	SurfaceFormat format;
+	BackendType backendType;
 	int mode, tff, quality;
 	std::string deviceName;
 	int deviceIndex;
+	int deviceGroup; // l̃CX^XD3D11foCXL
 	int cacheFrames;
 	int resetFrames;
 	int numCache;
 	int debug;
+	Tracer* tracer; // nullptrȂg[XȂ
 
 	VideoInfo srcvi;   // ̓tH[}bg
 	int width, height; // o̓TCY
 
-	PCom<ID3D11Device> dev;
-	PCom<ID3D11DeviceContext> devCtx;
-	PCom<ID3D11VideoDevice> videoDev;
-	PCom<ID3D11VideoProcessor> videoProc;
-	PCom<ID3D11VideoProcessorEnumerator> videoProcEnum;
-
-	D3D11_VIDEO_PROCESSOR_CAPS caps;
-	D3D11_VIDEO_PROCESSOR_RATE_CONVERSION_CAPS rccaps;
-
-	// planar formattexture array̓T|[gĂȂƂɒ
-	std::vector<PCom<ID3D11Texture2D>> texInputCPU;
-	std::vector<PCom<ID3D11Texture2D>> texOutputCPU;
-
-	std::vector<PCom<ID3D11Texture2D>> texInput;
-	std::vector<PCom<ID3D11VideoProcessorInputView>> inputViews;
-
-	// ꉞ񏈗ł悤ɏo͂pӂĂ
-	std::vector<PCom<ID3D11Texture2D>> texOutput;
-	std::vector<PCom<ID3D11VideoProcessorOutputView>> outputViews;
-
-	PCom<ID3D11VideoContext> videoCtx;
-
-	// devCtx(+videoCtx?)ĂяoƂɃbN擾
-	CriticalSection deviceLock;
+	std::shared_ptr<WorkerPool<ErrorHandler>> workerPool; // FϊCPU̕񉻗piSCX^XŋLj
+	std::unique_ptr<VPBackend<ErrorHandler>> backend;
 
 	CriticalSection inputTexPoolLock;
-	std::vector<ID3D11Texture2D*> inputTexPool;
+	std::deque<BackendSurface*> inputTexPool; // ă}bvԂɍ悤ɌÂɎg
 	CriticalSection outputTexPoolLock;
-	std::vector<ID3D11Texture2D*> outputTexPool;
+	CondWait outputTexPoolCond; // outputTexPoolɕԂꂽʒm
+	std::vector<BackendSurface*> outputTexPool;
 
 	struct FrameHeader {
 		ErrorHandler* env;
@@ -163,18 +146,21 @@ protected:
 		bool reset;
 		bool thread;
 		int n;
+		FrameInfo info;
 	};
 
 	template <typename T> struct FrameData : public FrameHeader {
-		FrameData() : FrameHeader(), data() { }
-		FrameData(const FrameHeader& o) : FrameHeader(o), data() { }
+		FrameData() : FrameHeader(), data(), next() { }
+		FrameData(const FrameHeader& o) : FrameHeader(o), data(), next() { }
 		T data;
+		T next; // IVTCŃtB[hgݍ킹鎟̓̓t[itoGPUXbhɓnƂj
 	};
 
-	class ToGPUThread : public DataPumpThread<FrameData<FrameType>, ErrorHandler, PRINT_WAIT> {
+	// eXbhւput͑Oi1Xbh炵Ȃ̂SPSCL[g
+	class ToGPUThread : public SPSCPumpThread<FrameData<FrameType>, ErrorHandler, PRINT_WAIT> {
 	public:
 		ToGPUThread(D3DVP* this_, ErrorHandler* env)
-			: DataPumpThread(NBUF_IN_FRAME - 2, env)
+			: SPSCPumpThread(NBUF_IN_FRAME - 2, env)
 			, this_(this_) { }
 	protected:
 		virtual void OnDataReceived(FrameData<FrameType>&& data) {
@@ -184,41 +170,144 @@ protected:
 		D3DVP* this_;
 	};
 
-	class ProcessThread : public DataPumpThread<FrameData<ID3D11Texture2D*>, ErrorHandler, PRINT_WAIT> {
+	class ProcessThread : public SPSCPumpThread<FrameData<BackendSurface*>, ErrorHandler, PRINT_WAIT> {
 	public:
 		ProcessThread(D3DVP* this_, ErrorHandler* env)
-			: DataPumpThread(NBUF_IN_TEX - 2, env)
-			, this_(this_) { }
+			: SPSCPumpThread(PROCESS_BATCH, env)
+			, this_(this_)
+		{
+			setMaxBatch(PROCESS_BATCH);
+		}
 	protected:
-		virtual void OnDataReceived(FrameData<ID3D11Texture2D*>&& data) {
+		virtual void OnDataReceived(FrameData<BackendSurface*>&& data) {
 			this_->processReceived(std::move(data));
 		}
+		virtual void OnBatchBegin() {
+			this_->BeginProcessBatch();
+		}
+		virtual void OnBatchEnd(int count) {
+			this_->EndProcessBatch(count);
+		}
 	private:
 		D3DVP* this_;
 	};
 
-	class FromGPUThread : public DataPumpThread<FrameData<ID3D11Texture2D*>, ErrorHandler, PRINT_WAIT> {
+	class FromGPUThread : public SPSCPumpThread<FrameData<BackendSurface*>, ErrorHandler, PRINT_WAIT> {
 	public:
 		FromGPUThread(D3DVP* this_, ErrorHandler* env)
-			: DataPumpThread(NBUF_OUT_TEX - 2, env)
+			: SPSCPumpThread(NBUF_OUT_TEX - 2, env)
 			, this_(this_) { }
 	protected:
-		virtual void OnDataReceived(FrameData<ID3D11Texture2D*>&& data) {
+		virtual void OnDataReceived(FrameData<BackendSurface*>&& data) {
 			this_->fromNV12Received(std::move(data));
 		}
 	private:
 		D3DVP* this_;
 	};
 
+	// zXgXNvgǂݍłԂɃobNGh߂ĂiPrimeBackendj
+	// ̃Xbhł̓zXgenvgȂiG[WarmUpErrorHandlerœj
+	class WarmUpThread : public ThreadBase<ErrorHandler> {
+	public:
+		WarmUpThread(D3DVP* this_, ErrorHandler* env)
+			: ThreadBase<ErrorHandler>(env)
+			, this_(this_)
+			, failed(false) { }
+		~WarmUpThread() {
+			this->join();
+		}
+		bool failed;
+		std::string message;
+		std::shared_ptr<void> hold; // ߂foCXƃ\[XiInitI܂ŎĂj
+	protected:
+		virtual void run() {
+			try {
+				TraceScope trace(this_->tracer, "WarmUp");
+				hold = this_->PrimeBackend();
+			}
+			catch (const std::string& e) {
+				failed = true;
+				message = e;
+			}
+			catch (const std::exception& e) {
+				failed = true;
+				message = e.what();
+			}
+			catch (...) {
+				failed = true;
+				message = "[D3DVP Error] unknown error in warm up";
+			}
+		}
+	private:
+		D3DVP* this_;
+	};
+
 	bool joinCalled;
 	ToGPUThread toGPUThread;
 	ProcessThread processThread;
 	FromGPUThread fromGPUThread;
+	std::unique_ptr<WarmUpThread> warmUpThread;
+	std::shared_ptr<void> warmUpHold; // EH[Abvŉ߂foCXƃ\[XiInitŎg܂ŉȂj
 
 	virtual FrameType GetChildFrame(int n, ErrorHandler* env) = 0;
 	virtual FrameType NewVideoFrame(ErrorHandler* env) = 0;
-	virtual void ToGPUFrame(FrameType& frame, D3D11_MAPPED_SUBRESOURCE res, ErrorHandler* env) = 0;
-	virtual void FromGPUFrame(FrameType& frame, D3D11_MAPPED_SUBRESOURCE res, ErrorHandler* env) = 0;
+	virtual void ToGPUFrame(FrameType& frame, MappedSurface res, ErrorHandler* env) = 0;
+	virtual void FromGPUFrame(FrameType& frame, MappedSurface res, ErrorHandler* env) = 0;
+	// parityi0: gbv, 1: {gj̃tB[h̍sށiIVTCpj
+	virtual void ToGPUField(FrameType& frame, MappedSurface res, int parity, ErrorHandler* env) {
+		env->ThrowError("[D3DVP Error] IVTC is not supported");
+	}
+
+	// O̓̓t[Ƃ̕ϐ΍i8bitZjԂBΉĂȂΕ̒l
+	virtual double FrameDiff(FrameType& cur, FrameType& prev, ErrorHandler* env) { return -1; }
+	// Ȃ̗ʁiFrameAnalyzer::CombScorejԂBΉĂȂΕ̒l
+	virtual int CombScore(FrameType& frame, ErrorHandler* env) { return -1; }
+	// ׂ荇2t[̃tB[hI[_[̔p̍iFrameAnalyzer::FieldOrderDiffjԂBΉĂȂfalse
+	virtual bool FieldOrderDiff(FrameType& cur, FrameType& next, double& tffDiff, double& bffDiff, ErrorHandler* env) { return false; }
+	// top̃gbvtB[hbottom̃{gtB[hgݍ킹t[̎Ȃ̗ʂԂBΉĂȂΕ̒l
+	virtual int WeaveCombScore(FrameType& top, FrameType& bottom, ErrorHandler* env) { return -1; }
+	// ͌ʂo̓t[ɕt
+	virtual void SetFrameInfo(FrameType& frame, const FrameInfo& info, ErrorHandler* env) { }
+	// o̓t[n󂯎ƂfromGPUXbhĂ΂ireceiveQɓOj
+	virtual void OnOutputFrame(int n, FrameType& frame, ErrorHandler* env) { }
+
+	// t[́iȂ疳j
+	float sceneThresh;  // Õt[Ƃ̍ȏȂV[`FW
+	float staticThresh; // Õt[Ƃ̍ȉȂÎ~t[
+	int combThresh;     // Ȃ̗ʂȉȂC^Ȃ
+	FrameType prevInput; // 邽߂̑O̓̓t[
+	int prevInputN;
+	bool autoFieldOrder; // tB[hI[_[͂画肷
+	FieldOrderDetector fieldOrder;
+
+	// IVTCitB[h}b`āAtB[hȂ΃C^BԈ͌Ăяoj
+	bool IsIVTC() const {
+		return mode == 2;
+	}
+
+	// O̓̓t[g
+	bool NeedPrevInput() const {
+		return sceneThresh >= 0 || staticThresh >= 0 || autoFieldOrder || IsIVTC();
+	}
+
+	bool AnalyzeEnabled() const {
+		return sceneThresh >= 0 || staticThresh >= 0 || combThresh >= 0 || autoFieldOrder || IsIVTC();
+	}
+
+	// IVTC̃tB[h}b`
+	// 1ڂ̃tB[hcāAOAÃt[̂̃tB[hȂԏȂȂ̂I
+	// prev: O̓̓t[iȂnullptrj, comb: I񂾑gݍ킹̎Ȃ̗
+	FieldMatch MatchFields(FrameType& cur, FrameType* prev, FrameType& next, bool tff, int& comb, ErrorHandler* env) {
+		FrameType* cands[3] = { prev, &cur, &next };
+		int combs[3];
+		for (int i = 0; i < 3; ++i) {
+			combs[i] = (cands[i] == nullptr) ? -1
+				: tff ? WeaveCombScore(cur, *cands[i], env) : WeaveCombScore(*cands[i], cur, env);
+		}
+		FieldMatch match = SelectFieldMatch(combs, (combThresh >= 0) ? combThresh : IVTC_COMB_THRESH);
+		comb = combs[((match == MATCH_NONE) ? MATCH_CUR : match) + 1];
+		return match;
+	}
 
 #if COUNT_FRAMES
 	int cntTo, cntReset, cntRecv, cntProc, cntFrom;
@@ -226,30 +315,84 @@ protected:
 
 	void toNV12Received(FrameData<FrameType>&& data) {
 		auto env = data.env;
-		FrameData<ID3D11Texture2D*> out = static_cast<FrameHeader>(data);
+		FrameData<BackendSurface*> out = static_cast<FrameHeader>(data);
 		out.data = nullptr;
 
 		if (data.exception == nullptr) {
+			PipelineStats::Scope scope(stats, STAGE_TO_GPU);
 			try {
 				{
 					auto& lock = with(inputTexPoolLock);
-					out.data = inputTexPool.back();
-					inputTexPool.pop_back();
+					out.data = inputTexPool.front();
+					inputTexPool.pop_front();
+				}
+
+				FrameType weave; // IVTC2ڂ̃tB[ht[
+				bool curTff = (tff != 0);
+				if (AnalyzeEnabled()) {
+					TraceScope trace(tracer, "analyze", data.n);
+					bool hasPrev = (prevInputN == data.n - 1);
+					if (NeedPrevInput()) {
+						if (hasPrev) {
+							if (sceneThresh >= 0 || staticThresh >= 0) {
+								out.info.diff = (float)FrameDiff(data.data, prevInput, env);
+							}
+							double tffDiff, bffDiff;
+							if (autoFieldOrder && FieldOrderDiff(prevInput, data.data, tffDiff, bffDiff, env)) {
+								fieldOrder.Add(tffDiff, bffDiff);
+							}
+						}
+						else {
+							// AĂȂ̂Ŕ蒼
+							fieldOrder.Reset();
+						}
+					}
+					if (autoFieldOrder) {
+						out.info.tff = fieldOrder.IsTFF() ? 1 : 0;
+						curTff = fieldOrder.IsTFF();
+						if (data.n >= 0) {
+							auto& lock = with(fieldOrderLock);
+							frameFieldOrder[data.n % FIELD_ORDER_HISTORY] = std::make_pair(data.n, out.info.tff);
+						}
+					}
+					if (IsIVTC()) {
+						out.info.match = MatchFields(data.data, hasPrev ? &prevInput : nullptr, data.next, curTff, out.info.comb, env);
+						if (out.info.match == MATCH_PREV) {
+							weave = prevInput;
+						}
+						else if (out.info.match == MATCH_NEXT) {
+							weave = data.next;
+						}
+					}
+					else if (combThresh >= 0) {
+						out.info.comb = CombScore(data.data, env);
+					}
+					if (NeedPrevInput()) {
+						prevInput = data.data;
+						prevInputN = data.n;
+					}
 				}
 
-				D3D11_MAPPED_SUBRESOURCE res;
+				// ]pT[tFX̓}bv܂܂Ȃ̂Œڏ
+				MappedSurface res;
+				{
+					TraceScope trace(tracer, "map input", data.n);
+					res = backend->GetInputMapping(out.data, env);
+				}
 				{
-					auto& lock = with(deviceLock);
-					COM_CHECK(devCtx->Map(out.data, 0, D3D11_MAP_WRITE, 0, &res));
+					TraceScope trace(tracer, "convert", data.n);
+					if (weave) {
+						// 1ڂ̃tB[h݂͌̃t[A2ڂ͑I񂾃t[
+						ToGPUField(data.data, res, curTff ? 0 : 1, env);
+						ToGPUField(weave, res, curTff ? 1 : 0, env);
+					}
+					else {
+						ToGPUFrame(data.data, res, env);
+					}
 				}
-				ToGPUFrame(data.data, res, env);
 #if COUNT_FRAMES
 				++cntTo;
 #endif
-				{
-					auto& lock = with(deviceLock);
-					devCtx->Unmap(out.data, 0);
-				}
 			}
 			catch (...) {
 				out.exception = std::current_exception();
@@ -258,6 +401,7 @@ protected:
 
 		if (out.thread) {
 			processThread.put(std::move(out));
+			stats.SampleQueue(QUEUE_PROCESS, (int)processThread.size());
 		}
 		else {
 			processReceived(std::move(out));
@@ -266,24 +410,109 @@ protected:
 
 	// processReceivedpf[^
 	std::deque<int> inputTexQueue;
+	std::deque<FrameInfo> inputInfoQueue; // inputTexQueue̊et[̉͌
+	int staticRun; // Õt[Ɠ̓t[̘A
+	int reusedFrames;
+	int progressiveFrames; // C^Ȃo̓t[
+	int backendTff; // obNGhɐݒ肵ĂtB[hI[_[
+	mutable CriticalSection fieldOrderLock;
+	std::vector<FieldOrderChange> fieldOrderLog;
+	std::vector<std::pair<int, int>> frameFieldOrder; // ̓t[ԍƂ̃tB[hI[_[iFIELD_ORDER_HISTORY̗]̈ʒuj
 	int processStartFrame;
 	int nextInputTex;
 	int nextOutputTex;
 	bool resetOutput;
-	std::vector<ID3D11VideoProcessorInputView*> pInputViews; // p|C^z
+	std::vector<int> inputSlots; // pXbgԍz
+	// ob`̓foCXbNĂ̂ŁAɂ͓nɗ߂Ă
+	// ifromGPUXbhMapbN҂Ăputi܂Ȃ߁j
+	bool processBatching;
+	std::vector<FrameData<BackendSurface*>> pendingOut;
+
+	void BeginProcessBatch() {
+		backend->BeginBatch();
+		processBatching = true;
+	}
+
+	void EndProcessBatch(int count) {
+		processBatching = false;
+		backend->EndBatch();
+		FlushProcessOutput();
+		stats.RecordBatch(count);
+	}
+
+	// ߂Ăo͂ɓniob`Ȃ烍bNxj
+	void FlushProcessOutput() {
+		if (pendingOut.empty()) {
+			return;
+		}
+		if (processBatching) {
+			backend->EndBatch();
+		}
+		for (auto& out : pendingOut) {
+			// O̓XbhgĂȂĂɗ
+			if (out.thread || out.exception != nullptr) {
+				fromGPUThread.put(std::move(out));
+				stats.SampleQueue(QUEUE_FROM_GPU, (int)fromGPUThread.size());
+			}
+			else {
+				fromNV12Received(std::move(out));
+			}
+		}
+		pendingOut.clear();
+		if (processBatching) {
+			backend->BeginBatch();
+		}
+	}
 
-	void processReceived(FrameData<ID3D11Texture2D*>&& data) {
+	// o͓]pT[tFX
+	// 󂢂ĂȂΗ߂Ăo͂ɓnāAfromGPUXbhԂ̂҂
+	BackendSurface* TakeOutputStaging() {
+		{
+			auto& lock = with(outputTexPoolLock);
+			if (outputTexPool.size() > 0) {
+				BackendSurface* surf = outputTexPool.back();
+				outputTexPool.pop_back();
+				return surf;
+			}
+		}
+		FlushProcessOutput();
+		BackendSurface* surf;
+		bool unlocked = false;
+		{
+			auto& lock = with(outputTexPoolLock);
+			while (outputTexPool.empty()) {
+				if (processBatching && !unlocked) {
+					// fromGPUXbhMapfoCXbN҂Ă邩Ȃ̂Ŏ
+					backend->EndBatch();
+					unlocked = true;
+				}
+				outputTexPoolCond.wait(outputTexPoolLock);
+			}
+			surf = outputTexPool.back();
+			outputTexPool.pop_back();
+		}
+		if (unlocked) {
+			backend->BeginBatch();
+		}
+		return surf;
+	}
+
+	void processReceived(FrameData<BackendSurface*>&& data) {
 		auto env = data.env;
-		FrameData<ID3D11Texture2D*> out = static_cast<FrameHeader>(data);
+		FrameData<BackendSurface*> out = static_cast<FrameHeader>(data);
 
 #if COUNT_FRAMES
 		++cntRecv;
 #endif
 		if (data.exception == nullptr) {
+			PipelineStats::Scope scope(stats, STAGE_PROCESS);
 			try {
+				int numInputTex = NumInputTex();
 				if (data.reset) {
 					inputTexQueue.clear();
-					processStartFrame = data.n + rccaps.PastFrames;
+					inputInfoQueue.clear();
+					staticRun = 0;
+					processStartFrame = data.n + backend->PastFrames();
 					nextInputTex = 0;
 					nextOutputTex = 0;
 					resetOutput = true;
@@ -294,89 +523,84 @@ protected:
 
 				// Vt[ǉGPUɃRs[
 				inputTexQueue.push_back(nextInputTex);
-				if (++nextInputTex >= (int)texInput.size()) {
+				inputInfoQueue.push_back(data.info);
+				bool isStatic = (staticThresh >= 0 && data.info.diff >= 0 && data.info.diff <= staticThresh);
+				staticRun = isStatic ? (staticRun + 1) : 0;
+				if (++nextInputTex >= numInputTex) {
 					nextInputTex = 0;
 				}
 				{
-					auto& lock = with(deviceLock);
-					devCtx->CopySubresourceRegion(
-						texInput[inputTexQueue.back()].get(), 0, 0, 0, 0, data.data, 0, NULL);
+					TraceScope trace(tracer, "upload", data.n);
+					backend->Upload(inputTexQueue.back(), data.data, env);
 				}
 
-				if (inputTexQueue.size() == texInput.size()) {
+				if ((int)inputTexQueue.size() == numInputTex) {
 					// Kvt[W܂
-
-					// pInputViews쐬
-					pInputViews.resize(texInput.size());
-					for (int i = 0; i < (int)texInput.size(); ++i) {
-						pInputViews[i] = inputViews[inputTexQueue[i]].get();
+					inputSlots.assign(inputTexQueue.begin(), inputTexQueue.end());
+
+					// o͂t[
+					const FrameInfo& info = inputInfoQueue[backend->PastFrames()];
+					// QƂ̓t[iƂ1OjSȂo͂Ȍo͂ƓɂȂ
+					bool reuse = !resetOutput && staticRun >= numInputTex;
+					// IVTCł̓tB[ht[͂̂܂܏o
+					bool progressive = IsIVTC()
+						? (info.match != MATCH_NONE)
+						: (combThresh >= 0 && info.comb >= 0 && info.comb <= combThresh);
+
+					if (info.tff >= 0 && info.tff != backendTff) {
+						int frame = data.n - backend->FutureFrames();
+						PRINTF("field order: %s from frame %d\n", info.tff ? "TFF" : "BFF", frame);
+						backend->SetFieldOrder(info.tff != 0);
+						backendTff = info.tff;
+						auto& lock = with(fieldOrderLock);
+						fieldOrderLog.push_back(FieldOrderChange(frame, info.tff != 0));
 					}
 
-					// stream쐬
-					D3D11_VIDEO_PROCESSOR_STREAM stream = { 0 };
-					stream.Enable = TRUE;
-					stream.PastFrames = rccaps.PastFrames;
-					stream.FutureFrames = rccaps.FutureFrames;
-
-					int findex = 0;
-					stream.ppPastSurfaces = pInputViews.data() + findex;
-					findex += rccaps.PastFrames;
-					stream.pInputSurface = pInputViews[findex++];
-					stream.ppFutureSurfaces = pInputViews.data() + findex;
-					findex += rccaps.FutureFrames;
-
 					int numFields = NumFramesPerBlock();
 					for (int parity = 0; parity < numFields; ++parity) {
-						stream.OutputIndex = parity;
-						stream.InputFrameOrField = (data.n - processStartFrame) * 2 + parity;
-
-						PRINTF("VideoProcessorBlt %d\n", data.n);
-						{
-							auto& lock = with(deviceLock);
-							if (debug) {
-								// \]p
-								devCtx->CopyResource(
-									texOutput[nextOutputTex].get(),
-									texInput[inputTexQueue[rccaps.PastFrames]].get());
+						out.info = info;
+						out.info.sceneChange = (parity == 0 && sceneThresh >= 0 && info.diff >= sceneThresh);
+						out.info.reuse = reuse;
+						out.info.deinterlaced = !progressive;
+						out.data = nullptr;
+						if (reuse) {
+							++reusedFrames;
+						}
+						else {
+							PRINTF("VideoProcessorBlt %d\n", data.n);
+							{
+								TraceScope trace(tracer, progressive ? "blt progressive" : "blt", data.n);
+								backend->Process(inputSlots.data(),
+									(data.n - processStartFrame) * 2 + parity, parity, nextOutputTex, progressive, env);
 							}
-							else {
-								// s
-								COM_CHECK(videoCtx->VideoProcessorBlt(
-									videoProc.get(), outputViews[nextOutputTex].get(), parity, 1, &stream));
+							if (progressive) {
+								++progressiveFrames;
 							}
 #if COUNT_FRAMES
 							++cntProc;
 #endif
-						}
-						{
-							auto& lock = with(outputTexPoolLock);
-							out.data = outputTexPool.back();
-							outputTexPool.pop_back();
-						}
+							out.data = TakeOutputStaging();
 
-						{
-							auto& lock = with(deviceLock);
 							// CPUɃRs[
-							devCtx->CopyResource(out.data, texOutput[nextOutputTex].get());
+							{
+								TraceScope trace(tracer, "readback", data.n);
+								backend->Download(out.data, nextOutputTex, env);
+							}
 						}
 
 						// ɓn
-						out.n = (data.n - rccaps.FutureFrames) * numFields + parity;
+						out.n = (data.n - backend->FutureFrames()) * numFields + parity;
 						out.reset = resetOutput;
-						if (out.thread) {
-							fromGPUThread.put(std::move(out));
-						}
-						else {
-							fromNV12Received(std::move(out));
-						}
+						pendingOut.push_back(out);
 
 						resetOutput = false;
-						if (++nextOutputTex >= (int)texOutput.size()) {
+						if (++nextOutputTex >= NBUF_OUT_TEX) {
 							nextOutputTex = 0;
 						}
 					}
 
 					inputTexQueue.pop_front();
+					inputInfoQueue.pop_front();
 				}
 			}
 			catch (...) {
@@ -392,7 +616,11 @@ protected:
 
 		// OĂ牺ɗ
 		if (out.exception != nullptr) {
-			fromGPUThread.put(std::move(out));
+			pendingOut.push_back(std::move(out));
+		}
+
+		if (!processBatching) {
+			FlushProcessOutput();
 		}
 	}
 
@@ -401,25 +629,53 @@ protected:
 	int waitingFrame;
 	std::deque<FrameData<FrameType>> receiveQ;
 
-	void fromNV12Received(FrameData<ID3D11Texture2D*>&& data) {
+	FrameType lastOutput[2]; // Î~t[Ŏg񂷑ȌóipeBƁj
+
+	void fromNV12Received(FrameData<BackendSurface*>&& data) {
 		auto env = data.env;
 		FrameData<FrameType> out = static_cast<FrameHeader>(data);
+		int parity = (NumFramesPerBlock() == 2) ? (data.n & 1) : 0;
 
-		if (data.exception == nullptr) {
+		if (data.reset) {
+			lastOutput[0] = FrameType();
+			lastOutput[1] = FrameType();
+		}
+
+		if (data.exception == nullptr && data.info.reuse) {
+			PipelineStats::Scope scope(stats, STAGE_FROM_GPU);
+			try {
+				if (!lastOutput[parity]) {
+					env->ThrowError("[D3DVP Error] no frame to reuse");
+				}
+				out.data = lastOutput[parity];
+				SetFrameInfo(out.data, data.info, env);
+			}
+			catch (...) {
+				out.exception = std::current_exception();
+			}
+		}
+		else if (data.exception == nullptr) {
+			PipelineStats::Scope scope(stats, STAGE_FROM_GPU);
 			try {
 				out.data = NewVideoFrame(env);
-				D3D11_MAPPED_SUBRESOURCE res;
+				MappedSurface res;
+				{
+					TraceScope trace(tracer, "map", data.n);
+					res = backend->Map(data.data, false, env);
+				}
 				{
-					auto& lock = with(deviceLock);
-					COM_CHECK(devCtx->Map(data.data, 0, D3D11_MAP_READ, 0, &res));
+					TraceScope trace(tracer, "convert out", data.n);
+					FromGPUFrame(out.data, res, env);
 				}
-				FromGPUFrame(out.data, res, env);
 #if COUNT_FRAMES
 				++cntFrom;
 #endif
-				{
-					auto& lock = with(deviceLock);
-					devCtx->Unmap(data.data, 0);
+				// A}bv͎Downloadł܂Ƃ߂čs
+				if (staticThresh >= 0) {
+					lastOutput[parity] = out.data;
+				}
+				if (AnalyzeEnabled()) {
+					SetFrameInfo(out.data, data.info, env);
 				}
 			}
 			catch (...) {
@@ -427,10 +683,20 @@ protected:
 			}
 		}
 
+		if (out.exception == nullptr) {
+			try {
+				OnOutputFrame(out.n, out.data, env);
+			}
+			catch (...) {
+				out.exception = std::current_exception();
+			}
+		}
+
 		// ̓t[
 		if (data.data != nullptr) {
 			auto& lock = with(outputTexPoolLock);
 			outputTexPool.push_back(data.data);
+			outputTexPoolCond.signal();
 		}
 
 		auto& lock = with(receiveLock);
@@ -446,6 +712,88 @@ protected:
 	int cacheStartFrame; // o̓t[ԍ
 	int nextInputFrame;  // ̓t[ԍ
 	int ignoreFrames;    // WaitFrameɖt[iZbĝ߁j
+	CacheWindow cacheWindow;
+	CacheStats cacheStats;
+	PipelineStats stats;
+
+	// obNGh̍쐬ƃXbh̊Jn͍ŏɕKvɂȂƂɂ
+	// iXNvg̓ǂݍ݂҂Ȃ߁j
+	CriticalSection initLock;
+	bool initialized;
+	bool filterSet; // OSetFilterĂ΂ꂽ
+	bool filterAutop;
+	int filterNr, filterEdge;
+	int64_t createTime;
+	StartupStats startupStats;
+
+	// tR}p
+	// ς݂̃ubNbackQɈڂāApCvCł͂̑ÕubNĂ
+	// pCvC͑O珇ɂłȂ̂ŁAubN̒͏ɏ
+	std::deque<FrameData<FrameType>> backQ;
+	int backStartFrame; // backQ[0]̏o̓t[ԍ
+	int blockInputEnd;  // ̃ubNœ̓t[̏I[
+
+	void PutFrames(int start, int end, bool reset, bool thread, ErrorHandler* env) {
+		FrameType next; // IVTCőÕt[nextƂĎ擾t[
+		for (int i = start; i < end; ++i, reset = false) {
+			FrameData<FrameType> data;
+			data.env = env;
+			data.reset = reset;
+			data.thread = thread;
+			data.n = i;
+			{
+				TraceScope trace(tracer, "GetChildFrame", i);
+				data.data = next ? next : GetChildFrame(i, env);
+				if (IsIVTC()) {
+					data.next = GetChildFrame(i + 1, env);
+					next = data.next;
+				}
+			}
+			if (data.thread) {
+				toGPUThread.put(std::move(data));
+				stats.SampleQueue(QUEUE_TO_GPU, (int)toGPUThread.size());
+			}
+			else {
+				toNV12Received(std::move(data));
+			}
+		}
+		nextInputFrame = std::max(nextInputFrame, end);
+	}
+
+	// ꂽt[̏SI܂ő҂
+	void DrainFrames(bool thread, ErrorHandler* env) {
+		int numFields = NumFramesPerBlock();
+		// ZbgŎ̂Ăt[܂ło͂Ȃꍇ́A̎̃t[oƂ܂œ
+		int minInput = (cacheStartFrame + ignoreFrames + numFields) / numFields + backend->PastFrames();
+		if (nextInputFrame < minInput) {
+			PutFrames(nextInputFrame, minInput, false, thread, env);
+		}
+		WaitFrame((nextInputFrame - backend->PastFrames()) * numFields - 1, env);
+	}
+
+	// ̃ubNbackQɈڂāȂÕubN̏n߂
+	void StartBackwardBlock(int blockFrames, bool thread, ErrorHandler* env) {
+		int numFields = NumFramesPerBlock();
+		if (cacheStartFrame <= 0) {
+			return;
+		}
+		DrainFrames(thread, env);
+		{
+			auto& lock = with(receiveLock);
+			backStartFrame = cacheStartFrame;
+			backQ.swap(receiveQ);
+			receiveQ.clear();
+		}
+		int blockStart = backStartFrame / numFields - (blockFrames + resetFrames);
+		cacheStartFrame = blockStart * numFields;
+		ignoreFrames = resetFrames;
+		// backStartFrame̒Õt[o͂Ƃ܂œ
+		blockInputEnd = (backStartFrame - 1) / numFields + backend->FutureFrames() + 1;
+		nextInputFrame = blockStart - backend->PastFrames();
+		++cacheStats.reset;
+		PRINTF("Backward Block %d\n", cacheStartFrame);
+		PutFrames(nextInputFrame, nextInputFrame + 1, true, thread, env);
+	}
 
 	void PutInputFrame(int n, bool thread, ErrorHandler* env) {
 		int numFields = NumFramesPerBlock();
@@ -453,36 +801,65 @@ protected:
 		bool reset = false;
 		int inputStart = nextInputFrame;
 		int nsrc = n / numFields;
-		if (cacheStartFrame == INVALID_FRAME || n < cacheStartFrame || nsrc > nextInputFrame + (procAhead + cacheFrames + resetFrames)) {
+
+		// ANZXp^[ɍ킹ĕێt[Ɛǂݖς
+		cacheWindow.Request(nsrc);
+		int backFrames = cacheWindow.BackFrames();
+		int aheadFrames = cacheWindow.AheadFrames(procAhead, backend->FutureFrames() + 1);
+		{
+			auto& lock = with(receiveLock);
+			// tubN̓ZbgŎ̂Ă镪܂߂đS󂯎Ăĝł̕Ă
+			numCache = (procAhead + backFrames + resetFrames) * numFields;
+		}
+
+		if (backQ.size() > 0) {
+			if (n >= backStartFrame && n < backStartFrame + (int)backQ.size()) {
+				// ς݃ubNԂ
+				// c̃R}̊ԂɑÕubN̏I悤ɏ
+				++cacheStats.hit;
+				int pending = blockInputEnd - nextInputFrame;
+				if (pending > 0) {
+					int remaining = std::max(1, n - backStartFrame);
+					PutFrames(nextInputFrame, nextInputFrame + (pending + remaining - 1) / remaining, false, thread, env);
+				}
+				return;
+			}
+			// ubN̊Oɏo畁ʂ̏ɖ߂
+			backQ.clear();
+		}
+
+		// tubN̏̓Zbg̎̂Ăt[cĂ邱Ƃ̂ŁA͈͊̕OƂ
+		if (cacheStartFrame == INVALID_FRAME || n < cacheStartFrame + ignoreFrames || nsrc > nextInputFrame + (procAhead + backFrames + resetFrames)) {
 			// Zbg
 			if (nextInputFrame != INVALID_FRAME) {
 				// ꂽt[̏SI܂ő҂
-				WaitFrame((nextInputFrame - rccaps.PastFrames) * numFields - 1, env);
+				DrainFrames(thread, env);
 				auto& lock = with(receiveLock);
 				receiveQ.clear();
 			}
 			reset = true;
-			nextInputFrame = nsrc - (cacheFrames + resetFrames);
+			++cacheStats.reset;
+			nextInputFrame = nsrc - (backFrames + resetFrames);
 			cacheStartFrame = nextInputFrame * numFields;
-			inputStart = nextInputFrame - rccaps.PastFrames;
+			inputStart = nextInputFrame - backend->PastFrames();
 			ignoreFrames = resetFrames;
 			PRINTF("Input Reset %d\n", n);
 		}
-		nextInputFrame = std::max(nextInputFrame, nsrc + procAhead);
-		for (int i = inputStart; i < nextInputFrame; ++i, reset = false) {
-			FrameData<FrameType> data;
-			data.env = env;
-			data.reset = reset;
-			data.thread = thread;
-			data.n = i;
-			data.data = GetChildFrame(i, env);
-			if (data.thread) {
-				toGPUThread.put(std::move(data));
+		else {
+			auto& lock = with(receiveLock);
+			int idx = n - cacheStartFrame;
+			if (idx < (int)receiveQ.size()) {
+				++cacheStats.hit;
 			}
 			else {
-				toNV12Received(std::move(data));
+				++cacheStats.miss;
 			}
 		}
+		PutFrames(inputStart, std::max(nextInputFrame, nsrc + aheadFrames), reset, thread, env);
+
+		if (cacheWindow.Pattern() == ACCESS_BACKWARD) {
+			StartBackwardBlock(backFrames, thread, env);
+		}
 	}
 
 	void DropFrame(ErrorHandler* env) {
@@ -494,11 +871,20 @@ protected:
 	}
 
 	FrameType WaitFrame(int n, ErrorHandler* env) {
+		PipelineStats::Scope scope(stats, STAGE_WAIT);
+		TraceScope trace(tracer, "WaitFrame", n);
+		if (n >= backStartFrame && n < backStartFrame + (int)backQ.size()) {
+			auto& data = backQ[n - backStartFrame];
+			if (data.exception) {
+				std::rethrow_exception(data.exception);
+			}
+			return data.data;
+		}
 		while (true) {
 			auto& lock = with(receiveLock);
 			// Zbg̃t[͎̂Ă
-			for (; ignoreFrames; --ignoreFrames) DropFrame(env);
-			int idx = n - receiveQ.front().n;
+			for (; ignoreFrames && receiveQ.size() > 0; --ignoreFrames) DropFrame(env);
+			int idx = (receiveQ.size() > 0) ? (n - receiveQ.front().n) : INT_MAX;
 			if (idx < (int)receiveQ.size()) {
 				auto data = receiveQ[idx];
 				if (data.exception) {
@@ -517,237 +903,180 @@ protected:
 		}
 	}
 
-	void CreateProcessor(ErrorHandler* env)
+	BackendParam MakeBackendParam()
 	{
-		auto wname = to_wstring(deviceName);
-
-		// DXGIt@Ng쐬
-		IDXGIFactory1 * pFactory_;
-		COM_CHECK(CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void**)&pFactory_));
-		auto pFactory = make_com_ptr(pFactory_);
-
-		// A_v^
-		IDXGIAdapter * pAdapter_;
-		int dIndex = 0;
-		for (int i = 0; pFactory->EnumAdapters(i, &pAdapter_) != DXGI_ERROR_NOT_FOUND; ++i) {
-			auto pAdapter = make_com_ptr(pAdapter_);
-
-			DXGI_ADAPTER_DESC desc;
-			COM_CHECK(pAdapter->GetDesc(&desc));
+		BackendParam param;
+		param.format = format;
+		param.srcWidth = srcvi.width;
+		param.srcHeight = srcvi.height;
+		param.fpsNum = srcvi.fps_numerator;
+		param.fpsDen = srcvi.fps_denominator;
+		param.width = width;
+		param.height = height;
+		param.tff = tff;
+		param.numFields = NumFramesPerBlock();
+		param.quality = quality;
+		param.deviceName = deviceName;
+		param.deviceIndex = deviceIndex;
+		param.deviceGroup = deviceGroup;
+		param.numInputStaging = NBUF_IN_TEX;
+		param.numOutputStaging = NBUF_OUT_TEX;
+		param.numOutput = NBUF_OUT_TEX;
+		param.debug = debug;
+		param.tracer = tracer;
+		param.stats = &stats;
+		return param;
+	}
 
-			PRINTF("%ls\n", desc.Description);
-			if (deviceName.size() > 0) { // w肪
-				if (memcmp(wname.data(), desc.Description, std::min(wname.size(), sizeof(desc.Description) / sizeof(desc.Description[0])))) {
+	// EH[AbviEH[AbṽXbhŌĂ΂j
+	// ݒ̈ꎞIȃobNGhāAZbgɎ̂Ăt[ƑO̎Qƃt[̕
+	// ̃t[i]pT[tFX̒ĝ܂܁j]EE󂯎܂ŗĂ
+	// foCXVideoProcessorEnumeratorD3D11DeviceCacheɁAVideoProcessorƃeNX`͎g񂵗p̃\[XƂĎĉŁA
+	// ŏ̃t[Init͂gōς݁Aŏ̏ŕhCȍōς܂Ă
+	// ̓Nbṽt[͎擾ȂizXg̃XbhȊO擾Ȃ߁j
+	// ߂l͉߂̂Ă߂̎QƁiInitI܂ŎĂƁj
+	// CPUobNGh͍쐬yĎg񂷂̂Ȃ̂ŉȂ
+	std::shared_ptr<void> PrimeBackend()
+	{
+#ifndef D3DVP_NO_D3D11
+		if (backendType == BACKEND_D3D11) {
+			WarmUpErrorHandler env;
+			BackendParam param = MakeBackendParam();
+			param.stats = nullptr; // ̓vɂ͓Ȃ
+			D3D11Backend<WarmUpErrorHandler> warm;
+			warm.Create(param, &env);
+			int numFields = NumFramesPerBlock();
+			int numSlots = warm.PastFrames() + warm.FutureFrames() + 1;
+			std::vector<int> slots(numSlots);
+			for (int i = 0; i < resetFrames + numSlots; ++i) {
+				BackendSurface* staging = warm.GetInputStaging(i % param.numInputStaging);
+				warm.GetInputMapping(staging, &env);
+				warm.Upload(i % numSlots, staging, &env);
+				if (i < numSlots - 1) {
 					continue;
 				}
+				for (int k = 0; k < numSlots; ++k) {
+					slots[k] = (i - numSlots + 1 + k) % numSlots;
+				}
+				for (int parity = 0; parity < numFields; ++parity) {
+					int outSlot = (i * numFields + parity) % param.numOutput;
+					warm.Process(slots.data(), i * 2 + parity, parity, outSlot, false, &env);
+					BackendSurface* outStaging = warm.GetOutputStaging(outSlot);
+					warm.Download(outStaging, outSlot, &env);
+					warm.Map(outStaging, false, &env);
+					warm.Unmap(outStaging);
+				}
 			}
-			if (dIndex != deviceIndex) {
-				dIndex++;
-				continue;
-			}
-
-			// D3D11foCX쐬
-			ID3D11Device* pDevice_;
-			ID3D11DeviceContext* pContext_;
-			const D3D_FEATURE_LEVEL featureLevels[] = {
-				D3D_FEATURE_LEVEL_11_1,
-				D3D_FEATURE_LEVEL_11_0,
-				D3D_FEATURE_LEVEL_10_1,
-				D3D_FEATURE_LEVEL_10_0,
-				D3D_FEATURE_LEVEL_9_3,
-			};
-#ifndef _DEBUG
-			int flags = 0;
-#else
-			int flags = D3D11_CREATE_DEVICE_DEBUG;
+			// warmjƃ\[X͎g񂵗pɕԂ
+			return warm.GetProcessor();
+		}
 #endif
-			COM_CHECK(D3D11CreateDevice(pAdapter.get(),
-				D3D_DRIVER_TYPE_UNKNOWN, // A_v^w̏ꍇUNKNOWN
-				NULL,
-				flags,
-				featureLevels,
-				sizeof(featureLevels) / sizeof(featureLevels[0]),
-				D3D11_SDK_VERSION,
-				&pDevice_,
-				NULL,
-				&pContext_));
-			auto pDevice = make_com_ptr(pDevice_);
-			auto pContext = make_com_ptr(pContext_);
-
-			// rfIfoCX쐬
-			ID3D11VideoDevice* pVideoDevice_;
-			if (FAILED(pDevice->QueryInterface(&pVideoDevice_))) {
-				// VideoDeviceT|[g
-				continue;
-			}
-			auto pVideoDevice = make_com_ptr(pVideoDevice_);
-
-			D3D11_VIDEO_PROCESSOR_CONTENT_DESC vdesc = {};
-			vdesc.InputFrameFormat = tff
-				? D3D11_VIDEO_FRAME_FORMAT_INTERLACED_TOP_FIELD_FIRST
-				: D3D11_VIDEO_FRAME_FORMAT_INTERLACED_BOTTOM_FIELD_FIRST;
-			vdesc.InputFrameRate.Numerator = srcvi.fps_numerator;
-			vdesc.InputFrameRate.Denominator = srcvi.fps_denominator;
-			vdesc.InputHeight = srcvi.height;
-			vdesc.InputWidth = srcvi.width;
-			vdesc.OutputFrameRate.Numerator = srcvi.fps_numerator * NumFramesPerBlock();
-			vdesc.OutputFrameRate.Denominator = srcvi.fps_denominator;
-			vdesc.OutputHeight = height;
-			vdesc.OutputWidth = width;
-
-			if (quality == 0) {
-				PRINTF("[D3DVP] Quality: Speed\n");
-				vdesc.Usage = D3D11_VIDEO_USAGE_OPTIMAL_SPEED;
-			}
-			else if (quality == 1) {
-				PRINTF("[D3DVP] Quality: Normal\n");
-				vdesc.Usage = D3D11_VIDEO_USAGE_PLAYBACK_NORMAL;
-			}
-			else { // quality == 2
-				PRINTF("[D3DVP] Quality: Quality\n");
-				vdesc.Usage = D3D11_VIDEO_USAGE_OPTIMAL_QUALITY;
-			}
-
-			// VideoProcessorEnumerator쐬
-			ID3D11VideoProcessorEnumerator* pEnum_;
-			COM_CHECK(pVideoDevice->CreateVideoProcessorEnumerator(&vdesc, &pEnum_));
-			auto pEnum = make_com_ptr(pEnum_);
-
-			D3D11_VIDEO_PROCESSOR_CAPS caps;
-			COM_CHECK(pEnum->GetVideoProcessorCaps(&caps));
-			for (int rci = 0; rci < (int)caps.RateConversionCapsCount; ++rci) {
-				D3D11_VIDEO_PROCESSOR_RATE_CONVERSION_CAPS rccaps;
-				COM_CHECK(pEnum->GetVideoProcessorRateConversionCaps(rci, &rccaps));
-				ID3D11VideoProcessor* pVideoProcessor_;
-				COM_CHECK(pVideoDevice->CreateVideoProcessor(pEnum.get(), rci, &pVideoProcessor_));
-				auto pVideoProcessor = make_com_ptr(pVideoProcessor_);
-
-				dev = std::move(pDevice);
-				devCtx = std::move(pContext);
-				videoDev = std::move(pVideoDevice);
-				videoProcEnum = std::move(pEnum);
-				videoProc = std::move(pVideoProcessor);
-				this->caps = caps;
-				this->rccaps = rccaps;
-
-				ID3D11VideoContext* pVideoCtx_;
-				COM_CHECK(devCtx->QueryInterface(&pVideoCtx_));
-				videoCtx = make_com_ptr(pVideoCtx_);
+		return nullptr;
+	}
 
-				return;
-				/*
-				for (int k = 0; k < rccaps.CustomRateCount; ++k) {
-				D3D11_VIDEO_PROCESSOR_CUSTOM_RATE customRate;
-				COM_CHECK(pEnum->GetVideoProcessorCustomRate(rci, k, &customRate));
-				PRINTF("%d-%d rate: %d/%d %d -> %d (interladed: %d)\n", rci, k,
-				customRate.CustomRate.Numerator, customRate.CustomRate.Denominator,
-				customRate.InputFramesOrFields, customRate.OutputFrames, customRate.InputInterlaced);
-				}
-				*/
+	// EH[AbvȂÎ҂
+	// EH[AbvŎsĂAG[InitŃzXgenvôłł͓Ȃ
+	void FinishWarmUp()
+	{
+		if (warmUpThread) {
+			warmUpThread->join();
+			if (warmUpThread->failed) {
+				PRINTF("[D3DVP] warm up failed: %s\n", warmUpThread->message.c_str());
 			}
+			warmUpHold = warmUpThread->hold;
+			warmUpThread = nullptr;
 		}
-
-		env->ThrowError("No such device ...");
 	}
 
-	void CreateResources(ErrorHandler* env)
+	void CreateBackend(ErrorHandler* env)
 	{
-		// KvȃeNX`
-		int numInputTex = rccaps.FutureFrames + rccaps.PastFrames + 1;
-		PRINTF("[D3DVP] PastFrames: %d, FutureFrames: %d\n", rccaps.PastFrames, rccaps.FutureFrames);
-
-		D3D11_TEXTURE2D_DESC desc = {};
-		desc.Width = srcvi.width;
-		desc.Height = srcvi.height;
-		desc.MipLevels = 1;
-		desc.ArraySize = 1;
-		desc.Format = format;
-		// restriction: no anti-aliasing
-		desc.SampleDesc.Count = 1;
-		desc.SampleDesc.Quality = 0;
-		// restriction: D3D11_USAGE_DEFAULT
-		desc.Usage = D3D11_USAGE_DEFAULT;
-		// no bind flag is OK for video processing input
-		desc.BindFlags = 0;
-		desc.CPUAccessFlags = 0;
-		desc.MiscFlags = 0;
-
-		// ͗peNX`
-		texInput.resize(numInputTex);
-		for (int i = 0; i < numInputTex; ++i) {
-			ID3D11Texture2D* pTexInput_;
-			COM_CHECK(dev->CreateTexture2D(&desc, NULL, &pTexInput_));
-			texInput[i] = make_com_ptr(pTexInput_);
-		}
-
-		// o͗peNX`
-		desc.Width = width;
-		desc.Height = height;
-		// output must be D3D11_BIND_RENDER_TARGET
-		desc.BindFlags = D3D11_BIND_RENDER_TARGET;
-
-		texOutput.resize(NBUF_OUT_TEX);
-		for (int i = 0; i < NBUF_OUT_TEX; ++i) {
-			ID3D11Texture2D* pTexOutput_;
-			COM_CHECK(dev->CreateTexture2D(&desc, NULL, &pTexOutput_));
-			texOutput[i] = make_com_ptr(pTexOutput_);
+		switch (backendType) {
+		case BACKEND_CPU:
+			backend = std::unique_ptr<VPBackend<ErrorHandler>>(
+				new CPUBackend<ErrorHandler>(workerPool.get(), GetSimdLevel() >= SIMD_AVX2));
+			break;
+		default:
+#ifdef D3DVP_NO_D3D11
+			env->ThrowError("[D3DVP Error] this build does not support d3d11 backend");
+#else
+			backend = std::unique_ptr<VPBackend<ErrorHandler>>(new D3D11Backend<ErrorHandler>());
+#endif
+			break;
 		}
 
-		// ͗pCPUeNX`
-		desc.Width = srcvi.width;
-		desc.Height = srcvi.height;
-		desc.Usage = D3D11_USAGE_STAGING;
-		desc.BindFlags = 0;
-		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		backend->Create(MakeBackendParam(), env);
 
-		texInputCPU.resize(NBUF_IN_TEX);
 		for (int i = 0; i < NBUF_IN_TEX; ++i) {
-			ID3D11Texture2D* pTexInputCPU_;
-			COM_CHECK(dev->CreateTexture2D(&desc, NULL, &pTexInputCPU_));
-			texInputCPU[i] = make_com_ptr(pTexInputCPU_);
-			inputTexPool.push_back(pTexInputCPU_);
+			inputTexPool.push_back(backend->GetInputStaging(i));
 		}
-
-		// o͗pCPUeNX`
-		desc.Width = width;
-		desc.Height = height;
-		desc.Usage = D3D11_USAGE_STAGING;
-		desc.BindFlags = 0;
-		desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-
-		texOutputCPU.resize(NBUF_OUT_TEX);
 		for (int i = 0; i < NBUF_OUT_TEX; ++i) {
-			ID3D11Texture2D* pTexOutputCPU_;
-			COM_CHECK(dev->CreateTexture2D(&desc, NULL, &pTexOutputCPU_));
-			texOutputCPU[i] = make_com_ptr(pTexOutputCPU_);
-			outputTexPool.push_back(pTexOutputCPU_);
+			outputTexPool.push_back(backend->GetOutputStaging(i));
+		}
+	}
+
+	// obNGh쐬ăXbhJniς݂Ȃ牽Ȃj
+	void Init(ErrorHandler* env)
+	{
+		auto& lock = with(initLock);
+		if (initialized) {
+			return;
 		}
+		TraceScope trace(tracer, "Init");
+		int64_t start = GetPerfCounter();
 
-		// InputView쐬
-		for (int i = 0; i < numInputTex; ++i) {
-			ID3D11VideoProcessorInputView* pInputView_;
-			D3D11_VIDEO_PROCESSOR_INPUT_VIEW_DESC inputViewDesc = { 0 };
-			inputViewDesc.ViewDimension = D3D11_VPIV_DIMENSION_TEXTURE2D;
-			COM_CHECK(videoDev->CreateVideoProcessorInputView(
-				texInput[i].get(), videoProcEnum.get(), &inputViewDesc, &pInputView_));
-			inputViews.emplace_back(pInputView_);
+		inputTexPool.clear();
+		outputTexPool.clear();
+		CreateBackend(env);
+		if (filterSet) {
+			backend->SetFilter(filterAutop, filterNr, filterEdge, env);
 		}
 
-		// OutputView쐬
-		for (int i = 0; i < NBUF_OUT_TEX; ++i) {
-			ID3D11VideoProcessorOutputView* pOutputView_;
-			D3D11_VIDEO_PROCESSOR_OUTPUT_VIEW_DESC outputViewDesc = { D3D11_VPOV_DIMENSION_TEXTURE2D };
-			outputViewDesc.Texture2D.MipSlice = 0;
-			COM_CHECK(videoDev->CreateVideoProcessorOutputView(
-				texOutput[i].get(), videoProcEnum.get(), &outputViewDesc, &pOutputView_));
-			outputViews.emplace_back(pOutputView_);
+		numCache = (NumFramesProcAhead() + cacheFrames) * NumFramesPerBlock();
+
+		toGPUThread.start();
+		processThread.start();
+		fromGPUThread.start();
+
+		initialized = true;
+		startupStats.initMs = (double)(GetPerfCounter() - start) * 1000 / GetPerfFrequency();
+		warmUpHold = nullptr;
+	}
+
+	// o̓t[nԂihNXGetFrameĂԁj
+	FrameType GetOutputFrame(int n, bool thread, ErrorHandler* env)
+	{
+		int64_t start = GetPerfCounter();
+		FinishWarmUp();
+		Init(env);
+		PutInputFrame(n, thread, env);
+		FrameType frame = WaitFrame(n, env);
+		if (startupStats.firstFrameMs < 0) {
+			int64_t now = GetPerfCounter();
+			startupStats.firstFrameMs = (double)(now - createTime) * 1000 / GetPerfFrequency();
+			startupStats.firstWaitMs = (double)(now - start) * 1000 / GetPerfFrequency();
+			PRINTF("[D3DVP] startup: init %.1fms, first frame %.1fms (wait %.1fms)\n",
+				startupStats.initMs, startupStats.firstFrameMs, startupStats.firstWaitMs);
+		}
+		return frame;
+	}
+
+	// ʃXbhŃobNGh߂ĂiPrimeBackendj
+	// ŏGetOutputFrame͂ꂪÎ҂
+	void StartWarmUpThread(ErrorHandler* env)
+	{
+		if (initialized || warmUpThread || backendType != BACKEND_D3D11) {
+			return;
 		}
+		startupStats.warmUp = true;
+		warmUpThread = std::unique_ptr<WarmUpThread>(new WarmUpThread(this, env));
+		warmUpThread->start();
 	}
 
 public:
-	D3DVP(VideoInfo srcvi, DXGI_FORMAT format, int mode, int tff, int width, int height, int quality,
-		const std::string& deviceName, int deviceIndex, int cache, int reset, int debug, ErrorHandler* env)
+	D3DVP(VideoInfo srcvi, SurfaceFormat format, BackendType backendType, int mode, int tff, int width, int height, int quality,
+		const std::string& deviceName, int deviceIndex, int cache, int reset, int debug, Tracer* tracer, ErrorHandler* env)
 		: format(format)
+		, backendType(backendType)
 		, mode(mode)
 		, tff(tff)
 		, width(width)
@@ -755,29 +1084,55 @@ public:
 		, quality(quality)
 		, deviceName(deviceName)
 		, deviceIndex(deviceIndex)
+		, deviceGroup(0)
 		, cacheFrames(cache)
 		, resetFrames(reset)
 		, debug(debug)
+		, tracer(tracer)
 		, srcvi(srcvi)
+		, workerPool(WorkerPool<ErrorHandler>::GetShared(env))
+		, initialized(false)
+		, filterSet(false)
+		, filterAutop(false)
+		, filterNr(-1)
+		, filterEdge(-1)
+		, createTime(GetPerfCounter())
 		, joinCalled(false)
 		, toGPUThread(this, env)
 		, processThread(this, env)
 		, fromGPUThread(this, env)
+		, sceneThresh(-1)
+		, staticThresh(-1)
+		, combThresh(-1)
+		, prevInputN(INVALID_FRAME)
+		, autoFieldOrder(false)
+		, fieldOrder(tff != 0)
+		, staticRun(0)
+		, reusedFrames(0)
+		, progressiveFrames(0)
+		, backendTff(tff)
+		, frameFieldOrder(FIELD_ORDER_HISTORY, std::make_pair((int)INVALID_FRAME, -1))
+		, processBatching(false)
 		, waitingFrame(INVALID_FRAME)
 		, cacheStartFrame(INVALID_FRAME)
 		, nextInputFrame(INVALID_FRAME)
 		, ignoreFrames(0)
+		, cacheWindow(cache)
+		, backStartFrame(INVALID_FRAME)
+		, blockInputEnd(INVALID_FRAME)
 	{
 		if (deviceIndex < 0) env->ThrowError("[D3DVP Error] deviceIndex must be >= 0");
-		if (mode != 0 && mode != 1) env->ThrowError("[D3DVP Error] mode must be 0 or 1");
+		if (mode < 0 || mode > 2) env->ThrowError("[D3DVP Error] mode must be between 0 and 2");
 		if (quality < 0 || quality > 2) env->ThrowError("[D3DVP Error] quality must be between 0 and 2");
 		if (cache < 0) env->ThrowError("[D3DVP Error] cache must be >= 0");
 		if (reset < 0) env->ThrowError("[D3DVP Error] reset must be >= 0");
 
-		CreateProcessor(env);
-		CreateResources(env);
-
-		numCache = (NumFramesProcAhead() + cacheFrames) * NumFramesPerBlock();
+		numCache = 0;
+		cacheStats = CacheStats();
+		startupStats.initMs = -1;
+		startupStats.firstFrameMs = -1;
+		startupStats.firstWaitMs = -1;
+		startupStats.warmUp = false;
 
 #if COUNT_FRAMES
 		cntTo = 0;
@@ -787,9 +1142,9 @@ public:
 		cntFrom = 0;
 #endif
 
-		toGPUThread.start();
-		processThread.start();
-		fromGPUThread.start();
+		stats.SetQueueCapacity(QUEUE_TO_GPU, (int)toGPUThread.capacity());
+		stats.SetQueueCapacity(QUEUE_PROCESS, (int)processThread.capacity());
+		stats.SetQueueCapacity(QUEUE_FROM_GPU, (int)fromGPUThread.capacity());
 	}
 
 	virtual ~D3DVP() {
@@ -808,29 +1163,21 @@ public:
 		PRINTF("processThread: %f,%f\n", proP, proC);
 		PRINTF("fromGPUThread: %f,%f\n", fromP, fromC);
 #endif
-#if 0
-		// [N
-		outputViews.clear();
-		texOutput.clear();
-		inputViews.clear();
-		texInput.clear();
-		texOutputCPU.clear();
-		texInputCPU.clear();
-
-		videoProcEnum = nullptr;
-		videoProc = nullptr;
-		videoDev = nullptr;
-		devCtx = nullptr;
-
-		ID3D11Debug* pDebug;
-		HRESULT hr = dev->QueryInterface(__uuidof(ID3D11Debug), (void**)&pDebug);
-		dev = nullptr;
-
-		if (SUCCEEDED(hr)) {
-			pDebug->ReportLiveDeviceObjects(D3D11_RLDO_DETAIL);
-			pDebug->Release();
-		}
-#endif
+		PRINTF("cache: hit=%d,miss=%d,reset=%d\n", cacheStats.hit, cacheStats.miss, cacheStats.reset);
+		if (staticThresh >= 0) {
+			PRINTF("static: reused=%d\n", reusedFrames);
+		}
+		if (combThresh >= 0) {
+			PRINTF("comb: progressive=%d\n", progressiveFrames);
+		}
+		if (autoFieldOrder) {
+			PRINTF("field order: changes=%d\n", (int)fieldOrderLog.size());
+		}
+		if (stats.Enabled()) {
+			PRINTF("%s", stats.Snapshot().Format().c_str());
+		}
+		PRINTF("startup: init=%.1fms,first=%.1fms,wait=%.1fms,warmup=%d\n", startupStats.initMs,
+			startupStats.firstFrameMs, startupStats.firstWaitMs, startupStats.warmUp ? 1 : 0);
 	}
 
 	// hNXŎĂ鉼z֐XbhĂ΂Ă\̂
@@ -838,21 +1185,32 @@ public:
 	// hNX̃fXgN^IOɂĂяoƁI
 	void JoinThreads() {
 		if (joinCalled == false) {
+			// EH[AbṽXbh͂̃IuWFNg̐ݒQƂĂ̂ŐɎ~߂
+			warmUpThread = nullptr;
 			toGPUThread.join();
 			processThread.join();
 			fromGPUThread.join();
 			receiveQ.clear();
+			backQ.clear();
+			prevInput = FrameType();
+			lastOutput[0] = FrameType();
+			lastOutput[1] = FrameType();
 			joinCalled = true;
 		}
 	}
 
 	int NumFramesPerBlock() {
-		return (mode >= 1) ? 2 : 1;
+		return (mode == 1) ? 2 : 1;
+	}
+
+	// ɕKvȓ̓t[
+	int NumInputTex() {
+		return backend->PastFrames() + backend->FutureFrames() + 1;
 	}
 
 	// ǂݖ
 	int NumFramesProcAhead() {
-		return NBUF_IN_FRAME + NBUF_IN_TEX + (NBUF_OUT_TEX / NumFramesPerBlock()) + rccaps.FutureFrames;
+		return NBUF_IN_FRAME + NBUF_IN_TEX + (NBUF_OUT_TEX / NumFramesPerBlock()) + backend->FutureFrames();
 	}
 
 	void SetFilter(bool autop, int nr, int edge, ErrorHandler* env)
@@ -861,63 +1219,82 @@ public:
 		if (nr < -1 || nr > 100) env->ThrowError("D3DVP Error] nr must be in range 0-100, or -1 to disable");
 		if (edge < -1 || edge > 100) env->ThrowError("D3DVP Error] edge must be in range 0-100, or -1 to disable");
 
-		bool bob = (mode >= 1);
+		auto& lock = with(initLock);
+		if (initialized) {
+			backend->SetFilter(autop, nr, edge, env);
+		}
+		else {
+			// Ƃɐݒ肷
+			filterSet = true;
+			filterAutop = autop;
+			filterNr = nr;
+			filterEdge = edge;
+		}
+	}
+
+	void Reset() {
+		PRINTF("Reset\n");
+		cacheStartFrame = INVALID_FRAME;
+		backQ.clear();
+	}
+
+	CacheStats GetCacheStats() const {
+		return cacheStats;
+	}
 
-		// D3D11_VIDEO_PROCESSOR_CONTENT_DESC̎w͔fĂȂۂ̂
-		// VideoProcessorݒ
-		videoCtx->VideoProcessorSetStreamOutputRate(
-			videoProc.get(), 0, bob
-			? D3D11_VIDEO_PROCESSOR_OUTPUT_RATE_NORMAL
-			: D3D11_VIDEO_PROCESSOR_OUTPUT_RATE_HALF, FALSE, NULL);
-		videoCtx->VideoProcessorSetStreamFrameFormat(
-			videoProc.get(), 0, tff
-			? D3D11_VIDEO_FRAME_FORMAT_INTERLACED_TOP_FIELD_FIRST
-			: D3D11_VIDEO_FRAME_FORMAT_INTERLACED_BOTTOM_FIELD_FIRST);
+	StartupStats GetStartupStats() const {
+		return startupStats;
+	}
 
-		BOOL enableNR = (nr >= 0) && (caps.FilterCaps & D3D11_VIDEO_PROCESSOR_FILTER_CAPS_NOISE_REDUCTION);
-		BOOL enableEE = (edge >= 0) && (caps.FilterCaps & D3D11_VIDEO_PROCESSOR_FILTER_CAPS_EDGE_ENHANCEMENT);
+	// iƂ̏ԂƃL[̐[̋L^iLɂƃZbgj
+	void EnableStats(bool enable) {
+		stats.Enable(enable);
+	}
 
-		D3D11_VIDEO_PROCESSOR_FILTER_RANGE nrRange = { 0 }, edgeRange = { 0 };
+	PipelineSnapshot GetStats() const {
+		return stats.Snapshot();
+	}
 
-		if (enableNR) {
-			COM_CHECK(videoProcEnum->GetVideoProcessorFilterRange(
-				D3D11_VIDEO_PROCESSOR_FILTER_NOISE_REDUCTION, &nrRange));
-			PRINTF("NR: [%d,%d,%d,%f]\n", nrRange.Minimum, nrRange.Maximum, nrRange.Default, nrRange.Multiplier);
-			nr = (int)std::round((double)nr * 0.01 *
-				(nrRange.Maximum - nrRange.Minimum) + nrRange.Minimum);
-			PRINTF("NR: %d %d\n", enableNR, nr);
-			videoCtx->VideoProcessorSetStreamFilter(
-				videoProc.get(), 0, D3D11_VIDEO_PROCESSOR_FILTER_NOISE_REDUCTION, enableNR, nr);
-		}
+	// V[`FWƐÎ~t[AȂ̂Ȃt[̌oiȂ疳j
+	// autoOrder: tB[hI[_[͂画肷iRXgN^tff͍ŏ̃I[_[ɂȂj
+	// t[OɌĂԂ
+	void SetAnalysis(float scene, float staticDiff, int comb, bool autoOrder) {
+		sceneThresh = scene;
+		staticThresh = staticDiff;
+		combThresh = comb;
+		autoFieldOrder = autoOrder;
+	}
 
-		if (enableEE) {
-			COM_CHECK(videoProcEnum->GetVideoProcessorFilterRange(
-				D3D11_VIDEO_PROCESSOR_FILTER_EDGE_ENHANCEMENT, &edgeRange));
-			PRINTF("EE: [%d,%d,%d,%f]\n", edgeRange.Minimum, edgeRange.Maximum, edgeRange.Default, edgeRange.Multiplier);
-			edge = (int)std::round((double)edge * 0.01 *
-				(edgeRange.Maximum - edgeRange.Minimum) + edgeRange.Minimum);
-			PRINTF("EE: %d %d\n", enableEE, edge);
-			videoCtx->VideoProcessorSetStreamFilter(
-				videoProc.get(), 0, D3D11_VIDEO_PROCESSOR_FILTER_EDGE_ENHANCEMENT, enableEE, edge);
-		}
+	// 񏈗̃CX^X͕ʂ̒lɂāAꂼʂD3D11foCXiC~fBGCgReLXgƃbNjg
+	// OɌĂԂ
+	void SetDeviceGroup(int group) {
+		deviceGroup = group;
+	}
 
-		// auto processing mode
-		videoCtx->VideoProcessorSetStreamAutoProcessingMode(videoProc.get(), 0, (BOOL)autop);
+	// tB[hI[_[؂ւL^
+	std::vector<FieldOrderChange> GetFieldOrderLog() const {
+		auto& lock = with(fieldOrderLock);
+		return fieldOrderLog;
 	}
 
-	void Reset() {
-		PRINTF("Reset\n");
-		cacheStartFrame = INVALID_FRAME;
+	// ̓t[nƂɔ肵tB[hI[_[i1: TFF, 0: BFF, -1: L^Ȃj
+	// FIELD_ORDER_HISTORYt[oĂ
+	int GetFieldOrder(int n) const {
+		if (n < 0) {
+			return -1;
+		}
+		auto& lock = with(fieldOrderLock);
+		const auto& rec = frameFieldOrder[n % FIELD_ORDER_HISTORY];
+		return (rec.first == n) ? rec.second : -1;
 	}
 };
 
 // AviSynthpWbNNX
 class D3DVPAvsWorker : public D3DVP<PVideoFrame, IScriptEnvironment2>
 {
-	typedef uint8_t pixel_t;
-
 	PClip child;
 	VideoInfo vi; // o̓tH[}bg
+	int bits;
 
 	int logUVx;
 	int logUVy;
@@ -926,27 +1303,26 @@ class D3DVPAvsWorker : public D3DVP<PVideoFrame, IScriptEnvironment2>
 	PVideoFrame blankFrame;
 	int adjustFrames;
 
-	void(*yuv_to_nv12)(
-		int height, int width,
-		uint8_t* dst, int dstPitch,
-		const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV,
-		int pitchY, int pitchUV);
-
-	void(*nv12_to_yuv)(
-		int height, int width,
-		uint8_t* dstY, uint8_t* dstU, uint8_t* dstV,
-		int pitchY, int pitchUV,
-		const uint8_t* src, int srcPitch);
+	ParallelConvert<IScriptEnvironment2> convert;
+	FrameAnalyzer<IScriptEnvironment2> analyzer;
+	SourceFetcher<PVideoFrame>* fetcher; // 񏈗pinullptrȂ玩Ŏ擾j
 
 	PVideoFrame GetChildFrame(int n, IScriptEnvironment2* env) {
 		if (border == BORDER_BLANK) {
 			if (n < 0 || n >= srcvi.num_frames) {
+				if (!blankFrame) {
+					blankFrame = NewBlankFrame(env);
+				}
 				return blankFrame;
 			}
 		}
 		else { // BORDER_COPY
 			n = std::max(0, std::min(srcvi.num_frames - 1, n));
 		}
+		if (fetcher) {
+			// zXg̃XbhɎ擾Ă炤
+			return fetcher->Fetch(n);
+		}
 		return child->GetFrame(n, env);
 	}
 
@@ -962,19 +1338,89 @@ class D3DVPAvsWorker : public D3DVP<PVideoFrame, IScriptEnvironment2>
 		return env->NewVideoFrame(vi);
 	}
 
-	void ToGPUFrame(PVideoFrame& src, D3D11_MAPPED_SUBRESOURCE dst, IScriptEnvironment2* env)
+	// ̓t[1v[itB[ĥƂ͂̃tB[h̍sj
+	struct SrcPlane {
+		const uint8_t* ptr;
+		int pitch;
+	};
+
+	// field: -1Ȃt[ŚA0/1Ȃ炻̃tB[h̍s
+	// tB[ĥƂ́AJns炵ăsb`2{A𔼕ɂ
+	// t[Ɠϊł̃tB[h̍s߂iF̍stB[h݂ɕł̂œj
+	SrcPlane GetSrcPlane(PVideoFrame& src, int plane, int field) {
+		SrcPlane ret = { src->GetReadPtr(plane), src->GetPitch(plane) };
+		if (field >= 0) {
+			ret.ptr += ret.pitch * field;
+			ret.pitch *= 2;
+		}
+		return ret;
+	}
+
+	template <typename pixel_t>
+	void ToGPUFrameT(const SrcPlane& y, const SrcPlane& u, const SrcPlane& v, int height, uint8_t* dstptr, int dstPitchBytes)
+	{
+		const pixel_t* srcY = reinterpret_cast<const pixel_t*>(y.ptr);
+		const pixel_t* srcU = reinterpret_cast<const pixel_t*>(u.ptr);
+		const pixel_t* srcV = reinterpret_cast<const pixel_t*>(v.ptr);
+		int pitchY = y.pitch / sizeof(pixel_t);
+		int pitchUV = u.pitch / sizeof(pixel_t);
+		int dstPitch = dstPitchBytes / sizeof(pixel_t);
+		pixel_t* dstY = reinterpret_cast<pixel_t*>(dstptr);
+		if (sizeof(pixel_t) == 1) {
+			convert.yuv_to_nv12(height, srcvi.width, (uint8_t*)dstY, dstPitch,
+				(const uint8_t*)srcY, (const uint8_t*)srcU, (const uint8_t*)srcV, pitchY, pitchUV);
+		}
+		else {
+			convert.yuv16_to_p010(height, srcvi.width, (uint16_t*)dstY, dstPitch,
+				(const uint16_t*)srcY, (const uint16_t*)srcU, (const uint16_t*)srcV, pitchY, pitchUV, bits);
+		}
+	}
+
+	void ToGPUFrame(PVideoFrame& src, MappedSurface dst, int field, IScriptEnvironment2* env)
+	{
+		int step = (field >= 0) ? 2 : 1;
+		int height = srcvi.height / step;
+		int dstPitch = dst.RowPitch * step;
+		uint8_t* dstptr = reinterpret_cast<uint8_t*>(dst.pData) + ((field >= 0) ? dst.RowPitch * field : 0);
+		if (srcvi.IsYUY2()) {
+			// ̂܂ܓ]
+			SrcPlane p = GetSrcPlane(src, 0, field);
+			env->BitBlt(dstptr, dstPitch, p.ptr, p.pitch, src->GetRowSize(), height);
+			return;
+		}
+		SrcPlane y = GetSrcPlane(src, PLANAR_Y, field);
+		SrcPlane u = GetSrcPlane(src, PLANAR_U, field);
+		SrcPlane v = GetSrcPlane(src, PLANAR_V, field);
+		switch (format) {
+		case SURFACE_YUY2:
+			convert.yuv422_to_yuy2(height, srcvi.width, dstptr, dstPitch,
+				y.ptr, u.ptr, v.ptr, y.pitch, u.pitch);
+			break;
+		case SURFACE_AYUV:
+			convert.yuv444_to_ayuv(height, srcvi.width, dstptr, dstPitch,
+				y.ptr, u.ptr, v.ptr, y.pitch, u.pitch);
+			break;
+		case SURFACE_NV12:
+			ToGPUFrameT<uint8_t>(y, u, v, height, dstptr, dstPitch);
+			break;
+		default:
+			ToGPUFrameT<uint16_t>(y, u, v, height, dstptr, dstPitch);
+			break;
+		}
+	}
+
+	void ToGPUFrame(PVideoFrame& src, MappedSurface dst, IScriptEnvironment2* env)
+	{
+		ToGPUFrame(src, dst, -1, env);
+	}
+
+	void ToGPUField(PVideoFrame& src, MappedSurface dst, int parity, IScriptEnvironment2* env)
 	{
-		const pixel_t* srcY = reinterpret_cast<const pixel_t*>(src->GetReadPtr(PLANAR_Y));
-		const pixel_t* srcU = reinterpret_cast<const pixel_t*>(src->GetReadPtr(PLANAR_U));
-		const pixel_t* srcV = reinterpret_cast<const pixel_t*>(src->GetReadPtr(PLANAR_V));
-		int pitchY = src->GetPitch(PLANAR_Y) / sizeof(pixel_t);
-		int pitchUV = src->GetPitch(PLANAR_U) / sizeof(pixel_t);
-		int dstPitch = dst.RowPitch / sizeof(pixel_t);
-		pixel_t* dstY = reinterpret_cast<pixel_t*>(dst.pData);
-		yuv_to_nv12(srcvi.height, srcvi.width, dstY, dstPitch, srcY, srcU, srcV, pitchY, pitchUV);
+		ToGPUFrame(src, dst, parity, env);
 	}
 
-	void FromGPUFrame(PVideoFrame& dst, D3D11_MAPPED_SUBRESOURCE src, IScriptEnvironment2* env)
+	template <typename pixel_t>
+	void FromGPUFrameT(PVideoFrame& dst, MappedSurface src)
 	{
 		pixel_t* dstY = reinterpret_cast<pixel_t*>(dst->GetWritePtr(PLANAR_Y));
 		pixel_t* dstU = reinterpret_cast<pixel_t*>(dst->GetWritePtr(PLANAR_U));
@@ -983,13 +1429,105 @@ class D3DVPAvsWorker : public D3DVP<PVideoFrame, IScriptEnvironment2>
 		int pitchUV = dst->GetPitch(PLANAR_U) / sizeof(pixel_t);
 		int srcPitch = src.RowPitch / sizeof(pixel_t);
 		const pixel_t* srcY = reinterpret_cast<const pixel_t*>(src.pData);
-		nv12_to_yuv(height, width, dstY, dstU, dstV, pitchY, pitchUV, srcY, srcPitch);
+		if (sizeof(pixel_t) == 1) {
+			convert.nv12_to_yuv(height, width, (uint8_t*)dstY, (uint8_t*)dstU, (uint8_t*)dstV,
+				pitchY, pitchUV, (const uint8_t*)srcY, srcPitch);
+		}
+		else {
+			convert.p010_to_yuv16(height, width, (uint16_t*)dstY, (uint16_t*)dstU, (uint16_t*)dstV,
+				pitchY, pitchUV, (const uint16_t*)srcY, srcPitch, bits);
+		}
 	}
 
-	PVideoFrame NewBlankFrame(IScriptEnvironment2* env)
+	void FromGPUFrame(PVideoFrame& dst, MappedSurface src, IScriptEnvironment2* env)
+	{
+		const uint8_t* srcptr = reinterpret_cast<const uint8_t*>(src.pData);
+		switch (format) {
+		case SURFACE_YUY2:
+			if (vi.IsYUY2()) {
+				env->BitBlt(dst->GetWritePtr(), dst->GetPitch(), srcptr, src.RowPitch, dst->GetRowSize(), height);
+			}
+			else {
+				convert.yuy2_to_yuv422(height, width,
+					dst->GetWritePtr(PLANAR_Y), dst->GetWritePtr(PLANAR_U), dst->GetWritePtr(PLANAR_V),
+					dst->GetPitch(PLANAR_Y), dst->GetPitch(PLANAR_U), srcptr, src.RowPitch);
+			}
+			break;
+		case SURFACE_AYUV:
+			convert.ayuv_to_yuv444(height, width,
+				dst->GetWritePtr(PLANAR_Y), dst->GetWritePtr(PLANAR_U), dst->GetWritePtr(PLANAR_V),
+				dst->GetPitch(PLANAR_Y), dst->GetPitch(PLANAR_U), srcptr, src.RowPitch);
+			break;
+		case SURFACE_NV12:
+			FromGPUFrameT<uint8_t>(dst, src);
+			break;
+		default:
+			FromGPUFrameT<uint16_t>(dst, src);
+			break;
+		}
+	}
+
+	// Pxv[ŔriYUY2͐F܂ށj
+	double FrameDiff(PVideoFrame& cur, PVideoFrame& prev, IScriptEnvironment2* env)
+	{
+		int plane = srcvi.IsYUY2() ? 0 : PLANAR_Y;
+		return analyzer.MeanAbsDiff(cur->GetReadPtr(plane), cur->GetPitch(plane),
+			prev->GetReadPtr(plane), prev->GetPitch(plane), cur->GetRowSize(plane), srcvi.height, bits);
+	}
+
+	int CombScore(PVideoFrame& frame, IScriptEnvironment2* env)
+	{
+		int plane = srcvi.IsYUY2() ? 0 : PLANAR_Y;
+		return analyzer.CombScore(frame->GetReadPtr(plane), frame->GetPitch(plane),
+			frame->GetRowSize(plane), srcvi.height, bits);
+	}
+
+	int WeaveCombScore(PVideoFrame& top, PVideoFrame& bottom, IScriptEnvironment2* env)
+	{
+		int plane = srcvi.IsYUY2() ? 0 : PLANAR_Y;
+		return analyzer.WeaveCombScore(top->GetReadPtr(plane), top->GetPitch(plane),
+			bottom->GetReadPtr(plane), bottom->GetPitch(plane), top->GetRowSize(plane), srcvi.height, bits);
+	}
+
+	bool FieldOrderDiff(PVideoFrame& cur, PVideoFrame& next, double& tffDiff, double& bffDiff, IScriptEnvironment2* env)
+	{
+		int plane = srcvi.IsYUY2() ? 0 : PLANAR_Y;
+		analyzer.FieldOrderDiff(cur->GetReadPtr(plane), cur->GetPitch(plane),
+			next->GetReadPtr(plane), next->GetPitch(plane), cur->GetRowSize(plane), srcvi.height, bits,
+			tffDiff, bffDiff);
+		return true;
+	}
+
+	// t[vpeBAviSynthNeô
+	void SetFrameInfo(PVideoFrame& frame, const FrameInfo& info, IScriptEnvironment2* env)
 	{
-		PVideoFrame dst = env->NewVideoFrame(srcvi);
+		PNeoEnv neo = env;
+		if (!neo) {
+			return;
+		}
+		// g񂵂t[͑Ȍo͂ƋLĂ̂ŁAvpeB悤ɂ
+		neo->MakePropertyWritable(&frame);
+		if (sceneThresh >= 0) {
+			frame->SetProperty("_SceneChangePrev", AVSMapValue((__int64)(info.sceneChange ? 1 : 0)));
+		}
+		if (sceneThresh >= 0 || staticThresh >= 0) {
+			frame->SetProperty("D3DVPDiff", AVSMapValue((double)info.diff));
+		}
+		if (IsIVTC()) {
+			frame->SetProperty("D3DVPMatch", AVSMapValue((__int64)info.match));
+		}
+		if (combThresh >= 0 || IsIVTC()) {
+			frame->SetProperty("D3DVPComb", AVSMapValue((__int64)info.comb));
+			frame->SetProperty("D3DVPDeinterlaced", AVSMapValue((__int64)(info.deinterlaced ? 1 : 0)));
+		}
+		if (autoFieldOrder) {
+			frame->SetProperty("D3DVPFieldOrder", AVSMapValue((__int64)info.tff));
+		}
+	}
 
+	template <typename pixel_t>
+	void FillBlankFrame(PVideoFrame& dst)
+	{
 		pixel_t* dstY = reinterpret_cast<pixel_t*>(dst->GetWritePtr(PLANAR_Y));
 		pixel_t* dstU = reinterpret_cast<pixel_t*>(dst->GetWritePtr(PLANAR_U));
 		pixel_t* dstV = reinterpret_cast<pixel_t*>(dst->GetWritePtr(PLANAR_V));
@@ -1000,7 +1538,7 @@ class D3DVPAvsWorker : public D3DVP<PVideoFrame, IScriptEnvironment2>
 		int widthUV = srcvi.width >> logUVx;
 		int heightUV = srcvi.height >> logUVy;
 
-		const int black[] = { 0, 128, 128 };
+		const int black[] = { 0, 128 << (bits - 8), 128 << (bits - 8) };
 
 		for (int y = 0; y < srcvi.height; ++y) {
 			for (int x = 0; x < srcvi.width; ++x) {
@@ -1014,7 +1552,30 @@ class D3DVPAvsWorker : public D3DVP<PVideoFrame, IScriptEnvironment2>
 				dstV[x + y * pitchUV] = black[2];
 			}
 		}
+	}
 
+	// GetFrameÕXbhĂ΂邱Ƃ̂NewVideoFrameƓCPUfoCXw肷
+	PVideoFrame NewBlankFrame(IScriptEnvironment2* env)
+	{
+		PNeoEnv neo = env;
+		PVideoFrame dst = neo
+			? neo->NewVideoFrame(srcvi, neo->GetDevice(DEV_TYPE_CPU, 0))
+			: env->NewVideoFrame(srcvi);
+		if (srcvi.IsYUY2()) {
+			uint8_t* dstptr = dst->GetWritePtr();
+			int pitch = dst->GetPitch();
+			for (int y = 0; y < srcvi.height; ++y) {
+				for (int x = 0; x < srcvi.width * 2; ++x) {
+					dstptr[x + y * pitch] = (x & 1) ? 128 : 0;
+				}
+			}
+		}
+		else if (bits == 8) {
+			FillBlankFrame<uint8_t>(dst);
+		}
+		else {
+			FillBlankFrame<uint16_t>(dst);
+		}
 		return dst;
 	}
 
@@ -1022,14 +1583,18 @@ class D3DVPAvsWorker : public D3DVP<PVideoFrame, IScriptEnvironment2>
 	int nextInputFrame;  // ̓t[ԍ
 
 public:
-	D3DVPAvsWorker(PClip child, DXGI_FORMAT format, int mode, int tff, VideoInfo vi, int quality,
+	D3DVPAvsWorker(PClip child, SurfaceFormat format, BackendType backendType, int mode, int tff, VideoInfo vi, int quality,
 		const std::string& deviceName, int deviceIndex, int cache, int reset, BorderFrame border, int adjust, int debug,
-		IScriptEnvironment2* env)
-		: D3DVP(child->GetVideoInfo(), format, mode, tff, vi.width, vi.height, quality, deviceName, deviceIndex, cache, reset, debug, env)
+		Tracer* tracer, IScriptEnvironment2* env)
+		: D3DVP(child->GetVideoInfo(), format, backendType, mode, tff, vi.width, vi.height, quality, deviceName, deviceIndex, cache, reset, debug, tracer, env)
 		, child(child)
 		, vi(vi)
+		, bits(vi.BitsPerComponent())
 		, border(border)
 		, adjustFrames(adjust)
+		, convert(workerPool.get(), GetConvertFuncs())
+		, analyzer(workerPool.get(), GetSimdLevel() >= SIMD_AVX2)
+		, fetcher()
 	{
 #if COUNT_FRAMES
 		cntTo = 0;
@@ -1038,30 +1603,69 @@ public:
 		cntProc = 0;
 		cntFrom = 0;
 #endif
-
-		if (CPUID().AVX2()) {
-			yuv_to_nv12 = yuv_to_nv12_avx2;
-			nv12_to_yuv = nv12_to_yuv_avx2;
-		}
-		else {
-			yuv_to_nv12 = yuv_to_nv12_c;
-			nv12_to_yuv = nv12_to_yuv_c;
-		}
-
-		blankFrame = NewBlankFrame(env);
 	}
 
 	~D3DVPAvsWorker() {
 		JoinThreads();
 	}
 
-	PVideoFrame GetFrame(int n, IScriptEnvironment2* env) {
+	// pCvCXbhŏĂ悢
+	static bool IsThreadEnabled(IScriptEnvironment2* env) {
 		PNeoEnv neo = env;
-		bool thread = !(neo &&
+		return !(neo &&
 			(neo->GetProperty(AEP_VERSION) >= 2820) &&
 			(neo->GetProperty(AEP_SUPPRESS_THREAD) > 0));
-		PutInputFrame(n + adjustFrames, thread, env);
-		return WaitFrame(n + adjustFrames, env);
+	}
+
+	// XbhgȂꍇ͉ȂiŏGetFrameŏj
+	void StartWarmUp(IScriptEnvironment2* env) {
+		if (!IsThreadEnabled(env)) {
+			return;
+		}
+		StartWarmUpThread(env);
+	}
+
+	// ̓Nbṽt[fetcher擾悤ɂ
+	void SetSourceFetcher(SourceFetcher<PVideoFrame>* fetcher) {
+		this->fetcher = fetcher;
+	}
+
+	PVideoFrame GetFrame(int n, IScriptEnvironment2* env) {
+		return GetOutputFrame(n + adjustFrames, IsThreadEnabled(env), env);
+	}
+};
+
+// t[񏈗piƊ蓖ĂSegmentParallelj
+class D3DVPAvsParallel : public SegmentParallel<D3DVPAvsWorker, PVideoFrame, IScriptEnvironment2>
+{
+	typedef SegmentParallel<D3DVPAvsWorker, PVideoFrame, IScriptEnvironment2> Base;
+public:
+	// workers̏L󂯎
+	D3DVPAvsParallel(const std::vector<D3DVPAvsWorker*>& workers, PClip child, int segmentLength, int numFrames, IScriptEnvironment2* env)
+		: Base(workers, [child](int n, IScriptEnvironment2* hostEnv) { return child->GetFrame(n, hostEnv); },
+			segmentLength, numFrames, env)
+	{ }
+
+	// SCX^X̍v
+	PipelineSnapshot GetStats() {
+		PipelineSnapshot s = GetWorker(0)->GetStats();
+		for (int i = 1; i < NumWorkers(); ++i) {
+			s.Merge(GetWorker(i)->GetStats());
+		}
+		return s;
+	}
+
+	// SCX^X̃tB[hI[_[̐؂ւit[j
+	std::vector<FieldOrderChange> GetFieldOrderLog() {
+		std::vector<FieldOrderChange> log;
+		for (int i = 0; i < NumWorkers(); ++i) {
+			auto l = GetWorker(i)->GetFieldOrderLog();
+			log.insert(log.end(), l.begin(), l.end());
+		}
+		std::sort(log.begin(), log.end(), [](const FieldOrderChange& a, const FieldOrderChange& b) {
+			return a.frame < b.frame;
+		});
+		return log;
 	}
 };
 
@@ -1069,27 +1673,206 @@ public:
 class D3DVPAvs : public GenericVideoFilter
 {
 	int mode, tff, quality;
+	bool autoOrder;
 	bool autop;
 	int nr, edge;
 	const std::string deviceName;
 	BorderFrame border;
+	BackendType backendType;
 	int cache, reset, adjust, debug, deviceIndex;
+	int instances, segment;
+	float scene, staticDiff;
+	int comb;
+	bool warmup;
+
+	// g[XitraceȂnullptrj
+	// SCX^XŋL̂ŃCX^XɍČɔj
+	std::string tracePath;
+	std::unique_ptr<Tracer> tracer;
 
 	std::unique_ptr<D3DVPAvsWorker> w;
+	std::unique_ptr<D3DVPAvsParallel> parallel;
+
+	// IVTC̊Ԉimode=2j
+	enum { IVTC_CYCLE = 5 };
+	CriticalSection decimateLock;
+	int dropCycle; // dropIndex߂TCN
+	int dropIndex;
+
+	// vt@CiȂL^Ȃj
+	std::string statsPath;
+	CriticalSection statsLock;
+	int64_t lastStatsWrite;
+
+	// ɊO猩悤1bƂɏ
+	void WriteStats(bool force) {
+		auto& lock = with(statsLock);
+		int64_t now = GetPerfCounter();
+		if (!force && now - lastStatsWrite < GetPerfFrequency()) {
+			return;
+		}
+		lastStatsWrite = now;
+		PipelineSnapshot s;
+		std::vector<FieldOrderChange> fieldOrderLog;
+		if (parallel) {
+			s = parallel->GetStats();
+			fieldOrderLog = parallel->GetFieldOrderLog();
+		}
+		else if (w) {
+			s = w->GetStats();
+			fieldOrderLog = w->GetFieldOrderLog();
+		}
+		else {
+			return;
+		}
+		FILE* fp = fopen(statsPath.c_str(), "w");
+		if (fp != NULL) {
+			fputs(s.Format().c_str(), fp);
+			if (w) {
+				CacheStats cs = w->GetCacheStats();
+				fprintf(fp, "cache: hit=%d,miss=%d,reset=%d\n", cs.hit, cs.miss, cs.reset);
+				StartupStats ss = w->GetStartupStats();
+				fprintf(fp, "startup: init %.1fms, first frame %.1fms (wait %.1fms)%s\n",
+					ss.initMs, ss.firstFrameMs, ss.firstWaitMs, ss.warmUp ? ", warmed up" : "");
+			}
+			if (autoOrder) {
+				fprintf(fp, "field order: %s at start, %d changes\n", tff ? "TFF" : "BFF", (int)fieldOrderLog.size());
+				for (const FieldOrderChange& c : fieldOrderLog) {
+					fprintf(fp, "  %d: %s\n", c.frame, c.tff ? "TFF" : "BFF");
+				}
+			}
+			fclose(fp);
+		}
+	}
+
+	// ̓t[ñtB[hI[_[
+	// order=2ł̓tB[h}b`ƓACX^X̃t[Ƃ̔茋ʂg
+	// i܂ĂȂ΍ŏ̃I[_[j
+	bool IsTFF(int n) {
+		int order = -1;
+		if (autoOrder) {
+			if (parallel) {
+				order = parallel->GetWorkerFor(n - adjust)->GetFieldOrder(n);
+			}
+			else if (w) {
+				order = w->GetFieldOrder(n);
+			}
+		}
+		return (order >= 0) ? (order != 0) : (tff != 0);
+	}
+
+	// ctB[hi1ڂ̃tB[hj́AÕt[Ƃ̕ϐ΍iPxA8bitZj
+	double KeptFieldDiff(int n, IScriptEnvironment2* env) {
+		const VideoInfo& srcvi = child->GetVideoInfo();
+		if (n <= 0) {
+			return DBL_MAX;
+		}
+		PVideoFrame cur = child->GetFrame(n, env);
+		PVideoFrame prev = child->GetFrame(n - 1, env);
+		int plane = srcvi.IsYUY2() ? 0 : PLANAR_Y;
+		int field = IsTFF(n) ? 0 : 1;
+		int bits = srcvi.BitsPerComponent();
+		bool avx2 = GetSimdLevel() >= SIMD_AVX2;
+		// 1tB[hȂ̂ŕ񉻂͂Ȃ
+		auto sad = (bits > 8)
+			? (avx2 ? sad_plane16_avx2 : sad_plane16_c)
+			: (avx2 ? sad_plane_avx2 : sad_plane_c);
+		int pitchA = cur->GetPitch(plane), pitchB = prev->GetPitch(plane);
+		int rows = srcvi.height / 2;
+		uint64_t sum = sad(cur->GetReadPtr(plane) + pitchA * field, pitchA * 2,
+			prev->GetReadPtr(plane) + pitchB * field, pitchB * 2, cur->GetRowSize(plane), 0, rows);
+		double pixels = (double)(cur->GetRowSize(plane) / ((bits > 8) ? 2 : 1)) * rows;
+		return sum / pixels / (1 << (std::max(bits, 8) - 8));
+	}
+
+	// Ԉ̃t[ԍAtB[h}b`íj̃t[ԍ߂
+	// 1TCNi5t[jdt[1Ƃ4ɂ
+	int DecimatedToMatched(int n, IScriptEnvironment2* env) {
+		int cycle = n / (IVTC_CYCLE - 1);
+		int index = n % (IVTC_CYCLE - 1);
+		int start = cycle * IVTC_CYCLE;
+		if (start + IVTC_CYCLE > child->GetVideoInfo().num_frames) {
+			// Ō̔[ȃTCN͊ԈȂ
+			return start + index;
+		}
+		auto& lock = with(decimateLock);
+		if (dropCycle != cycle) {
+			if (autoOrder) {
+				// tB[hI[_[̔茋ʂĝŁATCN̍Ō̃t[܂ŏĂ
+				GetFrame(start + IVTC_CYCLE - 1, env, 0);
+			}
+			double diffs[IVTC_CYCLE];
+			for (int i = 0; i < IVTC_CYCLE; ++i) {
+				diffs[i] = KeptFieldDiff(start + i, env);
+			}
+			dropIndex = SelectDropFrame(diffs, IVTC_CYCLE);
+			dropCycle = cycle;
+		}
+		return start + index + ((index >= dropIndex) ? 1 : 0);
+	}
+
+	// F̊ԈԂȂčςރtH[}bgœ]
+	// YUV422YUY2AYUV444AYUVAYUV4208bitȂNV12AȊOP010/P016
+	SurfaceFormat GetSurfaceFormat() const {
+		if (vi.IsYUY2() || vi.Is422()) return SURFACE_YUY2;
+		if (vi.Is444()) return SURFACE_AYUV;
+		switch (vi.BitsPerComponent()) {
+		case 8: return SURFACE_NV12;
+		case 10: return SURFACE_P010;
+		default: return SURFACE_P016;
+		}
+	}
+
+	// deviceGroup: 񏈗̃CX^X͂ꂼʂD3D11foCXgiGPUŕsē悤Ɂj
+	D3DVPAvsWorker* CreateWorker(int cache, int deviceGroup, IScriptEnvironment2* env) {
+		auto worker = std::unique_ptr<D3DVPAvsWorker>(new D3DVPAvsWorker(child,
+			GetSurfaceFormat(), backendType, mode,
+			tff, vi, quality, deviceName, deviceIndex, cache, reset, border, adjust, debug, tracer.get(), env));
+		worker->SetDeviceGroup(deviceGroup);
+		worker->SetFilter(autop, nr, edge, env);
+		worker->EnableStats(!statsPath.empty());
+		worker->SetAnalysis(scene, staticDiff, comb, autoOrder);
+		return worker.release();
+	}
 
 	void ResetInstance(IScriptEnvironment2* env) {
 		w = nullptr;
-		w = std::unique_ptr<D3DVPAvsWorker>(new D3DVPAvsWorker(child,
-			DXGI_FORMAT_NV12, mode,
-			tff, vi, quality, deviceName, deviceIndex, cache, reset, border, adjust, debug, env));
-		w->SetFilter(autop, nr, edge, env);
+		w = std::unique_ptr<D3DVPAvsWorker>(CreateWorker(cache, 0, env));
+	}
+
+	void CreateParallel(int numFrames, IScriptEnvironment2* env) {
+		// eCX^X̓ZOg擪珇ɏ邾Ȃ̂ŌLbV͕sv
+		// iς݃t[D3DVPAvsParallelŕێj
+		std::vector<D3DVPAvsWorker*> workers;
+		try {
+			for (int i = 0; i < instances; ++i) {
+				workers.push_back(CreateWorker(0, i, env));
+				if (warmup) {
+					workers.back()->StartWarmUp(env);
+				}
+			}
+		}
+		catch (...) {
+			for (auto worker : workers) delete worker;
+			throw;
+		}
+		parallel = std::unique_ptr<D3DVPAvsParallel>(
+			new D3DVPAvsParallel(workers, child, segment, numFrames, env));
 	}
 
 	PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env_, int retry)
 	{
 		IScriptEnvironment2* env = static_cast<IScriptEnvironment2*>(env_);
+		if (parallel) {
+			// ̃Xbh̉\̂ŃCX^X̍蒼͂Ȃ
+			PVideoFrame frame = parallel->GetFrame(n, env);
+			if (!statsPath.empty()) WriteStats(false);
+			return frame;
+		}
 		try {
-			return w->GetFrame(n, env);
+			PVideoFrame frame = w->GetFrame(n, env);
+			if (!statsPath.empty()) WriteStats(false);
+			return frame;
 		}
 		catch (const AvisynthError&) {
 			if (retry >= 2) {
@@ -1105,10 +1888,12 @@ public:
 	D3DVPAvs(PClip child, int mode, int order, int width, int height, int quality,
 		bool autop, int nr, int edge, const std::string& deviceName, int deviceIndex,
 		int cache, int reset, const std::string& border, int adjust, int debug,
-		IScriptEnvironment2* env)
+		const std::string& backend, int instances, int segment, const std::string& stats, const std::string& trace,
+		float scene, float staticDiff, int comb, bool warmup, IScriptEnvironment2* env)
 		: GenericVideoFilter(child)
 		, mode(mode)
 		, quality(quality)
+		, autoOrder(order == 2)
 		, autop(autop)
 		, nr(nr)
 		, edge(edge)
@@ -1118,15 +1903,46 @@ public:
 		, reset(reset)
 		, adjust(adjust)
 		, debug(debug)
+		, instances(instances)
+		, segment(segment)
+		, scene(scene)
+		, staticDiff(staticDiff)
+		, comb(comb)
+		, warmup(warmup)
+		, tracePath(trace)
+		, tracer(trace.empty() ? nullptr : new Tracer())
+		, dropCycle(-1)
+		, dropIndex(0)
+		, statsPath(stats)
+		, lastStatsWrite(0)
 	{
-		if (mode != 0 && mode != 1) env->ThrowError("[D3DVP Error] mode must be 0 or 1");
-		if (order < -1 || order > 1) env->ThrowError("[D3DVP Error] order must be between -1 and 1");
+		if (mode < 0 || mode > 2) env->ThrowError("[D3DVP Error] mode must be between 0 and 2");
+		if (order < -1 || order > 2) env->ThrowError("[D3DVP Error] order must be between -1 and 2");
 		if (quality < 0 || quality > 2) env->ThrowError("[D3DVP Error] quality must be between 0 and 2");
 		if (reset < 0) env->ThrowError("[D3DVP Error] reset must be >= 0");
 		if (nr < -1 || nr > 100) env->ThrowError("D3DVP Error] nr must be in range 0-100, or -1 to disable");
 		if (edge < -1 || edge > 100) env->ThrowError("D3DVP Error] edge must be in range 0-100, or -1 to disable");
+		if (instances < 1) env->ThrowError("[D3DVP Error] instances must be >= 1");
+		if (segment < 1) env->ThrowError("[D3DVP Error] segment must be >= 1");
+		if (vi.Is420()) {
+			if (vi.BitsPerComponent() == 32) {
+				env->ThrowError("[D3DVP Error] YUV420 input must be 8-16bit");
+			}
+		}
+		else if (vi.IsYUY2() || ((vi.Is422() || vi.Is444()) && vi.IsPlanar())) {
+			if (vi.BitsPerComponent() != 8) {
+				env->ThrowError("[D3DVP Error] YUV422/YUV444 input must be 8bit");
+			}
+		}
+		else {
+			env->ThrowError("[D3DVP Error] unsupported format (YUV420, YUV422, YUV444 or YUY2)");
+		}
+		if (mode == 2 && (vi.height % (vi.Is420() ? 4 : 2)) != 0) {
+			env->ThrowError("[D3DVP Error] IVTC (mode=2) requires height to be a multiple of 4 (YUV420) or 2");
+		}
 
-		tff = (order == -1) ? child->GetParity(0) : (order != 0);
+		// iorder=2j̍ŏ̃I[_[GetParityɏ]
+		tff = (order == -1 || order == 2) ? child->GetParity(0) : (order != 0);
 
 		if (border == "copy") {
 			this->border = BORDER_COPY;
@@ -1138,23 +1954,76 @@ public:
 			env->ThrowError("[D3DVP Error] border must be copy or blank");
 		}
 
+		if (backend == "d3d11") {
+#ifdef D3DVP_NO_D3D11
+			env->ThrowError("[D3DVP Error] this build does not support d3d11 backend");
+#endif
+			backendType = BACKEND_D3D11;
+		}
+		else if (backend == "cpu") {
+			backendType = BACKEND_CPU;
+		}
+		else {
+			env->ThrowError("[D3DVP Error] backend must be d3d11 or cpu");
+		}
+
 		vi.width = (width > 0) ? width : vi.width;
 		vi.height = (height > 0) ? height : vi.height;
 
-		ResetInstance(env);
+		// bobȂ1t[2t[o͂iD3DVP::NumFramesPerBlockƓj
+		int numFields = (mode == 1) ? 2 : 1;
+
+		if (instances > 1) {
+			CreateParallel(vi.num_frames * numFields, env);
+		}
+		else {
+			ResetInstance(env);
+			if (warmup) {
+				// XNvg̓ǂݍ݂I܂łɃobNGh쐬Ă
+				w->StartWarmUp(env);
+			}
+		}
+
+		vi.MulDivFPS(numFields, 1);
+		vi.num_frames *= numFields;
 
-		vi.MulDivFPS(w->NumFramesPerBlock(), 1);
-		vi.num_frames *= w->NumFramesPerBlock();
+		if (mode == 2) {
+			// 5t[4t[ɂi29.97fpsȂ23.976fpsj
+			vi.MulDivFPS(IVTC_CYCLE - 1, IVTC_CYCLE);
+			vi.num_frames = vi.num_frames / IVTC_CYCLE * (IVTC_CYCLE - 1) + vi.num_frames % IVTC_CYCLE;
+		}
+	}
+
+	~D3DVPAvs() {
+		if (!statsPath.empty()) {
+			WriteStats(true);
+		}
+		if (tracer) {
+			// L^ĂXbh~߂Ă珑o
+			w = nullptr;
+			parallel = nullptr;
+			if (!tracer->WriteChromeJson(tracePath)) {
+				PRINTF("[D3DVP] failed to write trace %s\n", tracePath.c_str());
+			}
+		}
 	}
 
 	PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env_)
 	{
+		if (mode == 2) {
+			IScriptEnvironment2* env = static_cast<IScriptEnvironment2*>(env_);
+			n = DecimatedToMatched(n, env);
+		}
 		return GetFrame(n, env_, 0);
 	}
 
 	int __stdcall SetCacheHints(int cachehints, int frame_range)
 	{
-		if (cachehints == CACHE_GET_MTMODE) return MT_SERIALIZED;
+		if (cachehints == CACHE_GET_MTMODE) {
+			// 񃂁[hł̓CX^XƂɃbNĂ̂œɌĂяoĂ悢
+			// i̓Nbṽt[͌ĂяoXbhŎ擾j
+			return parallel ? MT_NICE_FILTER : MT_SERIALIZED;
+		}
 		return 0;
 	}
 
@@ -1178,6 +2047,15 @@ public:
 			args[13].AsString("copy"),   // border
 			args[14].AsInt(0),   // adjust
 			args[15].AsInt(0),    // debug
+			args[16].AsString("d3d11"), // backend
+			args[17].AsInt(1),    // instances
+			args[18].AsInt(60),   // segment
+			args[19].AsString(""), // stats
+			args[20].AsString(""), // trace
+			(float)args[21].AsFloat(-1), // scene
+			(float)args[22].AsFloat(-1), // static
+			args[23].AsInt(-1),   // comb
+			args[24].AsBool(true), // warmup
 			env);
 	}
 };
@@ -1188,7 +2066,7 @@ extern "C" __declspec(dllexport) const char* __stdcall AvisynthPluginInit3(IScri
 {
 	AVS_linkage = vectors;
 
-	env->AddFunction("D3DVP", "c[mode]i[order]i[width]i[height]i[quality]i[autop]b[nr]i[edge]i[device]s[deviceIndex]i[cache]i[reset]i[border]s[adjust]i[debug]i", D3DVPAvs::Create, 0);
+	env->AddFunction("D3DVP", "c[mode]i[order]i[width]i[height]i[quality]i[autop]b[nr]i[edge]i[device]s[deviceIndex]i[cache]i[reset]i[border]s[adjust]i[debug]i[backend]s[instances]i[segment]i[stats]s[trace]s[scene]f[static]f[comb]i[warmup]b", D3DVPAvs::Create, 0);
 
 	return "Direct3D VideoProcessing Plugin";
 }
@@ -1296,6 +2174,11 @@ struct AviUtlErrorHandler {
 	void ThrowError(const char* str) {
 		throw std::string(str);
 	}
+	void ThrowError(const char* str, const char* a) {
+		char buf[1024];
+		sprintf_s(buf, str, a);
+		throw std::string(buf);
+	}
 	void ThrowError(const char* str, int a, const char* b, const char* c, int d) {
 		char buf[1024];
 		sprintf_s(buf, str, a, b, c, d);
@@ -1303,66 +2186,24 @@ struct AviUtlErrorHandler {
 	}
 };
 
-struct FramePool {
-	int w_, h_;
-	std::vector<PIXEL_YC*> pool_;
-	CriticalSection lock_;
-	~FramePool() {
-		Clear();
-	}
-	void SetSetting(int w, int h) {
-		auto& lock = with(lock_);
-		if (w != w_ || h != h_) {
-			Clear();
-		}
-		w = w_;
-		h = h_;
-	}
-	void Free(PIXEL_YC* ptr, int w, int h) {
-		auto& lock = with(lock_);
-		if (w != w_ || h != h_) {
-			delete[] ptr;
-		}
-		else {
-			pool_.push_back(ptr);
-		}
-	}
-	PIXEL_YC* Alloc(int w, int h) {
-		auto& lock = with(lock_);
-		if (w != w_ || h != h_) {
-			return new PIXEL_YC[w*h];
-		}
-		else {
-			if (pool_.size() > 0) {
-				auto ptr = pool_.back();
-				pool_.pop_back();
-				return ptr;
-			}
-			return new PIXEL_YC[w*h];
-		}
-	}
-private:
-	void Clear() {
-		for (PIXEL_YC* ptr : pool_) {
-			delete[] ptr;
-		}
-		pool_.clear();
-	}
-};
-
+// ͂AviUtlYC48t[Ao͂͏ʂNV12/YUY2̂܂܎
+// iYC48ւ̕ϊGetFrameycp_editɒڏj
 struct AviUtlFrame {
-	PIXEL_YC* yc;
-	int w, h;
+	uint8_t* ptr;
+	int pitch; // oCgP
+	int rows;
 	FramePool* pool;
 	AviUtlFrame(PIXEL_YC* yc, int w, int h)
-		: yc(yc), w(w), h(h), pool() { }
-	AviUtlFrame(PIXEL_YC* yc, int w, int h, FramePool* pool)
-		: yc(yc), w(w), h(h), pool(pool) { }
+		: ptr(reinterpret_cast<uint8_t*>(yc)), pitch(w * sizeof(PIXEL_YC)), rows(h), pool() { }
+	AviUtlFrame(uint8_t* ptr, int pitch, int rows, FramePool* pool)
+		: ptr(ptr), pitch(pitch), rows(rows), pool(pool) { }
 	~AviUtlFrame() {
-		if (pool && yc) {
-			pool->Free(yc, w, h);
+		if (pool && ptr) {
+			pool->Free(ptr, pitch * rows);
 		}
 	}
+	PIXEL_YC* yc() const { return reinterpret_cast<PIXEL_YC*>(ptr); }
+	int max_w() const { return pitch / sizeof(PIXEL_YC); }
 };
 
 // AviUtlpWbNNX
@@ -1374,16 +2215,49 @@ class D3DVPAviUtlWork : public D3DVP<std::shared_ptr<AviUtlFrame>, AviUtlErrorHa
 	FILTER *fp_;
 	FILTER_PROC_INFO *fpip_;
 
+	enum {
+		// AviUtl32bitȂ̂ŗ}߂ɂi1080pNV1280t[炢j
+		POOL_BUDGET = 256 * 1024 * 1024,
+	};
+
 	FramePool pool_;
+	int outRowBytes; // o̓t[iNV12/YUY2j
+	int outPitch;
+	int outRows;
+
+	const ConvertFuncs& funcs;
+	ParallelConvert<AviUtlErrorHandler> convert;
+
+	// GetFrameő҂Ăt[ycp_editւ̒ڕϊ
+	// ҂Ăt[󂯎AfromGPUXbhŃLbVɎcĂ邤ycp_editɕϊĂ܂
+	// zXg̃Xbh̓t[󂯎ĂϊȂĂ悭Ȃ
+	CriticalSection directLock;
+	int directFrame;           // ҂Ăo̓t[ԍ
+	PIXEL_YC* directDst;       // ϊinullptr: ҂ĂȂj
+	int directMaxW;
+	std::weak_ptr<AviUtlFrame> directSrc; // ϊt[
+
+	void ToYC48(PIXEL_YC* dst, int max_w, const AviUtlFrame& frame) {
+		if (is420) {
+			convert.nv12_to_yc48(height, width, dst, max_w, frame.ptr, frame.pitch);
+		}
+		else {
+			convert.yuy2_to_yc48(height, width, dst, max_w, frame.ptr, frame.pitch);
+		}
+	}
 
-	void(*nv12_to_yc48)(PIXEL_YC* dst, const uint8_t* src, int pitch, int w, int h, int max_w);
-	void(*yuy2_to_yc48)(PIXEL_YC* dst, const uint8_t* src, int pitch, int w, int h, int max_w);
-	void(*yc48_to_nv12)(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h, int max_w);
-	void(*yc48_to_yuy2)(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h, int max_w);
+	void OnOutputFrame(int n, std::shared_ptr<AviUtlFrame>& frame, AviUtlErrorHandler* env) {
+		auto& lock = with(directLock);
+		if (directDst != nullptr && n == directFrame) {
+			TraceScope trace(tracer, "convert yc48", n);
+			ToYC48(directDst, directMaxW, *frame);
+			directSrc = frame;
+		}
+	}
 
 	std::shared_ptr<AviUtlFrame> NewVideoFrame(AviUtlErrorHandler* env)
 	{
-		return std::make_shared<AviUtlFrame>(pool_.Alloc(width, height), width, height, &pool_);
+		return std::make_shared<AviUtlFrame>(pool_.Alloc(outPitch * outRows), outPitch, outRows, &pool_);
 	}
 
 	std::shared_ptr<AviUtlFrame> GetChildFrame(int n, AviUtlErrorHandler* env)
@@ -1410,73 +2284,104 @@ class D3DVPAviUtlWork : public D3DVP<std::shared_ptr<AviUtlFrame>, AviUtlErrorHa
 			}
 		}
 #if 0
-		auto ret = std::make_shared<AviUtlFrame>(pool_.Alloc(fpip_->max_w, fpip_->h), fpip_->max_w, fpip_->h, &pool_);
-		memcpy(ret->yc, frame_ptr, sizeof(PIXEL_YC)*fpip_->max_w*fpip_->h);
+		int pitch = fpip_->max_w * sizeof(PIXEL_YC);
+		auto ret = std::make_shared<AviUtlFrame>(pool_.Alloc(pitch * fpip_->h), pitch, fpip_->h, &pool_);
+		memcpy(ret->ptr, frame_ptr, pitch*fpip_->h);
 		return ret;
 #else
 		return std::make_shared<AviUtlFrame>(frame_ptr, fpip_->max_w, fpip_->h);
 #endif
 	}
 
-	void ToGPUFrame(std::shared_ptr<AviUtlFrame>& frame, D3D11_MAPPED_SUBRESOURCE res, AviUtlErrorHandler* env) {
+	void ToGPUFrame(std::shared_ptr<AviUtlFrame>& frame, MappedSurface res, AviUtlErrorHandler* env) {
 		uint8_t* dst = static_cast<uint8_t*>(res.pData);
 		if (is420) {
-			yc48_to_nv12(dst, res.RowPitch, frame->yc, srcvi.width, srcvi.height, frame->w);
+			// D3D11̃Xe[WOeNX`͏݌̂Ƃ̂ŃXg[~OXgAŏ
+			// CPUobNGh͂CPUœǂނ̂ŃLbVɎc
+			auto toNV12 = (backendType == BACKEND_D3D11) ? funcs.yc48_to_nv12_stream : funcs.yc48_to_nv12;
+			toNV12(dst, res.RowPitch, frame->yc(), srcvi.width, srcvi.height, frame->max_w());
 		}
 		else {
-			yc48_to_yuy2(dst, res.RowPitch, frame->yc, srcvi.width, srcvi.height, frame->w);
+			funcs.yc48_to_yuy2(dst, res.RowPitch, frame->yc(), srcvi.width, srcvi.height, frame->max_w());
 		}
 	}
 
-	void FromGPUFrame(std::shared_ptr<AviUtlFrame>& frame, D3D11_MAPPED_SUBRESOURCE res, AviUtlErrorHandler* env) {
+	// ǂ݂t[̂ŁAłYC48ɕϊNV12/YUY2̂܂܎Ă
+	// YC486oCg/f̂ŁAŕϊGetFrameł̃Rs[܂߂ē]ʂ{ɂȂ
+	void FromGPUFrame(std::shared_ptr<AviUtlFrame>& frame, MappedSurface res, AviUtlErrorHandler* env) {
 		const uint8_t* src = static_cast<const uint8_t*>(res.pData);
-		if (is420) {
-			nv12_to_yc48(frame->yc, src, res.RowPitch, width, height, frame->w);
-		}
-		else {
-			yuy2_to_yc48(frame->yc, src, res.RowPitch, width, height, frame->w);
+		for (int y = 0; y < outRows; ++y) {
+			memcpy(frame->ptr + frame->pitch * y, src + res.RowPitch * y, outRowBytes);
 		}
 	}
 
 public:
-	D3DVPAviUtlWork(VideoInfo srcvi, bool is420, int mode, int tff, int width, int height, int quality,
+	D3DVPAviUtlWork(VideoInfo srcvi, bool is420, BackendType backendType, int mode, int tff, int width, int height, int quality,
 		int deviceIndex, int cache, int reset, int debug,
 		AviUtlErrorHandler* env)
-		: D3DVP(srcvi, is420 ? DXGI_FORMAT_NV12 : DXGI_FORMAT_YUY2,
-			mode, tff, width, height, quality, "", deviceIndex, cache, reset, debug, env)
+		: D3DVP(srcvi, is420 ? SURFACE_NV12 : SURFACE_YUY2, backendType,
+			mode, tff, width, height, quality, "", deviceIndex, cache, reset, debug, nullptr, env)
 		, is420(is420)
+		, pool_(POOL_BUDGET)
+		, outRowBytes(is420 ? width : width * 2)
+		, outPitch((outRowBytes + 63) & ~63)
+		, outRows(is420 ? height + (height >> 1) : height)
+		, funcs(GetConvertFuncs())
+		, convert(workerPool.get(), funcs)
+		, directFrame(0)
+		, directDst(nullptr)
+		, directMaxW(0)
 	{
-		pool_.SetSetting(width, height);
-		if (CPUID().AVX2()) {
-			yc48_to_nv12 = yc48_to_nv12_avx2;
-			yc48_to_yuy2 = yc48_to_yuy2_avx2;
-			nv12_to_yc48 = nv12_to_yc48_avx2;
-			yuy2_to_yc48 = yuy2_to_yc48_avx2;
-		}
-		else {
-			yc48_to_nv12 = yc48_to_nv12_c;
-			yc48_to_yuy2 = yc48_to_yuy2_c;
-			nv12_to_yc48 = nv12_to_yc48_c;
-			yuy2_to_yc48 = yuy2_to_yc48_c;
-		}
 	}
 
 	~D3DVPAviUtlWork() {
 		JoinThreads();
+		FramePoolStats stats = pool_.GetStats();
+		PRINTF("pool: alloc=%lld,hit=%lld,release=%lld,peak=%lldMB\n",
+			(long long)stats.alloc, (long long)stats.hit, (long long)stats.release, (long long)(stats.peakBytes >> 20));
 	}
 
 	void GetFrame(FILTER *fp, FILTER_PROC_INFO *fpip, int adjust, AviUtlErrorHandler* env) {
 		fp_ = fp;
 		fpip_ = fpip;
-		PutInputFrame(fpip->frame + adjust, true, env);
-		auto out = WaitFrame(fpip->frame + adjust, env);
-		for (int y = 0; y < height; ++y) {
-			memcpy(fpip_->ycp_edit + fpip_->max_w * y, out->yc + out->w * y, width * sizeof(PIXEL_YC));
+		int n = fpip->frame + adjust;
+		{
+			auto& lock = with(directLock);
+			directFrame = n;
+			directDst = fpip_->ycp_edit;
+			directMaxW = fpip_->max_w;
+			directSrc.reset();
+		}
+		std::shared_ptr<AviUtlFrame> out;
+		std::shared_ptr<AviUtlFrame> converted;
+		try {
+			out = GetOutputFrame(n, true, env);
+		}
+		catch (...) {
+			auto& lock = with(directLock);
+			directDst = nullptr;
+			throw;
+		}
+		{
+			auto& lock = with(directLock);
+			directDst = nullptr;
+			converted = directSrc.lock();
+		}
+		if (converted != out) {
+			// LbVɂ̂ŒڕϊĂȂ
+			ToYC48(fpip_->ycp_edit, fpip_->max_w, *out);
 		}
 		fpip_->w = width;
 		fpip_->h = height;
 		PRINTF("GetFrame Finished %d\n", fpip->frame);
 	}
+
+	void StartWarmUp() {
+		StartWarmUpThread(&errorHandler);
+	}
+
+	int SrcWidth() const { return srcvi.width; }
+	int SrcHeight() const { return srcvi.height; }
 };
 
 enum {
@@ -1489,6 +2394,7 @@ class D3DVPAviUtl
 	std::vector<std::string> deviceNames;
 	std::unique_ptr<D3DVPAviUtlWork> w;
 	int gpuindex;
+	int numGPUs; // deviceNames̍ŌCPU
 	std::array<int, TRACK_N> track_c;
 	std::array<int, CHECK_N> check_c;
 	HWND combo;
@@ -1559,6 +2465,7 @@ public:
 		, track_c()
 		, check_c()
 	{
+#ifndef D3DVP_NO_D3D11
 		AviUtlErrorHandler eh;
 		auto env = &eh;
 
@@ -1577,6 +2484,10 @@ public:
 
 			deviceNames.push_back(to_string(desc.Description));
 		}
+#endif
+
+		numGPUs = (int)deviceNames.size();
+		deviceNames.push_back("CPUi\tgEFAj");
 	}
 
 	BOOL WndProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam, void *editp, FILTER *fp)
@@ -1586,6 +2497,12 @@ public:
 			InitDialog(hwnd);
 			SetupRange(fp, editp);
 			return TRUE;
+		case WM_FILTER_FILE_OPEN:
+			OnFileOpen(fp, editp);
+			return FALSE;
+		case WM_FILTER_FILE_CLOSE:
+			w = nullptr;
+			return FALSE;
 		case WM_COMMAND:
 			if (LOWORD(wparam) == ID_GPU_SELECT_COMBO) {
 				if (HIWORD(wparam) == CBN_SELENDOK) {
@@ -1617,42 +2534,66 @@ public:
 		return FALSE;
 	}
 
+	void CreateWork(FILTER *fp, int srcWidth, int srcHeight, AviUtlErrorHandler* env) {
+		VideoInfo srcvi = { 0 };
+		srcvi.width = srcWidth;
+		srcvi.height = srcHeight;
+		srcvi.fps_numerator = 30000;
+		srcvi.fps_denominator = 1001;
+
+		// TCYݒ
+		int width = clamp(fp->track[1], track_s[1], track_e[1]) & ~3;
+		int height = clamp(fp->track[2], track_s[2], track_e[2]) & ~3;
+
+		w = std::unique_ptr<D3DVPAviUtlWork>(new D3DVPAviUtlWork(srcvi,
+			fp->check[6] != 0,
+			(gpuindex < numGPUs) ? BACKEND_D3D11 : BACKEND_CPU,
+			fp->check[0],
+			!fp->check[1],
+			fp->check[2] ? width : srcvi.width,
+			fp->check[2] ? height : srcvi.height,
+			fp->track[0],
+			gpuindex,
+			15, // cache
+			4, // reset
+			fp->check[7],
+			env));
+		w->SetFilter(fp->check[3] != 0,
+			fp->check[4] ? fp->track[3] : -1,
+			fp->check[5] ? fp->track[4] : -1,
+			env);
+	}
+
+	// t@CJƂɁAŏProc܂łɏĂ
+	void OnFileOpen(FILTER *fp, void *editp) {
+		int srcWidth, srcHeight;
+		if (!fp->exfunc->is_filter_active(fp) ||
+			!fp->exfunc->get_frame_size(editp, &srcWidth, &srcHeight)) {
+			return;
+		}
+		AviUtlErrorHandler eh;
+		try {
+			CreateWork(fp, srcWidth, srcHeight, &eh);
+			StoreSetting(fp);
+			w->StartWarmUp();
+		}
+		catch (const std::string&) {
+			// Procłx
+			w = nullptr;
+		}
+	}
+
 	void Proc(FILTER *fp, FILTER_PROC_INFO *fpip, int retry) {
 		AviUtlErrorHandler eh;
 
-		if (IsReset(fp)) {
+		// ÕtB^ŃTCYςĂꍇ
+		if (w && (IsReset(fp) || w->SrcWidth() != fpip->w || w->SrcHeight() != fpip->h)) {
 			w = nullptr;
 		}
-		bool needSetFilter = false;
 		if (w == nullptr) {
-			VideoInfo srcvi = { 0 };
-			srcvi.width = fpip->w;
-			srcvi.height = fpip->h;
-			srcvi.fps_numerator = 30000;
-			srcvi.fps_denominator = 1001;
-
-			// TCYݒ
-			int width = clamp(fp->track[1], track_s[1], track_e[1]) & ~3;
-			int height = clamp(fp->track[2], track_s[2], track_e[2]) & ~3;
-
-			w = std::unique_ptr<D3DVPAviUtlWork>(new D3DVPAviUtlWork(srcvi,
-				fp->check[6] != 0,
-				fp->check[0],
-				!fp->check[1],
-				fp->check[2] ? width : srcvi.width,
-				fp->check[2] ? height : srcvi.height,
-				fp->track[0],
-				gpuindex,
-				15, // cache
-				4, // reset
-				fp->check[7],
-				&eh));
-			needSetFilter = true;
+			CreateWork(fp, fpip->w, fpip->h, &eh);
 		}
 		else if (IsFilterChanged(fp)) {
-			needSetFilter = true;
-		}
-		if (needSetFilter) {
 			w->SetFilter(fp->check[3] != 0,
 				fp->check[4] ? fp->track[3] : -1,
 				fp->check[5] ? fp->track[4] : -1,
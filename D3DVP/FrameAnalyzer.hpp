@@ -0,0 +1,231 @@
+#pragma once
+
+#include <stdint.h>
+#include <limits.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Thread.hpp"
+#include "analyze.h"
+
+// IVTCŎctB[hɑgݍ킹t[
+enum FieldMatch {
+	MATCH_NONE = -2, // ǂgݍ킹ĂȂciǗtB[hjAIVTCĂȂ
+	MATCH_PREV = -1,
+	MATCH_CUR = 0,
+	MATCH_NEXT = 1,
+};
+
+// ̓t[̉͌
+struct FrameInfo {
+	float diff;       // O̓̓t[Ƃ̕ϐ΍i8bitZjBÕt[Ȃ-1
+	bool sceneChange; // Õt[V[ςio̓t[1ڂ̃tB[hĂj
+	bool reuse;       // Ȍo͂ƓɂȂ̂ŏȗđȌo͂g
+	int comb;         // Ȃ̗ʁiubNƂ̎Ȃ̉f̍őljB͂ĂȂ-1
+	bool deinterlaced;// C^iȂȂƔ肵t[̓C^Ȃj
+	int tff;          // 肵tB[hI[_[i1: TFF, 0: BFFjB肵ĂȂ-1
+	int match;        // IVTCőgݍ킹t[iFieldMatchj
+
+	FrameInfo() : diff(-1), sceneChange(false), reuse(false), comb(-1), deinterlaced(true), tff(-1), match(MATCH_NONE) { }
+};
+
+// t[͂sohɕă[J[Xbhŕs
+// ParallelConvertƓv[g
+template <typename ErrorHandler>
+class FrameAnalyzer
+{
+	enum {
+		MIN_BAND_ROWS = 16,
+		MIN_BAND_BYTES = 256 * 1024,
+		COMB_THRESH = 9, // Ȃ̉fƔ肷㉺̍sƂ̍i8bitZj
+	};
+
+	WorkerPool<ErrorHandler>* pool;
+	bool avx2;
+
+	int NumBands(int height, int planeBytes) const {
+		int n = std::min(pool->NumThreads() * 2, std::min(height / MIN_BAND_ROWS, planeBytes / MIN_BAND_BYTES));
+		return std::max(1, n);
+	}
+
+	static int BandStart(int height, int numBands, int band) {
+		return (int)((int64_t)height * band / numBands);
+	}
+
+public:
+	FrameAnalyzer(WorkerPool<ErrorHandler>* pool, bool avx2)
+		: pool(pool)
+		, avx2(avx2)
+	{ }
+
+	// 2t[̓v[̕ϐ΍i8bitZj
+	// bits: f̃rbgi9ȏȂ16bitfj
+	double MeanAbsDiff(const uint8_t* a, int pitchA, const uint8_t* b, int pitchB,
+		int rowBytes, int height, int bits)
+	{
+		auto sad = (bits > 8)
+			? (avx2 ? sad_plane16_avx2 : sad_plane16_c)
+			: (avx2 ? sad_plane_avx2 : sad_plane_c);
+		int numBands = NumBands(height, rowBytes * height);
+		std::vector<uint64_t> sums(numBands);
+		pool->Run(numBands, [&](int band) {
+			sums[band] = sad(a, pitchA, b, pitchB, rowBytes,
+				BandStart(height, numBands, band), BandStart(height, numBands, band + 1));
+		});
+		uint64_t sum = 0;
+		for (uint64_t s : sums) sum += s;
+		int bytesPerPixel = (bits > 8) ? 2 : 1;
+		double pixels = (double)(rowBytes / bytesPerPixel) * height;
+		return sum / pixels / (1 << (std::max(bits, 8) - 8));
+	}
+
+	// Ȃ̗ʁiCOMB_BLOCK x COMB_BLOCKf̃ubNƂ̎Ȃ̉f̍őlj
+	// vObVũt[͏ÂC^[X̃t[͑傫Ȃ
+	int CombScore(const uint8_t* src, int pitch, int rowBytes, int height, int bits)
+	{
+		return WeaveCombScore(src, pitch, src, pitch, rowBytes, height, bits);
+	}
+
+	// stopAsbottomđgݍ킹t[̎Ȃ̗ʁiIVTC̃tB[h}b`pj
+	int WeaveCombScore(const uint8_t* top, int pitchTop, const uint8_t* bottom, int pitchBottom,
+		int rowBytes, int height, int bits)
+	{
+		auto comb = (bits > 8)
+			? (avx2 ? comb_block_max_weave16_avx2 : comb_block_max_weave16_c)
+			: (avx2 ? comb_block_max_weave_avx2 : comb_block_max_weave_c);
+		int thresh = COMB_THRESH << (std::max(bits, 8) - 8);
+		int numBlockRows = (height + COMB_BLOCK - 1) / COMB_BLOCK;
+		int numBands = std::min(NumBands(height, rowBytes * height), numBlockRows);
+		std::vector<int> maxs(numBands);
+		pool->Run(numBands, [&](int band) {
+			maxs[band] = comb(top, pitchTop, bottom, pitchBottom, rowBytes, height, thresh,
+				std::min(height, BandStart(numBlockRows, numBands, band) * COMB_BLOCK),
+				std::min(height, BandStart(numBlockRows, numBands, band + 1) * COMB_BLOCK));
+		});
+		return *std::max_element(maxs.begin(), maxs.end());
+	}
+
+	// tB[hI[_[̔p̍i8bitZ̕ϐ΍j
+	// tffDiff: cur̃{gnext̃gbv̍, bffDiff: cur̃gbvnext̃{g̍
+	void FieldOrderDiff(const uint8_t* cur, int pitchCur, const uint8_t* next, int pitchNext,
+		int rowBytes, int height, int bits, double& tffDiff, double& bffDiff)
+	{
+		tffDiff = bffDiff = 0;
+		if (height < 2) {
+			return;
+		}
+		auto fsad = (bits > 8)
+			? (avx2 ? field_order_sad16_avx2 : field_order_sad16_c)
+			: (avx2 ? field_order_sad_avx2 : field_order_sad_c);
+		int numBands = NumBands(height, rowBytes * height);
+		std::vector<uint64_t> sums(numBands * 2);
+		pool->Run(numBands, [&](int band) {
+			fsad(cur, pitchCur, next, pitchNext, rowBytes, height,
+				BandStart(height, numBands, band), BandStart(height, numBands, band + 1), &sums[band * 2]);
+		});
+		uint64_t top = 0, bottom = 0;
+		for (int i = 0; i < numBands; ++i) {
+			top += sums[i * 2];
+			bottom += sums[i * 2 + 1];
+		}
+		int bytesPerPixel = (bits > 8) ? 2 : 1;
+		double scale = (double)(rowBytes / bytesPerPixel) * (1 << (std::max(bits, 8) - 8));
+		tffDiff = bottom / (scale * (height / 2));
+		bffDiff = top / (scale * ((height + 1) / 2));
+	}
+};
+
+// IVTC̃tB[h}b`
+// combs: ctB[hɑOAÃt[̂̃tB[hgݍ킹Ƃ̎Ȃ̗ʁigȂ͕̂̒lj
+// Ȃ̗ʂԏ́iȂ瓯t[AÕt[̏ɗDjI
+// ǂthresh傫MATCH_NONEiǗtB[hȂ̂ŃC^j
+inline FieldMatch SelectFieldMatch(const int combs[3], int thresh)
+{
+	static const FieldMatch order[] = { MATCH_CUR, MATCH_PREV, MATCH_NEXT };
+	FieldMatch best = MATCH_NONE;
+	int bestComb = INT_MAX;
+	for (FieldMatch m : order) {
+		int comb = combs[m + 1];
+		if (comb >= 0 && comb < bestComb) {
+			best = m;
+			bestComb = comb;
+		}
+	}
+	return (bestComb <= thresh) ? best : MATCH_NONE;
+}
+
+// IVTC̊Ԉ
+// 1TCNi5t[j̒ŁActB[hÕt[ƈԋ߂t[
+// i3:2v_EœtB[h2oĂt[j𗎂Ƃ
+// diffs: et[̎ctB[h̑Õt[Ƃ̕ϐ΍B߂l͗Ƃt[̃TCN̈ʒu
+inline int SelectDropFrame(const double* diffs, int cycle)
+{
+	return (int)(std::min_element(diffs, diffs + cycle) - diffs);
+}
+
+// tB[hI[_[̔
+// WINDOWt[FrameAnalyzer::FieldOrderDiff̍vŁA
+// ЕЕRATIO_NUM/RATIO_DENȂ炻̃I[_[ɂ
+// iMIN_DIFFj͂肵ȂƂ͍̃I[_[̂܂
+class FieldOrderDetector
+{
+	enum {
+		WINDOW = 16,
+		MIN_FRAMES = WINDOW / 2,
+		RATIO_NUM = 3,
+		RATIO_DEN = 4,
+	};
+	static constexpr double MIN_DIFF = 1.0;
+
+	bool tff;
+	double diffs[WINDOW][2];
+	int count;
+	double sumTff, sumBff;
+
+public:
+	FieldOrderDetector(bool tff)
+		: tff(tff)
+		, count(0)
+		, sumTff(0)
+		, sumBff(0)
+	{ }
+
+	bool IsTFF() const { return tff; }
+
+	// t[AĂȂƂ͔蒼iI[_[͂̂܂܁j
+	void Reset() {
+		count = 0;
+		sumTff = sumBff = 0;
+	}
+
+	// ׂ荇2t[̍ǉĔ肷B߂l̓I[_[ς
+	bool Add(double tffDiff, double bffDiff) {
+		double* slot = diffs[count % WINDOW];
+		if (count >= WINDOW) {
+			sumTff -= slot[0];
+			sumBff -= slot[1];
+		}
+		slot[0] = tffDiff;
+		slot[1] = bffDiff;
+		sumTff += tffDiff;
+		sumBff += bffDiff;
+		++count;
+		int n = std::min<int>(count, WINDOW);
+		if (n < MIN_FRAMES || std::max(sumTff, sumBff) < MIN_DIFF * n) {
+			return false;
+		}
+		bool newTff = tff;
+		if (sumTff * RATIO_DEN < sumBff * RATIO_NUM) {
+			newTff = true;
+		}
+		else if (sumBff * RATIO_DEN < sumTff * RATIO_NUM) {
+			newTff = false;
+		}
+		if (newTff == tff) {
+			return false;
+		}
+		tff = newTff;
+		return true;
+	}
+};
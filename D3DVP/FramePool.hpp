@@ -0,0 +1,162 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <vector>
+#include <algorithm>
+#include <new>
+#include "Thread.hpp"
+
+// t[v[̓v
+struct FramePoolStats {
+	int64_t alloc;    // Alloc̉
+	int64_t hit;      // 󂫃XgԂ
+	int64_t release;  // \Z𒴂̂ŉ
+	size_t bytes;     // mۂĂoCgigp+󂫃Xgj
+	size_t peakBytes; // bytes̍ől
+};
+
+// t[obt@̃v[
+// TCYNXiCLASS_BYTESPʂɐ؂グTCYjƂɋ󂫃Xg
+// mۂĂoCgbudget𒴂AgĂȂTCYNX
+// ԁiTCỸt[mہEjł͐VȊmۂ͂Ȃ
+class FramePool : NonCopyable
+{
+public:
+	enum {
+		ALIGN = 64,
+		CLASS_BYTES = 4096,
+	};
+
+	FramePool(size_t budget)
+		: budget_(budget)
+		, stats_()
+	{ }
+
+	~FramePool() {
+		Clear();
+	}
+
+	// budget𒴂Ă镪͋󂫃Xg
+	void SetBudget(size_t budget) {
+		auto&& lock = with(lock_);
+		budget_ = budget;
+		Evict(0, -1);
+	}
+
+	uint8_t* Alloc(size_t bytes) {
+		auto&& lock = with(lock_);
+		size_t size = ClassSize(bytes);
+		SizeClass& sc = GetClass(size);
+		++stats_.alloc;
+		if (sc.free.size() > 0) {
+			uint8_t* ptr = sc.free.back();
+			sc.free.pop_back();
+			++stats_.hit;
+			return ptr;
+		}
+		// ݒ肪ςĎgȂȂTCY̕ɉ
+		Evict(size, (int)(&sc - classes_.data()));
+		uint8_t* ptr = AllocAligned(size);
+		if (ptr == nullptr) {
+			throw std::bad_alloc();
+		}
+		stats_.bytes += size;
+		stats_.peakBytes = std::max(stats_.peakBytes, stats_.bytes);
+		return ptr;
+	}
+
+	// bytesAllocɓn̂Ɠl
+	void Free(uint8_t* ptr, size_t bytes) {
+		auto&& lock = with(lock_);
+		size_t size = ClassSize(bytes);
+		if (stats_.bytes > budget_) {
+			FreeAligned(ptr);
+			stats_.bytes -= size;
+			++stats_.release;
+			return;
+		}
+		GetClass(size).free.push_back(ptr);
+	}
+
+	// 󂫃XgS
+	void Clear() {
+		auto&& lock = with(lock_);
+		for (SizeClass& sc : classes_) {
+			for (uint8_t* ptr : sc.free) {
+				FreeAligned(ptr);
+				stats_.bytes -= sc.size;
+			}
+			sc.free.clear();
+		}
+	}
+
+	FramePoolStats GetStats() const {
+		auto&& lock = with(lock_);
+		return stats_;
+	}
+
+private:
+	struct SizeClass {
+		size_t size;
+		std::vector<uint8_t*> free;
+	};
+
+	mutable CriticalSection lock_;
+	size_t budget_;
+	FramePoolStats stats_;
+	// ɎgTCY͐ނȂ̂Ő`T
+	std::vector<SizeClass> classes_;
+
+	static size_t ClassSize(size_t bytes) {
+		return (bytes + CLASS_BYTES - 1) & ~(size_t)(CLASS_BYTES - 1);
+	}
+
+	SizeClass& GetClass(size_t size) {
+		for (SizeClass& sc : classes_) {
+			if (sc.size == size) {
+				return sc;
+			}
+		}
+		classes_.push_back(SizeClass());
+		classes_.back().size = size;
+		return classes_.back();
+	}
+
+	// VbytesmۂĂbudgetɎ܂悤ɁAkeepȊÕTCYNX̋󂫃Xg
+	// łȂkeep
+	void Evict(size_t bytes, int keep) {
+		for (int pass = 0; pass < 2; ++pass) {
+			for (int i = 0; i < (int)classes_.size(); ++i) {
+				if ((pass == 0) == (i == keep)) {
+					continue;
+				}
+				SizeClass& sc = classes_[i];
+				while (sc.free.size() > 0 && stats_.bytes + bytes > budget_) {
+					FreeAligned(sc.free.back());
+					sc.free.pop_back();
+					stats_.bytes -= sc.size;
+					++stats_.release;
+				}
+			}
+		}
+	}
+
+	static uint8_t* AllocAligned(size_t bytes) {
+#ifdef _MSC_VER
+		return static_cast<uint8_t*>(_aligned_malloc(bytes, ALIGN));
+#else
+		void* ptr;
+		return (posix_memalign(&ptr, ALIGN, bytes) == 0) ? static_cast<uint8_t*>(ptr) : nullptr;
+#endif
+	}
+
+	static void FreeAligned(uint8_t* ptr) {
+#ifdef _MSC_VER
+		_aligned_free(ptr);
+#else
+		free(ptr);
+#endif
+	}
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+
+#include "Thread.hpp"
+#include "convert.h"
+
+// Fϊt[̍sohɕă[J[Xbhŕs
+// eoh1XbhŕϊꍇƓJ[lŏ̂ŁAo͂͊SɓɂȂ
+template <typename ErrorHandler>
+class ParallelConvert
+{
+	enum {
+		MIN_BAND_ROWS = 16,           // 1oh̍ŏs
+		MIN_BAND_BYTES = 256 * 1024,  // 1oh̍ŏoCgiƃXbh؂ւ̕dj
+	};
+
+	WorkerPool<ErrorHandler>* pool;
+	const ConvertFuncs& funcs;
+
+	// oh̓t[TCYƃXbh猈߂
+	// ]EE󂯎̊eXbhv[L̂ŁA
+	// ׂ΂Ȃ悤ɃXbh2{܂ŕ
+	// frameBytes: 1t[̃oCg
+	int NumBands(int height, int frameBytes) const {
+		int bytes = frameBytes;
+		int n = std::min(pool->NumThreads() * 2, std::min(height / MIN_BAND_ROWS, bytes / MIN_BAND_BYTES));
+		return std::max(1, n);
+	}
+
+	// oh̊JnsiFsƂȂ悤ɋɂj
+	static int BandStart(int height, int numBands, int band) {
+		if (band >= numBands) return height;
+		return (int)((int64_t)height * band / numBands) & ~1;
+	}
+
+public:
+	// funcs: gϊ֐iGetConvertFuncs()̖߂lj
+	ParallelConvert(WorkerPool<ErrorHandler>* pool, const ConvertFuncs& funcs)
+		: pool(pool)
+		, funcs(funcs)
+	{ }
+
+	void yuv_to_nv12(int height, int width,
+		uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV)
+	{
+		int numBands = NumBands(height, width * height * 3 / 2);
+		pool->Run(numBands, [&](int band) {
+			funcs.yuv_to_nv12_rows(height, width,
+				BandStart(height, numBands, band), BandStart(height, numBands, band + 1),
+				dst, dstPitch, srcY, srcU, srcV, pitchY, pitchUV);
+		});
+	}
+
+	void nv12_to_yuv(int height, int width,
+		uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch)
+	{
+		int numBands = NumBands(height, width * height * 3 / 2);
+		pool->Run(numBands, [&](int band) {
+			funcs.nv12_to_yuv_rows(height, width,
+				BandStart(height, numBands, band), BandStart(height, numBands, band + 1),
+				dstY, dstU, dstV, pitchY, pitchUV, src, srcPitch);
+		});
+	}
+
+	// sb`uint16_tP
+	void yuv16_to_p010(int height, int width,
+		uint16_t* dst, int dstPitch, const uint16_t* srcY, const uint16_t* srcU, const uint16_t* srcV, int pitchY, int pitchUV, int bits)
+	{
+		int numBands = NumBands(height, width * height * 3);
+		pool->Run(numBands, [&](int band) {
+			funcs.yuv16_to_p010_rows(height, width,
+				BandStart(height, numBands, band), BandStart(height, numBands, band + 1),
+				dst, dstPitch, srcY, srcU, srcV, pitchY, pitchUV, bits);
+		});
+	}
+
+	void p010_to_yuv16(int height, int width,
+		uint16_t* dstY, uint16_t* dstU, uint16_t* dstV, int pitchY, int pitchUV, const uint16_t* src, int srcPitch, int bits)
+	{
+		int numBands = NumBands(height, width * height * 3);
+		pool->Run(numBands, [&](int band) {
+			funcs.p010_to_yuv16_rows(height, width,
+				BandStart(height, numBands, band), BandStart(height, numBands, band + 1),
+				dstY, dstU, dstV, pitchY, pitchUV, src, srcPitch, bits);
+		});
+	}
+
+	void yuv422_to_yuy2(int height, int width,
+		uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV)
+	{
+		int numBands = NumBands(height, width * height * 2);
+		pool->Run(numBands, [&](int band) {
+			funcs.yuv422_to_yuy2_rows(width,
+				BandStart(height, numBands, band), BandStart(height, numBands, band + 1),
+				dst, dstPitch, srcY, srcU, srcV, pitchY, pitchUV);
+		});
+	}
+
+	void yuy2_to_yuv422(int height, int width,
+		uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch)
+	{
+		int numBands = NumBands(height, width * height * 2);
+		pool->Run(numBands, [&](int band) {
+			funcs.yuy2_to_yuv422_rows(width,
+				BandStart(height, numBands, band), BandStart(height, numBands, band + 1),
+				dstY, dstU, dstV, pitchY, pitchUV, src, srcPitch);
+		});
+	}
+
+	void yuv444_to_ayuv(int height, int width,
+		uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV)
+	{
+		int numBands = NumBands(height, width * height * 3);
+		pool->Run(numBands, [&](int band) {
+			funcs.yuv444_to_ayuv_rows(width,
+				BandStart(height, numBands, band), BandStart(height, numBands, band + 1),
+				dst, dstPitch, srcY, srcU, srcV, pitchY, pitchUV);
+		});
+	}
+
+	void ayuv_to_yuv444(int height, int width,
+		uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch)
+	{
+		int numBands = NumBands(height, width * height * 3);
+		pool->Run(numBands, [&](int band) {
+			funcs.ayuv_to_yuv444_rows(width,
+				BandStart(height, numBands, band), BandStart(height, numBands, band + 1),
+				dstY, dstU, dstV, pitchY, pitchUV, src, srcPitch);
+		});
+	}
+
+	// AviUtliYC48jAmax_w͉fP
+	void nv12_to_yc48(int height, int width, PIXEL_YC* dst, int max_w, const uint8_t* src, int srcPitch)
+	{
+		int numBands = NumBands(height, width * height * 6);
+		pool->Run(numBands, [&](int band) {
+			funcs.nv12_to_yc48_rows(height, width,
+				BandStart(height, numBands, band), BandStart(height, numBands, band + 1),
+				dst, max_w, src, srcPitch);
+		});
+	}
+
+	void yuy2_to_yc48(int height, int width, PIXEL_YC* dst, int max_w, const uint8_t* src, int srcPitch)
+	{
+		int numBands = NumBands(height, width * height * 6);
+		pool->Run(numBands, [&](int band) {
+			int yStart = BandStart(height, numBands, band);
+			int yEnd = BandStart(height, numBands, band + 1);
+			funcs.yuy2_to_yc48(dst + yStart * max_w, src + yStart * srcPitch, srcPitch, width, yEnd - yStart, max_w);
+		});
+	}
+};
@@ -0,0 +1,338 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <string>
+#include <algorithm>
+#include "Thread.hpp"
+
+// pCvC̊eȉԂƁAXbhԃL[̐[̓v
+// sɗLɂL^ĩRXg̓tO̊mFj
+// L^͊eĩXbh烍bNȂōsAǂݏo͕ʃXbhXibvVbg
+
+enum PipelineStage {
+	STAGE_TO_GPU,   // toNV12Receivedi̓t[̕ϊƓ]pT[tFXւ̏݁j
+	STAGE_PROCESS,  // processReceivediAbv[hAVideoProcessorBltA[hobNj
+	STAGE_FROM_GPU, // fromNV12Receivedi}bvƏo̓t[ւ̕ϊj
+	STAGE_WAIT,     // WaitFrameiĂяoo͂҂ԁj
+	NUM_STAGES,
+};
+
+enum PipelineQueue {
+	QUEUE_TO_GPU,
+	QUEUE_PROCESS,
+	QUEUE_FROM_GPU,
+	NUM_QUEUES,
+};
+
+struct LatencySnapshot {
+	enum { NUM_BUCKETS = 32 };
+	int64_t count;
+	int64_t sumUs;
+	int64_t maxUs;
+	int64_t buckets[NUM_BUCKETS];
+
+	void Merge(const LatencySnapshot& o) {
+		count += o.count;
+		sumUs += o.sumUs;
+		maxUs = std::max(maxUs, o.maxUs);
+		for (int i = 0; i < NUM_BUCKETS; ++i) {
+			buckets[i] += o.buckets[i];
+		}
+	}
+
+	double MeanUs() const {
+		return count ? (double)sumUs / count : 0;
+	}
+
+	// pi0-1j̃p[Z^C
+	// oPbg̏[Ԃ̂ōő2{炢̌덷imaxUs͒Ȃj
+	int64_t PercentileUs(double p) const {
+		int64_t target = (int64_t)(p * count + 0.5);
+		int64_t acc = 0;
+		for (int i = 0; i < NUM_BUCKETS; ++i) {
+			acc += buckets[i];
+			if (acc >= target && acc > 0) {
+				return std::min(maxUs, ((int64_t)1 << i) - 1);
+			}
+		}
+		return maxUs;
+	}
+};
+
+// Ԃ̃qXgO
+// oPbgi[2^(i-1), 2^i)}CNbii=01usj
+class LatencyHistogram : NonCopyable
+{
+public:
+	LatencyHistogram() { Reset(); }
+
+	void Record(int64_t us) {
+		int bucket = 0;
+		for (uint64_t v = (uint64_t)std::max<int64_t>(us, 0); v > 0 && bucket < LatencySnapshot::NUM_BUCKETS - 1; v >>= 1) {
+			++bucket;
+		}
+		buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+		count_.fetch_add(1, std::memory_order_relaxed);
+		sumUs_.fetch_add(us, std::memory_order_relaxed);
+		int64_t prev = maxUs_.load(std::memory_order_relaxed);
+		while (us > prev && !maxUs_.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {}
+	}
+
+	void Reset() {
+		for (int i = 0; i < LatencySnapshot::NUM_BUCKETS; ++i) {
+			buckets_[i].store(0);
+		}
+		count_.store(0);
+		sumUs_.store(0);
+		maxUs_.store(0);
+	}
+
+	LatencySnapshot Snapshot() const {
+		LatencySnapshot s;
+		for (int i = 0; i < LatencySnapshot::NUM_BUCKETS; ++i) {
+			s.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+		}
+		s.count = count_.load(std::memory_order_relaxed);
+		s.sumUs = sumUs_.load(std::memory_order_relaxed);
+		s.maxUs = maxUs_.load(std::memory_order_relaxed);
+		return s;
+	}
+
+private:
+	std::atomic<int64_t> buckets_[LatencySnapshot::NUM_BUCKETS];
+	std::atomic<int64_t> count_;
+	std::atomic<int64_t> sumUs_;
+	std::atomic<int64_t> maxUs_;
+};
+
+struct QueueSnapshot {
+	int capacity;
+	int64_t samples;
+	int64_t sum;
+	int last;
+	int max;
+
+	void Merge(const QueueSnapshot& o) {
+		capacity = std::max(capacity, o.capacity);
+		samples += o.samples;
+		sum += o.sum;
+		last = std::max(last, o.last);
+		max = std::max(max, o.max);
+	}
+
+	double Mean() const {
+		return samples ? (double)sum / samples : 0;
+	}
+};
+
+// L[̐[iput̗vfTvOj
+// tȂiAȂOi{glbN
+class QueueGauge : NonCopyable
+{
+public:
+	QueueGauge() : capacity_(0) { Reset(); }
+
+	void SetCapacity(int capacity) { capacity_ = capacity; }
+
+	void Sample(int depth) {
+		samples_.fetch_add(1, std::memory_order_relaxed);
+		sum_.fetch_add(depth, std::memory_order_relaxed);
+		last_.store(depth, std::memory_order_relaxed);
+		int prev = max_.load(std::memory_order_relaxed);
+		while (depth > prev && !max_.compare_exchange_weak(prev, depth, std::memory_order_relaxed)) {}
+	}
+
+	void Reset() {
+		samples_.store(0);
+		sum_.store(0);
+		last_.store(0);
+		max_.store(0);
+	}
+
+	QueueSnapshot Snapshot() const {
+		QueueSnapshot s;
+		s.capacity = capacity_;
+		s.samples = samples_.load(std::memory_order_relaxed);
+		s.sum = sum_.load(std::memory_order_relaxed);
+		s.last = last_.load(std::memory_order_relaxed);
+		s.max = max_.load(std::memory_order_relaxed);
+		return s;
+	}
+
+private:
+	int capacity_;
+	std::atomic<int64_t> samples_;
+	std::atomic<int64_t> sum_;
+	std::atomic<int> last_;
+	std::atomic<int> max_;
+};
+
+struct PipelineSnapshot {
+	LatencySnapshot stages[NUM_STAGES];
+	QueueSnapshot queues[NUM_QUEUES];
+	LatencySnapshot lockWait; // foCXbN̑҂ԁicount͎擾񐔁j
+	LatencySnapshot lockHold; // foCXbN̕ێ
+	int64_t batches;          // process̃ob`
+	int64_t batchFrames;      // ob`ŏ̓t[
+	double seconds; // LɂĂ̌oߎ
+
+	// CX^X̍vioߎԂ͒j
+	void Merge(const PipelineSnapshot& o) {
+		for (int i = 0; i < NUM_STAGES; ++i) stages[i].Merge(o.stages[i]);
+		for (int i = 0; i < NUM_QUEUES; ++i) queues[i].Merge(o.queues[i]);
+		lockWait.Merge(o.lockWait);
+		lockHold.Merge(o.lockHold);
+		batches += o.batches;
+		batchFrames += o.batchFrames;
+		seconds = std::max(seconds, o.seconds);
+	}
+
+	std::string Format() const {
+		static const char* stageNames[] = { "toGPU", "process", "fromGPU", "wait" };
+		static const char* queueNames[] = { "toGPU", "process", "fromGPU" };
+		std::string s;
+		char buf[256];
+		const LatencySnapshot& out = stages[STAGE_WAIT];
+		snprintf(buf, sizeof(buf), "frames: %lld, %.1f fps\n",
+			(long long)out.count, (seconds > 0) ? out.count / seconds : 0.0);
+		s += buf;
+		s += "stage    count     mean(ms) p50(ms)  p90(ms)  p99(ms)  max(ms)\n";
+		for (int i = 0; i < NUM_STAGES; ++i) {
+			s += FormatLatency(stageNames[i], stages[i]);
+		}
+		// foCXbNiobNGhD3D11̂Ƃ̂݁j
+		if (lockWait.count > 0) {
+			s += FormatLatency("lockWait", lockWait);
+			s += FormatLatency("lockHold", lockHold);
+			int64_t inputFrames = stages[STAGE_PROCESS].count;
+			snprintf(buf, sizeof(buf), "deviceLock: %.2f per input frame, wait %.1fms, hold %.1fms in total\n",
+				inputFrames ? (double)lockWait.count / inputFrames : 0.0,
+				lockWait.sumUs / 1000.0, lockHold.sumUs / 1000.0);
+			s += buf;
+		}
+		if (batches > 0) {
+			snprintf(buf, sizeof(buf), "batch: %lld, %.2f frames per batch\n",
+				(long long)batches, (double)batchFrames / batches);
+			s += buf;
+		}
+		s += "queue    capacity last     mean     max\n";
+		for (int i = 0; i < NUM_QUEUES; ++i) {
+			const QueueSnapshot& q = queues[i];
+			snprintf(buf, sizeof(buf), "%-8s %-8d %-8d %-8.2f %-8d\n",
+				queueNames[i], q.capacity, q.last, q.Mean(), q.max);
+			s += buf;
+		}
+		return s;
+	}
+
+private:
+	static std::string FormatLatency(const char* name, const LatencySnapshot& st) {
+		char buf[256];
+		snprintf(buf, sizeof(buf), "%-8s %-9lld %-8.3f %-8.3f %-8.3f %-8.3f %-8.3f\n",
+			name, (long long)st.count, st.MeanUs() / 1000,
+			st.PercentileUs(0.5) / 1000.0, st.PercentileUs(0.9) / 1000.0,
+			st.PercentileUs(0.99) / 1000.0, st.maxUs / 1000.0);
+		return buf;
+	}
+};
+
+class PipelineStats : NonCopyable
+{
+public:
+	PipelineStats() : enabled_(false), start_(0), batches_(0), batchFrames_(0) { }
+
+	bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+	// LɂƓvZbgċL^n߂
+	void Enable(bool enable) {
+		if (enable) {
+			for (int i = 0; i < NUM_STAGES; ++i) stages_[i].Reset();
+			for (int i = 0; i < NUM_QUEUES; ++i) queues_[i].Reset();
+			lockWait_.Reset();
+			lockHold_.Reset();
+			batches_.store(0);
+			batchFrames_.store(0);
+			start_ = GetPerfCounter();
+		}
+		enabled_.store(enable);
+	}
+
+	void SetQueueCapacity(PipelineQueue queue, int capacity) {
+		queues_[queue].SetCapacity(capacity);
+	}
+
+	void SampleQueue(PipelineQueue queue, int depth) {
+		if (Enabled()) {
+			queues_[queue].Sample(depth);
+		}
+	}
+
+	// foCXbN̑҂ԂƕێԁiGetPerfCounter̒PʁjL^
+	void RecordLock(int64_t waitTicks, int64_t holdTicks) {
+		if (Enabled()) {
+			lockWait_.Record(TicksToUs(waitTicks));
+			lockHold_.Record(TicksToUs(holdTicks));
+		}
+	}
+
+	// processł܂Ƃ߂ď̓t[L^
+	void RecordBatch(int frames) {
+		if (Enabled()) {
+			batches_.fetch_add(1, std::memory_order_relaxed);
+			batchFrames_.fetch_add(frames, std::memory_order_relaxed);
+		}
+	}
+
+	// XR[v̏ԂL^
+	class Scope : NonCopyable
+	{
+	public:
+		Scope(PipelineStats& stats, PipelineStage stage)
+			: stats_(stats.Enabled() ? &stats : nullptr)
+			, stage_(stage)
+			, start_(stats_ ? GetPerfCounter() : 0)
+		{ }
+		~Scope() {
+			if (stats_) {
+				stats_->stages_[stage_].Record(TicksToUs(GetPerfCounter() - start_));
+			}
+		}
+	private:
+		PipelineStats* stats_;
+		PipelineStage stage_;
+		int64_t start_;
+	};
+
+	PipelineSnapshot Snapshot() const {
+		PipelineSnapshot s;
+		for (int i = 0; i < NUM_STAGES; ++i) s.stages[i] = stages_[i].Snapshot();
+		for (int i = 0; i < NUM_QUEUES; ++i) s.queues[i] = queues_[i].Snapshot();
+		s.lockWait = lockWait_.Snapshot();
+		s.lockHold = lockHold_.Snapshot();
+		s.batches = batches_.load(std::memory_order_relaxed);
+		s.batchFrames = batchFrames_.load(std::memory_order_relaxed);
+		s.seconds = Enabled() ? (double)(GetPerfCounter() - start_) / Frequency() : 0;
+		return s;
+	}
+
+private:
+	std::atomic<bool> enabled_;
+	int64_t start_;
+	LatencyHistogram stages_[NUM_STAGES];
+	QueueGauge queues_[NUM_QUEUES];
+	LatencyHistogram lockWait_;
+	LatencyHistogram lockHold_;
+	std::atomic<int64_t> batches_;
+	std::atomic<int64_t> batchFrames_;
+
+	static int64_t Frequency() {
+		static const int64_t freq = GetPerfFrequency();
+		return freq;
+	}
+
+	static int64_t TicksToUs(int64_t ticks) {
+		return ticks * 1000000 / Frequency();
+	}
+};
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <exception>
+
+#include "Thread.hpp"
+
+// [J[̓Nbṽt[擾邽߂̂
+template <typename FrameType>
+class SourceFetcher
+{
+public:
+	virtual ~SourceFetcher() { }
+	// 擾ł܂ő҂
+	virtual FrameType Fetch(int n) = 0;
+};
+
+// t[񏈗
+// Nbvo̓t[segmentƂ̃ZOgɕāÃ[J[ɏԂɊ蓖Ă
+// eCX^X̓ZOg̐擪ŃZbĝŁAZbgɓǂݍޑOt[
+// iPastFrames + resetjZOgԂ̏dȂƂȂAȂڂ͏oȂ
+// vꂽZOǧ̃ZOg𑼂̃CX^XŐɏĂƂ
+// Ԃ1t[vꍇłCX^XɉđȂ
+//
+// [J[͐pXbhii[jœA̓Nbṽt[
+// zXgmȂXbh擾łȂ̂ŁAi[Fetch()ŗvoɂ
+// GetFrame()Ă񂾃zXg̃XbhɎ擾ēn
+// Worker FrameType GetFrame(int n, ErrorHandler* env) 
+// void SetSourceFetcher(SourceFetcher<FrameType>* fetcher) 
+template <typename Worker, typename FrameType, typename ErrorHandler>
+class SegmentParallel : public SourceFetcher<FrameType>
+{
+public:
+	// ̓Nbṽt[n擾izXg̃XbhŌĂ΂j
+	typedef std::function<FrameType(int n, ErrorHandler* env)> FetchFunc;
+
+	enum {
+		KEEP_FRAMES = 16, // vꂽt[OɎcĂt[iMTőOサėv邽߁j
+	};
+
+private:
+	// i[̓̓t[̗vivi[̃X^bNɂj
+	struct SourceRequest {
+		int n;
+		FrameType frame;
+		std::exception_ptr exception;
+		bool done;
+	};
+
+	// 1CX^X
+	// pXbhŊ蓖ĂꂽZOg擪珇ɏāAʂ߂Ă
+	// Ԃׂ͂Đelockŕی삷
+	class SegmentRunner : public ThreadBase<ErrorHandler>
+	{
+		SegmentParallel* parent;
+		std::unique_ptr<Worker> worker;
+
+		int segment;    // 蓖ĂꂽZOgԍi-1: Ȃj
+		int next, end;  // ɏt[ƏI[
+		int doneStart;  // done[0]̃t[ԍ
+		std::deque<FrameType> done;
+		int maxDone;
+		int generation; // 蓖Ăς邽тɑ₷
+		int users;      // ݂̊蓖Ẵt[҂ĂGet()̐
+		std::exception_ptr exception;
+		ErrorHandler* curEnv;
+
+		void Assign(int segment, int start, int end, ErrorHandler* env) {
+			this->segment = segment;
+			this->next = start;
+			this->end = end;
+			doneStart = start;
+			done.clear();
+			exception = nullptr;
+			++generation;
+			users = 0;
+			curEnv = env;
+			parent->cond.broadcast();
+		}
+
+	protected:
+		virtual void run() {
+			while (true) {
+				int n, gen;
+				ErrorHandler* env;
+				{
+					auto&& l = with(parent->lock);
+					while (!parent->finished && !(next < end && (int)done.size() < maxDone)) {
+						parent->cond.wait(parent->lock);
+					}
+					if (parent->finished) return;
+					n = next++;
+					gen = generation;
+					env = curEnv;
+				}
+				FrameType frame;
+				std::exception_ptr ex;
+				try {
+					frame = worker->GetFrame(n, env);
+				}
+				catch (...) {
+					ex = std::current_exception();
+				}
+				auto&& l = with(parent->lock);
+				if (gen != generation) {
+					// Ɋ蓖Ăς̂Ŏ̂Ă
+					continue;
+				}
+				if (ex) {
+					exception = ex;
+					next = end;
+				}
+				else {
+					done.push_back(frame);
+				}
+				parent->cond.broadcast();
+			}
+		}
+
+	public:
+		SegmentRunner(SegmentParallel* parent, Worker* worker, int segmentLength, ErrorHandler* env)
+			: ThreadBase<ErrorHandler>(env)
+			, parent(parent)
+			, worker(worker)
+			, segment(-1)
+			, next(0)
+			, end(0)
+			, doneStart(0)
+			, maxDone(segmentLength + KEEP_FRAMES)
+			, generation(0)
+			, users(0)
+			, curEnv(env)
+		{
+			this->start();
+		}
+
+		// efinished𗧂ĂĂj邱
+		~SegmentRunner() {
+			this->join();
+		}
+
+		Worker* GetWorker() { return worker.get(); }
+
+		// ȉlockԂŌĂԂ
+
+		// ǂ
+		// ṽZOgicurrentjOĂAsvȂ̂ŐVZOg蓖Ă
+		void Prefetch(int segment, int start, int end, int current, ErrorHandler* env) {
+			if (this->segment != segment && this->segment < current && users == 0) {
+				Assign(segment, start, end, env);
+			}
+		}
+
+		FrameType Get(int n, int segment, int end, ErrorHandler* env) {
+			int myGen = -1; // usersɐĂ銄蓖āi-1: ĂȂj
+			auto unregister = [&]() {
+				if (myGen == generation) {
+					if (--users == 0) {
+						// 蓖đ҂̃XbhN
+						parent->cond.broadcast();
+					}
+				}
+				myGen = -1;
+			};
+			while (true) {
+				if (this->segment != segment || n < doneStart || n >= this->end) {
+					unregister();
+					if (users > 0) {
+						// ̃Xbh҂Ăt[̂ŁAꂪIĂ犄蓖Ă
+						parent->Wait(env);
+						continue;
+					}
+					// vꂽt[珈
+					Assign(segment, n, end, env);
+				}
+				if (myGen != generation) {
+					++users;
+					myGen = generation;
+				}
+				// Ât[̂Ă
+				bool dropped = false;
+				while (done.size() > 0 && doneStart < n - KEEP_FRAMES) {
+					done.pop_front();
+					++doneStart;
+					dropped = true;
+				}
+				if (dropped) {
+					parent->cond.broadcast();
+				}
+				if (n < doneStart + (int)done.size()) {
+					unregister();
+					return done[n - doneStart];
+				}
+				if (exception) {
+					auto ex = exception;
+					unregister();
+					// ͂蒼
+					this->segment = -1;
+					std::rethrow_exception(ex);
+				}
+				parent->Wait(env);
+			}
+		}
+	};
+
+	ErrorHandler* env;
+	FetchFunc fetch;
+	int segmentLength;
+	int numFrames;
+
+	CriticalSection lock;
+	CondWait cond;
+	bool finished;
+	std::deque<SourceRequest*> sourceQ; // ܂N擾ĂȂv
+
+	std::vector<std::unique_ptr<SegmentRunner>> runners;
+
+	// lockԂŌĂԂ
+	// v1擾āi擾lockjtrueԂ
+	bool ServeSource(ErrorHandler* env) {
+		if (sourceQ.empty()) {
+			return false;
+		}
+		SourceRequest* req = sourceQ.front();
+		sourceQ.pop_front();
+		lock.exit();
+		try {
+			req->frame = fetch(req->n, env);
+		}
+		catch (...) {
+			req->exception = std::current_exception();
+		}
+		lock.enter();
+		req->done = true;
+		cond.broadcast();
+		return true;
+	}
+
+	// lockԂŌĂԂ
+	// i[vĂΎ擾āAȂΏԂς܂ő҂
+	void Wait(ErrorHandler* env) {
+		if (!ServeSource(env)) {
+			cond.wait(lock);
+		}
+	}
+
+public:
+	// workers̏L󂯎
+	SegmentParallel(const std::vector<Worker*>& workers, const FetchFunc& fetch, int segmentLength, int numFrames, ErrorHandler* env)
+		: env(env)
+		, fetch(fetch)
+		, segmentLength(segmentLength)
+		, numFrames(numFrames)
+		, finished(false)
+	{
+		for (auto w : workers) {
+			w->SetSourceFetcher(this);
+			runners.emplace_back(new SegmentRunner(this, w, segmentLength, env));
+		}
+	}
+
+	~SegmentParallel() {
+		{
+			auto&& l = with(lock);
+			finished = true;
+			cond.broadcast();
+		}
+		runners.clear();
+	}
+
+	// i[̃XbhĂ΂
+	FrameType Fetch(int n) {
+		SourceRequest req;
+		req.n = n;
+		req.frame = FrameType();
+		req.done = false;
+		auto&& l = with(lock);
+		sourceQ.push_back(&req);
+		cond.broadcast();
+		while (!req.done) {
+			if (finished) {
+				auto it = std::find(sourceQ.begin(), sourceQ.end(), &req);
+				if (it != sourceQ.end()) {
+					sourceQ.erase(it);
+					env->ThrowError("[D3DVP Error] parallel processing finished");
+				}
+				// 擾Ȃ̂ŏÎ҂
+			}
+			cond.wait(lock);
+		}
+		if (req.exception) {
+			std::rethrow_exception(req.exception);
+		}
+		return req.frame;
+	}
+
+	FrameType GetFrame(int n, ErrorHandler* env) {
+		int numInstances = (int)runners.size();
+		int seg = n / segmentLength;
+		auto&& l = with(lock);
+		// ǑĂяo痭܂Ăv擾ĂizXg҂ĂȂԂǂ݂i߂邽߁j
+		for (size_t i = sourceQ.size(); i > 0; --i) {
+			ServeSource(env);
+		}
+		// ̃ZOg󂢂ĂCX^XɊ蓖Ă
+		for (int k = 1; k < numInstances; ++k) {
+			int s = seg + k;
+			int start = s * segmentLength;
+			if (start >= numFrames) break;
+			runners[s % numInstances]->Prefetch(s, start, std::min(numFrames, start + segmentLength), seg, env);
+		}
+		int end = std::min(numFrames, (seg + 1) * segmentLength);
+		return runners[seg % numInstances]->Get(n, seg, end, env);
+	}
+
+	int NumWorkers() const { return (int)runners.size(); }
+	Worker* GetWorker(int i) { return runners[i]->GetWorker(); }
+	// t[ñZOg蓖Ă郏[J[
+	Worker* GetWorkerFor(int n) { return GetWorker((std::max(0, n) / segmentLength) % NumWorkers()); }
+};
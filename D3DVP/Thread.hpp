@@ -1,9 +1,40 @@
 #pragma once
 
+// WindowsȊOA܂THREAD_STD`ꍇC++WCuŎ
+// iLinuxł̃x`}[NXbhTj^CUł̌ؗpj
+#if defined(_WIN32) && !defined(THREAD_STD)
+#define THREAD_WIN32 1
+#else
+#define THREAD_WIN32 0
+#endif
+
+#if THREAD_WIN32
 #include <Windows.h>
 #include <process.h>
+#else
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <system_error>
+#endif
+
+#include <stdint.h>
 
 #include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h> // _mm_pause
+#define CPU_RELAX() _mm_pause()
+#else
+#define CPU_RELAX() std::this_thread::yield()
+#endif
 
 // Rs[֎~IuWFNg
 class NonCopyable
@@ -13,7 +44,7 @@ protected:
 	~NonCopyable() {} /// protected Ȕ񉼑zfXgN^
 private:
 	NonCopyable(const NonCopyable &);
-	NonCopyable& operator=(const NonCopyable &) { }
+	NonCopyable& operator=(const NonCopyable &);
 };
 
 // with idiom T|[g //
@@ -39,6 +70,8 @@ WithHolder<T> with(T& obj) {
 
 class CondWait;
 
+#if THREAD_WIN32
+
 class CriticalSection : NonCopyable
 {
 public:
@@ -79,6 +112,62 @@ private:
 	CONDITION_VARIABLE cond_val_;
 };
 
+inline int64_t GetPerfCounter() {
+	int64_t cur;
+	QueryPerformanceCounter((LARGE_INTEGER*)&cur);
+	return cur;
+}
+
+inline int64_t GetPerfFrequency() {
+	int64_t freq;
+	QueryPerformanceFrequency((LARGE_INTEGER*)&freq);
+	return freq;
+}
+
+#else // THREAD_WIN32
+
+// CRITICAL_SECTIONƓAXbhēł
+class CriticalSection : NonCopyable
+{
+public:
+	void enter() {
+		mutex_.lock();
+	}
+	void exit() {
+		mutex_.unlock();
+	}
+private:
+	std::recursive_mutex mutex_;
+
+	friend CondWait;
+};
+
+class CondWait : NonCopyable
+{
+public:
+	void wait(CriticalSection& cs) {
+		cond_val_.wait(cs.mutex_);
+	}
+	void signal() {
+		cond_val_.notify_one();
+	}
+	void broadcast() {
+		cond_val_.notify_all();
+	}
+private:
+	std::condition_variable_any cond_val_;
+};
+
+inline int64_t GetPerfCounter() {
+	return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+inline int64_t GetPerfFrequency() {
+	return std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num;
+}
+
+#endif // THREAD_WIN32
+
 class Stopwatch
 {
 	int64_t sum;
@@ -95,20 +184,17 @@ public:
 	}
 
 	void start() {
-		QueryPerformanceCounter((LARGE_INTEGER*)&prev);
+		prev = GetPerfCounter();
 	}
 
 	void stop() {
-		int64_t cur;
-		QueryPerformanceCounter((LARGE_INTEGER*)&cur);
+		int64_t cur = GetPerfCounter();
 		sum += cur - prev;
 		prev = cur;
 	}
 
 	double getTotal() const {
-		int64_t freq;
-		QueryPerformanceFrequency((LARGE_INTEGER*)&freq);
-		return (double)sum / freq;
+		return (double)sum / GetPerfFrequency();
 	}
 
 	double getAndReset() {
@@ -128,6 +214,7 @@ class ThreadBase
 public:
 	ErrorHandler* env;
 
+#if THREAD_WIN32
 	ThreadBase(ErrorHandler* env) : env(env), thread_handle_(NULL) { }
 	~ThreadBase() {
 		if (thread_handle_ != NULL) {
@@ -151,11 +238,38 @@ public:
 		}
 	}
 	bool isRunning() { return thread_handle_ != NULL; }
+#else
+	ThreadBase(ErrorHandler* env) : env(env) { }
+	~ThreadBase() {
+		if (thread_object_) {
+			env->ThrowError("finish join() before destroy object ...");
+		}
+	}
+	void start() {
+		if (thread_object_) {
+			env->ThrowError("thread already started ...");
+		}
+		try {
+			thread_object_ = std::unique_ptr<std::thread>(new std::thread(thread_, this));
+		}
+		catch (const std::system_error&) {
+			env->ThrowError("failed to begin pump thread ...");
+		}
+	}
+	void join() {
+		if (thread_object_) {
+			thread_object_->join();
+			thread_object_ = nullptr;
+		}
+	}
+	bool isRunning() { return thread_object_ != nullptr; }
+#endif
 
 protected:
 	virtual void run() = 0;
 
 private:
+#if THREAD_WIN32
 	HANDLE thread_handle_;
 
 	static unsigned __stdcall thread_(void* arg) {
@@ -167,6 +281,13 @@ private:
 		}
 		return 0;
 	}
+#else
+	std::unique_ptr<std::thread> thread_object_;
+
+	static void thread_(ThreadBase* this_) {
+		this_->run();
+	}
+#endif
 };
 
 template <typename T, typename ErrorHandler, bool PERF = false>
@@ -174,7 +295,7 @@ class DataPumpThread : private ThreadBase<ErrorHandler>
 {
 public:
 	DataPumpThread(size_t maximum, ErrorHandler* env)
-		: ThreadBase(env)
+		: ThreadBase<ErrorHandler>(env)
 		, maximum_(maximum)
 		, current_(0)
 		, finished_(false)
@@ -182,13 +303,13 @@ public:
 
 	~DataPumpThread() {
 		if (isRunning()) {
-			env->ThrowError("call join() before destroy object ...");
+			this->env->ThrowError("call join() before destroy object ...");
 		}
 	}
 
 	void put(T&& data)
 	{
-		auto& lock = with(critical_section_);
+		auto&& lock = with(critical_section_);
 		while (current_ >= maximum_) {
 			if (PERF) producer.start();
 			cond_full_.wait(critical_section_);
@@ -205,27 +326,35 @@ public:
 		finished_ = false;
 		producer.reset();
 		consumer.reset();
-		ThreadBase::start();
+		ThreadBase<ErrorHandler>::start();
 	}
 
 	void join() {
 		{
-			auto& lock = with(critical_section_);
+			auto&& lock = with(critical_section_);
 			finished_ = true;
 			cond_empty_.signal();
 		}
-		ThreadBase::join();
+		ThreadBase<ErrorHandler>::join();
 		data_.clear();
 		current_ = 0;
 	}
 
-	bool isRunning() { return ThreadBase::isRunning(); }
+	bool isRunning() { return ThreadBase<ErrorHandler>::isRunning(); }
 
 	void getTotalWait(double& prod, double& cons) {
 		prod = producer.getTotal();
 		cons = consumer.getTotal();
 	}
 
+	// L[ɂ܂Ă鐔
+	size_t size() {
+		auto&& lock = with(critical_section_);
+		return current_;
+	}
+
+	size_t capacity() const { return maximum_; }
+
 protected:
 	virtual void OnDataReceived(T&& data) = 0;
 
@@ -249,7 +378,7 @@ private:
 		while (true) {
 			T data;
 			{
-				auto& lock = with(critical_section_);
+				auto&& lock = with(critical_section_);
 				while (data_.size() == 0) {
 					if (finished_) return;
 					if (PERF) consumer.start();
@@ -269,3 +398,393 @@ private:
 		}
 	}
 };
+
+// 1vf[TE1RV[}p̌Œ蒷Oobt@
+// 󂯓n̂̓bNȂōsA҂Ƃ΂炭XsĂCondWaitŐQ
+// head/tail̓vf[TƃRV[}Ŏ荇Ȃ悤ɕʂ̃LbVCɒu
+template <typename T>
+class SPSCRing : NonCopyable
+{
+public:
+	enum {
+		CACHE_LINE = 64,
+		SPIN_COUNT = 2000, // QOɃXs
+	};
+
+	SPSCRing(size_t capacity)
+		: capacity_(capacity)
+		, buf_(new T[capacity])
+		// 1RAƃXsĂ肪i܂Ȃ̂ōŏQ
+		, spinCount_((std::thread::hardware_concurrency() > 1) ? SPIN_COUNT : 0)
+		, head_(0)
+		, tail_(0)
+		, consumerWaiting_(false)
+		, producerWaiting_(false)
+		, finished_(false)
+	{ }
+
+	// 󂫂ł܂ő҂Ăǉivf[TXbĥ݁j
+	void push(T&& data, Stopwatch* waitTime) {
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		auto hasSpace = [&]() { return tail - head_.load(std::memory_order_acquire) < capacity_; };
+		if (!hasSpace() && !spin(spinCount_, hasSpace)) {
+			if (waitTime) waitTime->start();
+			auto&& lock = with(critical_section_);
+			producerWaiting_.store(true);
+			while (tail - head_.load() >= capacity_) {
+				cond_full_.wait(critical_section_);
+			}
+			producerWaiting_.store(false, std::memory_order_relaxed);
+			if (waitTime) waitTime->stop();
+		}
+		buf_[tail % capacity_] = std::move(data);
+		tail_.store(tail + 1);
+		if (consumerWaiting_.load()) {
+			auto&& lock = with(critical_section_);
+			cond_empty_.signal();
+		}
+	}
+
+	// f[^܂ő҂ĎoiRV[}Xbĥ݁j
+	// finish()ɋɂȂfalseԂ
+	bool pop(T& data, Stopwatch* waitTime) {
+		size_t head = head_.load(std::memory_order_relaxed);
+		auto hasData = [&]() { return tail_.load(std::memory_order_acquire) != head; };
+		if (!hasData()) {
+			auto ready = [&]() { return hasData() || finished_.load(std::memory_order_acquire); };
+			if (!spin(spinCount_, ready)) {
+				if (waitTime) waitTime->start();
+				auto&& lock = with(critical_section_);
+				consumerWaiting_.store(true);
+				while (tail_.load() == head && !finished_.load()) {
+					cond_empty_.wait(critical_section_);
+				}
+				consumerWaiting_.store(false, std::memory_order_relaxed);
+				if (waitTime) waitTime->stop();
+			}
+			if (!hasData()) {
+				return false;
+			}
+		}
+		take(head, data);
+		return true;
+	}
+
+	// ҂ɎoiRV[}Xbĥ݁j
+	// ȂfalseԂ
+	bool tryPop(T& data) {
+		size_t head = head_.load(std::memory_order_relaxed);
+		if (tail_.load(std::memory_order_acquire) == head) {
+			return false;
+		}
+		take(head, data);
+		return true;
+	}
+
+	// ҂Ăpop()NicĂf[^͎oj
+	void finish() {
+		auto&& lock = with(critical_section_);
+		finished_.store(true);
+		cond_empty_.signal();
+	}
+
+	// Ă鐔iǂ̃XbhĂł悢AĂłԂɂςj
+	size_t size() const {
+		// headǂ߂tail >= headɂȂ
+		size_t head = head_.load(std::memory_order_acquire);
+		return tail_.load(std::memory_order_acquire) - head;
+	}
+
+	size_t capacity() const { return capacity_; }
+
+	// ɂďԂɖ߂ĩXbh~܂Ă鎞̂݁j
+	void clear() {
+		for (size_t i = 0; i < capacity_; ++i) {
+			buf_[i] = T();
+		}
+		head_.store(0);
+		tail_.store(0);
+		finished_.store(false);
+	}
+
+private:
+	void take(size_t head, T& data) {
+		T& slot = buf_[head % capacity_];
+		data = std::move(slot);
+		// [ułȂ^łQƂcȂ悤ɃNAĂ
+		slot = T();
+		head_.store(head + 1);
+		if (producerWaiting_.load()) {
+			auto&& lock = with(critical_section_);
+			cond_full_.signal();
+		}
+	}
+
+	template <typename Pred>
+	static bool spin(int count, Pred ready) {
+		for (int i = 0; i < count; ++i) {
+			if (ready()) return true;
+			CPU_RELAX();
+		}
+		return false;
+	}
+
+	const size_t capacity_;
+	std::unique_ptr<T[]> buf_;
+	int spinCount_;
+
+	alignas(CACHE_LINE) std::atomic<size_t> head_; // ɓǂވʒuiRV[}j
+	alignas(CACHE_LINE) std::atomic<size_t> tail_; // ɏʒuivf[Tj
+	alignas(CACHE_LINE) std::atomic<bool> consumerWaiting_;
+	std::atomic<bool> producerWaiting_;
+	std::atomic<bool> finished_;
+
+	// QƂg
+	CriticalSection critical_section_;
+	CondWait cond_full_;
+	CondWait cond_empty_;
+};
+
+// DataPumpThreadƓC^[tFCXSPSCRingg
+// put()𓯎ɌĂԃXbh1ł邱
+template <typename T, typename ErrorHandler, bool PERF = false>
+class SPSCPumpThread : private ThreadBase<ErrorHandler>
+{
+public:
+	SPSCPumpThread(size_t maximum, ErrorHandler* env)
+		: ThreadBase<ErrorHandler>(env)
+		, ring_(maximum)
+		, maxBatch_(1)
+	{ }
+
+	~SPSCPumpThread() {
+		if (isRunning()) {
+			this->env->ThrowError("call join() before destroy object ...");
+		}
+	}
+
+	void put(T&& data)
+	{
+		ring_.push(std::move(data), PERF ? &producer : nullptr);
+	}
+
+	void start() {
+		ring_.clear();
+		producer.reset();
+		consumer.reset();
+		ThreadBase<ErrorHandler>::start();
+	}
+
+	void join() {
+		ring_.finish();
+		ThreadBase<ErrorHandler>::join();
+		ring_.clear();
+	}
+
+	bool isRunning() { return ThreadBase<ErrorHandler>::isRunning(); }
+
+	void getTotalWait(double& prod, double& cons) {
+		prod = producer.getTotal();
+		cons = consumer.getTotal();
+	}
+
+	size_t size() const { return ring_.size(); }
+	size_t capacity() const { return ring_.capacity(); }
+
+	// 2ȏɂƁAĎof[^ő傱̐܂ł܂Ƃ߂
+	// OnBatchBegin()OnBatchEnd()̊Ԃŏistart()Oɐݒ肷邱Ɓj
+	// 1oƂɏ̂ŁAL[̗eʈȏɑOĩf[^ނƂ͂Ȃ
+	void setMaxBatch(int maxBatch) { maxBatch_ = std::max(1, maxBatch); }
+
+protected:
+	virtual void OnDataReceived(T&& data) = 0;
+	// ob`̍ŏ̃f[^OɌĂ΂imaxBatch2ȏ̂Ƃ̂݁j
+	virtual void OnBatchBegin() { }
+	// count: ob`ŏf[^̐
+	virtual void OnBatchEnd(int count) { }
+
+private:
+	SPSCRing<T> ring_;
+	int maxBatch_;
+
+	Stopwatch producer;
+	Stopwatch consumer;
+
+	virtual void run()
+	{
+		while (true) {
+			T data;
+			if (!ring_.pop(data, PERF ? &consumer : nullptr)) {
+				return;
+			}
+			if (maxBatch_ <= 1) {
+				OnDataReceived(std::move(data));
+				continue;
+			}
+			OnBatchBegin();
+			int count = 0;
+			do {
+				OnDataReceived(std::move(data));
+				data = T();
+			} while (++count < maxBatch_ && ring_.tryPop(data));
+			OnBatchEnd(count);
+		}
+	}
+};
+
+// 1̏𕡐Xbhŕs邽߂̃Xbhv[
+// Run()͕̃Xbh瓯ɌĂł悢
+// ĂяoXbhɎQASI܂Ŗ߂Ȃ
+template <typename ErrorHandler>
+class WorkerPool : NonCopyable
+{
+	struct Job {
+		const std::function<void(int)>* func;
+		int n;         // 
+		int next;      // ɏCfbNX
+		int finished;  // 
+		std::exception_ptr exception;
+	};
+
+	class Worker : public ThreadBase<ErrorHandler>
+	{
+	public:
+		Worker(WorkerPool* pool, ErrorHandler* env)
+			: ThreadBase<ErrorHandler>(env)
+			, pool(pool)
+		{ }
+	protected:
+		virtual void run() {
+			pool->workerMain();
+		}
+	private:
+		WorkerPool* pool;
+	};
+
+	CriticalSection lock_;
+	CondWait jobCond_;
+	CondWait doneCond_;
+	std::deque<Job*> jobs_;
+	bool finished_;
+	std::vector<std::unique_ptr<Worker>> workers_;
+
+	// lock_ԂŌĂԂ
+	int takeIndex(Job* job) {
+		int i = job->next++;
+		if (job->next >= job->n) {
+			// S蓖Ă̂ŃL[O
+			jobs_.erase(std::find(jobs_.begin(), jobs_.end(), job));
+		}
+		return i;
+	}
+
+	void execute(Job* job, int i) {
+		std::exception_ptr exception;
+		try {
+			(*job->func)(i);
+		}
+		catch (...) {
+			exception = std::current_exception();
+		}
+		auto&& lock = with(lock_);
+		if (exception && !job->exception) {
+			job->exception = exception;
+		}
+		if (++job->finished == job->n) {
+			doneCond_.broadcast();
+		}
+	}
+
+	void workerMain() {
+		while (true) {
+			Job* job;
+			int i;
+			{
+				auto&& lock = with(lock_);
+				while (jobs_.size() == 0) {
+					if (finished_) return;
+					jobCond_.wait(lock_);
+				}
+				job = jobs_.front();
+				i = takeIndex(job);
+			}
+			execute(job, i);
+		}
+	}
+
+public:
+	// numThreads: ĂяoXbh܂߂Xbhi0Ȃ_RAj
+	WorkerPool(int numThreads, ErrorHandler* env)
+		: finished_(false)
+	{
+		if (numThreads <= 0) {
+			numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+		}
+		for (int i = 1; i < numThreads; ++i) {
+			workers_.emplace_back(new Worker(this, env));
+			workers_.back()->start();
+		}
+	}
+
+	~WorkerPool() {
+		{
+			auto&& lock = with(lock_);
+			finished_ = true;
+			jobCond_.broadcast();
+		}
+		for (auto& w : workers_) {
+			w->join();
+		}
+	}
+
+	int NumThreads() const { return (int)workers_.size() + 1; }
+
+	// vZX1̋Lv[i_RAj
+	// ŏɗvꂽƂɍ쐬āAgĂ̂ȂȂj
+	// env̓XbhJñG[̒ʒmɂg
+	static std::shared_ptr<WorkerPool> GetShared(ErrorHandler* env) {
+		static CriticalSection lock;
+		static std::weak_ptr<WorkerPool> shared;
+		auto&& l = with(lock);
+		std::shared_ptr<WorkerPool> pool = shared.lock();
+		if (!pool) {
+			pool = std::make_shared<WorkerPool>(0, env);
+			shared = pool;
+		}
+		return pool;
+	}
+
+	// func(0)..func(n-1)s
+	// funcO𓊂ꍇ͑SÎ҂Ăŏ̗Ođo
+	void Run(int n, const std::function<void(int)>& func) {
+		if (n <= 0) return;
+		if (n == 1 || workers_.size() == 0) {
+			for (int i = 0; i < n; ++i) func(i);
+			return;
+		}
+		Job job = { &func, n, 0, 0, nullptr };
+		{
+			auto&& lock = with(lock_);
+			jobs_.push_back(&job);
+			jobCond_.broadcast();
+		}
+		while (true) {
+			int i;
+			{
+				auto&& lock = with(lock_);
+				if (job.next >= job.n) break;
+				i = takeIndex(&job);
+			}
+			execute(&job, i);
+		}
+		{
+			auto&& lock = with(lock_);
+			while (job.finished < job.n) {
+				doneCond_.wait(lock_);
+			}
+		}
+		if (job.exception) {
+			std::rethrow_exception(job.exception);
+		}
+	}
+};
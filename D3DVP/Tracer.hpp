@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include "Thread.hpp"
+
+// pCvC̃g[XiChromẽg[X`JSONŏoj
+// chrome://tracing  https://ui.perfetto.dev ŊJ
+// Cxg̓XbhƂ̃Oobt@ɋL^̂ŁAL^̓bNȂ
+// iŏɂ̃XbhL^ƂOobt@̓o^ŃbNj
+// Oobt@ςɂȂÂ̂㏑
+class Tracer : NonCopyable
+{
+public:
+	enum {
+		RING_EVENTS = 1 << 16, // Xbh̃Cxg
+	};
+
+	Tracer()
+		: id_(NextId())
+		, start_(GetPerfCounter())
+	{ }
+
+	// [start, end)L^Bname͕񃊃eł邱
+	void Record(const char* name, int frame, int64_t start, int64_t end) {
+		Ring* ring = GetRing();
+		Event& ev = ring->events[ring->count % RING_EVENTS];
+		ev.name = name;
+		ev.frame = frame;
+		ev.start = start;
+		ev.end = end;
+		ring->count.store(ring->count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// L^ĂXbhS~܂ĂĂԂ
+	bool WriteChromeJson(const std::string& path) {
+		FILE* fp = fopen(path.c_str(), "w");
+		if (fp == NULL) {
+			return false;
+		}
+		double usPerTick = 1000000.0 / GetPerfFrequency();
+		fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", fp);
+		bool first = true;
+		auto&& lock = with(lock_);
+		for (auto& ring : rings_) {
+			uint64_t count = ring->count.load(std::memory_order_acquire);
+			uint64_t begin = (count > RING_EVENTS) ? (count - RING_EVENTS) : 0;
+			for (uint64_t i = begin; i < count; ++i) {
+				const Event& ev = ring->events[i % RING_EVENTS];
+				fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+					first ? "" : ",\n", ev.name, ring->tid,
+					(ev.start - start_) * usPerTick, (ev.end - ev.start) * usPerTick);
+				if (ev.frame >= 0) {
+					fprintf(fp, ",\"args\":{\"frame\":%d}", ev.frame);
+				}
+				fputs("}", fp);
+				first = false;
+			}
+		}
+		fputs("\n]}\n", fp);
+		fclose(fp);
+		return true;
+	}
+
+private:
+	struct Event {
+		const char* name;
+		int frame;
+		int64_t start;
+		int64_t end;
+	};
+
+	struct Ring {
+		uint32_t tid;
+		std::unique_ptr<Event[]> events;
+		std::atomic<uint64_t> count;
+	};
+
+	// OɎgTracerƃOobt@iXbhƁj
+	struct RingCache {
+		uint64_t id;
+		Ring* ring;
+	};
+
+	const uint64_t id_; // jꂽTracer̃LbVƋʂ邽߁ACX^XƂɈႤl
+	const int64_t start_;
+	CriticalSection lock_;
+	std::vector<std::unique_ptr<Ring>> rings_;
+
+	static uint64_t NextId() {
+		static std::atomic<uint64_t> next(1);
+		return next++;
+	}
+
+	static uint32_t CurrentThreadId() {
+#if THREAD_WIN32
+		return (uint32_t)GetCurrentThreadId();
+#else
+		return (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+#endif
+	}
+
+	Ring* GetRing() {
+		static thread_local RingCache cache = { 0, nullptr };
+		if (cache.id == id_) {
+			return cache.ring;
+		}
+		uint32_t tid = CurrentThreadId();
+		auto&& lock = with(lock_);
+		Ring* ring = nullptr;
+		for (auto& r : rings_) {
+			if (r->tid == tid) {
+				ring = r.get();
+				break;
+			}
+		}
+		if (ring == nullptr) {
+			rings_.emplace_back(new Ring());
+			ring = rings_.back().get();
+			ring->tid = tid;
+			ring->events = std::unique_ptr<Event[]>(new Event[RING_EVENTS]);
+			ring->count = 0;
+		}
+		cache.id = id_;
+		cache.ring = ring;
+		return ring;
+	}
+};
+
+// XR[v̋ԂL^itracernullptrȂ牽Ȃj
+class TraceScope : NonCopyable
+{
+public:
+	TraceScope(Tracer* tracer, const char* name, int frame = -1)
+		: tracer_(tracer)
+		, name_(name)
+		, frame_(frame)
+		, start_(tracer ? GetPerfCounter() : 0)
+	{ }
+	~TraceScope() {
+		if (tracer_) {
+			tracer_->Record(name_, frame_, start_, GetPerfCounter());
+		}
+	}
+private:
+	Tracer* tracer_;
+	const char* name_;
+	int frame_;
+	int64_t start_;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+
+// t[̉́iV[`FWÎ~t[AȂ̌opj
+// deint.hƓACłAVX2łpӂČĂяoőI
+// ʂ͂ǂɂȂ
+
+// 2t[̓v[̍ΒlaiSADj
+// [yStart, yEnd)̍sisohɕĕ񏈗邽߁j
+// rowBytes: 1s̃oCg, sb`̓oCgP
+uint64_t sad_plane_c(const uint8_t* a, int pitchA, const uint8_t* b, int pitchB,
+	int rowBytes, int yStart, int yEnd);
+uint64_t sad_plane_avx2(const uint8_t* a, int pitchA, const uint8_t* b, int pitchB,
+	int rowBytes, int yStart, int yEnd);
+
+// sad_plane_c16bitf
+// sad_plane_cƓoCgP
+uint64_t sad_plane16_c(const uint8_t* a, int pitchA, const uint8_t* b, int pitchB,
+	int rowBytes, int yStart, int yEnd);
+uint64_t sad_plane16_avx2(const uint8_t* a, int pitchA, const uint8_t* b, int pitchB,
+	int rowBytes, int yStart, int yEnd);
+
+// Ȃ̌o
+// ㉺̍sĩtB[hjƂ̍ǂthresh傫AfȂ̉fƂA
+// COMB_BLOCK x COMB_BLOCKf̃ubNƂɐāA̍őlԂ
+// ʂ̏[Ɖ[̍s͐Ȃ
+// [yStart, yEnd)̍siyStartyEndCOMB_BLOCK̔{heightj
+// rowBytes: 1s̃oCg, thresh: fl̍̂li16bitł16bit̒lj
+enum { COMB_BLOCK = 16 };
+int comb_block_max_c(const uint8_t* src, int pitch,
+	int rowBytes, int height, int thresh, int yStart, int yEnd);
+int comb_block_max_avx2(const uint8_t* src, int pitch,
+	int rowBytes, int height, int thresh, int yStart, int yEnd);
+int comb_block_max16_c(const uint8_t* src, int pitch,
+	int rowBytes, int height, int thresh, int yStart, int yEnd);
+int comb_block_max16_avx2(const uint8_t* src, int pitch,
+	int rowBytes, int height, int thresh, int yStart, int yEnd);
+
+// IVTC̃tB[h}b`p
+// stopAsbottomđgݍ킹iweavejt[comb_block_max_cƓlԂ
+int comb_block_max_weave_c(const uint8_t* top, int pitchTop, const uint8_t* bottom, int pitchBottom,
+	int rowBytes, int height, int thresh, int yStart, int yEnd);
+int comb_block_max_weave_avx2(const uint8_t* top, int pitchTop, const uint8_t* bottom, int pitchBottom,
+	int rowBytes, int height, int thresh, int yStart, int yEnd);
+int comb_block_max_weave16_c(const uint8_t* top, int pitchTop, const uint8_t* bottom, int pitchBottom,
+	int rowBytes, int height, int thresh, int yStart, int yEnd);
+int comb_block_max_weave16_avx2(const uint8_t* top, int pitchTop, const uint8_t* bottom, int pitchBottom,
+	int rowBytes, int height, int thresh, int yStart, int yEnd);
+
+// tB[hI[_[̔p
+// cur̊esƁAnext̂̏㉺̍sĩtB[hj̕ςƂ̍ΒlaA
+// cur̋sigbvtB[hjƊsi{gtB[hjɕsums[0], sums[1]ɑ
+// TFFȂcur̃{gnext̃gbvԓIɗׂ荇̂sums[1]ABFFȂsums[0]Ȃ
+// ʂ̏[Ɖ[̍s͓̍sŕ₤iheight >= 2j
+// [yStart, yEnd)̍s
+void field_order_sad_c(const uint8_t* cur, int pitchCur, const uint8_t* next, int pitchNext,
+	int rowBytes, int height, int yStart, int yEnd, uint64_t sums[2]);
+void field_order_sad_avx2(const uint8_t* cur, int pitchCur, const uint8_t* next, int pitchNext,
+	int rowBytes, int height, int yStart, int yEnd, uint64_t sums[2]);
+void field_order_sad16_c(const uint8_t* cur, int pitchCur, const uint8_t* next, int pitchNext,
+	int rowBytes, int height, int yStart, int yEnd, uint64_t sums[2]);
+void field_order_sad16_avx2(const uint8_t* cur, int pitchCur, const uint8_t* next, int pitchNext,
+	int rowBytes, int height, int yStart, int yEnd, uint64_t sums[2]);
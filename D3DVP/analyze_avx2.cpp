@@ -0,0 +1,271 @@
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include <immintrin.h>
+
+#include "analyze.h"
+
+// 32bitrhłg悤ɃoRő
+static inline uint64_t hsum_epi64(__m256i v) {
+	alignas(32) uint64_t s[4];
+	_mm256_store_si256((__m256i*)s, v);
+	return s[0] + s[1] + s[2] + s[3];
+}
+
+uint64_t sad_plane_avx2(const uint8_t* a, int pitchA, const uint8_t* b, int pitchB,
+	int rowBytes, int yStart, int yEnd)
+{
+	int body = rowBytes & ~31;
+	__m256i acc = _mm256_setzero_si256();
+	uint64_t tail = 0;
+	for (int y = yStart; y < yEnd; ++y) {
+		const uint8_t* pa = a + y * pitchA;
+		const uint8_t* pb = b + y * pitchB;
+		for (int x = 0; x < body; x += 32) {
+			__m256i va = _mm256_loadu_si256((const __m256i*)(pa + x));
+			__m256i vb = _mm256_loadu_si256((const __m256i*)(pb + x));
+			acc = _mm256_add_epi64(acc, _mm256_sad_epu8(va, vb));
+		}
+		for (int x = body; x < rowBytes; ++x) {
+			tail += abs((int)pa[x] - (int)pb[x]);
+		}
+	}
+	return hsum_epi64(acc) + tail;
+}
+
+uint64_t sad_plane16_avx2(const uint8_t* a, int pitchA, const uint8_t* b, int pitchB,
+	int rowBytes, int yStart, int yEnd)
+{
+	int width = rowBytes / 2;
+	int body = width & ~15;
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i acc = _mm256_setzero_si256();
+	uint64_t tail = 0;
+	for (int y = yStart; y < yEnd; ++y) {
+		const uint16_t* pa = reinterpret_cast<const uint16_t*>(a + y * pitchA);
+		const uint16_t* pb = reinterpret_cast<const uint16_t*>(b + y * pitchB);
+		// 1s32bitőĂ64bitɂi[蕝/8fȂ̂łӂȂj
+		__m256i rowAcc = _mm256_setzero_si256();
+		for (int x = 0; x < body; x += 16) {
+			__m256i va = _mm256_loadu_si256((const __m256i*)(pa + x));
+			__m256i vb = _mm256_loadu_si256((const __m256i*)(pb + x));
+			__m256i d = _mm256_or_si256(_mm256_subs_epu16(va, vb), _mm256_subs_epu16(vb, va));
+			rowAcc = _mm256_add_epi32(rowAcc, _mm256_unpacklo_epi16(d, zero));
+			rowAcc = _mm256_add_epi32(rowAcc, _mm256_unpackhi_epi16(d, zero));
+		}
+		acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(rowAcc, zero));
+		acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(rowAcc, zero));
+		for (int x = body; x < width; ++x) {
+			tail += abs((int)pa[x] - (int)pb[x]);
+		}
+	}
+	return hsum_epi64(acc) + tail;
+}
+
+// stopAsbottomit[Ȃ畁ʂ̃t[j
+struct WeaveRows {
+	const uint8_t* top;
+	int pitchTop;
+	const uint8_t* bottom;
+	int pitchBottom;
+
+	const uint8_t* operator()(int y) const {
+		return (y & 1) ? (bottom + y * pitchBottom) : (top + y * pitchTop);
+	}
+};
+
+// [̗[xStart, xEnd)CłƓvZŐ
+template <typename pixel_t>
+static int comb_count_cols(const WeaveRows& row, int thresh, int xStart, int xEnd, int y0, int y1)
+{
+	int count = 0;
+	for (int y = y0; y < y1; ++y) {
+		const pixel_t* a = reinterpret_cast<const pixel_t*>(row(y - 1));
+		const pixel_t* c = reinterpret_cast<const pixel_t*>(row(y));
+		const pixel_t* b = reinterpret_cast<const pixel_t*>(row(y + 1));
+		for (int x = xStart; x < xEnd; ++x) {
+			int d1 = c[x] - a[x];
+			int d2 = c[x] - b[x];
+			if ((d1 > thresh && d2 > thresh) || (d1 < -thresh && d2 < -thresh)) {
+				++count;
+			}
+		}
+	}
+	return count;
+}
+
+// ㉺̍sƂ̍Ƃthresh傫f1ɂȂ
+// OaZō̂ŁAƉꂼꏬŔł
+static inline __m256i comb_pixels_epu8(__m256i a, __m256i c, __m256i b, __m256i th, __m256i one) {
+	__m256i up = _mm256_min_epu8(_mm256_subs_epu8(c, a), _mm256_subs_epu8(c, b));
+	__m256i down = _mm256_min_epu8(_mm256_subs_epu8(a, c), _mm256_subs_epu8(b, c));
+	__m256i notComb = _mm256_cmpeq_epi8(_mm256_subs_epu8(_mm256_max_epu8(up, down), th), _mm256_setzero_si256());
+	return _mm256_andnot_si256(notComb, one);
+}
+
+static inline __m256i comb_pixels_epu16(__m256i a, __m256i c, __m256i b, __m256i th, __m256i one) {
+	__m256i up = _mm256_min_epu16(_mm256_subs_epu16(c, a), _mm256_subs_epu16(c, b));
+	__m256i down = _mm256_min_epu16(_mm256_subs_epu16(a, c), _mm256_subs_epu16(b, c));
+	__m256i notComb = _mm256_cmpeq_epi16(_mm256_subs_epu16(_mm256_max_epu16(up, down), th), _mm256_setzero_si256());
+	return _mm256_andnot_si256(notComb, one);
+}
+
+static int comb_rows8_avx2(const WeaveRows& row,
+	int rowBytes, int height, int thresh, int yStart, int yEnd)
+{
+	if (thresh >= 255) {
+		return 0;
+	}
+	// 32oCg2ubN
+	int body = rowBytes & ~31;
+	const __m256i th = _mm256_set1_epi8((char)thresh);
+	const __m256i one = _mm256_set1_epi8(1);
+	int maxCount = 0;
+	for (int by = yStart; by < yEnd; by += COMB_BLOCK) {
+		int y0 = std::max(by, 1);
+		int y1 = std::min(std::min(by + COMB_BLOCK, yEnd), height - 1);
+		for (int x = 0; x < body; x += 32) {
+			// 1ubN̍s16Ȃ̂8bitŐ
+			__m256i cnt = _mm256_setzero_si256();
+			for (int y = y0; y < y1; ++y) {
+				__m256i a = _mm256_loadu_si256((const __m256i*)(row(y - 1) + x));
+				__m256i c = _mm256_loadu_si256((const __m256i*)(row(y) + x));
+				__m256i b = _mm256_loadu_si256((const __m256i*)(row(y + 1) + x));
+				cnt = _mm256_add_epi8(cnt, comb_pixels_epu8(a, c, b, th, one));
+			}
+			alignas(32) uint64_t s[4];
+			_mm256_store_si256((__m256i*)s, _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+			maxCount = std::max(maxCount, (int)std::max(s[0] + s[1], s[2] + s[3]));
+		}
+		for (int x = body; x < rowBytes; x += COMB_BLOCK) {
+			maxCount = std::max(maxCount, comb_count_cols<uint8_t>(row, thresh,
+				x, std::min(x + COMB_BLOCK, rowBytes), y0, y1));
+		}
+	}
+	return maxCount;
+}
+
+static int comb_rows16_avx2(const WeaveRows& row,
+	int rowBytes, int height, int thresh, int yStart, int yEnd)
+{
+	if (thresh >= 65535) {
+		return 0;
+	}
+	// 16f1ubN
+	int width = rowBytes / 2;
+	int body = width & ~15;
+	const __m256i th = _mm256_set1_epi16((short)thresh);
+	const __m256i one = _mm256_set1_epi16(1);
+	int maxCount = 0;
+	for (int by = yStart; by < yEnd; by += COMB_BLOCK) {
+		int y0 = std::max(by, 1);
+		int y1 = std::min(std::min(by + COMB_BLOCK, yEnd), height - 1);
+		for (int x = 0; x < body; x += 16) {
+			__m256i cnt = _mm256_setzero_si256();
+			for (int y = y0; y < y1; ++y) {
+				__m256i a = _mm256_loadu_si256((const __m256i*)(row(y - 1) + x * 2));
+				__m256i c = _mm256_loadu_si256((const __m256i*)(row(y) + x * 2));
+				__m256i b = _mm256_loadu_si256((const __m256i*)(row(y + 1) + x * 2));
+				cnt = _mm256_add_epi16(cnt, comb_pixels_epu16(a, c, b, th, one));
+			}
+			__m256i s32 = _mm256_madd_epi16(cnt, one);
+			__m128i s = _mm_add_epi32(_mm256_castsi256_si128(s32), _mm256_extracti128_si256(s32, 1));
+			s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+			s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+			maxCount = std::max(maxCount, _mm_cvtsi128_si32(s));
+		}
+		for (int x = body; x < width; x += COMB_BLOCK) {
+			maxCount = std::max(maxCount, comb_count_cols<uint16_t>(row, thresh,
+				x, std::min(x + COMB_BLOCK, width), y0, y1));
+		}
+	}
+	return maxCount;
+}
+
+// ςCłƓ؂グi_mm256_avg_epu8/epu16j
+void field_order_sad_avx2(const uint8_t* cur, int pitchCur, const uint8_t* next, int pitchNext,
+	int rowBytes, int height, int yStart, int yEnd, uint64_t sums[2])
+{
+	int body = rowBytes & ~31;
+	for (int y = yStart; y < yEnd; ++y) {
+		int ya = (y == 0) ? 1 : (y - 1);
+		int yb = (y == height - 1) ? (height - 2) : (y + 1);
+		const uint8_t* c = cur + y * pitchCur;
+		const uint8_t* a = next + ya * pitchNext;
+		const uint8_t* b = next + yb * pitchNext;
+		__m256i acc = _mm256_setzero_si256();
+		for (int x = 0; x < body; x += 32) {
+			__m256i vc = _mm256_loadu_si256((const __m256i*)(c + x));
+			__m256i va = _mm256_loadu_si256((const __m256i*)(a + x));
+			__m256i vb = _mm256_loadu_si256((const __m256i*)(b + x));
+			acc = _mm256_add_epi64(acc, _mm256_sad_epu8(vc, _mm256_avg_epu8(va, vb)));
+		}
+		uint64_t sum = hsum_epi64(acc);
+		for (int x = body; x < rowBytes; ++x) {
+			sum += abs((int)c[x] - (((int)a[x] + (int)b[x] + 1) >> 1));
+		}
+		sums[y & 1] += sum;
+	}
+}
+
+void field_order_sad16_avx2(const uint8_t* cur, int pitchCur, const uint8_t* next, int pitchNext,
+	int rowBytes, int height, int yStart, int yEnd, uint64_t sums[2])
+{
+	int width = rowBytes / 2;
+	int body = width & ~15;
+	const __m256i zero = _mm256_setzero_si256();
+	for (int y = yStart; y < yEnd; ++y) {
+		int ya = (y == 0) ? 1 : (y - 1);
+		int yb = (y == height - 1) ? (height - 2) : (y + 1);
+		const uint16_t* c = reinterpret_cast<const uint16_t*>(cur + y * pitchCur);
+		const uint16_t* a = reinterpret_cast<const uint16_t*>(next + ya * pitchNext);
+		const uint16_t* b = reinterpret_cast<const uint16_t*>(next + yb * pitchNext);
+		// sad_plane16_avx2Ɠ1s32bitő
+		__m256i rowAcc = _mm256_setzero_si256();
+		for (int x = 0; x < body; x += 16) {
+			__m256i vc = _mm256_loadu_si256((const __m256i*)(c + x));
+			__m256i va = _mm256_loadu_si256((const __m256i*)(a + x));
+			__m256i vb = _mm256_loadu_si256((const __m256i*)(b + x));
+			__m256i avg = _mm256_avg_epu16(va, vb);
+			__m256i d = _mm256_or_si256(_mm256_subs_epu16(vc, avg), _mm256_subs_epu16(avg, vc));
+			rowAcc = _mm256_add_epi32(rowAcc, _mm256_unpacklo_epi16(d, zero));
+			rowAcc = _mm256_add_epi32(rowAcc, _mm256_unpackhi_epi16(d, zero));
+		}
+		uint64_t sum = hsum_epi64(_mm256_add_epi64(
+			_mm256_unpacklo_epi32(rowAcc, zero), _mm256_unpackhi_epi32(rowAcc, zero)));
+		for (int x = body; x < width; ++x) {
+			sum += abs((int)c[x] - (((int)a[x] + (int)b[x] + 1) >> 1));
+		}
+		sums[y & 1] += sum;
+	}
+}
+
+int comb_block_max_avx2(const uint8_t* src, int pitch,
+	int rowBytes, int height, int thresh, int yStart, int yEnd)
+{
+	WeaveRows row = { src, pitch, src, pitch };
+	return comb_rows8_avx2(row, rowBytes, height, thresh, yStart, yEnd);
+}
+
+int comb_block_max16_avx2(const uint8_t* src, int pitch,
+	int rowBytes, int height, int thresh, int yStart, int yEnd)
+{
+	WeaveRows row = { src, pitch, src, pitch };
+	return comb_rows16_avx2(row, rowBytes, height, thresh, yStart, yEnd);
+}
+
+int comb_block_max_weave_avx2(const uint8_t* top, int pitchTop, const uint8_t* bottom, int pitchBottom,
+	int rowBytes, int height, int thresh, int yStart, int yEnd)
+{
+	WeaveRows row = { top, pitchTop, bottom, pitchBottom };
+	return comb_rows8_avx2(row, rowBytes, height, thresh, yStart, yEnd);
+}
+
+int comb_block_max_weave16_avx2(const uint8_t* top, int pitchTop, const uint8_t* bottom, int pitchBottom,
+	int rowBytes, int height, int thresh, int yStart, int yEnd)
+{
+	WeaveRows row = { top, pitchTop, bottom, pitchBottom };
+	return comb_rows16_avx2(row, rowBytes, height, thresh, yStart, yEnd);
+}
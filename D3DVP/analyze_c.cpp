@@ -0,0 +1,120 @@
+
+#include <stdlib.h>
+#include <algorithm>
+#include "analyze.h"
+
+// pixel_t: f̌^, pixel_tP
+template <typename pixel_t>
+static uint64_t sad_plane_t(const uint8_t* a, int pitchA, const uint8_t* b, int pitchB,
+	int width, int yStart, int yEnd)
+{
+	uint64_t sum = 0;
+	for (int y = yStart; y < yEnd; ++y) {
+		const pixel_t* pa = reinterpret_cast<const pixel_t*>(a + y * pitchA);
+		const pixel_t* pb = reinterpret_cast<const pixel_t*>(b + y * pitchB);
+		for (int x = 0; x < width; ++x) {
+			sum += abs((int)pa[x] - (int)pb[x]);
+		}
+	}
+	return sum;
+}
+
+uint64_t sad_plane_c(const uint8_t* a, int pitchA, const uint8_t* b, int pitchB,
+	int rowBytes, int yStart, int yEnd)
+{
+	return sad_plane_t<uint8_t>(a, pitchA, b, pitchB, rowBytes, yStart, yEnd);
+}
+
+uint64_t sad_plane16_c(const uint8_t* a, int pitchA, const uint8_t* b, int pitchB,
+	int rowBytes, int yStart, int yEnd)
+{
+	return sad_plane_t<uint16_t>(a, pitchA, b, pitchB, rowBytes / 2, yStart, yEnd);
+}
+
+// pixel_tP
+template <typename pixel_t>
+static int comb_block_max_t(const uint8_t* top, int pitchTop, const uint8_t* bottom, int pitchBottom,
+	int width, int height, int thresh, int yStart, int yEnd)
+{
+	auto row = [&](int y) {
+		return reinterpret_cast<const pixel_t*>((y & 1) ? (bottom + y * pitchBottom) : (top + y * pitchTop));
+	};
+	int maxCount = 0;
+	for (int by = yStart; by < yEnd; by += COMB_BLOCK) {
+		int y0 = std::max(by, 1);
+		int y1 = std::min(std::min(by + COMB_BLOCK, yEnd), height - 1);
+		for (int bx = 0; bx < width; bx += COMB_BLOCK) {
+			int bxEnd = std::min(bx + COMB_BLOCK, width);
+			int count = 0;
+			for (int y = y0; y < y1; ++y) {
+				const pixel_t* a = row(y - 1);
+				const pixel_t* c = row(y);
+				const pixel_t* b = row(y + 1);
+				for (int x = bx; x < bxEnd; ++x) {
+					int d1 = c[x] - a[x];
+					int d2 = c[x] - b[x];
+					if ((d1 > thresh && d2 > thresh) || (d1 < -thresh && d2 < -thresh)) {
+						++count;
+					}
+				}
+			}
+			maxCount = std::max(maxCount, count);
+		}
+	}
+	return maxCount;
+}
+
+int comb_block_max_c(const uint8_t* src, int pitch,
+	int rowBytes, int height, int thresh, int yStart, int yEnd)
+{
+	return comb_block_max_t<uint8_t>(src, pitch, src, pitch, rowBytes, height, thresh, yStart, yEnd);
+}
+
+int comb_block_max16_c(const uint8_t* src, int pitch,
+	int rowBytes, int height, int thresh, int yStart, int yEnd)
+{
+	return comb_block_max_t<uint16_t>(src, pitch, src, pitch, rowBytes / 2, height, thresh, yStart, yEnd);
+}
+
+int comb_block_max_weave_c(const uint8_t* top, int pitchTop, const uint8_t* bottom, int pitchBottom,
+	int rowBytes, int height, int thresh, int yStart, int yEnd)
+{
+	return comb_block_max_t<uint8_t>(top, pitchTop, bottom, pitchBottom, rowBytes, height, thresh, yStart, yEnd);
+}
+
+int comb_block_max_weave16_c(const uint8_t* top, int pitchTop, const uint8_t* bottom, int pitchBottom,
+	int rowBytes, int height, int thresh, int yStart, int yEnd)
+{
+	return comb_block_max_t<uint16_t>(top, pitchTop, bottom, pitchBottom, rowBytes / 2, height, thresh, yStart, yEnd);
+}
+
+// pixel_tP
+template <typename pixel_t>
+static void field_order_sad_t(const uint8_t* cur, int pitchCur, const uint8_t* next, int pitchNext,
+	int width, int height, int yStart, int yEnd, uint64_t sums[2])
+{
+	for (int y = yStart; y < yEnd; ++y) {
+		int ya = (y == 0) ? 1 : (y - 1);
+		int yb = (y == height - 1) ? (height - 2) : (y + 1);
+		const pixel_t* c = reinterpret_cast<const pixel_t*>(cur + y * pitchCur);
+		const pixel_t* a = reinterpret_cast<const pixel_t*>(next + ya * pitchNext);
+		const pixel_t* b = reinterpret_cast<const pixel_t*>(next + yb * pitchNext);
+		uint64_t sum = 0;
+		for (int x = 0; x < width; ++x) {
+			sum += abs((int)c[x] - (((int)a[x] + (int)b[x] + 1) >> 1));
+		}
+		sums[y & 1] += sum;
+	}
+}
+
+void field_order_sad_c(const uint8_t* cur, int pitchCur, const uint8_t* next, int pitchNext,
+	int rowBytes, int height, int yStart, int yEnd, uint64_t sums[2])
+{
+	field_order_sad_t<uint8_t>(cur, pitchCur, next, pitchNext, rowBytes, height, yStart, yEnd, sums);
+}
+
+void field_order_sad16_c(const uint8_t* cur, int pitchCur, const uint8_t* next, int pitchNext,
+	int rowBytes, int height, int yStart, int yEnd, uint64_t sums[2])
+{
+	field_order_sad_t<uint16_t>(cur, pitchCur, next, pitchNext, rowBytes / 2, height, yStart, yEnd, sums);
+}
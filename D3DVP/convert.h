@@ -12,12 +12,160 @@ void yuv_to_nv12_avx2(int height, int width,
 void nv12_to_yuv_avx2(int height, int width,
 	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch);
 
+// sohpiPx[yStart, yEnd)sƑΉFsϊj
+// Fs̑ΉȂ悤yStart͋AyEnd͋heightł邱
+void yuv_to_nv12_rows_c(int height, int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV);
+void nv12_to_yuv_rows_c(int height, int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch);
+void yuv_to_nv12_rows_avx2(int height, int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV);
+void nv12_to_yuv_rows_avx2(int height, int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch);
+
+// 10`16bitYUV420ibitsrbgLj P010/P016iNV12Ɠтŏʃrbgɋl߂j
+// sb`uint16_tP
+// P010/P016YUV420͉ʃrbgľܓ(1<<bits)-1ŖOa
+// rowsł̍s̎wyuv_to_nv12_rowsƓ
+void yuv16_to_p010_rows_c(int height, int width, int yStart, int yEnd,
+	uint16_t* dst, int dstPitch, const uint16_t* srcY, const uint16_t* srcU, const uint16_t* srcV, int pitchY, int pitchUV, int bits);
+void p010_to_yuv16_rows_c(int height, int width, int yStart, int yEnd,
+	uint16_t* dstY, uint16_t* dstU, uint16_t* dstV, int pitchY, int pitchUV, const uint16_t* src, int srcPitch, int bits);
+void yuv16_to_p010_rows_avx2(int height, int width, int yStart, int yEnd,
+	uint16_t* dst, int dstPitch, const uint16_t* srcY, const uint16_t* srcU, const uint16_t* srcV, int pitchY, int pitchUV, int bits);
+void p010_to_yuv16_rows_avx2(int height, int width, int yStart, int yEnd,
+	uint16_t* dstY, uint16_t* dstU, uint16_t* dstV, int pitchY, int pitchUV, const uint16_t* src, int srcPitch, int bits);
+void yuv16_to_p010_c(int height, int width,
+	uint16_t* dst, int dstPitch, const uint16_t* srcY, const uint16_t* srcU, const uint16_t* srcV, int pitchY, int pitchUV, int bits);
+void p010_to_yuv16_c(int height, int width,
+	uint16_t* dstY, uint16_t* dstU, uint16_t* dstV, int pitchY, int pitchUV, const uint16_t* src, int srcPitch, int bits);
+void yuv16_to_p010_avx2(int height, int width,
+	uint16_t* dst, int dstPitch, const uint16_t* srcY, const uint16_t* srcU, const uint16_t* srcV, int pitchY, int pitchUV, int bits);
+void p010_to_yuv16_avx2(int height, int width,
+	uint16_t* dstY, uint16_t* dstU, uint16_t* dstV, int pitchY, int pitchUV, const uint16_t* src, int srcPitch, int bits);
+
+// YUV422iYV16j YUY2AYUV444iYV24j AYUVioCgV,U,Y,ABA255j
+// F̊ԈԂɂ̂܂ܕבւ
+// [yStart, yEnd)̍sit[ŜyStart=0, yEnd=heightj
+void yuv422_to_yuy2_rows_c(int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV);
+void yuy2_to_yuv422_rows_c(int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch);
+void yuv444_to_ayuv_rows_c(int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV);
+void ayuv_to_yuv444_rows_c(int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch);
+void yuv422_to_yuy2_rows_avx2(int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV);
+void yuy2_to_yuv422_rows_avx2(int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch);
+void yuv444_to_ayuv_rows_avx2(int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV);
+void ayuv_to_yuv444_rows_avx2(int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch);
+
 void yc48_to_yuy2_c(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h, int max_w);
 void yc48_to_nv12_c(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h, int max_w);
 void yc48_to_yuy2_avx2(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h, int max_w);
 void yc48_to_nv12_avx2(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h, int max_w);
+// yc48_to_nv12_avx2Ɠo͂Xg[~OXgAŏi}bveNX`j
+void yc48_to_nv12_stream_avx2(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h, int max_w);
 
 void yuy2_to_yc48_c(PIXEL_YC* dst, const uint8_t* src, int pitch, int w, int h, int max_w);
 void nv12_to_yc48_c(PIXEL_YC* dst, const uint8_t* src, int pitch, int w, int h, int max_w);
 void yuy2_to_yc48_avx2(PIXEL_YC* dst, const uint8_t* src, int pitch, int w, int h, int max_w);
 void nv12_to_yc48_avx2(PIXEL_YC* dst, const uint8_t* src, int pitch, int w, int h, int max_w);
+// sohpis̎wyuv_to_nv12_rowsƓj
+// YUY2͍sƂɓƗĂ̂ŁA|C^点ΑS̔łŃohƂɏł
+void nv12_to_yc48_rows_c(int h, int w, int yStart, int yEnd, PIXEL_YC* dst, int max_w, const uint8_t* src, int pitch);
+void nv12_to_yc48_rows_avx2(int h, int w, int yStart, int yEnd, PIXEL_YC* dst, int max_w, const uint8_t* src, int pitch);
+
+// SSE4.1ŁiAVX2̂Ȃj
+void yuv_to_nv12_rows_sse41(int height, int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV);
+void nv12_to_yuv_rows_sse41(int height, int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch);
+void yuv16_to_p010_rows_sse41(int height, int width, int yStart, int yEnd,
+	uint16_t* dst, int dstPitch, const uint16_t* srcY, const uint16_t* srcU, const uint16_t* srcV, int pitchY, int pitchUV, int bits);
+void p010_to_yuv16_rows_sse41(int height, int width, int yStart, int yEnd,
+	uint16_t* dstY, uint16_t* dstU, uint16_t* dstV, int pitchY, int pitchUV, const uint16_t* src, int srcPitch, int bits);
+void yuv422_to_yuy2_rows_sse41(int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV);
+void yuy2_to_yuv422_rows_sse41(int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch);
+void yuv444_to_ayuv_rows_sse41(int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV);
+void ayuv_to_yuv444_rows_sse41(int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch);
+void yc48_to_yuy2_sse41(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h, int max_w);
+void yc48_to_nv12_sse41(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h, int max_w);
+void yuy2_to_yc48_sse41(PIXEL_YC* dst, const uint8_t* src, int pitch, int w, int h, int max_w);
+void nv12_to_yc48_sse41(PIXEL_YC* dst, const uint8_t* src, int pitch, int w, int h, int max_w);
+void nv12_to_yc48_rows_sse41(int h, int w, int yStart, int yEnd, PIXEL_YC* dst, int max_w, const uint8_t* src, int pitch);
+
+// AVX-512iF+BWj
+// ߐőx܂̂BAVX2łg
+void yuv_to_nv12_rows_avx512(int height, int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV);
+void nv12_to_yuv_rows_avx512(int height, int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch);
+void yc48_to_nv12_avx512(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h, int max_w);
+void nv12_to_yc48_avx512(PIXEL_YC* dst, const uint8_t* src, int pitch, int w, int h, int max_w);
+void nv12_to_yc48_rows_avx512(int h, int w, int yStart, int yEnd, PIXEL_YC* dst, int max_w, const uint8_t* src, int pitch);
+
+// ߃Zbg̃xiʂ͉ʂ܂ށj
+enum SimdLevel {
+	SIMD_C,
+	SIMD_SSE41,
+	SIMD_AVX2,
+	SIMD_AVX512, // AVX512F + AVX512BW
+	SIMD_LEVEL_COUNT,
+};
+
+// ϊ֐̃fBXpb`e[u
+// ͂ɑ΂Ă͂ǂ̃xłCłƓo͂ɂȂ
+struct ConvertFuncs {
+	typedef void(*YUVToNV12Rows)(int height, int width, int yStart, int yEnd,
+		uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV);
+	typedef void(*NV12ToYUVRows)(int height, int width, int yStart, int yEnd,
+		uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch);
+	typedef void(*YUV16ToP010Rows)(int height, int width, int yStart, int yEnd,
+		uint16_t* dst, int dstPitch, const uint16_t* srcY, const uint16_t* srcU, const uint16_t* srcV, int pitchY, int pitchUV, int bits);
+	typedef void(*P010ToYUV16Rows)(int height, int width, int yStart, int yEnd,
+		uint16_t* dstY, uint16_t* dstU, uint16_t* dstV, int pitchY, int pitchUV, const uint16_t* src, int srcPitch, int bits);
+	// YUV422/444  YUY2/AYUV
+	typedef void(*PlanarToPackedRows)(int width, int yStart, int yEnd,
+		uint8_t* dst, int dstPitch, const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV, int pitchY, int pitchUV);
+	typedef void(*PackedToPlanarRows)(int width, int yStart, int yEnd,
+		uint8_t* dstY, uint8_t* dstU, uint8_t* dstV, int pitchY, int pitchUV, const uint8_t* src, int srcPitch);
+	// AviUtliYC48j
+	typedef void(*FromYC48)(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h, int max_w);
+	typedef void(*ToYC48)(PIXEL_YC* dst, const uint8_t* src, int pitch, int w, int h, int max_w);
+	typedef void(*NV12ToYC48Rows)(int h, int w, int yStart, int yEnd, PIXEL_YC* dst, int max_w, const uint8_t* src, int pitch);
+
+	SimdLevel level;
+	YUVToNV12Rows yuv_to_nv12_rows;
+	NV12ToYUVRows nv12_to_yuv_rows;
+	YUV16ToP010Rows yuv16_to_p010_rows;
+	P010ToYUV16Rows p010_to_yuv16_rows;
+	PlanarToPackedRows yuv422_to_yuy2_rows;
+	PackedToPlanarRows yuy2_to_yuv422_rows;
+	PlanarToPackedRows yuv444_to_ayuv_rows;
+	PackedToPlanarRows ayuv_to_yuv444_rows;
+	FromYC48 yc48_to_yuy2;
+	FromYC48 yc48_to_nv12;
+	// ݌i}bvXe[WOeNX`jւ̏ݗp
+	// CPUœǂݒobt@ɎgƃLbVǂoĒxȂ
+	FromYC48 yc48_to_nv12_stream;
+	ToYC48 yuy2_to_yc48;
+	ToYC48 nv12_to_yc48;
+	NV12ToYC48Rows nv12_to_yc48_rows;
+};
+
+// CPUOSŎgŏʂ̃xiɔ肵ĈȌ͓lԂj
+SimdLevel GetSimdLevel();
+// level̃e[uBlevelGetSimdLevel()ȉł邱
+const ConvertFuncs& GetConvertFuncs(SimdLevel level);
+// GetConvertFuncs(GetSimdLevel())
+const ConvertFuncs& GetConvertFuncs();
+const char* SimdLevelName(SimdLevel level);
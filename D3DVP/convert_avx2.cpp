@@ -9,24 +9,22 @@
 
 #include <immintrin.h>
 
-void yuv_to_nv12_avx2(
-	int height, int width,
+void yuv_to_nv12_rows_avx2(
+	int height, int width, int yStart, int yEnd,
 	uint8_t* dst, int dstPitch,
 	const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV,
 	int pitchY, int pitchUV)
 {
 	int widthUV = width >> 1;
-	int heightUV = height >> 1;
-	int offsetUV = width * height;
 
 	uint8_t* dstY = dst;
 	uint8_t* dstUV = dstY + height * dstPitch;
 
-	for (int y = 0; y < height; ++y) {
+	for (int y = yStart; y < yEnd; ++y) {
 		memcpy(&dstY[y * dstPitch], &srcY[y * pitchY], width);
 	}
 
-	for (int y = 0; y < heightUV; ++y) {
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
 		int x = 0;
 		for (; x <= (widthUV - 16); x += 16) {
 			auto u = _mm_loadu_si128((__m128i*)&srcU[x + y * pitchUV]);
@@ -41,15 +39,22 @@ void yuv_to_nv12_avx2(
 	}
 }
 
-void nv12_to_yuv_avx2(
+void yuv_to_nv12_avx2(
 	int height, int width,
+	uint8_t* dst, int dstPitch,
+	const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV,
+	int pitchY, int pitchUV)
+{
+	yuv_to_nv12_rows_avx2(height, width, 0, height, dst, dstPitch, srcY, srcU, srcV, pitchY, pitchUV);
+}
+
+void nv12_to_yuv_rows_avx2(
+	int height, int width, int yStart, int yEnd,
 	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV,
 	int pitchY, int pitchUV,
 	const uint8_t* src, int srcPitch)
 {
 	int widthUV = width >> 1;
-	int heightUV = height >> 1;
-	int offsetUV = width * height;
 
 	const uint8_t* srcY = src;
 	const uint8_t* srcUV = srcY + height * srcPitch;
@@ -60,11 +65,11 @@ void nv12_to_yuv_avx2(
 		15, 13, 11, 9, 7, 5, 3, 1,
 		14, 12, 10, 8, 6, 4, 2, 0);
 
-	for (int y = 0; y < height; ++y) {
+	for (int y = yStart; y < yEnd; ++y) {
 		memcpy(&dstY[y * pitchY], &srcY[y * srcPitch], width);
 	}
 
-	for (int y = 0; y < heightUV; ++y) {
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
 		int x = 0;
 		for ( ; x <= (widthUV - 16); x += 16) {
 			auto a = _mm256_loadu_si256((const __m256i*)&srcUV[x * 2 + y * srcPitch]);
@@ -83,6 +88,285 @@ void nv12_to_yuv_avx2(
 	}
 }
 
+void nv12_to_yuv_avx2(
+	int height, int width,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV,
+	int pitchY, int pitchUV,
+	const uint8_t* src, int srcPitch)
+{
+	nv12_to_yuv_rows_avx2(height, width, 0, height, dstY, dstU, dstV, pitchY, pitchUV, src, srcPitch);
+}
+
+void yuv16_to_p010_rows_avx2(
+	int height, int width, int yStart, int yEnd,
+	uint16_t* dst, int dstPitch,
+	const uint16_t* srcY, const uint16_t* srcU, const uint16_t* srcV,
+	int pitchY, int pitchUV, int bits)
+{
+	int widthUV = width >> 1;
+	auto shift = _mm_cvtsi32_si128(16 - bits);
+
+	uint16_t* dstY = dst;
+	uint16_t* dstUV = dstY + height * dstPitch;
+
+	for (int y = yStart; y < yEnd; ++y) {
+		int x = 0;
+		for (; x <= (width - 16); x += 16) {
+			auto a = _mm256_loadu_si256((const __m256i*)&srcY[x + y * pitchY]);
+			_mm256_storeu_si256((__m256i*)&dstY[x + y * dstPitch], _mm256_sll_epi16(a, shift));
+		}
+		for (; x < width; ++x) {
+			dstY[x + y * dstPitch] = srcY[x + y * pitchY] << (16 - bits);
+		}
+	}
+
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
+		int x = 0;
+		for (; x <= (widthUV - 16); x += 16) {
+			auto u = _mm256_sll_epi16(_mm256_loadu_si256((const __m256i*)&srcU[x + y * pitchUV]), shift);
+			auto v = _mm256_sll_epi16(_mm256_loadu_si256((const __m256i*)&srcV[x + y * pitchUV]), shift);
+			// 128bitƂɃC^[ûŕבւ
+			auto lo = _mm256_unpacklo_epi16(u, v);
+			auto hi = _mm256_unpackhi_epi16(u, v);
+			_mm256_storeu_si256((__m256i*)&dstUV[x * 2 + y * dstPitch], _mm256_permute2x128_si256(lo, hi, 0x20));
+			_mm256_storeu_si256((__m256i*)&dstUV[x * 2 + 16 + y * dstPitch], _mm256_permute2x128_si256(lo, hi, 0x31));
+		}
+		for (; x < widthUV; ++x) {
+			dstUV[x * 2 + 0 + y * dstPitch] = srcU[x + y * pitchUV] << (16 - bits);
+			dstUV[x * 2 + 1 + y * dstPitch] = srcV[x + y * pitchUV] << (16 - bits);
+		}
+	}
+}
+
+void yuv16_to_p010_avx2(
+	int height, int width,
+	uint16_t* dst, int dstPitch,
+	const uint16_t* srcY, const uint16_t* srcU, const uint16_t* srcV,
+	int pitchY, int pitchUV, int bits)
+{
+	yuv16_to_p010_rows_avx2(height, width, 0, height, dst, dstPitch, srcY, srcU, srcV, pitchY, pitchUV, bits);
+}
+
+void p010_to_yuv16_rows_avx2(
+	int height, int width, int yStart, int yEnd,
+	uint16_t* dstY, uint16_t* dstU, uint16_t* dstV,
+	int pitchY, int pitchUV,
+	const uint16_t* src, int srcPitch, int bits)
+{
+	int widthUV = width >> 1;
+	int shift = 16 - bits;
+	int round = (shift > 0) ? (1 << (shift - 1)) : 0;
+	auto vshift = _mm_cvtsi32_si128(shift);
+	auto vround = _mm256_set1_epi16((short)round);
+
+	const uint16_t* srcY = src;
+	const uint16_t* srcUV = srcY + height * srcPitch;
+
+	// 128bitƂU,VɐU蕪
+	const __m256i pattern = _mm256_set_epi8(
+		15, 14, 11, 10, 7, 6, 3, 2,
+		13, 12, 9, 8, 5, 4, 1, 0,
+		15, 14, 11, 10, 7, 6, 3, 2,
+		13, 12, 9, 8, 5, 4, 1, 0);
+
+	// ľܓĖOaiOaZȂ̂(1<<bits)-1𒴂Ȃj
+#define FROM_P010(a) _mm256_srl_epi16(_mm256_adds_epu16(a, vround), vshift)
+
+	for (int y = yStart; y < yEnd; ++y) {
+		int x = 0;
+		for (; x <= (width - 16); x += 16) {
+			auto a = _mm256_loadu_si256((const __m256i*)&srcY[x + y * srcPitch]);
+			_mm256_storeu_si256((__m256i*)&dstY[x + y * pitchY], FROM_P010(a));
+		}
+		for (; x < width; ++x) {
+			int t = (srcY[x + y * srcPitch] + round) >> shift;
+			dstY[x + y * pitchY] = (t > (0xFFFF >> shift)) ? (0xFFFF >> shift) : t;
+		}
+	}
+
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
+		int x = 0;
+		for (; x <= (widthUV - 16); x += 16) {
+			auto a = _mm256_loadu_si256((const __m256i*)&srcUV[x * 2 + y * srcPitch]);
+			auto b = _mm256_loadu_si256((const __m256i*)&srcUV[x * 2 + 16 + y * srcPitch]);
+			// [U0-3 V0-3 | U4-7 V4-7] -> [U0-7 | V0-7]
+			a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, pattern), _MM_SHUFFLE(3, 1, 2, 0));
+			b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, pattern), _MM_SHUFFLE(3, 1, 2, 0));
+			auto u = _mm256_permute2x128_si256(a, b, 0x20);
+			auto v = _mm256_permute2x128_si256(a, b, 0x31);
+			_mm256_storeu_si256((__m256i*)&dstU[x + y * pitchUV], FROM_P010(u));
+			_mm256_storeu_si256((__m256i*)&dstV[x + y * pitchUV], FROM_P010(v));
+		}
+		for (; x < widthUV; ++x) {
+			int tu = (srcUV[x * 2 + 0 + y * srcPitch] + round) >> shift;
+			int tv = (srcUV[x * 2 + 1 + y * srcPitch] + round) >> shift;
+			dstU[x + y * pitchUV] = (tu > (0xFFFF >> shift)) ? (0xFFFF >> shift) : tu;
+			dstV[x + y * pitchUV] = (tv > (0xFFFF >> shift)) ? (0xFFFF >> shift) : tv;
+		}
+	}
+#undef FROM_P010
+}
+
+void p010_to_yuv16_avx2(
+	int height, int width,
+	uint16_t* dstY, uint16_t* dstU, uint16_t* dstV,
+	int pitchY, int pitchUV,
+	const uint16_t* src, int srcPitch, int bits)
+{
+	p010_to_yuv16_rows_avx2(height, width, 0, height, dstY, dstU, dstV, pitchY, pitchUV, src, srcPitch, bits);
+}
+
+void yuv422_to_yuy2_rows_avx2(
+	int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch,
+	const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV,
+	int pitchY, int pitchUV)
+{
+	int widthUV = width >> 1;
+
+	for (int y = yStart; y < yEnd; ++y) {
+		uint8_t* dstptr = dst + y * dstPitch;
+		int x = 0;
+		// 32f
+		for (; x <= (widthUV - 16); x += 16) {
+			auto u = _mm_loadu_si128((const __m128i*)&srcU[x + y * pitchUV]);
+			auto v = _mm_loadu_si128((const __m128i*)&srcV[x + y * pitchUV]);
+			auto uv = _mm256_inserti128_si256(_mm256_castsi128_si256(
+				_mm_unpacklo_epi8(u, v)), _mm_unpackhi_epi8(u, v), 1);
+			auto yy = _mm256_loadu_si256((const __m256i*)&srcY[x * 2 + y * pitchY]);
+			// lo: 0-7f,16-23f hi: 8-15f,24-31f
+			auto lo = _mm256_unpacklo_epi8(yy, uv);
+			auto hi = _mm256_unpackhi_epi8(yy, uv);
+			_mm256_storeu_si256((__m256i*)&dstptr[x * 4], _mm256_permute2x128_si256(lo, hi, 0x20));
+			_mm256_storeu_si256((__m256i*)&dstptr[x * 4 + 32], _mm256_permute2x128_si256(lo, hi, 0x31));
+		}
+		for (; x < widthUV; ++x) {
+			dstptr[x * 4 + 0] = srcY[x * 2 + 0 + y * pitchY];
+			dstptr[x * 4 + 1] = srcU[x + y * pitchUV];
+			dstptr[x * 4 + 2] = srcY[x * 2 + 1 + y * pitchY];
+			dstptr[x * 4 + 3] = srcV[x + y * pitchUV];
+		}
+	}
+}
+
+void yuy2_to_yuv422_rows_avx2(
+	int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV,
+	int pitchY, int pitchUV,
+	const uint8_t* src, int srcPitch)
+{
+	int widthUV = width >> 1;
+
+	// 128bitƂ[Y0-7 U0-3 V0-3]ɕבւ
+	const __m256i pattern = _mm256_set_epi8(
+		15, 11, 7, 3, 13, 9, 5, 1, 14, 12, 10, 8, 6, 4, 2, 0,
+		15, 11, 7, 3, 13, 9, 5, 1, 14, 12, 10, 8, 6, 4, 2, 0);
+	// [U0-3 V0-3 U4-7 V4-7] -> [U0-7 V0-7]
+	const __m256i patternUV = _mm256_set_epi8(
+		15, 14, 13, 12, 7, 6, 5, 4, 11, 10, 9, 8, 3, 2, 1, 0,
+		15, 14, 13, 12, 7, 6, 5, 4, 11, 10, 9, 8, 3, 2, 1, 0);
+
+	for (int y = yStart; y < yEnd; ++y) {
+		const uint8_t* srcptr = src + y * srcPitch;
+		int x = 0;
+		for (; x <= (widthUV - 16); x += 16) {
+			auto a = _mm256_loadu_si256((const __m256i*)&srcptr[x * 4]);
+			auto b = _mm256_loadu_si256((const __m256i*)&srcptr[x * 4 + 32]);
+			// [Y(16f) | U,V(16f)]
+			a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, pattern), _MM_SHUFFLE(3, 1, 2, 0));
+			b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, pattern), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_si256((__m256i*)&dstY[x * 2 + y * pitchY], _mm256_permute2x128_si256(a, b, 0x20));
+			auto uv = _mm256_shuffle_epi8(_mm256_permute2x128_si256(a, b, 0x31), patternUV);
+			uv = _mm256_permute4x64_epi64(uv, _MM_SHUFFLE(3, 1, 2, 0));
+			_mm_storeu_si128((__m128i*)&dstU[x + y * pitchUV], _mm256_castsi256_si128(uv));
+			_mm_storeu_si128((__m128i*)&dstV[x + y * pitchUV], _mm256_extracti128_si256(uv, 1));
+		}
+		for (; x < widthUV; ++x) {
+			dstY[x * 2 + 0 + y * pitchY] = srcptr[x * 4 + 0];
+			dstU[x + y * pitchUV] = srcptr[x * 4 + 1];
+			dstY[x * 2 + 1 + y * pitchY] = srcptr[x * 4 + 2];
+			dstV[x + y * pitchUV] = srcptr[x * 4 + 3];
+		}
+	}
+}
+
+void yuv444_to_ayuv_rows_avx2(
+	int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch,
+	const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV,
+	int pitchY, int pitchUV)
+{
+	const __m256i alpha = _mm256_set1_epi8((char)0xFF);
+
+	for (int y = yStart; y < yEnd; ++y) {
+		uint8_t* dstptr = dst + y * dstPitch;
+		int x = 0;
+		for (; x <= (width - 32); x += 32) {
+			auto yy = _mm256_loadu_si256((const __m256i*)&srcY[x + y * pitchY]);
+			auto u = _mm256_loadu_si256((const __m256i*)&srcU[x + y * pitchUV]);
+			auto v = _mm256_loadu_si256((const __m256i*)&srcV[x + y * pitchUV]);
+			auto vulo = _mm256_unpacklo_epi8(v, u);
+			auto vuhi = _mm256_unpackhi_epi8(v, u);
+			auto yalo = _mm256_unpacklo_epi8(yy, alpha);
+			auto yahi = _mm256_unpackhi_epi8(yy, alpha);
+			// 0-3,16-19 / 4-7,20-23 / 8-11,24-27 / 12-15,28-31f
+			auto p0 = _mm256_unpacklo_epi16(vulo, yalo);
+			auto p1 = _mm256_unpackhi_epi16(vulo, yalo);
+			auto p2 = _mm256_unpacklo_epi16(vuhi, yahi);
+			auto p3 = _mm256_unpackhi_epi16(vuhi, yahi);
+			_mm256_storeu_si256((__m256i*)&dstptr[x * 4 + 0], _mm256_permute2x128_si256(p0, p1, 0x20));
+			_mm256_storeu_si256((__m256i*)&dstptr[x * 4 + 32], _mm256_permute2x128_si256(p2, p3, 0x20));
+			_mm256_storeu_si256((__m256i*)&dstptr[x * 4 + 64], _mm256_permute2x128_si256(p0, p1, 0x31));
+			_mm256_storeu_si256((__m256i*)&dstptr[x * 4 + 96], _mm256_permute2x128_si256(p2, p3, 0x31));
+		}
+		for (; x < width; ++x) {
+			dstptr[x * 4 + 0] = srcV[x + y * pitchUV];
+			dstptr[x * 4 + 1] = srcU[x + y * pitchUV];
+			dstptr[x * 4 + 2] = srcY[x + y * pitchY];
+			dstptr[x * 4 + 3] = 0xFF;
+		}
+	}
+}
+
+void ayuv_to_yuv444_rows_avx2(
+	int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV,
+	int pitchY, int pitchUV,
+	const uint8_t* src, int srcPitch)
+{
+	// 128bitƂ[V0-3 U0-3 Y0-3 A0-3]ɕבւ
+	const __m256i pattern = _mm256_set_epi8(
+		15, 11, 7, 3, 14, 10, 6, 2, 13, 9, 5, 1, 12, 8, 4, 0,
+		15, 11, 7, 3, 14, 10, 6, 2, 13, 9, 5, 1, 12, 8, 4, 0);
+	// -> [V0-7 U0-7 | Y0-7 A0-7]
+	const __m256i perm = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+	for (int y = yStart; y < yEnd; ++y) {
+		const uint8_t* srcptr = src + y * srcPitch;
+		int x = 0;
+		for (; x <= (width - 32); x += 32) {
+			__m256i p[4];
+			for (int i = 0; i < 4; ++i) {
+				p[i] = _mm256_loadu_si256((const __m256i*)&srcptr[x * 4 + i * 32]);
+				p[i] = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(p[i], pattern), perm);
+			}
+			// lo: [V0-15 | Y0-15] hi: [U0-15 | A0-15]
+			auto lo01 = _mm256_unpacklo_epi64(p[0], p[1]);
+			auto hi01 = _mm256_unpackhi_epi64(p[0], p[1]);
+			auto lo23 = _mm256_unpacklo_epi64(p[2], p[3]);
+			auto hi23 = _mm256_unpackhi_epi64(p[2], p[3]);
+			_mm256_storeu_si256((__m256i*)&dstV[x + y * pitchUV], _mm256_permute2x128_si256(lo01, lo23, 0x20));
+			_mm256_storeu_si256((__m256i*)&dstY[x + y * pitchY], _mm256_permute2x128_si256(lo01, lo23, 0x31));
+			_mm256_storeu_si256((__m256i*)&dstU[x + y * pitchUV], _mm256_permute2x128_si256(hi01, hi23, 0x20));
+		}
+		for (; x < width; ++x) {
+			dstV[x + y * pitchUV] = srcptr[x * 4 + 0];
+			dstU[x + y * pitchUV] = srcptr[x * 4 + 1];
+			dstY[x + y * pitchY] = srcptr[x * 4 + 2];
+		}
+	}
+}
+
 #define MM_ABS(x) (((x) < 0) ? -(x) : (x))
 #define _mm256_alignr256_epi8(a, b, i) \
 	((i<=16) ? _mm256_alignr_epi8(_mm256_permute2x128_si256(a, b, (0x00<<4) + 0x03), b, i) \
@@ -262,7 +546,8 @@ void yc48_to_yuy2_avx2(uint8_t *dst, int pitch, const PIXEL_YC *src, int w, int
 }
 
 //cԂȂ
-static __forceinline void yc48_to_nv12_avx2_block(uint8_t *dstY, uint8_t *dstUV, const PIXEL_YC *ycp, const PIXEL_YC *ycpw, int pitch, int ifield) {
+// yY0: ycp̍sY, yY1: ycpw̍sY, yUV: ycp̍sUV
+static __forceinline void yc48_to_nv12_avx2_calc(__m256i& yY0, __m256i& yY1, __m256i& yUV, const PIXEL_YC *ycp, const PIXEL_YC *ycpw) {
 	const __m256i yC_YCC = _mm256_set1_epi32(1<<LSFT_YCC_8);
 	__m256i y0, y1, y2, y3, y4, y5, y6, y7;
 	y1 = _mm256_loadu_si256((const __m256i *)((const uint8_t *)ycp +   0));
@@ -278,8 +563,7 @@ static __forceinline void yc48_to_nv12_avx2_block(uint8_t *dstY, uint8_t *dstUV,
 	y1 = convert_y_range_from_yc48(y1, yC_Y_L_MA_8, Y_L_RSH_8, yC_YCC);
 	y5 = convert_y_range_from_yc48(y5, yC_Y_L_MA_8, Y_L_RSH_8, yC_YCC);
 	y1 = _mm256_packus_epi16(y1, y5);
-	y1 = _mm256_permute4x64_epi64(y1, _MM_SHUFFLE(3, 1, 2, 0));
-	_mm256_storeu_si256((__m256i *)dstY, y1);
+	yY0 = _mm256_permute4x64_epi64(y1, _MM_SHUFFLE(3, 1, 2, 0));
 
 	y1 = _mm256_loadu_si256((const __m256i *)((const uint8_t *)ycpw +   0));
 	y2 = _mm256_loadu_si256((const __m256i *)((const uint8_t *)ycpw +  32));
@@ -292,14 +576,20 @@ static __forceinline void yc48_to_nv12_avx2_block(uint8_t *dstY, uint8_t *dstUV,
 	y1 = convert_y_range_from_yc48(y1, yC_Y_L_MA_8, Y_L_RSH_8, yC_YCC);
 	y5 = convert_y_range_from_yc48(y5, yC_Y_L_MA_8, Y_L_RSH_8, yC_YCC);
 	y1 = _mm256_packus_epi16(y1, y5);
-	y1 = _mm256_permute4x64_epi64(y1, _MM_SHUFFLE(3, 1, 2, 0));
-	_mm256_storeu_si256((__m256i *)(dstY + pitch*2), y1);
+	yY1 = _mm256_permute4x64_epi64(y1, _MM_SHUFFLE(3, 1, 2, 0));
 
 	y0 = convert_uv_range_from_yc48(y0, _mm256_set1_epi16(UV_OFFSET_x1), yC_UV_L_MA_8_444, UV_L_RSH_8_444, yC_YCC);
-	y6 = convert_uv_range_from_yc48(y6, _mm256_set1_epi16(UV_OFFSET_x1), yC_UV_L_MA_8_444, UV_L_RSH_8_444, yC_YCC);
-	y0 = _mm256_packus_epi16(y0, y6);
-	y0 = _mm256_permute4x64_epi64(y0, _MM_SHUFFLE(3, 1, 2, 0));
-	_mm256_storeu_si256((__m256i *)dstUV, y0);
+	y4 = convert_uv_range_from_yc48(y4, _mm256_set1_epi16(UV_OFFSET_x1), yC_UV_L_MA_8_444, UV_L_RSH_8_444, yC_YCC);
+	y0 = _mm256_packus_epi16(y0, y4);
+	yUV = _mm256_permute4x64_epi64(y0, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+static __forceinline void yc48_to_nv12_avx2_block(uint8_t *dstY, uint8_t *dstUV, const PIXEL_YC *ycp, const PIXEL_YC *ycpw, int pitch, int ifield) {
+	__m256i yY0, yY1, yUV;
+	yc48_to_nv12_avx2_calc(yY0, yY1, yUV, ycp, ycpw);
+	_mm256_storeu_si256((__m256i *)dstY, yY0);
+	_mm256_storeu_si256((__m256i *)(dstY + pitch*2), yY1);
+	_mm256_storeu_si256((__m256i *)dstUV, yUV);
 }
 
 void yc48_to_nv12_avx2(uint8_t *dst, int pitch, const PIXEL_YC *src, int w, int h, int max_w) {
@@ -323,6 +613,63 @@ void yc48_to_nv12_avx2(uint8_t *dst, int pitch, const PIXEL_YC *src, int w, int
 	}
 }
 
+// }bvXe[WOeNX`i݌j
+// ʏ̃XgA1񂲂ƂɃoXɏoĒx̂ŁALbVCi64fjPʂ
+// Xg[~OXgAA͂̓\tgEFAvtFb`Őǂ݂
+// dstpitch64oCgACłȂΒʏłŏ
+void yc48_to_nv12_stream_avx2(uint8_t *dst, int pitch, const PIXEL_YC *src, int w, int h, int max_w) {
+	if (((size_t)dst & 63) != 0 || (pitch & 63) != 0 || w < 64) {
+		yc48_to_nv12_avx2(dst, pitch, src, w, h, max_w);
+		return;
+	}
+	// 2[vi͂̓[v1s384oCgj
+	const int PREFETCH_PX = 128;
+	for (int y = 0; y < h; y += 4) {
+		for (int ifield = 0; ifield < 2; ifield++) {
+			const PIXEL_YC *ycp = &src[max_w * (y + ifield)];
+			const PIXEL_YC *ycpw = &ycp[2 * max_w];
+			uint8_t *dstY = &dst[pitch * (y + ifield)];
+			uint8_t *dstUV = &dst[pitch * (h + ifield + (y >> 1))];
+			int x = 0;
+			for (; x <= w - 64; x += 64, ycp += 64, ycpw += 64, dstY += 64, dstUV += 64) {
+				for (int i = 0; i < 64 * (int)sizeof(PIXEL_YC); i += 64) {
+					_mm_prefetch((const char *)(ycp + PREFETCH_PX) + i, _MM_HINT_T0);
+					_mm_prefetch((const char *)(ycpw + PREFETCH_PX) + i, _MM_HINT_T0);
+				}
+				__m256i yY0, yY1, yUV, yY2, yY3, yUV1;
+				yc48_to_nv12_avx2_calc(yY0, yY1, yUV, ycp, ycpw);
+				yc48_to_nv12_avx2_calc(yY2, yY3, yUV1, ycp + 32, ycpw + 32);
+				_mm256_stream_si256((__m256i *)dstY, yY0);
+				_mm256_stream_si256((__m256i *)(dstY + 32), yY2);
+				_mm256_stream_si256((__m256i *)(dstY + pitch*2), yY1);
+				_mm256_stream_si256((__m256i *)(dstY + pitch*2 + 32), yY3);
+				_mm256_stream_si256((__m256i *)dstUV, yUV);
+				_mm256_stream_si256((__m256i *)(dstUV + 32), yUV1);
+			}
+			// [̓Xg[~OXgA͈͂ƏdȂȂ悤ɏ
+			if (w - x > 32) {
+				yc48_to_nv12_avx2_block(dstY, dstUV, ycp, ycpw, pitch, ifield);
+				x += 32, ycp += 32, ycpw += 32, dstY += 32, dstUV += 32;
+			}
+			int rest = w - x;
+			if (rest > 0) {
+				alignas(32) uint8_t tmp[3][32];
+				int offset = 32 - rest;
+				__m256i yY0, yY1, yUV;
+				yc48_to_nv12_avx2_calc(yY0, yY1, yUV, ycp - offset, ycpw - offset);
+				_mm256_store_si256((__m256i *)tmp[0], yY0);
+				_mm256_store_si256((__m256i *)tmp[1], yY1);
+				_mm256_store_si256((__m256i *)tmp[2], yUV);
+				memcpy(dstY, tmp[0] + offset, rest);
+				memcpy(dstY + pitch*2, tmp[1] + offset, rest);
+				memcpy(dstUV, tmp[2] + offset, rest);
+			}
+		}
+	}
+	// Unmap̑OɃXg[~OXgA
+	_mm_sfence();
+}
+
 static __forceinline void gather_y_u_v_to_yc48(__m256i& y0, __m256i& y1, __m256i& y2) {
 	__m256i y3, y4, y5;
 
@@ -501,11 +848,12 @@ static __forceinline void nv12_to_yc48_avx2_block(
 	}
 }
 
-void nv12_to_yc48_avx2(PIXEL_YC *dst, const uint8_t *src, int pitch, int w, int h, int max_w) {
-	const uint8_t *srcY = src;
-	const uint8_t *srcUV = srcY + h * pitch;
+void nv12_to_yc48_rows_avx2(int h, int w, int yStart, int yEnd, PIXEL_YC *dst, int max_w, const uint8_t *src, int pitch) {
+	const uint8_t *srcY = src + yStart * pitch;
+	const uint8_t *srcUV = src + h * pitch + (yStart >> 1) * pitch;
+	dst += yStart * max_w;
 
-	for (int y = 0; y < h; y += 2, dst += max_w*2, srcY += pitch*2, srcUV += pitch) {
+	for (int y = yStart; y < yEnd; y += 2, dst += max_w*2, srcY += pitch*2, srcUV += pitch) {
 		const uint8_t *srcYptr = srcY;
 		const uint8_t *srcUVptr = srcUV;
 		PIXEL_YC *dstptr = dst;
@@ -527,3 +875,7 @@ void nv12_to_yc48_avx2(PIXEL_YC *dst, const uint8_t *src, int pitch, int w, int
 			dstptr, srcYptr, srcUVptr, y, h, pitch, max_w);
 	}
 }
+
+void nv12_to_yc48_avx2(PIXEL_YC *dst, const uint8_t *src, int pitch, int w, int h, int max_w) {
+	nv12_to_yc48_rows_avx2(h, w, 0, h, dst, max_w, src, pitch);
+}
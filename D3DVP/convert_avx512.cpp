@@ -0,0 +1,308 @@
+
+#define NOMINMAX
+#include <Windows.h>
+#include <string.h>
+
+#include <immintrin.h>
+
+#include "convert.h"
+
+// AVX-512iF+BWj
+// шŌ܂炸ߐ̂BȊO̓fBXpb`e[uAVX2łg
+// o͂CŁAAVX2łƓɂȂ
+
+void yuv_to_nv12_rows_avx512(
+	int height, int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch,
+	const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV,
+	int pitchY, int pitchUV)
+{
+	int widthUV = width >> 1;
+
+	uint8_t* dstY = dst;
+	uint8_t* dstUV = dstY + height * dstPitch;
+
+	// unpack128bitƂȂ̂ŕג
+	const __m512i perm0 = _mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11);
+	const __m512i perm1 = _mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15);
+
+	for (int y = yStart; y < yEnd; ++y) {
+		memcpy(&dstY[y * dstPitch], &srcY[y * pitchY], width);
+	}
+
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
+		int x = 0;
+		for (; x <= (widthUV - 64); x += 64) {
+			auto u = _mm512_loadu_si512((const void*)&srcU[x + y * pitchUV]);
+			auto v = _mm512_loadu_si512((const void*)&srcV[x + y * pitchUV]);
+			auto lo = _mm512_unpacklo_epi8(u, v);
+			auto hi = _mm512_unpackhi_epi8(u, v);
+			_mm512_storeu_si512((void*)&dstUV[x * 2 + y * dstPitch], _mm512_permutex2var_epi64(lo, perm0, hi));
+			_mm512_storeu_si512((void*)&dstUV[x * 2 + 64 + y * dstPitch], _mm512_permutex2var_epi64(lo, perm1, hi));
+		}
+		for (; x < widthUV; ++x) {
+			dstUV[x * 2 + 0 + y * dstPitch] = srcU[x + y * pitchUV];
+			dstUV[x * 2 + 1 + y * dstPitch] = srcV[x + y * pitchUV];
+		}
+	}
+}
+
+void nv12_to_yuv_rows_avx512(
+	int height, int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV,
+	int pitchY, int pitchUV,
+	const uint8_t* src, int srcPitch)
+{
+	int widthUV = width >> 1;
+
+	const uint8_t* srcY = src;
+	const uint8_t* srcUV = srcY + height * srcPitch;
+
+	// 128bitƂ[U0-7 V0-7]ɐU蕪
+	const __m512i pattern = _mm512_broadcast_i32x4(_mm_set_epi8(
+		15, 13, 11, 9, 7, 5, 3, 1,
+		14, 12, 10, 8, 6, 4, 2, 0));
+	const __m512i permU = _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14);
+	const __m512i permV = _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15);
+
+	for (int y = yStart; y < yEnd; ++y) {
+		memcpy(&dstY[y * pitchY], &srcY[y * srcPitch], width);
+	}
+
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
+		int x = 0;
+		for (; x <= (widthUV - 64); x += 64) {
+			auto a = _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)&srcUV[x * 2 + y * srcPitch]), pattern);
+			auto b = _mm512_shuffle_epi8(_mm512_loadu_si512((const void*)&srcUV[x * 2 + 64 + y * srcPitch]), pattern);
+			_mm512_storeu_si512((void*)&dstU[x + y * pitchUV], _mm512_permutex2var_epi64(a, permU, b));
+			_mm512_storeu_si512((void*)&dstV[x + y * pitchUV], _mm512_permutex2var_epi64(a, permV, b));
+		}
+		for (; x < widthUV; ++x) {
+			dstU[x + y * pitchUV] = srcUV[x * 2 + 0 + y * srcPitch];
+			dstV[x + y * pitchUV] = srcUV[x * 2 + 1 + y * srcPitch];
+		}
+	}
+}
+
+static const int LSFT_YCC_8    = 4;
+static const int UV_OFFSET_x1 = (1<<11);
+
+static const int Y_L_MUL    = 219;
+static const int Y_L_ADD_8  = 383;
+static const int Y_L_RSH_8  = 12;
+
+static const int UV_L_MUL         = 14;
+static const int UV_L_ADD_8_444   = 132;
+static const int UV_L_RSH_8_444   =  8;
+
+// 32fYC48i96wordjY, UV(fcb,cr)W߂CfbNX
+// 64wordȍ~3ڂ̃WX^̂ŉ6bitg
+alignas(64) static const uint16_t ARRAY_GATHER_YC48_Y[32] = {
+	0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 33, 36, 39, 42, 45,
+	48, 51, 54, 57, 60, 63, 2, 5, 8, 11, 14, 17, 20, 23, 26, 29
+};
+alignas(64) static const uint16_t ARRAY_GATHER_YC48_UV[32] = {
+	1, 2, 7, 8, 13, 14, 19, 20, 25, 26, 31, 32, 37, 38, 43, 44,
+	49, 50, 55, 56, 61, 62, 3, 4, 9, 10, 15, 16, 21, 22, 27, 28
+};
+// 22Ԗڈȍ~3ڂ̃WX^
+static const __mmask32 MASK_GATHER_YC48_HI = 0xFFC00000;
+
+// Y(0-31), U(32-63)ׂYC48ɂCfbNXBV̈ʒuṼCfbNX
+alignas(64) static const uint16_t ARRAY_SCATTER_YC48[96] = {
+	0, 32, 0, 1, 33, 1, 2, 34, 2, 3, 35, 3, 4, 36, 4, 5,
+	37, 5, 6, 38, 6, 7, 39, 7, 8, 40, 8, 9, 41, 9, 10, 42,
+	10, 11, 43, 11, 12, 44, 12, 13, 45, 13, 14, 46, 14, 15, 47, 15,
+	16, 48, 16, 17, 49, 17, 18, 50, 18, 19, 51, 19, 20, 52, 20, 21,
+	53, 21, 22, 54, 22, 23, 55, 23, 24, 56, 24, 25, 57, 25, 26, 58,
+	26, 27, 59, 27, 28, 60, 28, 29, 61, 29, 30, 62, 30, 31, 63, 31
+};
+static const __mmask32 MASK_SCATTER_YC48_V[3] = { 0x24924924, 0x49249249, 0x92492492 };
+
+// 2wordỉf̐FjCfbNX
+alignas(64) static const uint16_t ARRAY_NEXT_UV[32] = {
+	2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17,
+	18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33
+};
+
+static __forceinline __m512i convert_range_from_yc48(__m512i z0, int MA, int RSH) {
+	const __m512i zC_MA = _mm512_set1_epi32(MA);
+	const __m512i zC_YCC = _mm512_set1_epi32(1<<LSFT_YCC_8);
+	__m512i z7;
+
+	z7 = _mm512_unpackhi_epi16(z0, _mm512_set1_epi16(1));
+	z0 = _mm512_unpacklo_epi16(z0, _mm512_set1_epi16(1));
+
+	z0 = _mm512_madd_epi16(z0, zC_MA);
+	z7 = _mm512_madd_epi16(z7, zC_MA);
+	z0 = _mm512_srai_epi32(z0, RSH);
+	z7 = _mm512_srai_epi32(z7, RSH);
+	z0 = _mm512_add_epi32(z0, zC_YCC);
+	z7 = _mm512_add_epi32(z7, zC_YCC);
+
+	return _mm512_packus_epi32(z0, z7);
+}
+
+// 32fY, UV(16g)oĕϊ
+static __forceinline void yc48_to_nv12_avx512_gather32(__m512i& zY, __m512i& zUV, const PIXEL_YC *ycp) {
+	__m512i z0 = _mm512_loadu_si512((const void *)((const uint8_t *)ycp +   0));
+	__m512i z1 = _mm512_loadu_si512((const void *)((const uint8_t *)ycp +  64));
+	__m512i z2 = _mm512_loadu_si512((const void *)((const uint8_t *)ycp + 128));
+	__m512i zIdxY = _mm512_load_si512((const void *)ARRAY_GATHER_YC48_Y);
+	__m512i zIdxUV = _mm512_load_si512((const void *)ARRAY_GATHER_YC48_UV);
+	zY = _mm512_permutex2var_epi16(z0, zIdxY, z1);
+	zY = _mm512_mask_permutexvar_epi16(zY, MASK_GATHER_YC48_HI, zIdxY, z2);
+	zUV = _mm512_permutex2var_epi16(z0, zIdxUV, z1);
+	zUV = _mm512_mask_permutexvar_epi16(zUV, MASK_GATHER_YC48_HI, zIdxUV, z2);
+
+	zY = convert_range_from_yc48(zY, (Y_L_ADD_8 << 16) | Y_L_MUL, Y_L_RSH_8);
+	zUV = _mm512_add_epi16(zUV, _mm512_set1_epi16(UV_OFFSET_x1));
+	zUV = convert_range_from_yc48(zUV, (UV_L_ADD_8_444 << 16) | UV_L_MUL, UV_L_RSH_8_444);
+}
+
+// 64f1s
+static __forceinline void yc48_to_nv12_avx512_row(__m512i& zY, __m512i& zUV, const PIXEL_YC *ycp) {
+	// packus128bitƂȂ̂ŕג
+	const __m512i perm = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+	__m512i zY0, zUV0, zY1, zUV1;
+	yc48_to_nv12_avx512_gather32(zY0, zUV0, ycp);
+	yc48_to_nv12_avx512_gather32(zY1, zUV1, ycp + 32);
+	zY = _mm512_permutexvar_epi64(perm, _mm512_packus_epi16(zY0, zY1));
+	zUV = _mm512_permutexvar_epi64(perm, _mm512_packus_epi16(zUV0, zUV1));
+}
+
+//cԂȂ
+static __forceinline void yc48_to_nv12_avx512_block(uint8_t *dstY, uint8_t *dstUV, const PIXEL_YC *ycp, const PIXEL_YC *ycpw, int pitch) {
+	__m512i zY, zUV, zYw, zUVw;
+	yc48_to_nv12_avx512_row(zY, zUV, ycp);
+	yc48_to_nv12_avx512_row(zYw, zUVw, ycpw);
+	_mm512_storeu_si512((void *)dstY, zY);
+	_mm512_storeu_si512((void *)(dstY + pitch*2), zYw);
+	_mm512_storeu_si512((void *)dstUV, zUV);
+}
+
+void yc48_to_nv12_avx512(uint8_t *dst, int pitch, const PIXEL_YC *src, int w, int h, int max_w) {
+	if (w < 64) {
+		yc48_to_nv12_avx2(dst, pitch, src, w, h, max_w);
+		return;
+	}
+	for (int y = 0; y < h; y += 4) {
+		for (int ifield = 0; ifield < 2; ifield++) {
+			const PIXEL_YC *ycp = &src[max_w * (y + ifield)];
+			const PIXEL_YC *ycpw = &ycp[2 * max_w];
+			uint8_t *dstY = &dst[pitch * (y + ifield)];
+			uint8_t *dstUV = &dst[pitch * (h + ifield + (y >> 1))];
+			int x = 0;
+			for (; x < w - 64; x += 64, ycp += 64, ycpw += 64, dstY += 64, dstUV += 64) {
+				yc48_to_nv12_avx512_block(dstY, dstUV, ycp, ycpw, pitch);
+			}
+			int offset = x - (w - 64);
+			dstY -= offset;
+			dstUV -= offset;
+			ycp -= offset;
+			ycpw -= offset;
+			yc48_to_nv12_avx512_block(dstY, dstUV, ycp, ycpw, pitch);
+		}
+	}
+}
+
+static __forceinline __m512i convert_y_range_to_yc48(__m512i z0) {
+	//coef = 4788
+	//((( y - 32768 ) * coef) >> 16 ) + (coef/2 - 299)
+	z0 = _mm512_add_epi16(z0, _mm512_set1_epi16((short)0x8000)); // -32768
+	z0 = _mm512_mulhi_epi16(z0, _mm512_set1_epi16(4788));
+	z0 = _mm512_adds_epi16(z0, _mm512_set1_epi16(4788/2 - 299));
+	return z0;
+}
+
+static __forceinline __m512i convert_uv_range_to_yc48(__m512i z0) {
+	//coeff = 4682
+	//UV = (( uv - 32768 ) * coef + (1<<15) ) >> 16
+	const __m512i zC_coeff = _mm512_unpacklo_epi16(_mm512_set1_epi16(4682), _mm512_set1_epi16(-1));
+	const __m512i zC_0x8000 = _mm512_set1_epi16((short)0x8000);
+	__m512i z1;
+	z0 = _mm512_add_epi16(z0, zC_0x8000); // -32768
+	z1 = _mm512_unpackhi_epi16(z0, zC_0x8000);
+	z0 = _mm512_unpacklo_epi16(z0, zC_0x8000);
+	z0 = _mm512_madd_epi16(z0, zC_coeff);
+	z1 = _mm512_madd_epi16(z1, zC_coeff);
+	z0 = _mm512_srai_epi32(z0, 16);
+	z1 = _mm512_srai_epi32(z1, 16);
+	return _mm512_packs_epi32(z0, z1);
+}
+
+// 32fY<<8ƕϊς݂U,VYC48o͂
+static __forceinline void nv12_to_yc48_avx512_row(PIXEL_YC *dstptr, __m512i zY, __m512i zU, __m512i zV) {
+	__m512i zIdx0 = _mm512_load_si512((const void *)&ARRAY_SCATTER_YC48[0]);
+	__m512i zIdx1 = _mm512_load_si512((const void *)&ARRAY_SCATTER_YC48[32]);
+	__m512i zIdx2 = _mm512_load_si512((const void *)&ARRAY_SCATTER_YC48[64]);
+	zY = convert_y_range_to_yc48(zY);
+	__m512i z0 = _mm512_mask_permutexvar_epi16(_mm512_permutex2var_epi16(zY, zIdx0, zU), MASK_SCATTER_YC48_V[0], zIdx0, zV);
+	__m512i z1 = _mm512_mask_permutexvar_epi16(_mm512_permutex2var_epi16(zY, zIdx1, zU), MASK_SCATTER_YC48_V[1], zIdx1, zV);
+	__m512i z2 = _mm512_mask_permutexvar_epi16(_mm512_permutex2var_epi16(zY, zIdx2, zU), MASK_SCATTER_YC48_V[2], zIdx2, zV);
+	_mm512_storeu_si512((void *)((uint8_t *)dstptr +   0), z0);
+	_mm512_storeu_si512((void *)((uint8_t *)dstptr +  64), z1);
+	_mm512_storeu_si512((void *)((uint8_t *)dstptr + 128), z2);
+}
+
+static __forceinline __m512i nv12_to_yc48_avx512_load(const uint8_t *ptr) {
+	return _mm512_slli_epi16(_mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)ptr)), 8);
+}
+
+//ԂAcԂȂ
+template<bool lastBlock>
+static __forceinline void nv12_to_yc48_avx512_block(
+	__m512i& zUV0, PIXEL_YC *dstptr, const uint8_t *srcYptr, const uint8_t *srcUVptr, int pitch, int max_w) {
+	__m512i zUV1;
+	if (lastBlock) {
+		// E[͍Ō̐F̂܂܎g
+		zUV1 = _mm512_permutexvar_epi32(_mm512_set1_epi32(15), zUV0);
+	} else {
+		zUV1 = nv12_to_yc48_avx512_load(srcUVptr + 32);
+	}
+	__m512i zUV01 = _mm512_permutex2var_epi16(zUV0, _mm512_load_si512((const void *)ARRAY_NEXT_UV), zUV1);
+	zUV01 = _mm512_avg_epu16(zUV01, zUV0);
+
+	const __mmask32 odd = 0xAAAAAAAA;
+	__m512i zU = _mm512_mask_blend_epi16(odd, zUV0, _mm512_slli_epi32(zUV01, 16));
+	__m512i zV = _mm512_mask_blend_epi16(odd, _mm512_srli_epi32(zUV0, 16), zUV01);
+	zU = convert_uv_range_to_yc48(zU);
+	zV = convert_uv_range_to_yc48(zV);
+
+	// 2sœFg
+	nv12_to_yc48_avx512_row(dstptr, nv12_to_yc48_avx512_load(srcYptr), zU, zV);
+	nv12_to_yc48_avx512_row(dstptr + max_w, nv12_to_yc48_avx512_load(srcYptr + pitch), zU, zV);
+
+	if (!lastBlock) {
+		zUV0 = zUV1;
+	}
+}
+
+void nv12_to_yc48_rows_avx512(int h, int w, int yStart, int yEnd, PIXEL_YC *dst, int max_w, const uint8_t *src, int pitch) {
+	const uint8_t *srcY = src + yStart * pitch;
+	const uint8_t *srcUV = src + h * pitch + (yStart >> 1) * pitch;
+	dst += yStart * max_w;
+
+	for (int y = yStart; y < yEnd; y += 2, dst += max_w*2, srcY += pitch*2, srcUV += pitch) {
+		const uint8_t *srcYptr = srcY;
+		const uint8_t *srcUVptr = srcUV;
+		PIXEL_YC *dstptr = dst;
+		__m512i zUV0 = nv12_to_yc48_avx512_load(srcUVptr);
+		int x = 0;
+		for (; x < w - 32; x += 32, dstptr += 32, srcYptr += 32, srcUVptr += 32) {
+			nv12_to_yc48_avx512_block<false>(zUV0, dstptr, srcYptr, srcUVptr, pitch, max_w);
+		}
+		int offset = x - (w - 32);
+		if (offset > 0) {
+			dstptr -= offset;
+			srcYptr -= offset;
+			srcUVptr -= offset;
+			zUV0 = nv12_to_yc48_avx512_load(srcUVptr);
+		}
+		nv12_to_yc48_avx512_block<true>(zUV0, dstptr, srcYptr, srcUVptr, pitch, max_w);
+	}
+}
+
+void nv12_to_yc48_avx512(PIXEL_YC *dst, const uint8_t *src, int pitch, int w, int h, int max_w) {
+	nv12_to_yc48_rows_avx512(h, w, 0, h, dst, max_w, src, pitch);
+}
@@ -4,24 +4,22 @@
 #include <string.h>
 #include "convert.h"
 
-void yuv_to_nv12_c(
-	int height, int width,
+void yuv_to_nv12_rows_c(
+	int height, int width, int yStart, int yEnd,
 	uint8_t* dst, int dstPitch,
 	const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV,
 	int pitchY, int pitchUV)
 {
 	int widthUV = width >> 1;
-	int heightUV = height >> 1;
-	int offsetUV = width * height;
 
 	uint8_t* dstY = dst;
 	uint8_t* dstUV = dstY + height * dstPitch;
 
-	for (int y = 0; y < height; ++y) {
+	for (int y = yStart; y < yEnd; ++y) {
 		memcpy(&dstY[y * dstPitch], &srcY[y * pitchY], width);
 	}
 
-	for (int y = 0; y < heightUV; ++y) {
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
 		for (int x = 0; x < widthUV; ++x) {
 			dstUV[x * 2 + 0 + y * dstPitch] = srcU[x + y * pitchUV];
 			dstUV[x * 2 + 1 + y * dstPitch] = srcV[x + y * pitchUV];
@@ -29,24 +27,31 @@ void yuv_to_nv12_c(
 	}
 }
 
-void nv12_to_yuv_c(
+void yuv_to_nv12_c(
 	int height, int width,
+	uint8_t* dst, int dstPitch,
+	const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV,
+	int pitchY, int pitchUV)
+{
+	yuv_to_nv12_rows_c(height, width, 0, height, dst, dstPitch, srcY, srcU, srcV, pitchY, pitchUV);
+}
+
+void nv12_to_yuv_rows_c(
+	int height, int width, int yStart, int yEnd,
 	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV,
 	int pitchY, int pitchUV,
 	const uint8_t* src, int srcPitch)
 {
 	int widthUV = width >> 1;
-	int heightUV = height >> 1;
-	int offsetUV = width * height;
 
 	const uint8_t* srcY = src;
 	const uint8_t* srcUV = srcY + height * srcPitch;
 
-	for (int y = 0; y < height; ++y) {
+	for (int y = yStart; y < yEnd; ++y) {
 		memcpy(&dstY[y * pitchY], &srcY[y * srcPitch], width);
 	}
 
-	for (int y = 0; y < heightUV; ++y) {
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
 		for (int x = 0; x < widthUV; ++x) {
 			dstU[x + y * pitchUV] = srcUV[x * 2 + 0 + y * srcPitch];
 			dstV[x + y * pitchUV] = srcUV[x * 2 + 1 + y * srcPitch];
@@ -54,6 +59,161 @@ void nv12_to_yuv_c(
 	}
 }
 
+void nv12_to_yuv_c(
+	int height, int width,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV,
+	int pitchY, int pitchUV,
+	const uint8_t* src, int srcPitch)
+{
+	nv12_to_yuv_rows_c(height, width, 0, height, dstY, dstU, dstV, pitchY, pitchUV, src, srcPitch);
+}
+
+void yuv16_to_p010_rows_c(
+	int height, int width, int yStart, int yEnd,
+	uint16_t* dst, int dstPitch,
+	const uint16_t* srcY, const uint16_t* srcU, const uint16_t* srcV,
+	int pitchY, int pitchUV, int bits)
+{
+	int widthUV = width >> 1;
+	int shift = 16 - bits;
+
+	uint16_t* dstY = dst;
+	uint16_t* dstUV = dstY + height * dstPitch;
+
+	for (int y = yStart; y < yEnd; ++y) {
+		for (int x = 0; x < width; ++x) {
+			dstY[x + y * dstPitch] = srcY[x + y * pitchY] << shift;
+		}
+	}
+
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
+		for (int x = 0; x < widthUV; ++x) {
+			dstUV[x * 2 + 0 + y * dstPitch] = srcU[x + y * pitchUV] << shift;
+			dstUV[x * 2 + 1 + y * dstPitch] = srcV[x + y * pitchUV] << shift;
+		}
+	}
+}
+
+void yuv16_to_p010_c(
+	int height, int width,
+	uint16_t* dst, int dstPitch,
+	const uint16_t* srcY, const uint16_t* srcU, const uint16_t* srcV,
+	int pitchY, int pitchUV, int bits)
+{
+	yuv16_to_p010_rows_c(height, width, 0, height, dst, dstPitch, srcY, srcU, srcV, pitchY, pitchUV, bits);
+}
+
+static inline uint16_t from_p010(uint16_t v, int shift, int round) {
+	int t = (v + round) >> shift;
+	int maxv = 0xFFFF >> shift;
+	return (t > maxv) ? maxv : t;
+}
+
+void p010_to_yuv16_rows_c(
+	int height, int width, int yStart, int yEnd,
+	uint16_t* dstY, uint16_t* dstU, uint16_t* dstV,
+	int pitchY, int pitchUV,
+	const uint16_t* src, int srcPitch, int bits)
+{
+	int widthUV = width >> 1;
+	int shift = 16 - bits;
+	int round = (shift > 0) ? (1 << (shift - 1)) : 0;
+
+	const uint16_t* srcY = src;
+	const uint16_t* srcUV = srcY + height * srcPitch;
+
+	for (int y = yStart; y < yEnd; ++y) {
+		for (int x = 0; x < width; ++x) {
+			dstY[x + y * pitchY] = from_p010(srcY[x + y * srcPitch], shift, round);
+		}
+	}
+
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
+		for (int x = 0; x < widthUV; ++x) {
+			dstU[x + y * pitchUV] = from_p010(srcUV[x * 2 + 0 + y * srcPitch], shift, round);
+			dstV[x + y * pitchUV] = from_p010(srcUV[x * 2 + 1 + y * srcPitch], shift, round);
+		}
+	}
+}
+
+void p010_to_yuv16_c(
+	int height, int width,
+	uint16_t* dstY, uint16_t* dstU, uint16_t* dstV,
+	int pitchY, int pitchUV,
+	const uint16_t* src, int srcPitch, int bits)
+{
+	p010_to_yuv16_rows_c(height, width, 0, height, dstY, dstU, dstV, pitchY, pitchUV, src, srcPitch, bits);
+}
+void yuv422_to_yuy2_rows_c(
+	int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch,
+	const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV,
+	int pitchY, int pitchUV)
+{
+	int widthUV = width >> 1;
+
+	for (int y = yStart; y < yEnd; ++y) {
+		uint8_t* dstptr = dst + y * dstPitch;
+		for (int x = 0; x < widthUV; ++x) {
+			dstptr[x * 4 + 0] = srcY[x * 2 + 0 + y * pitchY];
+			dstptr[x * 4 + 1] = srcU[x + y * pitchUV];
+			dstptr[x * 4 + 2] = srcY[x * 2 + 1 + y * pitchY];
+			dstptr[x * 4 + 3] = srcV[x + y * pitchUV];
+		}
+	}
+}
+
+void yuy2_to_yuv422_rows_c(
+	int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV,
+	int pitchY, int pitchUV,
+	const uint8_t* src, int srcPitch)
+{
+	int widthUV = width >> 1;
+
+	for (int y = yStart; y < yEnd; ++y) {
+		const uint8_t* srcptr = src + y * srcPitch;
+		for (int x = 0; x < widthUV; ++x) {
+			dstY[x * 2 + 0 + y * pitchY] = srcptr[x * 4 + 0];
+			dstU[x + y * pitchUV] = srcptr[x * 4 + 1];
+			dstY[x * 2 + 1 + y * pitchY] = srcptr[x * 4 + 2];
+			dstV[x + y * pitchUV] = srcptr[x * 4 + 3];
+		}
+	}
+}
+
+void yuv444_to_ayuv_rows_c(
+	int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch,
+	const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV,
+	int pitchY, int pitchUV)
+{
+	for (int y = yStart; y < yEnd; ++y) {
+		uint8_t* dstptr = dst + y * dstPitch;
+		for (int x = 0; x < width; ++x) {
+			dstptr[x * 4 + 0] = srcV[x + y * pitchUV];
+			dstptr[x * 4 + 1] = srcU[x + y * pitchUV];
+			dstptr[x * 4 + 2] = srcY[x + y * pitchY];
+			dstptr[x * 4 + 3] = 0xFF;
+		}
+	}
+}
+
+void ayuv_to_yuv444_rows_c(
+	int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV,
+	int pitchY, int pitchUV,
+	const uint8_t* src, int srcPitch)
+{
+	for (int y = yStart; y < yEnd; ++y) {
+		const uint8_t* srcptr = src + y * srcPitch;
+		for (int x = 0; x < width; ++x) {
+			dstV[x + y * pitchUV] = srcptr[x * 4 + 0];
+			dstU[x + y * pitchUV] = srcptr[x * 4 + 1];
+			dstY[x + y * pitchY] = srcptr[x * 4 + 2];
+		}
+	}
+}
 
 template<typename T>
 T clamp(T n, T min, T max)
@@ -90,7 +250,9 @@ void yc48_to_nv12_c(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h,
 	uint8_t* dstUV = dstY + h * pitch;
 
 	for (int y = 0; y < h; ++y) {
-		int y2 = (y >> 1);
+		// F͏cԂȂŃtB[hƂɎ
+		// is̓gbvtB[h4nsځAs̓{gtB[h4n+1sځBSIMDłƓj
+		int y2 = ((y >> 2) << 1) + (y & 1);
 		for (int x = 0; x < w; x += 2) {
 			short y0 = src[x + y * max_w].y;
 			short y1 = src[x + 1 + y * max_w].y;
@@ -105,7 +267,7 @@ void yc48_to_nv12_c(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h,
 			dstY[x + 0 + y * pitch] = Y0;
 			dstY[x + 1 + y * pitch] = Y1;
 
-			if ((y & 1) == (y2 & 1)) {
+			if ((y & 2) == 0) {
 				dstUV[x + 0 + y2 * pitch] = U;
 				dstUV[x + 1 + y2 * pitch] = V;
 			}
@@ -113,98 +275,65 @@ void yc48_to_nv12_c(uint8_t* dst, int pitch, const PIXEL_YC* src, int w, int h,
 	}
 }
 
+// 8bitYYC48ɕϊ
+static inline short y_to_yc48(int Y) {
+	return (short)(((Y * 1197) >> 6) - 299);
+}
+
+// 8bitUV8bitVtgliԂl܂ށjYC48ɕϊ
+static inline short uv16_to_yc48(int uv16) {
+	return (short)(((uv16 - 32768) * 4682 + 32768) >> 16);
+}
+
+// UV̓ĂȂf͍Ẻf̕ςŕԂ
+// SIMDłƓʂɂȂ悤8bit̂܂ܕρiľܓjĂϊ
 void yuy2_to_yc48_c(PIXEL_YC* dst, const uint8_t* src, int pitch, int w, int h, int max_w)
 {
-	const uint8_t* srcptr = src;
-
 	for (int y = 0; y < h; ++y) {
-
-		// ܂UV͍ɂ̂܂ܓ
-		for (int x = 0, x2 = 0; x < w; x += 2, ++x2) {
-			uint8_t Y0 = srcptr[x * 2 + 0 + y * pitch];
-			uint8_t U = srcptr[x * 2 + 1 + y * pitch];
-			uint8_t Y1 = srcptr[x * 2 + 2 + y * pitch];
-			uint8_t V = srcptr[x * 2 + 3 + y * pitch];
-
-			short y0 = ((Y0 * 1197) >> 6) - 299;
-			short y1 = ((Y1 * 1197) >> 6) - 299;
-			short cb = (U * 4682 - (4681 << 7)) >> 8;
-			short cr = (V * 4682 - (4681 << 7)) >> 8;
-
-			dst[x + y * max_w].y = y0;
-			dst[x + 1 + y * max_w].y = y1;
-			dst[x + y * max_w].cb = cb;
-			dst[x + y * max_w].cr = cr;
-		}
-
-		// UV̓ĂȂƂ
-		short cb0 = dst[y * max_w].cb;
-		short cr0 = dst[y * max_w].cr;
-		for (int x = 0; x < w - 2; x += 2) {
-			short cb2 = dst[x + 2 + y * max_w].cb;
-			short cr2 = dst[x + 2 + y * max_w].cr;
-			dst[x + 1 + y * max_w].cb = (cb0 + cb2) >> 1;
-			dst[x + 1 + y * max_w].cr = (cr0 + cr2) >> 1;
-			cb0 = cb2;
-			cr0 = cr2;
+		const uint8_t* srcptr = src + y * pitch;
+		PIXEL_YC* dstptr = dst + y * max_w;
+		for (int x = 0; x < w; x += 2) {
+			int x2 = (x + 2 < w) ? (x + 2) : x;
+			int U0 = srcptr[x * 2 + 1], U2 = srcptr[x2 * 2 + 1];
+			int V0 = srcptr[x * 2 + 3], V2 = srcptr[x2 * 2 + 3];
+
+			dstptr[x].y = y_to_yc48(srcptr[x * 2 + 0]);
+			dstptr[x].cb = uv16_to_yc48(U0 << 8);
+			dstptr[x].cr = uv16_to_yc48(V0 << 8);
+			dstptr[x + 1].y = y_to_yc48(srcptr[x * 2 + 2]);
+			dstptr[x + 1].cb = uv16_to_yc48(((U0 + U2 + 1) >> 1) << 8);
+			dstptr[x + 1].cr = uv16_to_yc48(((V0 + V2 + 1) >> 1) << 8);
 		}
-		dst[w - 1 + y * max_w].cb = cb0;
-		dst[w - 1 + y * max_w].cr = cr0;
 	}
 }
 
-void nv12_to_yc48_c(PIXEL_YC* dst, const uint8_t* src, int pitch, int w, int h, int max_w)
+// F͉ԂAcԂȂiSIMDłƓj
+// NV1216bitɍLĂ畽ς̂Ŏľܓ͓Ȃ
+void nv12_to_yc48_rows_c(int h, int w, int yStart, int yEnd, PIXEL_YC* dst, int max_w, const uint8_t* src, int pitch)
 {
 	const uint8_t* srcY = src;
 	const uint8_t* srcUV = srcY + h * pitch;
 
-	for (int y = 0; y < h; ++y) {
-
-		// ܂UV͍ɂ̂܂ܓ
-		for (int x = 0, x2 = 0; x < w; x += 2, ++x2) {
-			uint8_t Y0 = srcY[x + 0 + y * pitch];
-			uint8_t Y1 = srcY[x + 1 + y * pitch];
-			uint8_t U = srcUV[x + 0 + (y >> 1) * pitch];
-			uint8_t V = srcUV[x + 1 + (y >> 1) * pitch];
-
-			short y0 = ((Y0 * 1197) >> 6) - 299;
-			short y1 = ((Y1 * 1197) >> 6) - 299;
-			short cb = ((U - 128) * 4681 + 164) >> 8;
-			short cr = ((V - 128) * 4681 + 164) >> 8;
-
-			dst[x + y * max_w].y = y0;
-			dst[x + 1 + y * max_w].y = y1;
-			dst[x + y * max_w].cb = cb;
-			dst[x + y * max_w].cr = cr;
-		}
-
-		// UV̓ĂȂƂ
-		short cb0 = dst[y * max_w].cb;
-		short cr0 = dst[y * max_w].cr;
-		for (int x = 0; x < w - 2; x += 2) {
-			short cb2 = dst[x + 2 + y * max_w].cb;
-			short cr2 = dst[x + 2 + y * max_w].cr;
-			dst[x + 1 + y * max_w].cb = (cb0 + cb2) >> 1;
-			dst[x + 1 + y * max_w].cr = (cr0 + cr2) >> 1;
-			cb0 = cb2;
-			cr0 = cr2;
-		}
-		dst[w - 1 + y * max_w].cb = cb0;
-		dst[w - 1 + y * max_w].cr = cr0;
-	}
-
-	// y
-	for (int y = 1; y + 1 < h; y += 2) {
-		for (int x = 0; x < w; ++x) {
-			short cb0 = dst[x + (y + 0) * max_w].cb;
-			short cr0 = dst[x + (y + 0) * max_w].cr;
-			short cb1 = dst[x + (y + 1) * max_w].cb;
-			short cr1 = dst[x + (y + 1) * max_w].cr;
-			dst[x + (y + 0) * max_w].cb = (cb0 * 3 + cb1 + 2) >> 2;
-			dst[x + (y + 0) * max_w].cr = (cr0 * 3 + cr1 + 2) >> 2;
-			dst[x + (y + 1) * max_w].cb = (cb0 + cb1 * 3 + 2) >> 2;
-			dst[x + (y + 1) * max_w].cr = (cr0 + cr1 * 3 + 2) >> 2;
+	for (int y = yStart; y < yEnd; ++y) {
+		const uint8_t* srcYptr = srcY + y * pitch;
+		const uint8_t* srcUVptr = srcUV + (y >> 1) * pitch;
+		PIXEL_YC* dstptr = dst + y * max_w;
+		for (int x = 0; x < w; x += 2) {
+			int x2 = (x + 2 < w) ? (x + 2) : x;
+			int U0 = srcUVptr[x + 0], U2 = srcUVptr[x2 + 0];
+			int V0 = srcUVptr[x + 1], V2 = srcUVptr[x2 + 1];
+
+			dstptr[x].y = y_to_yc48(srcYptr[x + 0]);
+			dstptr[x].cb = uv16_to_yc48(U0 << 8);
+			dstptr[x].cr = uv16_to_yc48(V0 << 8);
+			dstptr[x + 1].y = y_to_yc48(srcYptr[x + 1]);
+			dstptr[x + 1].cb = uv16_to_yc48((U0 + U2) << 7);
+			dstptr[x + 1].cr = uv16_to_yc48((V0 + V2) << 7);
 		}
 	}
 }
 
+void nv12_to_yc48_c(PIXEL_YC* dst, const uint8_t* src, int pitch, int w, int h, int max_w)
+{
+	nv12_to_yc48_rows_c(h, w, 0, h, dst, max_w, src, pitch);
+}
@@ -0,0 +1,120 @@
+
+#define NOMINMAX
+#include <Windows.h>
+#include "convert.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+static void cpuidex(int info[4], int leaf, int subleaf) {
+#ifdef _MSC_VER
+	__cpuidex(info, leaf, subleaf);
+#else
+	unsigned int a, b, c, d;
+	__cpuid_count(leaf, subleaf, a, b, c, d);
+	info[0] = (int)a; info[1] = (int)b; info[2] = (int)c; info[3] = (int)d;
+#endif
+}
+
+static uint64_t xgetbv0() {
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	uint32_t lo, hi;
+	__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+// CPȖΉɉOSWX^ۑ邩iXCR0j
+static SimdLevel DetectSimdLevel() {
+	int info[4];
+	cpuidex(info, 0, 0);
+	int maxLeaf = info[0];
+	if (maxLeaf < 1) {
+		return SIMD_C;
+	}
+	cpuidex(info, 1, 0);
+	bool sse41 = (info[2] & (1 << 19)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	if (!sse41) {
+		return SIMD_C;
+	}
+	if (!osxsave || maxLeaf < 7) {
+		return SIMD_SSE41;
+	}
+	uint64_t xcr0 = xgetbv0();
+	cpuidex(info, 7, 0);
+	bool avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x06) == 0x06;
+	if (!avx2) {
+		return SIMD_SSE41;
+	}
+	bool avx512 = (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0 && (xcr0 & 0xE6) == 0xE6;
+	return avx512 ? SIMD_AVX512 : SIMD_AVX2;
+}
+
+SimdLevel GetSimdLevel() {
+	static const SimdLevel level = DetectSimdLevel();
+	return level;
+}
+
+static const ConvertFuncs CONVERT_FUNCS[SIMD_LEVEL_COUNT] = {
+	// CłSSE4.1ł̃Xg[~OXgAł͒ʏłƓ
+	{
+		SIMD_C,
+		yuv_to_nv12_rows_c, nv12_to_yuv_rows_c,
+		yuv16_to_p010_rows_c, p010_to_yuv16_rows_c,
+		yuv422_to_yuy2_rows_c, yuy2_to_yuv422_rows_c,
+		yuv444_to_ayuv_rows_c, ayuv_to_yuv444_rows_c,
+		yc48_to_yuy2_c, yc48_to_nv12_c, yc48_to_nv12_c,
+		yuy2_to_yc48_c, nv12_to_yc48_c, nv12_to_yc48_rows_c,
+	},
+	{
+		SIMD_SSE41,
+		yuv_to_nv12_rows_sse41, nv12_to_yuv_rows_sse41,
+		yuv16_to_p010_rows_sse41, p010_to_yuv16_rows_sse41,
+		yuv422_to_yuy2_rows_sse41, yuy2_to_yuv422_rows_sse41,
+		yuv444_to_ayuv_rows_sse41, ayuv_to_yuv444_rows_sse41,
+		yc48_to_yuy2_sse41, yc48_to_nv12_sse41, yc48_to_nv12_sse41,
+		yuy2_to_yc48_sse41, nv12_to_yc48_sse41, nv12_to_yc48_rows_sse41,
+	},
+	{
+		SIMD_AVX2,
+		yuv_to_nv12_rows_avx2, nv12_to_yuv_rows_avx2,
+		yuv16_to_p010_rows_avx2, p010_to_yuv16_rows_avx2,
+		yuv422_to_yuy2_rows_avx2, yuy2_to_yuv422_rows_avx2,
+		yuv444_to_ayuv_rows_avx2, ayuv_to_yuv444_rows_avx2,
+		yc48_to_yuy2_avx2, yc48_to_nv12_avx2, yc48_to_nv12_stream_avx2,
+		yuy2_to_yc48_avx2, nv12_to_yc48_avx2, nv12_to_yc48_rows_avx2,
+	},
+	{
+		// шŌ܂̂AVX2ł̂܂
+		SIMD_AVX512,
+		yuv_to_nv12_rows_avx512, nv12_to_yuv_rows_avx512,
+		yuv16_to_p010_rows_avx2, p010_to_yuv16_rows_avx2,
+		yuv422_to_yuy2_rows_avx2, yuy2_to_yuv422_rows_avx2,
+		yuv444_to_ayuv_rows_avx2, ayuv_to_yuv444_rows_avx2,
+		yc48_to_yuy2_avx2, yc48_to_nv12_avx512, yc48_to_nv12_stream_avx2,
+		yuy2_to_yc48_avx2, nv12_to_yc48_avx512, nv12_to_yc48_rows_avx512,
+	},
+};
+
+const ConvertFuncs& GetConvertFuncs(SimdLevel level) {
+	return CONVERT_FUNCS[level];
+}
+
+const ConvertFuncs& GetConvertFuncs() {
+	return CONVERT_FUNCS[GetSimdLevel()];
+}
+
+const char* SimdLevelName(SimdLevel level) {
+	switch (level) {
+	case SIMD_SSE41: return "SSE4.1";
+	case SIMD_AVX2: return "AVX2";
+	case SIMD_AVX512: return "AVX-512";
+	default: return "C";
+	}
+}
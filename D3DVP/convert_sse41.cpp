@@ -0,0 +1,598 @@
+
+#define NOMINMAX
+#include <Windows.h>
+#include "filter.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <immintrin.h>
+
+// AVX2̂Ȃ
+// convert_avx2.cpp128bitŁBo͂CŁAAVX2łƓɂȂ
+
+void yuv_to_nv12_rows_sse41(
+	int height, int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch,
+	const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV,
+	int pitchY, int pitchUV)
+{
+	int widthUV = width >> 1;
+
+	uint8_t* dstY = dst;
+	uint8_t* dstUV = dstY + height * dstPitch;
+
+	for (int y = yStart; y < yEnd; ++y) {
+		memcpy(&dstY[y * dstPitch], &srcY[y * pitchY], width);
+	}
+
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
+		int x = 0;
+		for (; x <= (widthUV - 16); x += 16) {
+			auto u = _mm_loadu_si128((const __m128i*)&srcU[x + y * pitchUV]);
+			auto v = _mm_loadu_si128((const __m128i*)&srcV[x + y * pitchUV]);
+			_mm_storeu_si128((__m128i*)&dstUV[x * 2 + y * dstPitch], _mm_unpacklo_epi8(u, v));
+			_mm_storeu_si128((__m128i*)&dstUV[x * 2 + 16 + y * dstPitch], _mm_unpackhi_epi8(u, v));
+		}
+		for (; x < widthUV; ++x) {
+			dstUV[x * 2 + 0 + y * dstPitch] = srcU[x + y * pitchUV];
+			dstUV[x * 2 + 1 + y * dstPitch] = srcV[x + y * pitchUV];
+		}
+	}
+}
+
+void nv12_to_yuv_rows_sse41(
+	int height, int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV,
+	int pitchY, int pitchUV,
+	const uint8_t* src, int srcPitch)
+{
+	int widthUV = width >> 1;
+
+	const uint8_t* srcY = src;
+	const uint8_t* srcUV = srcY + height * srcPitch;
+
+	const __m128i pattern = _mm_set_epi8(
+		15, 13, 11, 9, 7, 5, 3, 1,
+		14, 12, 10, 8, 6, 4, 2, 0);
+
+	for (int y = yStart; y < yEnd; ++y) {
+		memcpy(&dstY[y * pitchY], &srcY[y * srcPitch], width);
+	}
+
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
+		int x = 0;
+		for (; x <= (widthUV - 16); x += 16) {
+			// [U0-7 V0-7], [U8-15 V8-15]
+			auto a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&srcUV[x * 2 + y * srcPitch]), pattern);
+			auto b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&srcUV[x * 2 + 16 + y * srcPitch]), pattern);
+			_mm_storeu_si128((__m128i*)&dstU[x + y * pitchUV], _mm_unpacklo_epi64(a, b));
+			_mm_storeu_si128((__m128i*)&dstV[x + y * pitchUV], _mm_unpackhi_epi64(a, b));
+		}
+		for (; x < widthUV; ++x) {
+			dstU[x + y * pitchUV] = srcUV[x * 2 + 0 + y * srcPitch];
+			dstV[x + y * pitchUV] = srcUV[x * 2 + 1 + y * srcPitch];
+		}
+	}
+}
+
+void yuv16_to_p010_rows_sse41(
+	int height, int width, int yStart, int yEnd,
+	uint16_t* dst, int dstPitch,
+	const uint16_t* srcY, const uint16_t* srcU, const uint16_t* srcV,
+	int pitchY, int pitchUV, int bits)
+{
+	int widthUV = width >> 1;
+	auto shift = _mm_cvtsi32_si128(16 - bits);
+
+	uint16_t* dstY = dst;
+	uint16_t* dstUV = dstY + height * dstPitch;
+
+	for (int y = yStart; y < yEnd; ++y) {
+		int x = 0;
+		for (; x <= (width - 8); x += 8) {
+			auto a = _mm_loadu_si128((const __m128i*)&srcY[x + y * pitchY]);
+			_mm_storeu_si128((__m128i*)&dstY[x + y * dstPitch], _mm_sll_epi16(a, shift));
+		}
+		for (; x < width; ++x) {
+			dstY[x + y * dstPitch] = srcY[x + y * pitchY] << (16 - bits);
+		}
+	}
+
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
+		int x = 0;
+		for (; x <= (widthUV - 8); x += 8) {
+			auto u = _mm_sll_epi16(_mm_loadu_si128((const __m128i*)&srcU[x + y * pitchUV]), shift);
+			auto v = _mm_sll_epi16(_mm_loadu_si128((const __m128i*)&srcV[x + y * pitchUV]), shift);
+			_mm_storeu_si128((__m128i*)&dstUV[x * 2 + y * dstPitch], _mm_unpacklo_epi16(u, v));
+			_mm_storeu_si128((__m128i*)&dstUV[x * 2 + 8 + y * dstPitch], _mm_unpackhi_epi16(u, v));
+		}
+		for (; x < widthUV; ++x) {
+			dstUV[x * 2 + 0 + y * dstPitch] = srcU[x + y * pitchUV] << (16 - bits);
+			dstUV[x * 2 + 1 + y * dstPitch] = srcV[x + y * pitchUV] << (16 - bits);
+		}
+	}
+}
+
+void p010_to_yuv16_rows_sse41(
+	int height, int width, int yStart, int yEnd,
+	uint16_t* dstY, uint16_t* dstU, uint16_t* dstV,
+	int pitchY, int pitchUV,
+	const uint16_t* src, int srcPitch, int bits)
+{
+	int widthUV = width >> 1;
+	int shift = 16 - bits;
+	int round = (shift > 0) ? (1 << (shift - 1)) : 0;
+	auto vshift = _mm_cvtsi32_si128(shift);
+	auto vround = _mm_set1_epi16((short)round);
+
+	const uint16_t* srcY = src;
+	const uint16_t* srcUV = srcY + height * srcPitch;
+
+	// [U0-3 V0-3]ɐU蕪
+	const __m128i pattern = _mm_set_epi8(
+		15, 14, 11, 10, 7, 6, 3, 2,
+		13, 12, 9, 8, 5, 4, 1, 0);
+
+	// ľܓĖOaiOaZȂ̂(1<<bits)-1𒴂Ȃj
+#define FROM_P010(a) _mm_srl_epi16(_mm_adds_epu16(a, vround), vshift)
+
+	for (int y = yStart; y < yEnd; ++y) {
+		int x = 0;
+		for (; x <= (width - 8); x += 8) {
+			auto a = _mm_loadu_si128((const __m128i*)&srcY[x + y * srcPitch]);
+			_mm_storeu_si128((__m128i*)&dstY[x + y * pitchY], FROM_P010(a));
+		}
+		for (; x < width; ++x) {
+			int t = (srcY[x + y * srcPitch] + round) >> shift;
+			dstY[x + y * pitchY] = (t > (0xFFFF >> shift)) ? (0xFFFF >> shift) : t;
+		}
+	}
+
+	for (int y = (yStart >> 1); y < (yEnd >> 1); ++y) {
+		int x = 0;
+		for (; x <= (widthUV - 8); x += 8) {
+			auto a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&srcUV[x * 2 + y * srcPitch]), pattern);
+			auto b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&srcUV[x * 2 + 8 + y * srcPitch]), pattern);
+			_mm_storeu_si128((__m128i*)&dstU[x + y * pitchUV], FROM_P010(_mm_unpacklo_epi64(a, b)));
+			_mm_storeu_si128((__m128i*)&dstV[x + y * pitchUV], FROM_P010(_mm_unpackhi_epi64(a, b)));
+		}
+		for (; x < widthUV; ++x) {
+			int tu = (srcUV[x * 2 + 0 + y * srcPitch] + round) >> shift;
+			int tv = (srcUV[x * 2 + 1 + y * srcPitch] + round) >> shift;
+			dstU[x + y * pitchUV] = (tu > (0xFFFF >> shift)) ? (0xFFFF >> shift) : tu;
+			dstV[x + y * pitchUV] = (tv > (0xFFFF >> shift)) ? (0xFFFF >> shift) : tv;
+		}
+	}
+#undef FROM_P010
+}
+
+void yuv422_to_yuy2_rows_sse41(
+	int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch,
+	const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV,
+	int pitchY, int pitchUV)
+{
+	int widthUV = width >> 1;
+
+	for (int y = yStart; y < yEnd; ++y) {
+		uint8_t* dstptr = dst + y * dstPitch;
+		int x = 0;
+		// 16f
+		for (; x <= (widthUV - 8); x += 8) {
+			auto u = _mm_loadl_epi64((const __m128i*)&srcU[x + y * pitchUV]);
+			auto v = _mm_loadl_epi64((const __m128i*)&srcV[x + y * pitchUV]);
+			auto uv = _mm_unpacklo_epi8(u, v);
+			auto yy = _mm_loadu_si128((const __m128i*)&srcY[x * 2 + y * pitchY]);
+			_mm_storeu_si128((__m128i*)&dstptr[x * 4], _mm_unpacklo_epi8(yy, uv));
+			_mm_storeu_si128((__m128i*)&dstptr[x * 4 + 16], _mm_unpackhi_epi8(yy, uv));
+		}
+		for (; x < widthUV; ++x) {
+			dstptr[x * 4 + 0] = srcY[x * 2 + 0 + y * pitchY];
+			dstptr[x * 4 + 1] = srcU[x + y * pitchUV];
+			dstptr[x * 4 + 2] = srcY[x * 2 + 1 + y * pitchY];
+			dstptr[x * 4 + 3] = srcV[x + y * pitchUV];
+		}
+	}
+}
+
+void yuy2_to_yuv422_rows_sse41(
+	int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV,
+	int pitchY, int pitchUV,
+	const uint8_t* src, int srcPitch)
+{
+	int widthUV = width >> 1;
+
+	// [Y0-7 U0-3 V0-3]ɕבւ
+	const __m128i pattern = _mm_set_epi8(
+		15, 11, 7, 3, 13, 9, 5, 1, 14, 12, 10, 8, 6, 4, 2, 0);
+
+	for (int y = yStart; y < yEnd; ++y) {
+		const uint8_t* srcptr = src + y * srcPitch;
+		int x = 0;
+		for (; x <= (widthUV - 8); x += 8) {
+			auto a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&srcptr[x * 4]), pattern);
+			auto b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&srcptr[x * 4 + 16]), pattern);
+			_mm_storeu_si128((__m128i*)&dstY[x * 2 + y * pitchY], _mm_unpacklo_epi64(a, b));
+			// [U0-3 U4-7 V0-3 V4-7]
+			auto uv = _mm_shuffle_epi32(_mm_unpackhi_epi64(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm_storel_epi64((__m128i*)&dstU[x + y * pitchUV], uv);
+			_mm_storel_epi64((__m128i*)&dstV[x + y * pitchUV], _mm_unpackhi_epi64(uv, uv));
+		}
+		for (; x < widthUV; ++x) {
+			dstY[x * 2 + 0 + y * pitchY] = srcptr[x * 4 + 0];
+			dstU[x + y * pitchUV] = srcptr[x * 4 + 1];
+			dstY[x * 2 + 1 + y * pitchY] = srcptr[x * 4 + 2];
+			dstV[x + y * pitchUV] = srcptr[x * 4 + 3];
+		}
+	}
+}
+
+void yuv444_to_ayuv_rows_sse41(
+	int width, int yStart, int yEnd,
+	uint8_t* dst, int dstPitch,
+	const uint8_t* srcY, const uint8_t* srcU, const uint8_t* srcV,
+	int pitchY, int pitchUV)
+{
+	const __m128i alpha = _mm_set1_epi8((char)0xFF);
+
+	for (int y = yStart; y < yEnd; ++y) {
+		uint8_t* dstptr = dst + y * dstPitch;
+		int x = 0;
+		for (; x <= (width - 16); x += 16) {
+			auto yy = _mm_loadu_si128((const __m128i*)&srcY[x + y * pitchY]);
+			auto u = _mm_loadu_si128((const __m128i*)&srcU[x + y * pitchUV]);
+			auto v = _mm_loadu_si128((const __m128i*)&srcV[x + y * pitchUV]);
+			auto vulo = _mm_unpacklo_epi8(v, u);
+			auto vuhi = _mm_unpackhi_epi8(v, u);
+			auto yalo = _mm_unpacklo_epi8(yy, alpha);
+			auto yahi = _mm_unpackhi_epi8(yy, alpha);
+			_mm_storeu_si128((__m128i*)&dstptr[x * 4 + 0], _mm_unpacklo_epi16(vulo, yalo));
+			_mm_storeu_si128((__m128i*)&dstptr[x * 4 + 16], _mm_unpackhi_epi16(vulo, yalo));
+			_mm_storeu_si128((__m128i*)&dstptr[x * 4 + 32], _mm_unpacklo_epi16(vuhi, yahi));
+			_mm_storeu_si128((__m128i*)&dstptr[x * 4 + 48], _mm_unpackhi_epi16(vuhi, yahi));
+		}
+		for (; x < width; ++x) {
+			dstptr[x * 4 + 0] = srcV[x + y * pitchUV];
+			dstptr[x * 4 + 1] = srcU[x + y * pitchUV];
+			dstptr[x * 4 + 2] = srcY[x + y * pitchY];
+			dstptr[x * 4 + 3] = 0xFF;
+		}
+	}
+}
+
+void ayuv_to_yuv444_rows_sse41(
+	int width, int yStart, int yEnd,
+	uint8_t* dstY, uint8_t* dstU, uint8_t* dstV,
+	int pitchY, int pitchUV,
+	const uint8_t* src, int srcPitch)
+{
+	// [V0-3 U0-3 Y0-3 A0-3]ɕבւ
+	const __m128i pattern = _mm_set_epi8(
+		15, 11, 7, 3, 14, 10, 6, 2, 13, 9, 5, 1, 12, 8, 4, 0);
+
+	for (int y = yStart; y < yEnd; ++y) {
+		const uint8_t* srcptr = src + y * srcPitch;
+		int x = 0;
+		for (; x <= (width - 16); x += 16) {
+			__m128i p[4];
+			for (int i = 0; i < 4; ++i) {
+				p[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&srcptr[x * 4 + i * 16]), pattern);
+			}
+			// [V0-3 V4-7 U0-3 U4-7], [Y0-3 Y4-7 A0-3 A4-7]
+			auto vu01 = _mm_unpacklo_epi32(p[0], p[1]);
+			auto ya01 = _mm_unpackhi_epi32(p[0], p[1]);
+			auto vu23 = _mm_unpacklo_epi32(p[2], p[3]);
+			auto ya23 = _mm_unpackhi_epi32(p[2], p[3]);
+			_mm_storeu_si128((__m128i*)&dstV[x + y * pitchUV], _mm_unpacklo_epi64(vu01, vu23));
+			_mm_storeu_si128((__m128i*)&dstU[x + y * pitchUV], _mm_unpackhi_epi64(vu01, vu23));
+			_mm_storeu_si128((__m128i*)&dstY[x + y * pitchY], _mm_unpacklo_epi64(ya01, ya23));
+		}
+		for (; x < width; ++x) {
+			dstV[x + y * pitchUV] = srcptr[x * 4 + 0];
+			dstU[x + y * pitchUV] = srcptr[x * 4 + 1];
+			dstY[x + y * pitchY] = srcptr[x * 4 + 2];
+		}
+	}
+}
+
+static const int LSFT_YCC_8    = 4;
+static const int UV_OFFSET_x1 = (1<<11);
+
+static const int Y_L_MUL    = 219;
+static const int Y_L_ADD_8  = 383;
+static const int Y_L_RSH_8  = 12;
+
+static const int UV_L_MUL         = 14;
+static const int UV_L_ADD_8_444   = 132;
+static const int UV_L_RSH_8_444   =  8;
+
+alignas(16) static const uint8_t ARRAY_SUFFLE_YCP_Y[16] = {
+	0, 1, 6, 7, 12, 13, 2, 3, 8, 9, 14, 15, 4, 5, 10, 11
+};
+
+#define xC_Y_L_MA_8 _mm_set1_epi32((Y_L_ADD_8 << 16) | Y_L_MUL)
+#define xC_UV_L_MA_8_444 _mm_set1_epi32((UV_L_ADD_8_444 << 16) | UV_L_MUL)
+
+// 8fi48bytejY 8UV 4go
+static __forceinline void gather_y_uv_from_yc48(__m128i& x0, __m128i& x1, __m128i x2) {
+	const int MASK_INT_Y  = 0x80 + 0x10 + 0x02;
+	const int MASK_INT_UV = 0x40 + 0x20 + 0x01;
+	__m128i x3;
+
+	x3 = _mm_blend_epi16(x0, x1, MASK_INT_Y);
+	x3 = _mm_blend_epi16(x3, x2, MASK_INT_Y>>2);
+
+	x1 = _mm_blend_epi16(x0, x1, MASK_INT_UV);
+	x1 = _mm_blend_epi16(x1, x2, MASK_INT_UV>>2);
+	x1 = _mm_alignr_epi8(x1, x1, 2);
+	x1 = _mm_shuffle_epi32(x1, _MM_SHUFFLE(1, 2, 3, 0));
+
+	x0 = _mm_shuffle_epi8(x3, _mm_load_si128((const __m128i*)ARRAY_SUFFLE_YCP_Y));
+}
+
+static __forceinline __m128i convert_range_from_yc48(__m128i x0, __m128i xC_MA, int RSH, const __m128i& xC_YCC) {
+	__m128i x7;
+
+	x7 = _mm_unpackhi_epi16(x0, _mm_set1_epi16(1));
+	x0 = _mm_unpacklo_epi16(x0, _mm_set1_epi16(1));
+
+	x0 = _mm_madd_epi16(x0, xC_MA);
+	x7 = _mm_madd_epi16(x7, xC_MA);
+	x0 = _mm_srai_epi32(x0, RSH);
+	x7 = _mm_srai_epi32(x7, RSH);
+	x0 = _mm_add_epi32(x0, xC_YCC);
+	x7 = _mm_add_epi32(x7, xC_YCC);
+
+	return _mm_packus_epi32(x0, x7);
+}
+
+static __forceinline __m128i convert_y_range_from_yc48(__m128i x0) {
+	return convert_range_from_yc48(x0, xC_Y_L_MA_8, Y_L_RSH_8, _mm_set1_epi32(1<<LSFT_YCC_8));
+}
+
+static __forceinline __m128i convert_uv_range_from_yc48(__m128i x0) {
+	x0 = _mm_add_epi16(x0, _mm_set1_epi16(UV_OFFSET_x1));
+	return convert_range_from_yc48(x0, xC_UV_L_MA_8_444, UV_L_RSH_8_444, _mm_set1_epi32(1<<LSFT_YCC_8));
+}
+
+static __forceinline __m128i convert_y_range_to_yc48(__m128i x0) {
+	//coef = 4788
+	//((( y - 32768 ) * coef) >> 16 ) + (coef/2 - 299)
+	const __m128i xC_0x8000 = _mm_slli_epi16(_mm_cmpeq_epi32(x0, x0), 15);
+	x0 = _mm_add_epi16(x0, xC_0x8000); // -32768
+	x0 = _mm_mulhi_epi16(x0, _mm_set1_epi16(4788));
+	x0 = _mm_adds_epi16(x0, _mm_set1_epi16(4788/2 - 299));
+	return x0;
+}
+
+static __forceinline __m128i convert_uv_range_to_yc48(__m128i x0) {
+	//coeff = 4682
+	//UV = (( uv - 32768 ) * coef + (1<<15) ) >> 16
+	const __m128i xC_coeff = _mm_unpacklo_epi16(_mm_set1_epi16(4682), _mm_set1_epi16(-1));
+	const __m128i xC_0x8000 = _mm_slli_epi16(_mm_cmpeq_epi32(x0, x0), 15);
+	__m128i x1;
+	x0 = _mm_add_epi16(x0, xC_0x8000); // -32768
+	x1 = _mm_unpackhi_epi16(x0, xC_0x8000);
+	x0 = _mm_unpacklo_epi16(x0, xC_0x8000);
+	x0 = _mm_madd_epi16(x0, xC_coeff);
+	x1 = _mm_madd_epi16(x1, xC_coeff);
+	x0 = _mm_srai_epi32(x0, 16);
+	x1 = _mm_srai_epi32(x1, 16);
+	return _mm_packs_epi32(x0, x1);
+}
+
+// Y,U,V 88fi48bytejYC48ɕׂ
+static __forceinline void gather_y_u_v_to_yc48(__m128i& x0, __m128i& x1, __m128i& x2) {
+	__m128i x3, x4, x5;
+
+	x5 = _mm_load_si128((const __m128i*)ARRAY_SUFFLE_YCP_Y);
+	x0 = _mm_shuffle_epi8(x0, x5);                       //5,2,7,4,1,6,3,0
+	x1 = _mm_shuffle_epi8(x1, _mm_alignr_epi8(x5, x5, 14)); //2,7,4,1,6,3,0,5
+	x2 = _mm_shuffle_epi8(x2, _mm_alignr_epi8(x5, x5, 12)); //7,4,1,6,3,0,5,2
+
+	x3 = _mm_blend_epi16(x0, x1, 0x80 + 0x10 + 0x02);
+	x3 = _mm_blend_epi16(x3, x2, 0x20 + 0x04);        //0
+
+	x4 = _mm_blend_epi16(x2, x1, 0x20 + 0x04);
+	x4 = _mm_blend_epi16(x4, x0, 0x80 + 0x10 + 0x02); //128
+
+	x2 = _mm_blend_epi16(x2, x0, 0x20 + 0x04);
+	x2 = _mm_blend_epi16(x2, x1, 0x40 + 0x08 + 0x01); //256
+
+	x0 = x3;
+	x1 = x4;
+}
+
+static __forceinline void yc48_to_yuy2_sse41_block(uint8_t *dst, const PIXEL_YC *ycp) {
+	const __m128i yuyShuffle = _mm_setr_epi8(0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15);
+	__m128i x1 = _mm_loadu_si128((const __m128i *)((const uint8_t *)ycp +  0));
+	__m128i x2 = _mm_loadu_si128((const __m128i *)((const uint8_t *)ycp + 16));
+	__m128i x3 = _mm_loadu_si128((const __m128i *)((const uint8_t *)ycp + 32));
+	gather_y_uv_from_yc48(x1, x2, x3);
+	x1 = convert_y_range_from_yc48(x1);
+	x2 = convert_uv_range_from_yc48(x2);
+	x1 = _mm_packus_epi16(x1, x2);
+	x1 = _mm_shuffle_epi8(x1, yuyShuffle);
+	_mm_storeu_si128((__m128i *)dst, x1);
+}
+
+void yc48_to_yuy2_sse41(uint8_t *dst, int pitch, const PIXEL_YC *src, int w, int h, int max_w) {
+	for (int y = 0; y < h; y++, dst += pitch, src += max_w) {
+		const PIXEL_YC *srcptr = src;
+		uint8_t *dstptr = dst;
+		int x = 0;
+		for (; x < w - 8; x += 8, dstptr += 16, srcptr += 8) {
+			yc48_to_yuy2_sse41_block(dstptr, srcptr);
+		}
+		int offset = x - (w - 8);
+		dstptr -= offset * 2;
+		srcptr -= offset;
+		yc48_to_yuy2_sse41_block(dstptr, srcptr);
+	}
+}
+
+// 16fYUVo
+static __forceinline void yc48_to_nv12_sse41_gather16(__m128i& xY, __m128i& xUV, const PIXEL_YC *ycp) {
+	__m128i x0 = _mm_loadu_si128((const __m128i *)((const uint8_t *)ycp +  0));
+	__m128i x1 = _mm_loadu_si128((const __m128i *)((const uint8_t *)ycp + 16));
+	__m128i x2 = _mm_loadu_si128((const __m128i *)((const uint8_t *)ycp + 32));
+	__m128i x3 = _mm_loadu_si128((const __m128i *)((const uint8_t *)ycp + 48));
+	__m128i x4 = _mm_loadu_si128((const __m128i *)((const uint8_t *)ycp + 64));
+	__m128i x5 = _mm_loadu_si128((const __m128i *)((const uint8_t *)ycp + 80));
+	gather_y_uv_from_yc48(x0, x1, x2);
+	gather_y_uv_from_yc48(x3, x4, x5);
+	xY = _mm_packus_epi16(convert_y_range_from_yc48(x0), convert_y_range_from_yc48(x3));
+	xUV = _mm_packus_epi16(convert_uv_range_from_yc48(x1), convert_uv_range_from_yc48(x4));
+}
+
+//cԂȂ
+static __forceinline void yc48_to_nv12_sse41_block(uint8_t *dstY, uint8_t *dstUV, const PIXEL_YC *ycp, const PIXEL_YC *ycpw, int pitch) {
+	__m128i xY, xUV, xYw, xUVw;
+	yc48_to_nv12_sse41_gather16(xY, xUV, ycp);
+	yc48_to_nv12_sse41_gather16(xYw, xUVw, ycpw);
+	_mm_storeu_si128((__m128i *)dstY, xY);
+	_mm_storeu_si128((__m128i *)(dstY + pitch*2), xYw);
+	_mm_storeu_si128((__m128i *)dstUV, xUV);
+}
+
+void yc48_to_nv12_sse41(uint8_t *dst, int pitch, const PIXEL_YC *src, int w, int h, int max_w) {
+	for (int y = 0; y < h; y += 4) {
+		for (int ifield = 0; ifield < 2; ifield++) {
+			const PIXEL_YC *ycp = &src[max_w * (y + ifield)];
+			const PIXEL_YC *ycpw = &ycp[2 * max_w];
+			uint8_t *dstY = &dst[pitch * (y + ifield)];
+			uint8_t *dstUV = &dst[pitch * (h + ifield + (y >> 1))];
+			int x = 0;
+			for (; x < w - 16; x += 16, ycp += 16, ycpw += 16, dstY += 16, dstUV += 16) {
+				yc48_to_nv12_sse41_block(dstY, dstUV, ycp, ycpw, pitch);
+			}
+			int offset = x - (w - 16);
+			dstY -= offset;
+			dstUV -= offset;
+			ycp -= offset;
+			ycpw -= offset;
+			yc48_to_nv12_sse41_block(dstY, dstUV, ycp, ycpw, pitch);
+		}
+	}
+}
+
+// 8fY<<8, UV<<8ƊfpɕԂUV<<8YC48o͂
+static __forceinline void yuv_to_yc48_sse41_store(PIXEL_YC *dstptr, __m128i xY, __m128i xUV0, __m128i xUV01) {
+	__m128i xU = _mm_blend_epi16(xUV0, _mm_slli_epi32(xUV01, 16), 0x80+0x20+0x08+0x02);
+	__m128i xV = _mm_blend_epi16(_mm_srli_epi32(xUV0, 16), xUV01, 0x80+0x20+0x08+0x02);
+
+	__m128i x1 = convert_y_range_to_yc48(xY);
+	__m128i x2 = convert_uv_range_to_yc48(xU);
+	__m128i x3 = convert_uv_range_to_yc48(xV);
+	gather_y_u_v_to_yc48(x1, x2, x3);
+	_mm_storeu_si128((__m128i *)((uint8_t *)dstptr +  0), x1);
+	_mm_storeu_si128((__m128i *)((uint8_t *)dstptr + 16), x2);
+	_mm_storeu_si128((__m128i *)((uint8_t *)dstptr + 32), x3);
+}
+
+template<bool lastBlock>
+static __forceinline void yuy2_to_yc48_sse41_block(__m128i& xPrev, PIXEL_YC *dstptr, const uint8_t *srcptr) {
+	__m128i xY = _mm_slli_epi16(xPrev, 8);
+	__m128i xUV0 = _mm_srli_epi16(xPrev, 8);
+	__m128i xUV1, xNext;
+	if (lastBlock) {
+		xUV1 = _mm_shuffle_epi32(xUV0, _MM_SHUFFLE(3,3,3,3));
+	} else {
+		xNext = _mm_loadu_si128((const __m128i *)(srcptr + 16));
+		xUV1 = _mm_srli_epi16(xNext, 8);
+	}
+	// AVX2łƓ8bit̂܂ܕς
+	__m128i xUV01 = _mm_avg_epu16(_mm_alignr_epi8(xUV1, xUV0, 4), xUV0);
+	yuv_to_yc48_sse41_store(dstptr, xY, _mm_slli_epi16(xUV0, 8), _mm_slli_epi16(xUV01, 8));
+	if (!lastBlock) {
+		xPrev = xNext;
+	}
+}
+
+void yuy2_to_yc48_sse41(PIXEL_YC *dst, const uint8_t *src, int pitch, int w, int h, int max_w) {
+	for (int y = 0; y < h; y++, dst += max_w, src += pitch) {
+		const uint8_t *srcptr = src;
+		PIXEL_YC *dstptr = dst;
+		__m128i x0 = _mm_loadu_si128((const __m128i *)srcptr);
+		int x = 0;
+		for (; x < w - 8; x += 8, dstptr += 8, srcptr += 16) {
+			yuy2_to_yc48_sse41_block<false>(x0, dstptr, srcptr);
+		}
+		int offset = x - (w - 8);
+		if (offset > 0) {
+			dstptr -= offset;
+			srcptr -= offset * 2;
+			x0 = _mm_loadu_si128((const __m128i *)srcptr);
+		}
+		yuy2_to_yc48_sse41_block<true>(x0, dstptr, srcptr);
+	}
+}
+
+//ԂAcԂȂ
+template<bool lastBlock>
+static __forceinline void nv12_to_yc48_sse41_block(
+	__m128i& xUV00lo, __m128i& xUV00hi,
+	PIXEL_YC *dstptr, const uint8_t *srcYptr, const uint8_t *srcUVptr, int pitch, int max_w) {
+	__m128i xY0 = _mm_loadu_si128((const __m128i *)srcYptr);
+	__m128i xY1 = _mm_loadu_si128((const __m128i *)&srcYptr[pitch]);
+
+	__m128i xUV01lo, xUV01hi;
+	if (lastBlock) {
+		xUV01lo = _mm_shuffle_epi32(xUV00hi, _MM_SHUFFLE(3,3,3,3));
+	} else {
+		__m128i xUV = _mm_loadu_si128((const __m128i *)(srcUVptr + 16));
+		xUV01lo = _mm_unpacklo_epi8(_mm_setzero_si128(), xUV);
+		xUV01hi = _mm_unpackhi_epi8(_mm_setzero_si128(), xUV);
+	}
+
+	// 2sœFg
+	__m128i xUVlo = _mm_avg_epu16(_mm_alignr_epi8(xUV00hi, xUV00lo, 4), xUV00lo);
+	__m128i xUVhi = _mm_avg_epu16(_mm_alignr_epi8(xUV01lo, xUV00hi, 4), xUV00hi);
+	yuv_to_yc48_sse41_store(dstptr + 0, _mm_unpacklo_epi8(_mm_setzero_si128(), xY0), xUV00lo, xUVlo);
+	yuv_to_yc48_sse41_store(dstptr + 8, _mm_unpackhi_epi8(_mm_setzero_si128(), xY0), xUV00hi, xUVhi);
+	dstptr += max_w;
+	yuv_to_yc48_sse41_store(dstptr + 0, _mm_unpacklo_epi8(_mm_setzero_si128(), xY1), xUV00lo, xUVlo);
+	yuv_to_yc48_sse41_store(dstptr + 8, _mm_unpackhi_epi8(_mm_setzero_si128(), xY1), xUV00hi, xUVhi);
+
+	if (!lastBlock) {
+		xUV00lo = xUV01lo;
+		xUV00hi = xUV01hi;
+	}
+}
+
+void nv12_to_yc48_rows_sse41(int h, int w, int yStart, int yEnd, PIXEL_YC *dst, int max_w, const uint8_t *src, int pitch) {
+	const uint8_t *srcY = src + yStart * pitch;
+	const uint8_t *srcUV = src + h * pitch + (yStart >> 1) * pitch;
+	dst += yStart * max_w;
+
+	for (int y = yStart; y < yEnd; y += 2, dst += max_w*2, srcY += pitch*2, srcUV += pitch) {
+		const uint8_t *srcYptr = srcY;
+		const uint8_t *srcUVptr = srcUV;
+		PIXEL_YC *dstptr = dst;
+		__m128i xUV = _mm_loadu_si128((const __m128i *)srcUVptr);
+		__m128i xUV00lo = _mm_unpacklo_epi8(_mm_setzero_si128(), xUV);
+		__m128i xUV00hi = _mm_unpackhi_epi8(_mm_setzero_si128(), xUV);
+		int x = 0;
+		for (; x < w - 16; x += 16, dstptr += 16, srcYptr += 16, srcUVptr += 16) {
+			nv12_to_yc48_sse41_block<false>(xUV00lo, xUV00hi,
+				dstptr, srcYptr, srcUVptr, pitch, max_w);
+		}
+		int offset = x - (w - 16);
+		if (offset > 0) {
+			dstptr -= offset;
+			srcYptr -= offset;
+			srcUVptr -= offset;
+			xUV = _mm_loadu_si128((const __m128i *)srcUVptr);
+			xUV00lo = _mm_unpacklo_epi8(_mm_setzero_si128(), xUV);
+			xUV00hi = _mm_unpackhi_epi8(_mm_setzero_si128(), xUV);
+		}
+		nv12_to_yc48_sse41_block<true>(xUV00lo, xUV00hi,
+			dstptr, srcYptr, srcUVptr, pitch, max_w);
+	}
+}
+
+void nv12_to_yc48_sse41(PIXEL_YC *dst, const uint8_t *src, int pitch, int w, int h, int max_w) {
+	nv12_to_yc48_rows_sse41(h, w, 0, h, dst, max_w, src, pitch);
+}
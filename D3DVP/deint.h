@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+
+// 1v[̃tB[hԁibobj
+// keepParityƓpeB̍s͂̂܂܃Rs[Ac̍s͏㉺̍sԂ
+// rowBytes: 1s̃oCg, height: s
+void bob_field_c(uint8_t* dst, int dstPitch, const uint8_t* src, int srcPitch,
+	int rowBytes, int height, int keepParity);
+
+// 1v[̓KC^iyadifj
+// keepParityƓpeB̍scur炻̂܂܃Rs[Ac̍s
+// ԕiOt[̓sjƋԕi㉺̍sj̗\瓮ʂɉĕԂ
+// f̕тɈˑȂ悤ɋԕ̓GbWT㉺̍sg
+// îNV12UVv[YUY2AAYUVɂ̂܂܎gj
+// secondField: 0=cur1ڂ̃tB[h 1=2ڂ̃tB[ho
+// [yStart, yEnd)̍sisohɕĕ񏈗邽߁j
+// prev/cur/next͓sb`ł邱
+void yadif_field_c(uint8_t* dst, int dstPitch,
+	const uint8_t* prev, const uint8_t* cur, const uint8_t* next, int srcPitch,
+	int rowBytes, int height, int keepParity, int secondField, int yStart, int yEnd);
+void yadif_field_avx2(uint8_t* dst, int dstPitch,
+	const uint8_t* prev, const uint8_t* cur, const uint8_t* next, int srcPitch,
+	int rowBytes, int height, int keepParity, int secondField, int yStart, int yEnd);
+
+// yadif_field_c16bitfŁiP010/P016pj
+// yadif_field_cƓoCgP
+void yadif_field16_c(uint8_t* dst, int dstPitch,
+	const uint8_t* prev, const uint8_t* cur, const uint8_t* next, int srcPitch,
+	int rowBytes, int height, int keepParity, int secondField, int yStart, int yEnd);
+void yadif_field16_avx2(uint8_t* dst, int dstPitch,
+	const uint8_t* prev, const uint8_t* cur, const uint8_t* next, int srcPitch,
+	int rowBytes, int height, int keepParity, int secondField, int yStart, int yEnd);
@@ -0,0 +1,184 @@
+
+#include <stdint.h>
+#include <string.h>
+
+#include <immintrin.h>
+
+#include "deint.h"
+
+static inline __m256i avg_epi16(__m256i a, __m256i b) {
+	// ͂0`255Ȃ̂ŃI[o[t[Ȃ
+	return _mm256_srli_epi16(_mm256_add_epi16(a, b), 1);
+}
+
+static inline __m256i absdiff_epi16(__m256i a, __m256i b) {
+	return _mm256_abs_epi16(_mm256_sub_epi16(a, b));
+}
+
+// yadif_field_cƓvZ16f16bitōs
+static inline __m256i yadif_pixels(
+	__m256i pc, __m256i pe,       // cur ㉺̍s
+	__m256i pp1a, __m256i pp1b,   // prev ㉺̍s
+	__m256i pn1a, __m256i pn1b,   // next ㉺̍s
+	__m256i pp20, __m256i pn20,   // prev2/next2 ԑΏۍs
+	__m256i pp2a, __m256i pn2a,   // prev2/next2 2s
+	__m256i pp2b, __m256i pn2b)   // prev2/next2 2s
+{
+	auto d = avg_epi16(pp20, pn20);
+	auto tdiff0 = absdiff_epi16(pp20, pn20);
+	auto tdiff1 = _mm256_srli_epi16(_mm256_add_epi16(absdiff_epi16(pp1a, pc), absdiff_epi16(pp1b, pe)), 1);
+	auto tdiff2 = _mm256_srli_epi16(_mm256_add_epi16(absdiff_epi16(pn1a, pc), absdiff_epi16(pn1b, pe)), 1);
+	auto diff = _mm256_max_epi16(_mm256_max_epi16(_mm256_srli_epi16(tdiff0, 1), tdiff1), tdiff2);
+
+	auto b = avg_epi16(pp2a, pn2a);
+	auto f = avg_epi16(pp2b, pn2b);
+	auto de = _mm256_sub_epi16(d, pe);
+	auto dc = _mm256_sub_epi16(d, pc);
+	auto bc = _mm256_sub_epi16(b, pc);
+	auto fe = _mm256_sub_epi16(f, pe);
+	auto dmax = _mm256_max_epi16(_mm256_max_epi16(de, dc), _mm256_min_epi16(bc, fe));
+	auto dmin = _mm256_min_epi16(_mm256_min_epi16(de, dc), _mm256_max_epi16(bc, fe));
+	diff = _mm256_max_epi16(_mm256_max_epi16(diff, dmin), _mm256_sub_epi16(_mm256_setzero_si256(), dmax));
+
+	auto spatial = avg_epi16(pc, pe);
+	spatial = _mm256_min_epi16(spatial, _mm256_add_epi16(d, diff));
+	spatial = _mm256_max_epi16(spatial, _mm256_sub_epi16(d, diff));
+	return spatial;
+}
+
+void yadif_field_avx2(uint8_t* dst, int dstPitch,
+	const uint8_t* prev, const uint8_t* cur, const uint8_t* next, int srcPitch,
+	int rowBytes, int height, int keepParity, int secondField, int yStart, int yEnd)
+{
+	if (rowBytes < 32) {
+		yadif_field_c(dst, dstPitch, prev, cur, next, srcPitch,
+			rowBytes, height, keepParity, secondField, yStart, yEnd);
+		return;
+	}
+
+	const uint8_t* prev2 = secondField ? cur : prev;
+	const uint8_t* next2 = secondField ? next : cur;
+
+	for (int y = yStart; y < yEnd; ++y) {
+		uint8_t* dstptr = dst + y * dstPitch;
+		if ((y & 1) == keepParity) {
+			memcpy(dstptr, cur + y * srcPitch, rowBytes);
+			continue;
+		}
+		int y1a = (y - 1 >= 0) ? (y - 1) : (y + 1);
+		int y1b = (y + 1 < height) ? (y + 1) : (y - 1);
+		int y2a = (y - 2 >= 0) ? (y - 2) : (y + 2 < height) ? (y + 2) : y;
+		int y2b = (y + 2 < height) ? (y + 2) : (y - 2 >= 0) ? (y - 2) : y;
+		int o0 = y * srcPitch;
+		int o1a = y1a * srcPitch, o1b = y1b * srcPitch;
+		int o2a = y2a * srcPitch, o2b = y2b * srcPitch;
+
+		for (int x = 0; x < rowBytes; x += 32) {
+			// [͍Ō32oCgƏd˂ďio͓͂͂ƕʃobt@Ȃ̂œlɂȂj
+			if (x > rowBytes - 32) x = rowBytes - 32;
+			__m256i r[2];
+			for (int h = 0; h < 2; ++h) {
+				int xh = x + h * 16;
+#define LOAD(p, o) _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)&(p)[(o) + xh]))
+				r[h] = yadif_pixels(
+					LOAD(cur, o1a), LOAD(cur, o1b),
+					LOAD(prev, o1a), LOAD(prev, o1b),
+					LOAD(next, o1a), LOAD(next, o1b),
+					LOAD(prev2, o0), LOAD(next2, o0),
+					LOAD(prev2, o2a), LOAD(next2, o2a),
+					LOAD(prev2, o2b), LOAD(next2, o2b));
+#undef LOAD
+			}
+			auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(r[0], r[1]), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_si256((__m256i*)&dstptr[x], packed);
+		}
+	}
+}
+
+static inline __m256i avg_epi32(__m256i a, __m256i b) {
+	return _mm256_srli_epi32(_mm256_add_epi32(a, b), 1);
+}
+
+static inline __m256i absdiff_epi32(__m256i a, __m256i b) {
+	return _mm256_abs_epi32(_mm256_sub_epi32(a, b));
+}
+
+// yadif_pixels16bitfŁi8f32bitŌvZj
+static inline __m256i yadif_pixels32(
+	__m256i pc, __m256i pe,
+	__m256i pp1a, __m256i pp1b,
+	__m256i pn1a, __m256i pn1b,
+	__m256i pp20, __m256i pn20,
+	__m256i pp2a, __m256i pn2a,
+	__m256i pp2b, __m256i pn2b)
+{
+	auto d = avg_epi32(pp20, pn20);
+	auto tdiff0 = absdiff_epi32(pp20, pn20);
+	auto tdiff1 = _mm256_srli_epi32(_mm256_add_epi32(absdiff_epi32(pp1a, pc), absdiff_epi32(pp1b, pe)), 1);
+	auto tdiff2 = _mm256_srli_epi32(_mm256_add_epi32(absdiff_epi32(pn1a, pc), absdiff_epi32(pn1b, pe)), 1);
+	auto diff = _mm256_max_epi32(_mm256_max_epi32(_mm256_srli_epi32(tdiff0, 1), tdiff1), tdiff2);
+
+	auto b = avg_epi32(pp2a, pn2a);
+	auto f = avg_epi32(pp2b, pn2b);
+	auto de = _mm256_sub_epi32(d, pe);
+	auto dc = _mm256_sub_epi32(d, pc);
+	auto bc = _mm256_sub_epi32(b, pc);
+	auto fe = _mm256_sub_epi32(f, pe);
+	auto dmax = _mm256_max_epi32(_mm256_max_epi32(de, dc), _mm256_min_epi32(bc, fe));
+	auto dmin = _mm256_min_epi32(_mm256_min_epi32(de, dc), _mm256_max_epi32(bc, fe));
+	diff = _mm256_max_epi32(_mm256_max_epi32(diff, dmin), _mm256_sub_epi32(_mm256_setzero_si256(), dmax));
+
+	auto spatial = avg_epi32(pc, pe);
+	spatial = _mm256_min_epi32(spatial, _mm256_add_epi32(d, diff));
+	spatial = _mm256_max_epi32(spatial, _mm256_sub_epi32(d, diff));
+	return spatial;
+}
+
+void yadif_field16_avx2(uint8_t* dst, int dstPitch,
+	const uint8_t* prev, const uint8_t* cur, const uint8_t* next, int srcPitch,
+	int rowBytes, int height, int keepParity, int secondField, int yStart, int yEnd)
+{
+	if (rowBytes < 32) {
+		yadif_field16_c(dst, dstPitch, prev, cur, next, srcPitch,
+			rowBytes, height, keepParity, secondField, yStart, yEnd);
+		return;
+	}
+
+	const uint8_t* prev2 = secondField ? cur : prev;
+	const uint8_t* next2 = secondField ? next : cur;
+
+	for (int y = yStart; y < yEnd; ++y) {
+		uint8_t* dstptr = dst + y * dstPitch;
+		if ((y & 1) == keepParity) {
+			memcpy(dstptr, cur + y * srcPitch, rowBytes);
+			continue;
+		}
+		int y1a = (y - 1 >= 0) ? (y - 1) : (y + 1);
+		int y1b = (y + 1 < height) ? (y + 1) : (y - 1);
+		int y2a = (y - 2 >= 0) ? (y - 2) : (y + 2 < height) ? (y + 2) : y;
+		int y2b = (y + 2 < height) ? (y + 2) : (y - 2 >= 0) ? (y - 2) : y;
+		int o0 = y * srcPitch;
+		int o1a = y1a * srcPitch, o1b = y1b * srcPitch;
+		int o2a = y2a * srcPitch, o2b = y2b * srcPitch;
+
+		// 32oCgi16fj
+		for (int x = 0; x < rowBytes; x += 32) {
+			if (x > rowBytes - 32) x = rowBytes - 32;
+			__m256i r[2];
+			for (int h = 0; h < 2; ++h) {
+				int xh = x + h * 16;
+#define LOAD(p, o) _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)&(p)[(o) + xh]))
+				r[h] = yadif_pixels32(
+					LOAD(cur, o1a), LOAD(cur, o1b),
+					LOAD(prev, o1a), LOAD(prev, o1b),
+					LOAD(next, o1a), LOAD(next, o1b),
+					LOAD(prev2, o0), LOAD(next2, o0),
+					LOAD(prev2, o2a), LOAD(next2, o2a),
+					LOAD(prev2, o2b), LOAD(next2, o2b));
+#undef LOAD
+			}
+			auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(r[0], r[1]), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_si256((__m256i*)&dstptr[x], packed);
+		}
+	}
+}
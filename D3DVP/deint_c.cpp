@@ -0,0 +1,95 @@
+
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include "deint.h"
+
+void bob_field_c(uint8_t* dst, int dstPitch, const uint8_t* src, int srcPitch,
+	int rowBytes, int height, int keepParity)
+{
+	for (int y = 0; y < height; ++y) {
+		uint8_t* dstptr = dst + y * dstPitch;
+		if ((y & 1) == keepParity) {
+			memcpy(dstptr, src + y * srcPitch, rowBytes);
+			continue;
+		}
+		// ʒ[͓tB[h̍sg
+		int ya = (y - 1 >= 0) ? (y - 1) : (y + 1);
+		int yb = (y + 1 < height) ? (y + 1) : (y - 1);
+		const uint8_t* a = src + ya * srcPitch;
+		const uint8_t* b = src + yb * srcPitch;
+		for (int x = 0; x < rowBytes; ++x) {
+			dstptr[x] = (a[x] + b[x] + 1) >> 1;
+		}
+	}
+}
+
+template <typename T> static T max3(T a, T b, T c) { return std::max(std::max(a, b), c); }
+template <typename T> static T min3(T a, T b, T c) { return std::min(std::min(a, b), c); }
+
+// pixel_t: f̌^, sb`ƕpixel_tP
+template <typename pixel_t>
+static void yadif_field_t(pixel_t* dst, int dstPitch,
+	const pixel_t* prev, const pixel_t* cur, const pixel_t* next, int srcPitch,
+	int width, int height, int keepParity, int secondField, int yStart, int yEnd)
+{
+	// ԂsƓ̑ÕtB[h
+	// 1: Ot[ƌt[̕ԑΏۍs, 2: t[Ǝt[̕ԑΏۍs
+	const pixel_t* prev2 = secondField ? cur : prev;
+	const pixel_t* next2 = secondField ? next : cur;
+
+	for (int y = yStart; y < yEnd; ++y) {
+		pixel_t* dstptr = dst + y * dstPitch;
+		if ((y & 1) == keepParity) {
+			memcpy(dstptr, cur + y * srcPitch, width * sizeof(pixel_t));
+			continue;
+		}
+		// ʒ[͓tB[h̍sg
+		int y1a = (y - 1 >= 0) ? (y - 1) : (y + 1);
+		int y1b = (y + 1 < height) ? (y + 1) : (y - 1);
+		int y2a = (y - 2 >= 0) ? (y - 2) : (y + 2 < height) ? (y + 2) : y;
+		int y2b = (y + 2 < height) ? (y + 2) : (y - 2 >= 0) ? (y - 2) : y;
+		int o0 = y * srcPitch;
+		int o1a = y1a * srcPitch, o1b = y1b * srcPitch;
+		int o2a = y2a * srcPitch, o2b = y2b * srcPitch;
+
+		for (int x = 0; x < width; ++x) {
+			int c = cur[o1a + x];
+			int e = cur[o1b + x];
+			int d = (prev2[o0 + x] + next2[o0 + x]) >> 1;
+			int tdiff0 = std::abs(prev2[o0 + x] - next2[o0 + x]);
+			int tdiff1 = (std::abs(prev[o1a + x] - c) + std::abs(prev[o1b + x] - e)) >> 1;
+			int tdiff2 = (std::abs(next[o1a + x] - c) + std::abs(next[o1b + x] - e)) >> 1;
+			int diff = max3(tdiff0 >> 1, tdiff1, tdiff2);
+
+			// ԕ̕ωԕ̗\ƖȂmF
+			int b = (prev2[o2a + x] + next2[o2a + x]) >> 1;
+			int f = (prev2[o2b + x] + next2[o2b + x]) >> 1;
+			int dmax = max3(d - e, d - c, std::min(b - c, f - e));
+			int dmin = min3(d - e, d - c, std::max(b - c, f - e));
+			diff = max3(diff, dmin, -dmax);
+
+			int spatial = (c + e) >> 1;
+			if (spatial > d + diff) spatial = d + diff;
+			else if (spatial < d - diff) spatial = d - diff;
+			dstptr[x] = (pixel_t)spatial;
+		}
+	}
+}
+
+void yadif_field_c(uint8_t* dst, int dstPitch,
+	const uint8_t* prev, const uint8_t* cur, const uint8_t* next, int srcPitch,
+	int rowBytes, int height, int keepParity, int secondField, int yStart, int yEnd)
+{
+	yadif_field_t<uint8_t>(dst, dstPitch, prev, cur, next, srcPitch,
+		rowBytes, height, keepParity, secondField, yStart, yEnd);
+}
+
+void yadif_field16_c(uint8_t* dst, int dstPitch,
+	const uint8_t* prev, const uint8_t* cur, const uint8_t* next, int srcPitch,
+	int rowBytes, int height, int keepParity, int secondField, int yStart, int yEnd)
+{
+	yadif_field_t<uint16_t>((uint16_t*)dst, dstPitch / 2,
+		(const uint16_t*)prev, (const uint16_t*)cur, (const uint16_t*)next, srcPitch / 2,
+		rowBytes / 2, height, keepParity, secondField, yStart, yEnd);
+}
@@ -0,0 +1,579 @@
+
+// convert.h̕ϊ֐̃x`}[NiGoogle Benchmarkj
+// ֐ƁETCYƂGB/si+o͂̃oCgjcycles/pixeliTSCjo
+// : D3DVPBench --benchmark_filter=avx2
+//     D3DVPBench --benchmark_filter=yc48_to_nv12  i߃ZbgƂ̔rj
+//     D3DVPBench --benchmark_filter=upload/       iʏ̃Ə݌ւ̏݁j
+//     D3DVPBench --benchmark_filter=startup/      iŏ̃t[o܂ł̎ԁj
+//     D3DVPBench --benchmark_filter=aviutl_out/   iAviUtlł̏o̓t[YC48ւ̕ϊj
+
+#define NOMINMAX
+#include <Windows.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <chrono>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+#include "benchmark/benchmark.h"
+
+#include "convert.h"
+
+// x`}[NłAviSynth̃wb_gȂ̂ŕWCũXbhɂ
+#define THREAD_STD
+#include "Thread.hpp"
+#include "CPUBackend.hpp"
+#include "ParallelConvert.hpp"
+
+namespace {
+
+struct FrameSize {
+	const char* name;
+	int width, height;
+};
+
+const FrameSize SIZES[] = {
+	{ "SD", 720, 480 },
+	{ "1080p", 1920, 1080 },
+	{ "4K", 3840, 2160 },
+	// SIMD̔{łȂ
+	{ "1366x768", 1366, 768 },
+	{ "odd", 721, 480 },
+};
+
+enum { ALIGN = 64 };
+
+int Align(int n) { return (n + ALIGN - 1) & ~(ALIGN - 1); }
+
+// 64oCgAC̃obt@
+template <typename T>
+class Buffer
+{
+	std::unique_ptr<uint8_t[]> mem;
+	T* ptr;
+public:
+	Buffer(size_t count)
+		: mem(new uint8_t[count * sizeof(T) + ALIGN])
+	{
+		ptr = reinterpret_cast<T*>(
+			(reinterpret_cast<uintptr_t>(mem.get()) + ALIGN - 1) & ~(uintptr_t)(ALIGN - 1));
+		// g͉łAy[W蓖ĂĂ߂ɖ߂Ă
+		uint8_t* p = reinterpret_cast<uint8_t*>(ptr);
+		for (size_t i = 0; i < count * sizeof(T); ++i) {
+			p[i] = (uint8_t)rand();
+		}
+	}
+	T* get() { return ptr; }
+};
+
+// ݌i}bvXe[WOeNX`̑j
+// WindowsȊOł͊mۂłȂ̂nullptr
+class WriteCombinedBuffer
+{
+	void* ptr;
+public:
+	WriteCombinedBuffer(size_t bytes)
+	{
+#ifdef _WIN32
+		ptr = VirtualAlloc(NULL, bytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE | PAGE_WRITECOMBINE);
+		if (ptr) {
+			memset(ptr, 0, bytes);
+		}
+#else
+		ptr = nullptr;
+#endif
+	}
+	~WriteCombinedBuffer()
+	{
+#ifdef _WIN32
+		if (ptr) {
+			VirtualFree(ptr, 0, MEM_RELEASE);
+		}
+#endif
+	}
+	uint8_t* get() { return static_cast<uint8_t*>(ptr); }
+};
+
+// YV12 <-> NV12, YUV420P16 <-> P010, YV16 <-> YUY2, YV24 <-> AYUV, YC48 <-> YUY2/NV12 ̗̓o͈ꎮ
+// 16bit̃sb`uint16_tP
+// YV16̐FYV24p̃obt@pitchUVŎg
+struct Frames {
+	int width, height;
+	int pitchY, pitchUV, pitchNV12, pitchYUY2, pitchAYUV, pitchYC48;
+	int pitchY16, pitchUV16, pitchP010;
+	Buffer<uint8_t> y, u, v, u444, v444, nv12, yuy2, ayuv;
+	Buffer<uint16_t> y16, u16, v16, p010;
+	Buffer<PIXEL_YC> yc48;
+
+	Frames(int width, int height)
+		: width(width)
+		, height(height)
+		, pitchY(Align(width))
+		, pitchUV(Align(width >> 1))
+		, pitchNV12(Align(width))
+		, pitchYUY2(Align(width * 2))
+		, pitchAYUV(Align(width * 4))
+		, pitchYC48(width)
+		, pitchY16(Align(width * 2) / 2)
+		, pitchUV16(Align(width) / 2)
+		, pitchP010(Align(width * 2) / 2)
+		, y(pitchY * height)
+		, u(pitchUV * (height >> 1))
+		, v(pitchUV * (height >> 1))
+		, u444(pitchY * height)
+		, v444(pitchY * height)
+		, nv12(pitchNV12 * (height + (height >> 1)))
+		, yuy2(pitchYUY2 * height)
+		, ayuv(pitchAYUV * height)
+		, y16(pitchY16 * height)
+		, u16(pitchUV16 * (height >> 1))
+		, v16(pitchUV16 * (height >> 1))
+		, p010(pitchP010 * (height + (height >> 1)))
+		, yc48(pitchYC48 * height)
+	{
+		// YC48͔͈͊O̒lƒxpXɓ邱Ƃ̂ŐȔ͈͂ɂĂ
+		PIXEL_YC* p = yc48.get();
+		for (int i = 0; i < pitchYC48 * height; ++i) {
+			p[i].y = rand() & 0xFFF;
+			p[i].cb = (rand() & 0xFFF) - 2048;
+			p[i].cr = (rand() & 0xFFF) - 2048;
+		}
+	}
+};
+
+enum Format { YV12, NV12, YUV16, P010, YV16, YUY2, YV24, AYUV, YC48 };
+
+int64_t FrameBytes(Format format, int width, int height)
+{
+	int64_t pixels = (int64_t)width * height;
+	switch (format) {
+	case YV12:
+	case NV12:
+		return pixels * 3 / 2;
+	case YUV16:
+	case P010:
+		return pixels * 3;
+	case YV16:
+	case YUY2:
+		return pixels * 2;
+	case YV24:
+		return pixels * 3;
+	case AYUV:
+		return pixels * 4;
+	default:
+		return pixels * sizeof(PIXEL_YC);
+	}
+}
+
+typedef void(*KernelFunc)(Frames& f);
+
+struct Kernel {
+	const char* name;
+	SimdLevel level; // KvȖ߃Zbg
+	Format src, dst;
+	KernelFunc func;
+};
+
+const Kernel KERNELS[] = {
+	{ "yuv_to_nv12_c", SIMD_C, YV12, NV12, [](Frames& f) {
+		yuv_to_nv12_c(f.height, f.width, f.nv12.get(), f.pitchNV12, f.y.get(), f.u.get(), f.v.get(), f.pitchY, f.pitchUV); } },
+	{ "yuv_to_nv12_avx2", SIMD_AVX2, YV12, NV12, [](Frames& f) {
+		yuv_to_nv12_avx2(f.height, f.width, f.nv12.get(), f.pitchNV12, f.y.get(), f.u.get(), f.v.get(), f.pitchY, f.pitchUV); } },
+	{ "nv12_to_yuv_c", SIMD_C, NV12, YV12, [](Frames& f) {
+		nv12_to_yuv_c(f.height, f.width, f.y.get(), f.u.get(), f.v.get(), f.pitchY, f.pitchUV, f.nv12.get(), f.pitchNV12); } },
+	{ "nv12_to_yuv_avx2", SIMD_AVX2, NV12, YV12, [](Frames& f) {
+		nv12_to_yuv_avx2(f.height, f.width, f.y.get(), f.u.get(), f.v.get(), f.pitchY, f.pitchUV, f.nv12.get(), f.pitchNV12); } },
+	// sohł͑Ŝ1ohƂđibp[Ƃ̍oh̃I[o[wbhj
+	{ "yuv_to_nv12_rows_c", SIMD_C, YV12, NV12, [](Frames& f) {
+		yuv_to_nv12_rows_c(f.height, f.width, 0, f.height, f.nv12.get(), f.pitchNV12, f.y.get(), f.u.get(), f.v.get(), f.pitchY, f.pitchUV); } },
+	{ "yuv_to_nv12_rows_avx2", SIMD_AVX2, YV12, NV12, [](Frames& f) {
+		yuv_to_nv12_rows_avx2(f.height, f.width, 0, f.height, f.nv12.get(), f.pitchNV12, f.y.get(), f.u.get(), f.v.get(), f.pitchY, f.pitchUV); } },
+	{ "yuv_to_nv12_rows_sse41", SIMD_SSE41, YV12, NV12, [](Frames& f) {
+		yuv_to_nv12_rows_sse41(f.height, f.width, 0, f.height, f.nv12.get(), f.pitchNV12, f.y.get(), f.u.get(), f.v.get(), f.pitchY, f.pitchUV); } },
+	{ "yuv_to_nv12_rows_avx512", SIMD_AVX512, YV12, NV12, [](Frames& f) {
+		yuv_to_nv12_rows_avx512(f.height, f.width, 0, f.height, f.nv12.get(), f.pitchNV12, f.y.get(), f.u.get(), f.v.get(), f.pitchY, f.pitchUV); } },
+	{ "nv12_to_yuv_rows_c", SIMD_C, NV12, YV12, [](Frames& f) {
+		nv12_to_yuv_rows_c(f.height, f.width, 0, f.height, f.y.get(), f.u.get(), f.v.get(), f.pitchY, f.pitchUV, f.nv12.get(), f.pitchNV12); } },
+	{ "nv12_to_yuv_rows_avx2", SIMD_AVX2, NV12, YV12, [](Frames& f) {
+		nv12_to_yuv_rows_avx2(f.height, f.width, 0, f.height, f.y.get(), f.u.get(), f.v.get(), f.pitchY, f.pitchUV, f.nv12.get(), f.pitchNV12); } },
+	{ "nv12_to_yuv_rows_sse41", SIMD_SSE41, NV12, YV12, [](Frames& f) {
+		nv12_to_yuv_rows_sse41(f.height, f.width, 0, f.height, f.y.get(), f.u.get(), f.v.get(), f.pitchY, f.pitchUV, f.nv12.get(), f.pitchNV12); } },
+	{ "nv12_to_yuv_rows_avx512", SIMD_AVX512, NV12, YV12, [](Frames& f) {
+		nv12_to_yuv_rows_avx512(f.height, f.width, 0, f.height, f.y.get(), f.u.get(), f.v.get(), f.pitchY, f.pitchUV, f.nv12.get(), f.pitchNV12); } },
+	// 16bit10bitƂđiVtgʂႤőx͕ςȂj
+	{ "yuv16_to_p010_c", SIMD_C, YUV16, P010, [](Frames& f) {
+		yuv16_to_p010_c(f.height, f.width, f.p010.get(), f.pitchP010, f.y16.get(), f.u16.get(), f.v16.get(), f.pitchY16, f.pitchUV16, 10); } },
+	{ "yuv16_to_p010_avx2", SIMD_AVX2, YUV16, P010, [](Frames& f) {
+		yuv16_to_p010_avx2(f.height, f.width, f.p010.get(), f.pitchP010, f.y16.get(), f.u16.get(), f.v16.get(), f.pitchY16, f.pitchUV16, 10); } },
+	{ "p010_to_yuv16_c", SIMD_C, P010, YUV16, [](Frames& f) {
+		p010_to_yuv16_c(f.height, f.width, f.y16.get(), f.u16.get(), f.v16.get(), f.pitchY16, f.pitchUV16, f.p010.get(), f.pitchP010, 10); } },
+	{ "p010_to_yuv16_avx2", SIMD_AVX2, P010, YUV16, [](Frames& f) {
+		p010_to_yuv16_avx2(f.height, f.width, f.y16.get(), f.u16.get(), f.v16.get(), f.pitchY16, f.pitchUV16, f.p010.get(), f.pitchP010, 10); } },
+	{ "yuv16_to_p010_rows_c", SIMD_C, YUV16, P010, [](Frames& f) {
+		yuv16_to_p010_rows_c(f.height, f.width, 0, f.height, f.p010.get(), f.pitchP010, f.y16.get(), f.u16.get(), f.v16.get(), f.pitchY16, f.pitchUV16, 10); } },
+	{ "yuv16_to_p010_rows_avx2", SIMD_AVX2, YUV16, P010, [](Frames& f) {
+		yuv16_to_p010_rows_avx2(f.height, f.width, 0, f.height, f.p010.get(), f.pitchP010, f.y16.get(), f.u16.get(), f.v16.get(), f.pitchY16, f.pitchUV16, 10); } },
+	{ "yuv16_to_p010_rows_sse41", SIMD_SSE41, YUV16, P010, [](Frames& f) {
+		yuv16_to_p010_rows_sse41(f.height, f.width, 0, f.height, f.p010.get(), f.pitchP010, f.y16.get(), f.u16.get(), f.v16.get(), f.pitchY16, f.pitchUV16, 10); } },
+	{ "p010_to_yuv16_rows_c", SIMD_C, P010, YUV16, [](Frames& f) {
+		p010_to_yuv16_rows_c(f.height, f.width, 0, f.height, f.y16.get(), f.u16.get(), f.v16.get(), f.pitchY16, f.pitchUV16, f.p010.get(), f.pitchP010, 10); } },
+	{ "p010_to_yuv16_rows_avx2", SIMD_AVX2, P010, YUV16, [](Frames& f) {
+		p010_to_yuv16_rows_avx2(f.height, f.width, 0, f.height, f.y16.get(), f.u16.get(), f.v16.get(), f.pitchY16, f.pitchUV16, f.p010.get(), f.pitchP010, 10); } },
+	{ "p010_to_yuv16_rows_sse41", SIMD_SSE41, P010, YUV16, [](Frames& f) {
+		p010_to_yuv16_rows_sse41(f.height, f.width, 0, f.height, f.y16.get(), f.u16.get(), f.v16.get(), f.pitchY16, f.pitchUV16, f.p010.get(), f.pitchP010, 10); } },
+	{ "yuv422_to_yuy2_rows_c", SIMD_C, YV16, YUY2, [](Frames& f) {
+		yuv422_to_yuy2_rows_c(f.width, 0, f.height, f.yuy2.get(), f.pitchYUY2, f.y.get(), f.u444.get(), f.v444.get(), f.pitchY, f.pitchUV); } },
+	{ "yuv422_to_yuy2_rows_avx2", SIMD_AVX2, YV16, YUY2, [](Frames& f) {
+		yuv422_to_yuy2_rows_avx2(f.width, 0, f.height, f.yuy2.get(), f.pitchYUY2, f.y.get(), f.u444.get(), f.v444.get(), f.pitchY, f.pitchUV); } },
+	{ "yuv422_to_yuy2_rows_sse41", SIMD_SSE41, YV16, YUY2, [](Frames& f) {
+		yuv422_to_yuy2_rows_sse41(f.width, 0, f.height, f.yuy2.get(), f.pitchYUY2, f.y.get(), f.u444.get(), f.v444.get(), f.pitchY, f.pitchUV); } },
+	{ "yuy2_to_yuv422_rows_c", SIMD_C, YUY2, YV16, [](Frames& f) {
+		yuy2_to_yuv422_rows_c(f.width, 0, f.height, f.y.get(), f.u444.get(), f.v444.get(), f.pitchY, f.pitchUV, f.yuy2.get(), f.pitchYUY2); } },
+	{ "yuy2_to_yuv422_rows_avx2", SIMD_AVX2, YUY2, YV16, [](Frames& f) {
+		yuy2_to_yuv422_rows_avx2(f.width, 0, f.height, f.y.get(), f.u444.get(), f.v444.get(), f.pitchY, f.pitchUV, f.yuy2.get(), f.pitchYUY2); } },
+	{ "yuy2_to_yuv422_rows_sse41", SIMD_SSE41, YUY2, YV16, [](Frames& f) {
+		yuy2_to_yuv422_rows_sse41(f.width, 0, f.height, f.y.get(), f.u444.get(), f.v444.get(), f.pitchY, f.pitchUV, f.yuy2.get(), f.pitchYUY2); } },
+	{ "yuv444_to_ayuv_rows_c", SIMD_C, YV24, AYUV, [](Frames& f) {
+		yuv444_to_ayuv_rows_c(f.width, 0, f.height, f.ayuv.get(), f.pitchAYUV, f.y.get(), f.u444.get(), f.v444.get(), f.pitchY, f.pitchY); } },
+	{ "yuv444_to_ayuv_rows_avx2", SIMD_AVX2, YV24, AYUV, [](Frames& f) {
+		yuv444_to_ayuv_rows_avx2(f.width, 0, f.height, f.ayuv.get(), f.pitchAYUV, f.y.get(), f.u444.get(), f.v444.get(), f.pitchY, f.pitchY); } },
+	{ "yuv444_to_ayuv_rows_sse41", SIMD_SSE41, YV24, AYUV, [](Frames& f) {
+		yuv444_to_ayuv_rows_sse41(f.width, 0, f.height, f.ayuv.get(), f.pitchAYUV, f.y.get(), f.u444.get(), f.v444.get(), f.pitchY, f.pitchY); } },
+	{ "ayuv_to_yuv444_rows_c", SIMD_C, AYUV, YV24, [](Frames& f) {
+		ayuv_to_yuv444_rows_c(f.width, 0, f.height, f.y.get(), f.u444.get(), f.v444.get(), f.pitchY, f.pitchY, f.ayuv.get(), f.pitchAYUV); } },
+	{ "ayuv_to_yuv444_rows_avx2", SIMD_AVX2, AYUV, YV24, [](Frames& f) {
+		ayuv_to_yuv444_rows_avx2(f.width, 0, f.height, f.y.get(), f.u444.get(), f.v444.get(), f.pitchY, f.pitchY, f.ayuv.get(), f.pitchAYUV); } },
+	{ "ayuv_to_yuv444_rows_sse41", SIMD_SSE41, AYUV, YV24, [](Frames& f) {
+		ayuv_to_yuv444_rows_sse41(f.width, 0, f.height, f.y.get(), f.u444.get(), f.v444.get(), f.pitchY, f.pitchY, f.ayuv.get(), f.pitchAYUV); } },
+	{ "yc48_to_yuy2_c", SIMD_C, YC48, YUY2, [](Frames& f) {
+		yc48_to_yuy2_c(f.yuy2.get(), f.pitchYUY2, f.yc48.get(), f.width, f.height, f.pitchYC48); } },
+	{ "yc48_to_yuy2_avx2", SIMD_AVX2, YC48, YUY2, [](Frames& f) {
+		yc48_to_yuy2_avx2(f.yuy2.get(), f.pitchYUY2, f.yc48.get(), f.width, f.height, f.pitchYC48); } },
+	{ "yc48_to_yuy2_sse41", SIMD_SSE41, YC48, YUY2, [](Frames& f) {
+		yc48_to_yuy2_sse41(f.yuy2.get(), f.pitchYUY2, f.yc48.get(), f.width, f.height, f.pitchYC48); } },
+	{ "yc48_to_nv12_c", SIMD_C, YC48, NV12, [](Frames& f) {
+		yc48_to_nv12_c(f.nv12.get(), f.pitchNV12, f.yc48.get(), f.width, f.height, f.pitchYC48); } },
+	{ "yc48_to_nv12_avx2", SIMD_AVX2, YC48, NV12, [](Frames& f) {
+		yc48_to_nv12_avx2(f.nv12.get(), f.pitchNV12, f.yc48.get(), f.width, f.height, f.pitchYC48); } },
+	{ "yc48_to_nv12_sse41", SIMD_SSE41, YC48, NV12, [](Frames& f) {
+		yc48_to_nv12_sse41(f.nv12.get(), f.pitchNV12, f.yc48.get(), f.width, f.height, f.pitchYC48); } },
+	{ "yc48_to_nv12_avx512", SIMD_AVX512, YC48, NV12, [](Frames& f) {
+		yc48_to_nv12_avx512(f.nv12.get(), f.pitchNV12, f.yc48.get(), f.width, f.height, f.pitchYC48); } },
+	{ "yuy2_to_yc48_c", SIMD_C, YUY2, YC48, [](Frames& f) {
+		yuy2_to_yc48_c(f.yc48.get(), f.yuy2.get(), f.pitchYUY2, f.width, f.height, f.pitchYC48); } },
+	{ "yuy2_to_yc48_avx2", SIMD_AVX2, YUY2, YC48, [](Frames& f) {
+		yuy2_to_yc48_avx2(f.yc48.get(), f.yuy2.get(), f.pitchYUY2, f.width, f.height, f.pitchYC48); } },
+	{ "yuy2_to_yc48_sse41", SIMD_SSE41, YUY2, YC48, [](Frames& f) {
+		yuy2_to_yc48_sse41(f.yc48.get(), f.yuy2.get(), f.pitchYUY2, f.width, f.height, f.pitchYC48); } },
+	{ "nv12_to_yc48_c", SIMD_C, NV12, YC48, [](Frames& f) {
+		nv12_to_yc48_c(f.yc48.get(), f.nv12.get(), f.pitchNV12, f.width, f.height, f.pitchYC48); } },
+	{ "nv12_to_yc48_avx2", SIMD_AVX2, NV12, YC48, [](Frames& f) {
+		nv12_to_yc48_avx2(f.yc48.get(), f.nv12.get(), f.pitchNV12, f.width, f.height, f.pitchYC48); } },
+	{ "nv12_to_yc48_sse41", SIMD_SSE41, NV12, YC48, [](Frames& f) {
+		nv12_to_yc48_sse41(f.yc48.get(), f.nv12.get(), f.pitchNV12, f.width, f.height, f.pitchYC48); } },
+	{ "nv12_to_yc48_avx512", SIMD_AVX512, NV12, YC48, [](Frames& f) {
+		nv12_to_yc48_avx512(f.yc48.get(), f.nv12.get(), f.pitchNV12, f.width, f.height, f.pitchYC48); } },
+};
+
+void RunKernel(benchmark::State& state, const Kernel* kernel, const FrameSize* size)
+{
+	if (kernel->level > GetSimdLevel()) {
+		state.SkipWithError("The instruction set is not supported");
+		return;
+	}
+
+	Frames frames(size->width, size->height);
+	int64_t pixels = (int64_t)size->width * size->height;
+
+	// LbV߂
+	kernel->func(frames);
+
+	uint64_t cycles = 0;
+	for (auto _ : state) {
+		uint64_t start = __rdtsc();
+		kernel->func(frames);
+		cycles += __rdtsc() - start;
+		benchmark::ClobberMemory();
+	}
+
+	state.SetBytesProcessed(state.iterations() *
+		(FrameBytes(kernel->src, size->width, size->height) + FrameBytes(kernel->dst, size->width, size->height)));
+	state.SetItemsProcessed(state.iterations() * pixels);
+	state.counters["cycles/px"] = (double)cycles / ((double)state.iterations() * pixels);
+}
+
+// YC48 -> NV12̃eNX`ւ̏݁iAviUtlłToGPUFramej
+// ֐ʏ̃iWBjƏ݌iWCjŔׂ
+struct UploadKernel {
+	const char* name;
+	SimdLevel level;
+	ConvertFuncs::FromYC48 func;
+};
+
+const UploadKernel UPLOAD_KERNELS[] = {
+	{ "yc48_to_nv12_avx2", SIMD_AVX2, yc48_to_nv12_avx2 },
+	{ "yc48_to_nv12_avx512", SIMD_AVX512, yc48_to_nv12_avx512 },
+	{ "yc48_to_nv12_stream_avx2", SIMD_AVX2, yc48_to_nv12_stream_avx2 },
+};
+
+void RunUpload(benchmark::State& state, const UploadKernel* kernel, const FrameSize* size, bool writeCombined)
+{
+	if (kernel->level > GetSimdLevel()) {
+		state.SkipWithError("The instruction set is not supported");
+		return;
+	}
+
+	int width = size->width;
+	int height = size->height;
+	int pitch = Align(width);
+	size_t dstBytes = (size_t)pitch * (height + (height >> 1));
+	Buffer<PIXEL_YC> src((size_t)width * height);
+	for (int i = 0; i < width * height; ++i) {
+		src.get()[i].y = rand() & 0xFFF;
+		src.get()[i].cb = (rand() & 0xFFF) - 2048;
+		src.get()[i].cr = (rand() & 0xFFF) - 2048;
+	}
+	Buffer<uint8_t> wb(writeCombined ? 0 : dstBytes);
+	WriteCombinedBuffer wc(writeCombined ? dstBytes : 0);
+	uint8_t* dst = writeCombined ? wc.get() : wb.get();
+	if (dst == nullptr) {
+		state.SkipWithError("Write-combined memory is not available");
+		return;
+	}
+
+	kernel->func(dst, pitch, src.get(), width, height, width);
+
+	uint64_t cycles = 0;
+	for (auto _ : state) {
+		uint64_t start = __rdtsc();
+		kernel->func(dst, pitch, src.get(), width, height, width);
+		cycles += __rdtsc() - start;
+		benchmark::ClobberMemory();
+	}
+
+	int64_t pixels = (int64_t)width * height;
+	state.SetBytesProcessed(state.iterations() *
+		(FrameBytes(YC48, width, height) + FrameBytes(NV12, width, height)));
+	state.SetItemsProcessed(state.iterations() * pixels);
+	state.counters["cycles/px"] = (double)cycles / ((double)state.iterations() * pixels);
+}
+
+struct BenchErrorHandler {
+	template <typename... Args>
+	void ThrowError(const char* str, Args... args) {
+		throw std::runtime_error(str);
+	}
+};
+
+// Nŏ̃t[o܂łCPUobNGhōČ
+// D3DVPƓAZbg̎̂Ăt[ƑO̎Qƃt[Ăŏ̃t[o
+// iD3D11obNGh͂̊ɈˑȂ̔rpŁAۂ̒lstats"startup"邱Ɓj
+class StartupPipeline
+{
+	enum {
+		NBUF = 4,
+		RESET_FRAMES = 4, // D3DVPreset̃ftHg
+	};
+
+	BenchErrorHandler env;
+	Frames& src;
+	Frames& dst;
+	std::unique_ptr<WorkerPool<BenchErrorHandler>> pool;
+	std::unique_ptr<CPUBackend<BenchErrorHandler>> backend;
+
+public:
+	StartupPipeline(Frames& src, Frames& dst) : src(src), dst(dst) { }
+
+	// D3DVPInitiobNGh̍쐬ƃXbh̊Jnj
+	void Init() {
+		pool = std::unique_ptr<WorkerPool<BenchErrorHandler>>(new WorkerPool<BenchErrorHandler>(0, &env));
+		backend = std::unique_ptr<CPUBackend<BenchErrorHandler>>(
+			new CPUBackend<BenchErrorHandler>(pool.get(), GetSimdLevel() >= SIMD_AVX2));
+		BackendParam param = BackendParam();
+		param.format = SURFACE_NV12;
+		param.srcWidth = param.width = src.width;
+		param.srcHeight = param.height = src.height;
+		param.fpsNum = 30000;
+		param.fpsDen = 1001;
+		param.tff = 1;
+		param.numFields = 1;
+		param.numInputStaging = NBUF;
+		param.numOutputStaging = NBUF;
+		param.numOutput = NBUF;
+		backend->Create(param, &env);
+	}
+
+	// ŏ̃t[܂ŏi͂̕ϊAC^Ao͂̕ϊj
+	void Run() {
+		const ConvertFuncs& funcs = GetConvertFuncs();
+		int past = backend->PastFrames();
+		int numSlots = past + backend->FutureFrames() + 1;
+		int numInput = RESET_FRAMES + numSlots;
+		std::vector<int> slots(numSlots);
+		for (int i = 0; i < numInput; ++i) {
+			BackendSurface* staging = backend->GetInputStaging(i % NBUF);
+			MappedSurface map = backend->GetInputMapping(staging, &env);
+			funcs.yuv_to_nv12_rows(src.height, src.width, 0, src.height, (uint8_t*)map.pData, map.RowPitch,
+				src.y.get(), src.u.get(), src.v.get(), src.pitchY, src.pitchUV);
+			backend->Upload(i % numSlots, staging, &env);
+			if (i < numSlots - 1) {
+				continue;
+			}
+			// ̓t[ i - FutureFrames o͂
+			for (int k = 0; k < numSlots; ++k) {
+				slots[k] = (i - numSlots + 1 + k) % numSlots;
+			}
+			int outSlot = i % NBUF;
+			backend->Process(slots.data(), 0, 0, outSlot, false, &env);
+			BackendSurface* outStaging = backend->GetOutputStaging(outSlot);
+			backend->Download(outStaging, outSlot, &env);
+			MappedSurface map2 = backend->Map(outStaging, false, &env);
+			funcs.nv12_to_yuv_rows(dst.height, dst.width, 0, dst.height, dst.y.get(), dst.u.get(), dst.v.get(),
+				dst.pitchY, dst.pitchUV, (const uint8_t*)map2.pData, map2.RowPitch);
+			backend->Unmap(outStaging);
+		}
+	}
+};
+
+// XNvg̓ǂݍ݁iparseMsj̑OD3DVPāAǂݍ݂Iŏ̃t[v
+// warmUp=falseȂŏ̗vŏAtrueȂƂɕʃXbhŏĂ
+// iD3D11ł̃EH[Abv͋̃t[ŃZbg̏ĂAhCȍς܂邽߂̂̂Ȃ̂ōČȂj
+// v͍̂ŏ̗vt[o܂Łitime-to-first-framej
+void RunStartup(benchmark::State& state, const FrameSize* size, bool warmUp)
+{
+	int parseMs = (int)state.range(0);
+	Frames src(size->width, size->height);
+	Frames dst(size->width, size->height);
+	double initSum = 0;
+
+	for (auto _ : state) {
+		StartupPipeline pipeline(src, dst);
+		std::unique_ptr<std::thread> warmUpThread;
+		if (warmUp) {
+			warmUpThread = std::unique_ptr<std::thread>(new std::thread([&]() {
+				pipeline.Init();
+			}));
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(parseMs));
+
+		auto start = std::chrono::steady_clock::now();
+		if (warmUp) {
+			warmUpThread->join();
+		}
+		else {
+			pipeline.Init();
+			initSum += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+		pipeline.Run();
+		state.SetIterationTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	if (!warmUp) {
+		state.counters["init_ms"] = initSum * 1000 / state.iterations();
+	}
+}
+
+// AviUtlł̏óiXe[WONV12ŃRs[YC48ɕϊj
+// bands=false: zXg̃Xbh1ŕϊiȑO̓j
+// bands=true: ParallelConvertŋL̃[J[XbhɃohŕĕϊ
+// iGetFrameő҂Ăt[fromGPUXbhRs[̒ycp_editɒڕϊ̂ŁȀԂɂȂj
+void RunAviUtlOutput(benchmark::State& state, const FrameSize* size, bool bands)
+{
+	BenchErrorHandler env;
+	WorkerPool<BenchErrorHandler> pool(0, &env);
+	const ConvertFuncs& funcs = GetConvertFuncs();
+	ParallelConvert<BenchErrorHandler> convert(&pool, funcs);
+	int width = size->width;
+	int height = size->height;
+	Frames staging(width, height); // nv12}bvXe[WOeNX`ƂĎg
+	Frames out(width, height);     // nv12v[̃t[Ayc48ycp_editƂĎg
+	int rows = height + (height >> 1);
+
+	auto run = [&]() {
+		for (int y = 0; y < rows; ++y) {
+			memcpy(out.nv12.get() + out.pitchNV12 * y, staging.nv12.get() + staging.pitchNV12 * y, width);
+		}
+		if (bands) {
+			convert.nv12_to_yc48(height, width, out.yc48.get(), out.pitchYC48, out.nv12.get(), out.pitchNV12);
+		}
+		else {
+			funcs.nv12_to_yc48(out.yc48.get(), out.nv12.get(), out.pitchNV12, width, height, out.pitchYC48);
+		}
+	};
+
+	run();
+
+	for (auto _ : state) {
+		run();
+		benchmark::ClobberMemory();
+	}
+
+	state.SetBytesProcessed(state.iterations() *
+		(FrameBytes(NV12, width, height) + FrameBytes(YC48, width, height)));
+	state.SetItemsProcessed(state.iterations() * (int64_t)width * height);
+	state.counters["threads"] = bands ? pool.NumThreads() : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	for (const Kernel& kernel : KERNELS) {
+		for (const FrameSize& size : SIZES) {
+			std::string name = std::string(kernel.name) + "/" + size.name;
+			benchmark::RegisterBenchmark(name.c_str(), RunKernel, &kernel, &size)
+				->Unit(benchmark::kMicrosecond);
+		}
+	}
+
+	for (const UploadKernel& kernel : UPLOAD_KERNELS) {
+		for (int wc = 0; wc < 2; ++wc) {
+			for (const FrameSize& size : SIZES) {
+				std::string name = std::string("upload/") + kernel.name + (wc ? "/WC/" : "/WB/") + size.name;
+				benchmark::RegisterBenchmark(name.c_str(), RunUpload, &kernel, &size, wc != 0)
+					->Unit(benchmark::kMicrosecond);
+			}
+		}
+	}
+
+	for (const FrameSize& size : SIZES) {
+		for (int warmUp = 0; warmUp < 2; ++warmUp) {
+			std::string name = std::string("startup/") + (warmUp ? "warmup/" : "sync/") + size.name;
+			benchmark::RegisterBenchmark(name.c_str(), RunStartup, &size, warmUp != 0)
+				->ArgName("parse_ms")->Arg(0)->Arg(20)
+				// EH[AbvԂɍƌvԂق0ɂȂ̂ŉ񐔂Œ肷
+				->Iterations(20)->UseManualTime()->Unit(benchmark::kMillisecond);
+		}
+	}
+
+	for (const FrameSize& size : SIZES) {
+		if ((size.width | size.height) & 1) {
+			continue; // AviUtlłNV12͕
+		}
+		for (int bands = 0; bands < 2; ++bands) {
+			std::string name = std::string("aviutl_out/") + (bands ? "bands/" : "single/") + size.name;
+			benchmark::RegisterBenchmark(name.c_str(), RunAviUtlOutput, &size, bands != 0)
+				->UseRealTime()->Unit(benchmark::kMicrosecond);
+		}
+	}
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// WindowsȊOŃx`}[Nrh邽߂̍ŏ̒`
+// ϊ֐WindowsAPIgĂȂ̂ŁAfilter.hQƂ^`
+
+#include <stdint.h>
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef uint32_t UINT;
+typedef uintptr_t WPARAM;
+typedef intptr_t LPARAM;
+typedef intptr_t LRESULT;
+typedef char* LPSTR;
+typedef const char* LPCSTR;
+typedef char TCHAR;
+typedef void* LPVOID;
+typedef void* HANDLE;
+typedef void* HWND;
+typedef void* HINSTANCE;
+typedef void* HMENU;
+typedef void* HFONT;
+typedef void* HDC;
+typedef void* HICON;
+
+typedef struct tagRECT { LONG left, top, right, bottom; } RECT;
+typedef struct tagBITMAPINFOHEADER BITMAPINFOHEADER;
+typedef struct tagWAVEFORMATEX WAVEFORMATEX;
+
+#define TRUE 1
+#define FALSE 0
+
+#define __forceinline inline __attribute__((always_inline))
@@ -11,12 +11,27 @@
 
 #include "gtest/gtest.h"
 
+#include <float.h>
 #include <fstream>
 #include <string>
 #include <memory>
+#include <vector>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <random>
 
 #include "convert.h"
+#include "deint.h"
+#include "analyze.h"
+#include "FrameAnalyzer.hpp"
+#include "ParallelConvert.hpp"
+#include "CacheWindow.hpp"
+#include "FramePool.hpp"
+#include "PipelineStats.hpp"
+#include "Tracer.hpp"
+#include "SegmentParallel.hpp"
 
 std::string GetDirectoryName(const std::string& filename)
 {
@@ -243,16 +258,14 @@ void CompareImageYC48(int height, int width, PIXEL_YC* ref, PIXEL_YC* test, int
 				printf("Error at Y(%d,%d): %d != %d\n", x, y, ref[x + y * pitch].y, test[x + y * pitch].y);
 				ASSERT_TRUE(0);
 			}
-			if ((x % 2) == 0) {
-				// Ԃ̌vZႤ̂Ŗʓ|Ȃ̂ŊsNZ͖
-				if (ref[x + y * pitch].cb != test[x + y * pitch].cb) {
-					printf("Error at U(%d,%d): %d != %d\n", x, y, ref[x + y * pitch].cb, test[x + y * pitch].cb);
-					ASSERT_TRUE(0);
-				}
-				if (ref[x + y * pitch].cr != test[x + y * pitch].cr) {
-					printf("Error at V(%d,%d): %d != %d\n", x, y, ref[x + y * pitch].cr, test[x + y * pitch].cr);
-					ASSERT_TRUE(0);
-				}
+			// f̕ԂCłSIMDłœvZɂĂ̂őSfr
+			if (ref[x + y * pitch].cb != test[x + y * pitch].cb) {
+				printf("Error at U(%d,%d): %d != %d\n", x, y, ref[x + y * pitch].cb, test[x + y * pitch].cb);
+				ASSERT_TRUE(0);
+			}
+			if (ref[x + y * pitch].cr != test[x + y * pitch].cr) {
+				printf("Error at V(%d,%d): %d != %d\n", x, y, ref[x + y * pitch].cr, test[x + y * pitch].cr);
+				ASSERT_TRUE(0);
 			}
 		}
 	}
@@ -344,9 +357,1182 @@ TEST_F(ConvertTest, yc48_to_yuy2)
 	CompareImageYC48(height, width, ref2.get(), test2.get(), pitchYC48);
 }
 
+TEST_F(ConvertTest, yuv16_to_p010)
+{
+	// 16fɖȂ[̂镝mF
+	const int widths[] = { 1280, 1366 };
+	int height = 720;
+
+	for (int width : widths) {
+		for (int bits = 10; bits <= 16; bits += 2) {
+			int widthUV = width >> 1;
+			int heightUV = height >> 1;
+
+			int pitchY = width + 16;
+			int pitchUV = widthUV + 16;
+			int dstPitch = width + 32;
+			int maxv = (1 << bits) - 1;
+
+			auto srcY = std::unique_ptr<uint16_t[]>(new uint16_t[pitchY * height]);
+			auto srcU = std::unique_ptr<uint16_t[]>(new uint16_t[pitchUV * heightUV]);
+			auto srcV = std::unique_ptr<uint16_t[]>(new uint16_t[pitchUV * heightUV]);
+			auto ref = std::unique_ptr<uint16_t[]>(new uint16_t[dstPitch * (height + heightUV)]);
+			auto test = std::unique_ptr<uint16_t[]>(new uint16_t[dstPitch * (height + heightUV)]);
+
+			for (int i = 0; i < pitchY * height; ++i) srcY[i] = rand() & maxv;
+			for (int i = 0; i < pitchUV * heightUV; ++i) srcU[i] = rand() & maxv;
+			for (int i = 0; i < pitchUV * heightUV; ++i) srcV[i] = rand() & maxv;
+
+			yuv16_to_p010_c(height, width, ref.get(), dstPitch, srcY.get(), srcU.get(), srcV.get(), pitchY, pitchUV, bits);
+			yuv16_to_p010_avx2(height, width, test.get(), dstPitch, srcY.get(), srcU.get(), srcV.get(), pitchY, pitchUV, bits);
+
+			for (int y = 0; y < height + heightUV; ++y) {
+				int rowWidth = (y < height) ? width : (widthUV * 2);
+				for (int x = 0; x < rowWidth; ++x) {
+					if (ref[x + y * dstPitch] != test[x + y * dstPitch]) {
+						printf("Error at (%d,%d) bits=%d: %d != %d\n", x, y, bits, ref[x + y * dstPitch], test[x + y * dstPitch]);
+						GTEST_FAIL();
+					}
+				}
+			}
+
+			// ʃrbgɃmCY𑫂ĂľܓŌɖ߂邱
+			if (bits < 16) {
+				int noise = (1 << (16 - bits - 1)) - 1;
+				for (int i = 0; i < dstPitch * (height + heightUV); ++i) {
+					if (rand() & 1) test[i] += rand() & noise;
+				}
+			}
+
+			auto refY = std::unique_ptr<uint16_t[]>(new uint16_t[pitchY * height]);
+			auto refU = std::unique_ptr<uint16_t[]>(new uint16_t[pitchUV * heightUV]);
+			auto refV = std::unique_ptr<uint16_t[]>(new uint16_t[pitchUV * heightUV]);
+			auto testY = std::unique_ptr<uint16_t[]>(new uint16_t[pitchY * height]);
+			auto testU = std::unique_ptr<uint16_t[]>(new uint16_t[pitchUV * heightUV]);
+			auto testV = std::unique_ptr<uint16_t[]>(new uint16_t[pitchUV * heightUV]);
+
+			p010_to_yuv16_c(height, width, refY.get(), refU.get(), refV.get(), pitchY, pitchUV, test.get(), dstPitch, bits);
+			p010_to_yuv16_avx2(height, width, testY.get(), testU.get(), testV.get(), pitchY, pitchUV, test.get(), dstPitch, bits);
+
+			for (int y = 0; y < height; ++y) {
+				for (int x = 0; x < width; ++x) {
+					ASSERT_EQ(refY[x + y * pitchY], testY[x + y * pitchY]);
+					ASSERT_EQ(srcY[x + y * pitchY], testY[x + y * pitchY]);
+				}
+			}
+			for (int y = 0; y < heightUV; ++y) {
+				for (int x = 0; x < widthUV; ++x) {
+					ASSERT_EQ(refU[x + y * pitchUV], testU[x + y * pitchUV]);
+					ASSERT_EQ(refV[x + y * pitchUV], testV[x + y * pitchUV]);
+					ASSERT_EQ(srcU[x + y * pitchUV], testU[x + y * pitchUV]);
+					ASSERT_EQ(srcV[x + y * pitchUV], testV[x + y * pitchUV]);
+				}
+			}
+		}
+	}
+}
+
+TEST_F(ConvertTest, yuv422_444_to_packed)
+{
+	// 32fɖȂ[̂镝mF
+	const int widths[] = { 1920, 1366, 722 };
+	int height = 480;
+
+	for (int width : widths) {
+		for (int is444 = 0; is444 < 2; ++is444) {
+			int widthUV = is444 ? width : (width >> 1);
+			int rowBytes = is444 ? width * 4 : width * 2;
+			int pitchY = width + 16;
+			int pitchUV = widthUV + 16;
+			int dstPitch = rowBytes + 32;
+
+			auto srcY = std::unique_ptr<uint8_t[]>(new uint8_t[pitchY * height]);
+			auto srcU = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * height]);
+			auto srcV = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * height]);
+			auto ref = std::unique_ptr<uint8_t[]>(new uint8_t[dstPitch * height]);
+			auto test = std::unique_ptr<uint8_t[]>(new uint8_t[dstPitch * height]);
+			for (int i = 0; i < pitchY * height; ++i) srcY[i] = rand();
+			for (int i = 0; i < pitchUV * height; ++i) srcU[i] = rand();
+			for (int i = 0; i < pitchUV * height; ++i) srcV[i] = rand();
+
+			auto toPacked_c = is444 ? yuv444_to_ayuv_rows_c : yuv422_to_yuy2_rows_c;
+			auto toPacked_avx2 = is444 ? yuv444_to_ayuv_rows_avx2 : yuv422_to_yuy2_rows_avx2;
+			auto toPlanar_c = is444 ? ayuv_to_yuv444_rows_c : yuy2_to_yuv422_rows_c;
+			auto toPlanar_avx2 = is444 ? ayuv_to_yuv444_rows_avx2 : yuy2_to_yuv422_rows_avx2;
+
+			toPacked_c(width, 0, height, ref.get(), dstPitch, srcY.get(), srcU.get(), srcV.get(), pitchY, pitchUV);
+			toPacked_avx2(width, 0, height, test.get(), dstPitch, srcY.get(), srcU.get(), srcV.get(), pitchY, pitchUV);
+
+			for (int y = 0; y < height; ++y) {
+				for (int x = 0; x < rowBytes; ++x) {
+					if (ref[x + y * dstPitch] != test[x + y * dstPitch]) {
+						printf("Error at (%d,%d) width=%d 444=%d\n", x, y, width, is444);
+						GTEST_FAIL();
+					}
+				}
+			}
+
+			auto refY = std::unique_ptr<uint8_t[]>(new uint8_t[pitchY * height]);
+			auto refU = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * height]);
+			auto refV = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * height]);
+			auto testY = std::unique_ptr<uint8_t[]>(new uint8_t[pitchY * height]);
+			auto testU = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * height]);
+			auto testV = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * height]);
+
+			toPlanar_c(width, 0, height, refY.get(), refU.get(), refV.get(), pitchY, pitchUV, ref.get(), dstPitch);
+			toPlanar_avx2(width, 0, height, testY.get(), testU.get(), testV.get(), pitchY, pitchUV, test.get(), dstPitch);
+
+			// F̊ԈȂ̂Ōɖ߂邱
+			for (int y = 0; y < height; ++y) {
+				for (int x = 0; x < width; ++x) {
+					ASSERT_EQ(refY[x + y * pitchY], testY[x + y * pitchY]);
+					ASSERT_EQ(srcY[x + y * pitchY], testY[x + y * pitchY]);
+				}
+				for (int x = 0; x < widthUV; ++x) {
+					ASSERT_EQ(refU[x + y * pitchUV], testU[x + y * pitchUV]);
+					ASSERT_EQ(refV[x + y * pitchUV], testV[x + y * pitchUV]);
+					ASSERT_EQ(srcU[x + y * pitchUV], testU[x + y * pitchUV]);
+					ASSERT_EQ(srcV[x + y * pitchUV], testV[x + y * pitchUV]);
+				}
+			}
+		}
+	}
+}
+
+TEST_F(ConvertTest, yadif_field)
+{
+	// A32oCgɖȂmF
+	const int widths[] = { 1920, 1922, 721, 30 };
+	int height = 480;
+
+	for (int width : widths) {
+		int pitch = width + 64;
+
+		auto prev = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		auto cur = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		auto next = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		auto ref = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		auto test = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+
+		for (int i = 0; i < pitch * height; ++i) {
+			prev[i] = rand();
+			cur[i] = rand();
+			// Î~Ɠ̂镔
+			next[i] = (rand() & 1) ? cur[i] : rand();
+		}
+
+		for (int keepParity = 0; keepParity < 2; ++keepParity) {
+			for (int secondField = 0; secondField < 2; ++secondField) {
+				yadif_field_c(ref.get(), pitch, prev.get(), cur.get(), next.get(), pitch,
+					width, height, keepParity, secondField, 0, height);
+				// ohĂʂɂȂ邱
+				const int numBands = 7;
+				for (int band = 0; band < numBands; ++band) {
+					yadif_field_avx2(test.get(), pitch, prev.get(), cur.get(), next.get(), pitch,
+						width, height, keepParity, secondField,
+						height * band / numBands, height * (band + 1) / numBands);
+				}
+				for (int y = 0; y < height; ++y) {
+					for (int x = 0; x < width; ++x) {
+						if (ref[x + y * pitch] != test[x + y * pitch]) {
+							printf("Error at (%d,%d) width=%d keep=%d second=%d\n", x, y, width, keepParity, secondField);
+							GTEST_FAIL();
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST_F(ConvertTest, yadif_field16)
+{
+	// 16fɖȂ[̂镝A32oCgɖȂmF
+	const int widths[] = { 1920, 1366, 721, 14 };
+	int height = 480;
+
+	for (int width : widths) {
+		int pitch = width + 64;
+
+		auto prev = std::unique_ptr<uint16_t[]>(new uint16_t[pitch * height]);
+		auto cur = std::unique_ptr<uint16_t[]>(new uint16_t[pitch * height]);
+		auto next = std::unique_ptr<uint16_t[]>(new uint16_t[pitch * height]);
+		auto ref = std::unique_ptr<uint16_t[]>(new uint16_t[pitch * height]);
+		auto test = std::unique_ptr<uint16_t[]>(new uint16_t[pitch * height]);
+
+		for (int i = 0; i < pitch * height; ++i) {
+			// P016őS͈͂ĝ16bit̑S͈͂ŊmF
+			prev[i] = rand() * 2;
+			cur[i] = rand() * 2;
+			next[i] = (rand() & 1) ? cur[i] : rand() * 2;
+		}
+
+		for (int keepParity = 0; keepParity < 2; ++keepParity) {
+			for (int secondField = 0; secondField < 2; ++secondField) {
+				yadif_field16_c((uint8_t*)ref.get(), pitch * 2,
+					(uint8_t*)prev.get(), (uint8_t*)cur.get(), (uint8_t*)next.get(), pitch * 2,
+					width * 2, height, keepParity, secondField, 0, height);
+				const int numBands = 7;
+				for (int band = 0; band < numBands; ++band) {
+					yadif_field16_avx2((uint8_t*)test.get(), pitch * 2,
+						(uint8_t*)prev.get(), (uint8_t*)cur.get(), (uint8_t*)next.get(), pitch * 2,
+						width * 2, height, keepParity, secondField,
+						height * band / numBands, height * (band + 1) / numBands);
+				}
+				for (int y = 0; y < height; ++y) {
+					for (int x = 0; x < width; ++x) {
+						if (ref[x + y * pitch] != test[x + y * pitch]) {
+							printf("Error at (%d,%d) width=%d keep=%d second=%d\n", x, y, width, keepParity, secondField);
+							GTEST_FAIL();
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST_F(ConvertTest, sad_plane)
+{
+	// [̂镝A32oCgɖȂmF
+	const int widths[] = { 1920, 1366, 721, 14 };
+	int height = 480;
+
+	for (int width : widths) {
+		int pitch = width * 2 + 64;
+		auto a = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		auto b = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		for (int i = 0; i < pitch * height; ++i) {
+			a[i] = rand();
+			b[i] = (rand() & 1) ? a[i] : rand();
+		}
+
+		// 8bit͑S255Ȃ255*f
+		auto ones = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		auto zeros = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		memset(ones.get(), 255, pitch * height);
+		memset(zeros.get(), 0, pitch * height);
+		EXPECT_EQ(255ull * width * height, sad_plane_c(ones.get(), pitch, zeros.get(), pitch, width, 0, height));
+		EXPECT_EQ(255ull * width * height, sad_plane_avx2(zeros.get(), pitch, ones.get(), pitch, width, 0, height));
+		EXPECT_EQ(65535ull * width * height, sad_plane16_avx2(ones.get(), pitch, zeros.get(), pitch, width * 2, 0, height));
+
+		const int numBands = 7;
+		uint64_t ref = sad_plane_c(a.get(), pitch, b.get(), pitch, width, 0, height);
+		uint64_t ref16 = sad_plane16_c(a.get(), pitch, b.get(), pitch, width * 2, 0, height);
+		uint64_t test = 0, test16 = 0;
+		for (int band = 0; band < numBands; ++band) {
+			test += sad_plane_avx2(a.get(), pitch, b.get(), pitch, width,
+				height * band / numBands, height * (band + 1) / numBands);
+			test16 += sad_plane16_avx2(a.get(), pitch, b.get(), pitch, width * 2,
+				height * band / numBands, height * (band + 1) / numBands);
+		}
+		EXPECT_EQ(ref, test);
+		EXPECT_EQ(ref16, test16);
+
+		for (int threads = 1; threads <= 4; threads += 3) {
+			WorkerPool<IScriptEnvironment2> pool(threads, nullptr);
+			FrameAnalyzer<IScriptEnvironment2> analyzer(&pool, true);
+			EXPECT_DOUBLE_EQ((double)ref / (width * height),
+				analyzer.MeanAbsDiff(a.get(), pitch, b.get(), pitch, width, height, 8));
+			// 10bit8bitZ
+			EXPECT_DOUBLE_EQ((double)ref16 / (width * height) / 4,
+				analyzer.MeanAbsDiff(a.get(), pitch, b.get(), pitch, width * 2, height, 10));
+			EXPECT_DOUBLE_EQ(0, analyzer.MeanAbsDiff(a.get(), pitch, a.get(), pitch, width, height, 8));
+		}
+	}
+}
+
+TEST_F(ConvertTest, comb_block_max)
+{
+	// [̂镝AA32oCgɖȂmF
+	const int sizes[][2] = { { 1920, 1080 }, { 1366, 487 }, { 721, 480 }, { 14, 40 } };
+
+	for (auto size : sizes) {
+		int width = size[0];
+		int height = size[1];
+		int pitch = width * 2 + 64;
+		auto src = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+
+		// ȂȂ0ASȂȂ̃ubN͑Sf
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < pitch; ++x) {
+				src[x + y * pitch] = (uint8_t)(x + y);
+			}
+		}
+		EXPECT_EQ(0, comb_block_max_avx2(src.get(), pitch, width, height, 9, 0, height));
+		for (int y = 0; y < height; ++y) {
+			memset(src.get() + y * pitch, (y & 1) ? 200 : 20, pitch);
+		}
+		int full = std::min(width, (int)COMB_BLOCK) * std::min(height - 2, (int)COMB_BLOCK);
+		EXPECT_EQ(full, comb_block_max_c(src.get(), pitch, width, height, 9, 0, height));
+		EXPECT_EQ(full, comb_block_max_avx2(src.get(), pitch, width, height, 9, 0, height));
+		EXPECT_EQ(0, comb_block_max_avx2(src.get(), pitch, width, height, 180, 0, height));
+
+		for (int i = 0; i < pitch * height; ++i) {
+			// Ȃ̕ƂłȂ
+			src[i] = (rand() & 3) ? (uint8_t)((i / pitch) & 1 ? 100 : 120) : rand();
+		}
+		for (int thresh : { 0, 9, 30 }) {
+			int ref = comb_block_max_c(src.get(), pitch, width, height, thresh, 0, height);
+			int ref16 = comb_block_max16_c(src.get(), pitch, width * 2, height, thresh << 8, 0, height);
+			// ubNsPʂŃohĂʂɂȂ邱
+			int test = 0, test16 = 0;
+			for (int y = 0; y < height; y += COMB_BLOCK * 3) {
+				int yEnd = std::min(height, y + COMB_BLOCK * 3);
+				test = std::max(test, comb_block_max_avx2(src.get(), pitch, width, height, thresh, y, yEnd));
+				test16 = std::max(test16, comb_block_max16_avx2(src.get(), pitch, width * 2, height, thresh << 8, y, yEnd));
+			}
+			EXPECT_EQ(ref, test);
+			EXPECT_EQ(ref16, test16);
+		}
+
+		WorkerPool<IScriptEnvironment2> pool(4, nullptr);
+		FrameAnalyzer<IScriptEnvironment2> analyzer(&pool, true);
+		EXPECT_EQ(comb_block_max_c(src.get(), pitch, width, height, 9, 0, height),
+			analyzer.CombScore(src.get(), pitch, width, height, 8));
+	}
+}
+
+TEST_F(ConvertTest, field_order)
+{
+	const int sizes[][2] = { { 1920, 1080 }, { 1366, 487 }, { 14, 40 } };
+
+	for (auto size : sizes) {
+		int width = size[0];
+		int height = size[1];
+		int pitch = width * 2 + 64;
+		auto cur = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		auto next = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		for (int i = 0; i < pitch * height; ++i) {
+			cur[i] = rand();
+			next[i] = rand();
+		}
+		uint64_t ref[2] = { 0 }, ref16[2] = { 0 };
+		field_order_sad_c(cur.get(), pitch, next.get(), pitch, width, height, 0, height, ref);
+		field_order_sad16_c(cur.get(), pitch, next.get(), pitch, width * 2, height, 0, height, ref16);
+		// ohĂʂɂȂ邱
+		uint64_t test[2] = { 0 }, test16[2] = { 0 };
+		for (int y = 0; y < height; y += 7) {
+			int yEnd = std::min(height, y + 7);
+			field_order_sad_avx2(cur.get(), pitch, next.get(), pitch, width, height, y, yEnd, test);
+			field_order_sad16_avx2(cur.get(), pitch, next.get(), pitch, width * 2, height, y, yEnd, test16);
+		}
+		EXPECT_EQ(ref[0], test[0]);
+		EXPECT_EQ(ref[1], test[1]);
+		EXPECT_EQ(ref16[0], test16[0]);
+		EXPECT_EQ(ref16[1], test16[1]);
+	}
+
+	// ɓOpgtB[hƂɎBC^[Xf
+	const int width = 256, height = 64;
+	auto makeFrame = [&](uint8_t* dst, int n, bool tff) {
+		for (int y = 0; y < height; ++y) {
+			// TFFȂs̃tB[h
+			int t = n * 2 + (((y & 1) == 0) == tff ? 0 : 1);
+			for (int x = 0; x < width; ++x) {
+				dst[x + y * width] = (uint8_t)(abs((x + t * 4) % 128 - 64) * 3);
+			}
+		}
+	};
+	WorkerPool<IScriptEnvironment2> pool(4, nullptr);
+	FrameAnalyzer<IScriptEnvironment2> analyzer(&pool, true);
+	FieldOrderDetector detector(false);
+	auto a = std::unique_ptr<uint8_t[]>(new uint8_t[width * height]);
+	auto b = std::unique_ptr<uint8_t[]>(new uint8_t[width * height]);
+	for (bool tff : { true, false }) {
+		int switched = 0;
+		for (int n = 0; n < 16; ++n) {
+			makeFrame(a.get(), n, tff);
+			makeFrame(b.get(), n + 1, tff);
+			double tffDiff, bffDiff;
+			analyzer.FieldOrderDiff(a.get(), width, b.get(), width, width, height, 8, tffDiff, bffDiff);
+			EXPECT_TRUE(tff ? (tffDiff < bffDiff) : (bffDiff < tffDiff));
+			if (detector.Add(tffDiff, bffDiff)) {
+				++switched;
+			}
+		}
+		EXPECT_EQ(1, switched);
+		EXPECT_EQ(tff, detector.IsTFF());
+	}
+	// ȂΕςȂ
+	detector.Reset();
+	makeFrame(a.get(), 0, true);
+	for (int n = 0; n < 16; ++n) {
+		double tffDiff, bffDiff;
+		analyzer.FieldOrderDiff(a.get(), width, a.get(), width, width, height, 8, tffDiff, bffDiff);
+		EXPECT_FALSE(detector.Add(tffDiff, bffDiff));
+	}
+	EXPECT_FALSE(detector.IsTFF());
+}
+
+TEST_F(ConvertTest, ivtc)
+{
+	const int sizes[][2] = { { 1920, 1080 }, { 721, 480 }, { 14, 40 } };
+
+	for (auto size : sizes) {
+		int width = size[0];
+		int height = size[1];
+		int pitch = width * 2 + 64;
+		auto top = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		auto bottom = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		for (int i = 0; i < pitch * height; ++i) {
+			top[i] = (rand() & 3) ? 100 : rand();
+			bottom[i] = (rand() & 3) ? 130 : rand();
+		}
+		// t[gݍ킹畁ʂ̎Ȃ̗
+		EXPECT_EQ(comb_block_max_c(top.get(), pitch, width, height, 9, 0, height),
+			comb_block_max_weave_avx2(top.get(), pitch, top.get(), pitch, width, height, 9, 0, height));
+		int ref = comb_block_max_weave_c(top.get(), pitch, bottom.get(), pitch, width, height, 9, 0, height);
+		int ref16 = comb_block_max_weave16_c(top.get(), pitch, bottom.get(), pitch, width * 2, height, 9 << 8, 0, height);
+		int test = 0, test16 = 0;
+		for (int y = 0; y < height; y += COMB_BLOCK * 3) {
+			int yEnd = std::min(height, y + COMB_BLOCK * 3);
+			test = std::max(test, comb_block_max_weave_avx2(top.get(), pitch, bottom.get(), pitch, width, height, 9, y, yEnd));
+			test16 = std::max(test16, comb_block_max_weave16_avx2(top.get(), pitch, bottom.get(), pitch, width * 2, height, 9 << 8, y, yEnd));
+		}
+		EXPECT_EQ(ref, test);
+		EXPECT_EQ(ref16, test16);
+	}
+
+	// ɓ24p̉f3:2v_ETFF̑f
+	// et[́igbv, {gjtB[h̃R}ԍ
+	const int width = 256, height = 64;
+	const int telecine[][2] = { { 0, 0 }, { 1, 1 }, { 1, 2 }, { 2, 3 }, { 3, 3 }, { 4, 4 } };
+	const FieldMatch expected[] = { MATCH_CUR, MATCH_CUR, MATCH_PREV, MATCH_PREV, MATCH_CUR };
+	auto film = [&](int x, int k) { return (uint8_t)(abs((x + k * 8) % 128 - 64) * 3); };
+	std::vector<std::unique_ptr<uint8_t[]>> frames;
+	for (auto fields : telecine) {
+		frames.emplace_back(new uint8_t[width * height]);
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				frames.back()[x + y * width] = film(x, fields[y & 1]);
+			}
+		}
+	}
+	WorkerPool<IScriptEnvironment2> pool(4, nullptr);
+	FrameAnalyzer<IScriptEnvironment2> analyzer(&pool, true);
+	for (int n = 0; n < 5; ++n) {
+		int combs[3];
+		for (int i = 0; i < 3; ++i) {
+			int m = n + i - 1;
+			combs[i] = (m < 0) ? -1 : analyzer.WeaveCombScore(
+				frames[n].get(), width, frames[m].get(), width, width, height, 8);
+		}
+		EXPECT_EQ(expected[n], SelectFieldMatch(combs, 80));
+	}
+	// tB[hȂ΃C^
+	const int orphan[] = { 200, 200, 200 };
+	EXPECT_EQ(MATCH_NONE, SelectFieldMatch(orphan, 80));
+
+	// gbvtB[hÕt[Ɠt[𗎂Ƃ
+	double diffs[5];
+	diffs[0] = DBL_MAX;
+	for (int n = 1; n < 5; ++n) {
+		diffs[n] = (double)sad_plane_c(frames[n].get(), width * 2, frames[n - 1].get(), width * 2, width, 0, height / 2);
+	}
+	EXPECT_EQ(2, SelectDropFrame(diffs, 5));
+}
+
+TEST_F(ConvertTest, parallel_convert)
+{
+	// Aoh̑t[mF
+	const int sizes[][2] = { { 1920, 1080 }, { 3840, 2160 }, { 722, 481 }, { 64, 2000 } };
+
+	for (auto size : sizes) {
+		int width = size[0];
+		int height = size[1];
+		int widthUV = width >> 1;
+		int heightUV = height >> 1;
+
+		int pitchY = width + 32;
+		int pitchUV = widthUV + 16;
+		int dstPitch = width + 64;
+
+		auto srcY = std::unique_ptr<uint8_t[]>(new uint8_t[pitchY * height]);
+		auto srcU = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * heightUV]);
+		auto srcV = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * heightUV]);
+		for (int i = 0; i < pitchY * height; ++i) srcY[i] = rand();
+		for (int i = 0; i < pitchUV * heightUV; ++i) srcU[i] = rand();
+		for (int i = 0; i < pitchUV * heightUV; ++i) srcV[i] = rand();
+
+		auto ref = std::unique_ptr<uint8_t[]>(new uint8_t[dstPitch * (height + heightUV)]);
+		auto test = std::unique_ptr<uint8_t[]>(new uint8_t[dstPitch * (height + heightUV)]);
+		yuv_to_nv12_c(height, width, ref.get(), dstPitch, srcY.get(), srcU.get(), srcV.get(), pitchY, pitchUV);
+
+		auto refY = std::unique_ptr<uint8_t[]>(new uint8_t[pitchY * height]);
+		auto refU = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * heightUV]);
+		auto refV = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * heightUV]);
+		auto testY = std::unique_ptr<uint8_t[]>(new uint8_t[pitchY * height]);
+		auto testU = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * heightUV]);
+		auto testV = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * heightUV]);
+		nv12_to_yuv_c(height, width, refY.get(), refU.get(), refV.get(), pitchY, pitchUV, ref.get(), dstPitch);
+
+		// AviUtliYC48j
+		int pitchYC = width + 8;
+		int pitchYUY2 = width * 2 + 32;
+		auto yuy2 = std::unique_ptr<uint8_t[]>(new uint8_t[pitchYUY2 * height]);
+		for (int i = 0; i < pitchYUY2 * height; ++i) yuy2[i] = rand();
+		auto refYC = std::unique_ptr<PIXEL_YC[]>(new PIXEL_YC[pitchYC * height]);
+		auto refYC2 = std::unique_ptr<PIXEL_YC[]>(new PIXEL_YC[pitchYC * height]);
+		auto testYC = std::unique_ptr<PIXEL_YC[]>(new PIXEL_YC[pitchYC * height]);
+		if ((height & 1) == 0) { // AviUtlNV12͍
+			nv12_to_yc48_c(refYC.get(), ref.get(), dstPitch, width, height, pitchYC);
+		}
+		yuy2_to_yc48_c(refYC2.get(), yuy2.get(), pitchYUY2, width, height, pitchYC);
+
+		for (int threads = 1; threads <= 4; ++threads) {
+			WorkerPool<IScriptEnvironment2> pool(threads, nullptr);
+			for (int level = SIMD_C; level <= GetSimdLevel(); ++level) {
+				ParallelConvert<IScriptEnvironment2> convert(&pool, GetConvertFuncs((SimdLevel)level));
+
+				convert.yuv_to_nv12(height, width, test.get(), dstPitch, srcY.get(), srcU.get(), srcV.get(), pitchY, pitchUV);
+				CompareImageNV12(height, width, ref.get(), test.get(), dstPitch);
+
+				convert.nv12_to_yuv(height, width, testY.get(), testU.get(), testV.get(), pitchY, pitchUV, test.get(), dstPitch);
+				CompareImageYV12(height, width, refY.get(), refU.get(), refV.get(), testY.get(), testU.get(), testV.get(), pitchY, pitchUV);
+
+				if ((height & 1) == 0) {
+					convert.nv12_to_yc48(height, width, testYC.get(), pitchYC, test.get(), dstPitch);
+					CompareImageYC48(height, width, refYC.get(), testYC.get(), pitchYC);
+				}
+
+				convert.yuy2_to_yc48(height, width, testYC.get(), pitchYC, yuy2.get(), pitchYUY2);
+				CompareImageYC48(height, width, refYC2.get(), testYC.get(), pitchYC);
+			}
+		}
+	}
+}
+
+// 1srowBytesoCgrowssr
+static void CompareRows(const void* ref, const void* test, int pitchBytes, int rowBytes, int rows, const char* name)
+{
+	for (int y = 0; y < rows; ++y) {
+		const uint8_t* r = (const uint8_t*)ref + y * pitchBytes;
+		const uint8_t* t = (const uint8_t*)test + y * pitchBytes;
+		for (int x = 0; x < rowBytes; ++x) {
+			if (r[x] != t[x]) {
+				printf("Error in %s at byte (%d,%d): %d != %d\n", name, x, y, r[x], t[x]);
+				GTEST_FAIL();
+			}
+		}
+	}
+}
+
+// fBXpb`e[ȗS֐ɂāAgSxCłƓo͂ɂȂ邱
+TEST_F(ConvertTest, dispatch_tiers)
+{
+	// SIMDɖȂ[̂镝mF
+	const int sizes[][2] = { { 1280, 720 }, { 1366, 768 }, { 722, 480 }, { 760, 480 } };
+	const ConvertFuncs& ref = GetConvertFuncs(SIMD_C);
+
+	for (auto size : sizes) {
+		int width = size[0];
+		int height = size[1];
+		int widthUV = width >> 1;
+		int heightUV = height >> 1;
+		int pitch = width + 64;     // ͂1v[i444j
+		int dstPitch = (width * 4 + 64 + 63) & ~63; // pbN`iAYUVj
+		int bits = 10;
+
+		auto srcY = std::unique_ptr<uint16_t[]>(new uint16_t[pitch * height]);
+		auto srcU = std::unique_ptr<uint16_t[]>(new uint16_t[pitch * height]);
+		auto srcV = std::unique_ptr<uint16_t[]>(new uint16_t[pitch * height]);
+		auto yc48 = std::unique_ptr<PIXEL_YC[]>(new PIXEL_YC[pitch * height]);
+		for (int i = 0; i < pitch * height; ++i) {
+			srcY[i] = rand() & 0xFFFF;
+			srcU[i] = rand() & 0xFFFF;
+			srcV[i] = rand() & 0xFFFF;
+			// ͈͊O̒lŖOamF
+			yc48[i].y = (short)(rand() % 5000 - 400);
+			yc48[i].cb = (short)(rand() % 5000 - 2500);
+			yc48[i].cr = (short)(rand() % 5000 - 2500);
+		}
+		// 8bit͉ʃoCgA16bitbitsrbgɐĎg
+		auto src8Y = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		auto src8U = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		auto src8V = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height]);
+		for (int i = 0; i < pitch * height; ++i) {
+			src8Y[i] = (uint8_t)srcY[i];
+			src8U[i] = (uint8_t)srcU[i];
+			src8V[i] = (uint8_t)srcV[i];
+			srcY[i] &= (1 << bits) - 1;
+			srcU[i] &= (1 << bits) - 1;
+			srcV[i] &= (1 << bits) - 1;
+		}
+
+		size_t dstBytes = (size_t)dstPitch * (height + heightUV) * 2;
+		auto refDst = std::unique_ptr<uint8_t[]>(new uint8_t[dstBytes]);
+		auto testDst = std::unique_ptr<uint8_t[]>(new uint8_t[dstBytes]);
+		auto refY = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height * 6]);
+		auto refU = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height * 2]);
+		auto refV = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height * 2]);
+		auto testY = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height * 6]);
+		auto testU = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height * 2]);
+		auto testV = std::unique_ptr<uint8_t[]>(new uint8_t[pitch * height * 2]);
+
+		for (int level = SIMD_SSE41; level <= GetSimdLevel(); ++level) {
+			const ConvertFuncs& test = GetConvertFuncs((SimdLevel)level);
+			printf("%s: %dx%d\n", SimdLevelName((SimdLevel)level), width, height);
+
+			// YV12 <-> NV12
+			ref.yuv_to_nv12_rows(height, width, 0, height, refDst.get(), dstPitch, src8Y.get(), src8U.get(), src8V.get(), pitch, pitch);
+			test.yuv_to_nv12_rows(height, width, 0, height, testDst.get(), dstPitch, src8Y.get(), src8U.get(), src8V.get(), pitch, pitch);
+			CompareRows(refDst.get(), testDst.get(), dstPitch, width, height + heightUV, "yuv_to_nv12");
+			ref.nv12_to_yuv_rows(height, width, 0, height, refY.get(), refU.get(), refV.get(), pitch, pitch, refDst.get(), dstPitch);
+			test.nv12_to_yuv_rows(height, width, 0, height, testY.get(), testU.get(), testV.get(), pitch, pitch, refDst.get(), dstPitch);
+			CompareRows(refY.get(), testY.get(), pitch, width, height, "nv12_to_yuv Y");
+			CompareRows(refU.get(), testU.get(), pitch, widthUV, heightUV, "nv12_to_yuv U");
+			CompareRows(refV.get(), testV.get(), pitch, widthUV, heightUV, "nv12_to_yuv V");
+
+			// YUV420 10bit <-> P010isb`uint16_tPʁj
+			ref.yuv16_to_p010_rows(height, width, 0, height, (uint16_t*)refDst.get(), dstPitch, srcY.get(), srcU.get(), srcV.get(), pitch, pitch, bits);
+			test.yuv16_to_p010_rows(height, width, 0, height, (uint16_t*)testDst.get(), dstPitch, srcY.get(), srcU.get(), srcV.get(), pitch, pitch, bits);
+			CompareRows(refDst.get(), testDst.get(), dstPitch * 2, width * 2, height + heightUV, "yuv16_to_p010");
+			ref.p010_to_yuv16_rows(height, width, 0, height, (uint16_t*)refY.get(), (uint16_t*)refU.get(), (uint16_t*)refV.get(), pitch, pitch, (uint16_t*)refDst.get(), dstPitch, bits);
+			test.p010_to_yuv16_rows(height, width, 0, height, (uint16_t*)testY.get(), (uint16_t*)testU.get(), (uint16_t*)testV.get(), pitch, pitch, (uint16_t*)refDst.get(), dstPitch, bits);
+			CompareRows(refY.get(), testY.get(), pitch * 2, width * 2, height, "p010_to_yuv16 Y");
+			CompareRows(refU.get(), testU.get(), pitch * 2, widthUV * 2, heightUV, "p010_to_yuv16 U");
+			CompareRows(refV.get(), testV.get(), pitch * 2, widthUV * 2, heightUV, "p010_to_yuv16 V");
+
+			// YV16 <-> YUY2
+			ref.yuv422_to_yuy2_rows(width, 0, height, refDst.get(), dstPitch, src8Y.get(), src8U.get(), src8V.get(), pitch, pitch);
+			test.yuv422_to_yuy2_rows(width, 0, height, testDst.get(), dstPitch, src8Y.get(), src8U.get(), src8V.get(), pitch, pitch);
+			CompareRows(refDst.get(), testDst.get(), dstPitch, width * 2, height, "yuv422_to_yuy2");
+			ref.yuy2_to_yuv422_rows(width, 0, height, refY.get(), refU.get(), refV.get(), pitch, pitch, refDst.get(), dstPitch);
+			test.yuy2_to_yuv422_rows(width, 0, height, testY.get(), testU.get(), testV.get(), pitch, pitch, refDst.get(), dstPitch);
+			CompareRows(refY.get(), testY.get(), pitch, width, height, "yuy2_to_yuv422 Y");
+			CompareRows(refU.get(), testU.get(), pitch, widthUV, height, "yuy2_to_yuv422 U");
+			CompareRows(refV.get(), testV.get(), pitch, widthUV, height, "yuy2_to_yuv422 V");
+
+			// YV24 <-> AYUV
+			ref.yuv444_to_ayuv_rows(width, 0, height, refDst.get(), dstPitch, src8Y.get(), src8U.get(), src8V.get(), pitch, pitch);
+			test.yuv444_to_ayuv_rows(width, 0, height, testDst.get(), dstPitch, src8Y.get(), src8U.get(), src8V.get(), pitch, pitch);
+			CompareRows(refDst.get(), testDst.get(), dstPitch, width * 4, height, "yuv444_to_ayuv");
+			ref.ayuv_to_yuv444_rows(width, 0, height, refY.get(), refU.get(), refV.get(), pitch, pitch, refDst.get(), dstPitch);
+			test.ayuv_to_yuv444_rows(width, 0, height, testY.get(), testU.get(), testV.get(), pitch, pitch, refDst.get(), dstPitch);
+			CompareRows(refY.get(), testY.get(), pitch, width, height, "ayuv_to_yuv444 Y");
+			CompareRows(refU.get(), testU.get(), pitch, width, height, "ayuv_to_yuv444 U");
+			CompareRows(refV.get(), testV.get(), pitch, width, height, "ayuv_to_yuv444 V");
+
+			// YC48 <-> YUY2iYC48̃sb`͉fPʁj
+			PIXEL_YC* refYC = (PIXEL_YC*)refY.get();
+			PIXEL_YC* testYC = (PIXEL_YC*)testY.get();
+			ref.yc48_to_yuy2(refDst.get(), dstPitch, yc48.get(), width, height, pitch);
+			test.yc48_to_yuy2(testDst.get(), dstPitch, yc48.get(), width, height, pitch);
+			CompareRows(refDst.get(), testDst.get(), dstPitch, width * 2, height, "yc48_to_yuy2");
+			ref.yuy2_to_yc48(refYC, refDst.get(), dstPitch, width, height, pitch);
+			test.yuy2_to_yc48(testYC, refDst.get(), dstPitch, width, height, pitch);
+			CompareImageYC48(height, width, refYC, testYC, pitch);
+
+			// YC48 <-> NV12
+			ref.yc48_to_nv12(refDst.get(), dstPitch, yc48.get(), width, height, pitch);
+			test.yc48_to_nv12(testDst.get(), dstPitch, yc48.get(), width, height, pitch);
+			CompareRows(refDst.get(), testDst.get(), dstPitch, width, height + heightUV, "yc48_to_nv12");
+			// Xg[~OXgAł̓ACĂ΃Xg[~OXgAAĂȂΒʏłŏ
+			uint8_t* alignedDst = (uint8_t*)(((uintptr_t)testDst.get() + 63) & ~(uintptr_t)63);
+			test.yc48_to_nv12_stream(alignedDst, dstPitch, yc48.get(), width, height, pitch);
+			CompareRows(refDst.get(), alignedDst, dstPitch, width, height + heightUV, "yc48_to_nv12_stream");
+			test.yc48_to_nv12_stream(alignedDst + 1, dstPitch, yc48.get(), width, height, pitch);
+			CompareRows(refDst.get(), alignedDst + 1, dstPitch, width, height + heightUV, "yc48_to_nv12_stream (unaligned)");
+			ref.nv12_to_yc48(refYC, refDst.get(), dstPitch, width, height, pitch);
+			test.nv12_to_yc48(testYC, refDst.get(), dstPitch, width, height, pitch);
+			CompareImageYC48(height, width, refYC, testYC, pitch);
+		}
+	}
+}
+
+// Xbhɑ΂XP[OmFpiʏ̃eXgł͎sȂj
+TEST(ConvertPerfTest, parallel_convert_scaling)
+{
+	int width = 3840;
+	int height = 2160;
+	int widthUV = width >> 1;
+	int heightUV = height >> 1;
+	int pitchY = width;
+	int pitchUV = widthUV;
+	int dstPitch = width;
+	const int numFrames = 200;
+
+	auto srcY = std::unique_ptr<uint8_t[]>(new uint8_t[pitchY * height]);
+	auto srcU = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * heightUV]);
+	auto srcV = std::unique_ptr<uint8_t[]>(new uint8_t[pitchUV * heightUV]);
+	auto nv12 = std::unique_ptr<uint8_t[]>(new uint8_t[dstPitch * (height + heightUV)]);
+	memset(srcY.get(), 16, pitchY * height);
+	memset(srcU.get(), 128, pitchUV * heightUV);
+	memset(srcV.get(), 128, pitchUV * heightUV);
+
+	int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+	for (int threads = 1; threads <= maxThreads; ++threads) {
+		WorkerPool<IScriptEnvironment2> pool(threads, nullptr);
+		ParallelConvert<IScriptEnvironment2> convert(&pool, GetConvertFuncs());
+		Stopwatch sw;
+		sw.start();
+		for (int i = 0; i < numFrames; ++i) {
+			convert.yuv_to_nv12(height, width, nv12.get(), dstPitch, srcY.get(), srcU.get(), srcV.get(), pitchY, pitchUV);
+			convert.nv12_to_yuv(height, width, srcY.get(), srcU.get(), srcV.get(), pitchY, pitchUV, nv12.get(), dstPitch);
+		}
+		double sec = sw.getAndReset();
+		printf("threads=%d: %.3f ms/frame (%.2f GB/s)\n", threads, sec * 1000 / numFrames,
+			(double)width * height * 3 / 2 * 4 * numFrames / sec / 1e9);
+	}
+}
+
+// DataPumpThreadSPSCPumpThread𓯂eXgŎg߂̂
+// 󂯎ľ؂Ǝ󂯓nxL^
+template <template <typename, typename, bool> class Pump>
+class TestPump : public Pump<int64_t, IScriptEnvironment2, false>
+{
+public:
+	TestPump(size_t maximum)
+		: Pump<int64_t, IScriptEnvironment2, false>(maximum, nullptr)
+		, received(0), errors(0), latency(0) { }
+
+	std::atomic<int64_t> received;
+	std::atomic<int64_t> errors;
+	std::atomic<int64_t> latency; // imb̍v
+
+	static int64_t Now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+protected:
+	// l͑MA̒l͏ԊmFp̘A
+	virtual void OnDataReceived(int64_t&& data) {
+		if (data < 0) {
+			if (-data - 1 != received) ++errors;
+		}
+		else {
+			latency += Now() - data;
+		}
+		++received;
+	}
+};
+
+template <template <typename, typename, bool> class Pump>
+void PumpOrderTest()
+{
+	const int N = 20000;
+	TestPump<Pump> pump(2);
+	pump.start();
+	for (int i = 0; i < N; ++i) {
+		pump.put(-(int64_t)i - 1);
+	}
+	// join()͎cĂf[^̂Ă邱Ƃ̂őS󂯎܂ő҂
+	while (pump.received < N) {
+		std::this_thread::yield();
+	}
+	pump.join();
+	EXPECT_EQ(N, pump.received);
+	EXPECT_EQ(0, pump.errors);
+}
+
+TEST(PumpThreadTest, DataPumpThread_order)
+{
+	PumpOrderTest<DataPumpThread>();
+}
+
+TEST(PumpThreadTest, SPSCPumpThread_order)
+{
+	PumpOrderTest<SPSCPumpThread>();
+}
+
+class BatchPump : public SPSCPumpThread<int, IScriptEnvironment2, false>
+{
+public:
+	BatchPump(int maxBatch)
+		: SPSCPumpThread<int, IScriptEnvironment2, false>(2, nullptr)
+		, received(0), errors(0), batches(0), maxCount(0), inBatch(false)
+	{
+		setMaxBatch(maxBatch);
+	}
+
+	std::atomic<int> received;
+	std::atomic<int> errors;
+	int batches;
+	int maxCount;
+
+protected:
+	virtual void OnDataReceived(int&& data) {
+		if (!inBatch || data != received) ++errors;
+		++received;
+	}
+	virtual void OnBatchBegin() {
+		if (inBatch) ++errors;
+		inBatch = true;
+	}
+	virtual void OnBatchEnd(int count) {
+		if (!inBatch || count < 1) ++errors;
+		inBatch = false;
+		++batches;
+		maxCount = std::max(maxCount, count);
+	}
+
+private:
+	bool inBatch;
+};
+
+TEST(PumpThreadTest, SPSCPumpThread_batch)
+{
+	const int N = 20000;
+	BatchPump pump(4);
+	pump.start();
+	for (int i = 0; i < N; ++i) {
+		pump.put(int(i));
+	}
+	while (pump.received < N) {
+		std::this_thread::yield();
+	}
+	pump.join();
+	EXPECT_EQ(N, pump.received);
+	EXPECT_EQ(0, pump.errors);
+	// SOnBatchBegin()OnBatchEnd()̊ԂŏāA1͍̐ő吔𒴂Ȃ
+	EXPECT_GE(pump.batches, N / 4);
+	EXPECT_LE(pump.maxCount, 4);
+}
+
+TEST(WorkerPoolTest, shared)
+{
+	auto pool = WorkerPool<IScriptEnvironment2>::GetShared(nullptr);
+	EXPECT_EQ(pool, WorkerPool<IScriptEnvironment2>::GetShared(nullptr));
+	EXPECT_EQ(std::max(1, (int)std::thread::hardware_concurrency()), pool->NumThreads());
+	// ̃Xbh瓯Ɏg
+	std::atomic<int> sum(0);
+	std::thread t([&]() { pool->Run(100, [&](int i) { sum += i; }); });
+	pool->Run(100, [&](int i) { sum += i; });
+	t.join();
+	EXPECT_EQ(2 * 4950, sum);
+	// gĂ̂ȂȂj
+	std::weak_ptr<WorkerPool<IScriptEnvironment2>> weak = pool;
+	pool = nullptr;
+	EXPECT_TRUE(weak.expired());
+}
+
+// SegmentParallel̃eXgp[J[
+// o̓t[n͓̓t[n̂܂ܕԂi̓̓t[gj
+class TestSegmentWorker
+{
+public:
+	TestSegmentWorker() : fetcher() { }
+	void SetSourceFetcher(SourceFetcher<int>* fetcher) { this->fetcher = fetcher; }
+	int GetFrame(int n, IScriptEnvironment2* env) {
+		// ɑ̃Xbh̗v⊄蓖Ă̕ύX悤ɏ҂
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+		int frame = fetcher->Fetch(n);
+		fetcher->Fetch(n + 1);
+		return frame;
+	}
+private:
+	SourceFetcher<int>* fetcher;
+};
+
+TEST(SegmentParallelTest, multi_thread)
+{
+	const int numFrames = 300;
+	const int segment = 10;
+	const int numThreads = 4;
+	PEnv env(CreateScriptEnvironment2());
+
+	CriticalSection lock;
+	std::set<std::thread::id> hostThreads;
+	std::atomic<int> fetchErrors(0);
+	std::atomic<int> errors(0);
+	{
+		std::vector<TestSegmentWorker*> workers;
+		for (int i = 0; i < 3; ++i) {
+			workers.push_back(new TestSegmentWorker());
+		}
+		// ̓t[GetFrame()Ă񂾃Xbhł擾Ă͂Ȃ
+		auto fetch = [&](int n, IScriptEnvironment2* env) {
+			auto&& l = with(lock);
+			if (hostThreads.count(std::this_thread::get_id()) == 0) ++fetchErrors;
+			return n * 3 + 1;
+		};
+		SegmentParallel<TestSegmentWorker, int, IScriptEnvironment2> parallel(workers, fetch, segment, numFrames, env.get());
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < numThreads; ++t) {
+			threads.emplace_back([&, t]() {
+				{
+					auto&& l = with(lock);
+					hostThreads.insert(std::this_thread::get_id());
+				}
+				// MT̂悤ɊeXbhԂɑOサėv
+				for (int n = t; n < numFrames; n += numThreads) {
+					if (parallel.GetFrame(n, env.get()) != n * 3 + 1) ++errors;
+				}
+				// _ANZXiCX^Xɕʂ̃ZOgvĊ蓖ĒɂȂj
+				std::mt19937 rng(t);
+				for (int i = 0; i < 100; ++i) {
+					int n = rng() % numFrames;
+					if (parallel.GetFrame(n, env.get()) != n * 3 + 1) ++errors;
+				}
+			});
+		}
+		for (auto& th : threads) {
+			th.join();
+		}
+		// jƂɐǂݒ̃[J[̓t[҂ĂĂIł
+	}
+	EXPECT_EQ(0, errors);
+	EXPECT_EQ(0, fetchErrors);
+}
+
+// 1nĎ󂯎܂ő҂Ƃ̎󂯓nx
+// intervalUs: n܂ł̊ԊuiƎ󂯑͐QĂj
+template <template <typename, typename, bool> class Pump>
+double PumpLatency(int N, int intervalUs)
+{
+	TestPump<Pump> pump(2);
+	pump.start();
+	for (int i = 0; i < N; ++i) {
+		if (intervalUs > 0) {
+			std::this_thread::sleep_for(std::chrono::microseconds(intervalUs));
+		}
+		pump.put(TestPump<Pump>::Now());
+		while (pump.received <= i) {
+			std::this_thread::yield();
+		}
+	}
+	pump.join();
+	return (double)pump.latency / N;
+}
+
+// 󂯓nx̔rpiʏ̃eXgł͎sȂj
+TEST(PumpPerfTest, handoff_latency)
+{
+	const int intervals[] = { 0, 50, 1000 };
+	for (int interval : intervals) {
+		int N = (interval > 0) ? 1000 : 100000;
+		double deque = PumpLatency<DataPumpThread>(N, interval);
+		double spsc = PumpLatency<SPSCPumpThread>(N, interval);
+		printf("interval=%dus: DataPumpThread %.0f ns, SPSCPumpThread %.0f ns\n", interval, deque, spsc);
+	}
+}
+
+TEST(CacheWindowTest, pattern)
+{
+	const int cache = 15;
+
+	// i2{FPSȂ̂œ̓t[2񑱂j
+	CacheWindow fw(cache);
+	for (int n = 0; n < 40; ++n) fw.Request(100 + n / 2);
+	EXPECT_EQ(ACCESS_FORWARD, fw.Pattern());
+	EXPECT_EQ((int)CacheWindow::MIN_BACK_FRAMES, fw.BackFrames());
+	EXPECT_EQ(20, fw.AheadFrames(20, 2));
+
+	// MTŏԂOシ
+	CacheWindow mt(cache);
+	const int order[] = { 0, 2, 1, 3, 6, 4, 5, 7, 10, 8, 9, 11, 14, 12, 13, 15 };
+	for (int n : order) mt.Request(n);
+	EXPECT_EQ(ACCESS_FORWARD, mt.Pattern());
+	EXPECT_EQ(2, mt.BackFrames());
+
+	// t̃R}
+	CacheWindow bw(cache);
+	for (int n = 0; n < 20; ++n) bw.Request(500 - n);
+	EXPECT_EQ(ACCESS_BACKWARD, bw.Pattern());
+	EXPECT_EQ((int)CacheWindow::MIN_BACKWARD_FRAMES, bw.BackFrames());
+	EXPECT_EQ(2, bw.AheadFrames(20, 2));
+
+	// V[N
+	CacheWindow rnd(cache);
+	const int seek[] = { 100, 5000, 300, 20000, 40, 9000, 700, 1200, 60 };
+	for (int n : seek) rnd.Request(n);
+	EXPECT_EQ(ACCESS_RANDOM, rnd.Pattern());
+	EXPECT_EQ(cache, rnd.BackFrames());
+
+	// rŏɖ߂
+	for (int n = 0; n < CacheWindow::HISTORY; ++n) rnd.Request(1000 + n);
+	EXPECT_EQ(ACCESS_FORWARD, rnd.Pattern());
+
+	// cache=0Ȃ珇łcȂ
+	CacheWindow zero(0);
+	for (int n = 0; n < 20; ++n) zero.Request(n);
+	EXPECT_EQ(0, zero.BackFrames());
+}
+
+TEST(FramePoolTest, reuse_and_budget)
+{
+	const size_t nv12 = 1920 * 1620;
+	const size_t yuy2 = 1280 * 2 * 720;
+	FramePool pool(nv12 * 8);
+
+	// Ԃł͐VɊmۂȂ
+	std::vector<uint8_t*> frames;
+	for (int i = 0; i < 4; ++i) {
+		frames.push_back(pool.Alloc(nv12));
+		EXPECT_EQ(0, (uintptr_t)frames.back() % FramePool::ALIGN);
+	}
+	size_t steadyBytes = pool.GetStats().bytes;
+	for (int n = 0; n < 100; ++n) {
+		pool.Free(frames[n % 4], nv12);
+		frames[n % 4] = pool.Alloc(nv12);
+	}
+	FramePoolStats stats = pool.GetStats();
+	EXPECT_EQ(104, stats.alloc);
+	EXPECT_EQ(100, stats.hit);
+	EXPECT_EQ(steadyBytes, stats.bytes);
+	EXPECT_EQ(steadyBytes, stats.peakBytes);
+
+	// TCYςÂTCY̋󂫂͗\Zɍ킹ĉ
+	// gp̂̂͗\Z𒴂Ămۂ
+	for (uint8_t* ptr : frames) pool.Free(ptr, nv12);
+	frames.clear();
+	for (int i = 0; i < 16; ++i) {
+		frames.push_back(pool.Alloc(yuy2));
+	}
+	stats = pool.GetStats();
+	EXPECT_EQ(4, stats.release);
+	EXPECT_EQ(yuy2 * 16, stats.bytes);
+
+	// \Z𒴂ĂԂɕԂꂽ͉̂
+	pool.SetBudget(yuy2 * 4);
+	for (uint8_t* ptr : frames) pool.Free(ptr, yuy2);
+	frames.clear();
+	stats = pool.GetStats();
+	EXPECT_EQ(4 + 12, stats.release);
+	EXPECT_EQ(yuy2 * 4, stats.bytes);
+
+	pool.Clear();
+	EXPECT_EQ(0, pool.GetStats().bytes);
+}
+
+TEST(PipelineStatsTest, histogram)
+{
+	LatencyHistogram h;
+	// 1ms 90A10ms 9A100ms 1
+	for (int i = 0; i < 90; ++i) h.Record(1000);
+	for (int i = 0; i < 9; ++i) h.Record(10000);
+	h.Record(100000);
+	LatencySnapshot s = h.Snapshot();
+	EXPECT_EQ(100, s.count);
+	EXPECT_EQ(100000, s.maxUs);
+	EXPECT_DOUBLE_EQ((90 * 1000 + 9 * 10000 + 100000) / 100.0, s.MeanUs());
+	// oPbg̏[Ȃ̂2{ȓ
+	EXPECT_GE(s.PercentileUs(0.5), 1000);
+	EXPECT_LT(s.PercentileUs(0.5), 2000);
+	EXPECT_GE(s.PercentileUs(0.99), 10000);
+	EXPECT_LT(s.PercentileUs(0.99), 20000);
+	EXPECT_EQ(100000, s.PercentileUs(1.0));
+
+	LatencySnapshot s2 = s;
+	s2.Merge(s);
+	EXPECT_EQ(200, s2.count);
+	EXPECT_EQ(s.PercentileUs(0.9), s2.PercentileUs(0.9));
+
+	// ̊Ԃ͋L^Ȃ
+	PipelineStats stats;
+	{ PipelineStats::Scope scope(stats, STAGE_WAIT); }
+	stats.SampleQueue(QUEUE_PROCESS, 2);
+	EXPECT_EQ(0, stats.Snapshot().stages[STAGE_WAIT].count);
+	EXPECT_EQ(0, stats.Snapshot().queues[QUEUE_PROCESS].samples);
+	stats.Enable(true);
+	stats.SetQueueCapacity(QUEUE_PROCESS, 4);
+	{ PipelineStats::Scope scope(stats, STAGE_WAIT); }
+	stats.SampleQueue(QUEUE_PROCESS, 1);
+	stats.SampleQueue(QUEUE_PROCESS, 3);
+	PipelineSnapshot ps = stats.Snapshot();
+	EXPECT_EQ(1, ps.stages[STAGE_WAIT].count);
+	EXPECT_EQ(2, ps.queues[QUEUE_PROCESS].samples);
+	EXPECT_EQ(3, ps.queues[QUEUE_PROCESS].max);
+	EXPECT_DOUBLE_EQ(2.0, ps.queues[QUEUE_PROCESS].Mean());
+	EXPECT_NE(std::string::npos, ps.Format().find("process"));
+}
+
+TEST(PipelineStatsTest, device_lock)
+{
+	const int64_t ms = GetPerfFrequency() / 1000;
+	PipelineStats stats;
+	stats.RecordLock(ms, ms);
+	stats.RecordBatch(2);
+	EXPECT_EQ(0, stats.Snapshot().lockWait.count);
+	EXPECT_EQ(0, stats.Snapshot().batches);
+
+	stats.Enable(true);
+	// 4t[2ob`ŏāAbN3
+	for (int i = 0; i < 4; ++i) {
+		PipelineStats::Scope scope(stats, STAGE_PROCESS);
+	}
+	stats.RecordLock(0, 2 * ms);
+	stats.RecordLock(ms, 2 * ms);
+	stats.RecordLock(3 * ms, ms);
+	stats.RecordBatch(3);
+	stats.RecordBatch(1);
+	PipelineSnapshot ps = stats.Snapshot();
+	EXPECT_EQ(3, ps.lockWait.count);
+	EXPECT_EQ(3, ps.lockHold.count);
+	EXPECT_NEAR(4000, ps.lockWait.sumUs, 10);
+	EXPECT_NEAR(5000, ps.lockHold.sumUs, 10);
+	EXPECT_EQ(2, ps.batches);
+	EXPECT_EQ(4, ps.batchFrames);
+
+	PipelineSnapshot ps2 = ps;
+	ps2.Merge(ps);
+	EXPECT_EQ(6, ps2.lockWait.count);
+	EXPECT_EQ(8, ps2.batchFrames);
+
+	std::string s = ps.Format();
+	EXPECT_NE(std::string::npos, s.find("lockWait"));
+	EXPECT_NE(std::string::npos, s.find("deviceLock: 0.75 per input frame"));
+	EXPECT_NE(std::string::npos, s.find("batch: 2, 2.00 frames per batch"));
+}
+
+TEST(TracerTest, chrome_json)
+{
+	const char* path = "TracerTest.json";
+	{
+		Tracer tracer;
+		// 1ڂ̃Xbh̓Oobt@
+		std::thread t1([&]() {
+			for (int i = 0; i < Tracer::RING_EVENTS + 10; ++i) {
+				TraceScope scope(&tracer, "wrap", i);
+			}
+		});
+		std::thread t2([&]() {
+			for (int i = 0; i < 5; ++i) {
+				TraceScope scope(&tracer, "other", i);
+			}
+			TraceScope scope(&tracer, "noframe");
+		});
+		t1.join();
+		t2.join();
+		// nullptrȂ牽Ȃ
+		{ TraceScope scope(nullptr, "none", 0); }
+		ASSERT_TRUE(tracer.WriteChromeJson(path));
+	}
+
+	std::ifstream in(path);
+	std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	in.close();
+	remove(path);
+
+	auto count = [&](const std::string& s) {
+		int n = 0;
+		for (size_t pos = json.find(s); pos != std::string::npos; pos = json.find(s, pos + 1)) ++n;
+		return n;
+	};
+	EXPECT_EQ(0, json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+	EXPECT_EQ(Tracer::RING_EVENTS + 6, count("\"ph\":\"X\""));
+	EXPECT_EQ(Tracer::RING_EVENTS, count("\"name\":\"wrap\""));
+	EXPECT_EQ(5, count("\"name\":\"other\""));
+	EXPECT_EQ(0, count("\"name\":\"none\""));
+	// Â̂㏑
+	EXPECT_EQ(0, count("\"args\":{\"frame\":9}"));
+	EXPECT_EQ(1, count("\"args\":{\"frame\":10}"));
+	EXPECT_EQ(1, count("\"args\":{\"frame\":" + std::to_string(Tracer::RING_EVENTS + 9) + "}"));
+	// XbhƂtid
+	std::set<std::string> tids;
+	for (size_t pos = json.find("\"tid\":"); pos != std::string::npos; pos = json.find("\"tid\":", pos + 1)) {
+		tids.insert(json.substr(pos, json.find(',', pos) - pos));
+	}
+	EXPECT_EQ(2, (int)tids.size());
+	EXPECT_EQ(json.size() - 3, json.rfind("]}"));
+}
+
 int main(int argc, char **argv)
 {
-	::testing::GTEST_FLAG(filter) = "ConvertTest.*";
+	::testing::GTEST_FLAG(filter) = "ConvertTest.*:PumpThreadTest.*:CacheWindowTest.*:FramePoolTest.*:PipelineStatsTest.*:TracerTest.*";
 	::testing::InitGoogleTest(&argc, argv);
 	int result = RUN_ALL_TESTS();
 